@@ -32,14 +32,14 @@ using namespace Platform::Collections;
 void ArduinoAdcControllerProvider::AcquireChannel(int channel)
 {
     if (_Arduino)
-        _Arduino->pinMode(14 + channel, PinMode::ANALOG);
+        _Arduino->analogPinMode(static_cast<uint8_t>(channel), PinMode::ANALOG);
 }
 
 int ArduinoAdcControllerProvider::ReadValue(int channel)
 {
     unsigned short value = 0;
     if (_Arduino)
-        value = _Arduino->analogRead(ref new Platform::String(L"A") + channel.ToString());
+        value = _Arduino->analogRead(static_cast<uint8_t>(channel));
     return value;
 }
 
@@ -38,18 +38,18 @@ ArduinoI2cDeviceProvider::ArduinoI2cDeviceProvider(RemoteDevice^ arduino, Provid
 
     _Arduino = arduino;
 
-    _Arduino->I2c->I2cReplyEvent +=
-            ref new I2cReplyCallback(
+    _Arduino->I2c->I2cReplyDataEvent +=
+            ref new I2cReplyDataCallback(
                 [this](
                     uint8_t address_, 
                     uint8_t reg_, 
-                    Windows::Storage::Streams::DataReader ^response
+                    const Platform::Array<uint8_t> ^response
                     ) -> void 
                 {
                     std::lock_guard<std::mutex> lock(_DataReaderMutex);
 
-                    auto byteArrayCopy = ref new Platform::Array<unsigned char>(response->UnconsumedBufferLength);
-                    response->ReadBytes(byteArrayCopy);
+                    // the response is only valid during the callback, so keep a copy for ReadPartial
+                    auto byteArrayCopy = ref new Platform::Array<unsigned char>(response->Data, response->Length);
                     _I2cData.insert_or_assign(address_, byteArrayCopy);
                     _I2cRegisters.insert_or_assign(address_, reg_);
                     SetEvent(_DataRead);
@@ -46,6 +46,9 @@
 #define PULSE_IN 0x42
 #define DISTANCE 0x43
 
+// Echoed back unchanged so the host can measure the round trip time of the link
+#define PING 0x44
+
 #ifdef FIRMATA_FIRMWARE_MAJOR_VERSION
 #undef FIRMATA_FIRMWARE_MAJOR_VERSION
 #define FIRMATA_FIRMWARE_MAJOR_VERSION 2
@@ -576,6 +579,16 @@ void sysexCallback(byte command, byte argc, byte *argv)
     if (argc < 1) return;     
       GetDistance(command, argc, argv);  
     break;
+
+    case PING:
+      // the payload is the host's sequence number, which it uses to match the reply to its request
+      Firmata.write(START_SYSEX);
+      Firmata.write(PING);
+      for (byte i = 0; i < argc; i++) {
+        Firmata.write(argv[i]);
+      }
+      Firmata.write(END_SYSEX);
+      break;
       
     case I2C_REQUEST:
       mode = argv[1] & I2C_READ_WRITE_MODE_MASK;
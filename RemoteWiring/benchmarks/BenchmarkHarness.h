@@ -0,0 +1,249 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+/*
+ * A small harness shared by the benchmark executables. Each benchmark is timed for a minimum duration, repeated, and
+ * the fastest repetition is kept. A table is printed to stderr as the benchmarks run, and the results are written as JSON
+ * to stdout (or to the file given with --json=path) so successive builds can be compared by a script.
+ *
+ * Recognized arguments: --filter=substring --min-time-ms=N --repetitions=N --json=path
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Benchmark {
+
+//keeps results alive so the optimizer cannot discard the work that produced them
+template <typename T>
+inline
+void
+doNotOptimize(
+    const T &value_
+    )
+{
+#if defined(__GNUC__)
+    asm volatile( "" : : "g"( value_ ) : "memory" );
+#else
+    static volatile const T *sink;
+    sink = &value_;
+#endif
+}
+
+//additional named values reported alongside a result, such as latency percentiles
+typedef std::vector<std::pair<std::string, double>> Metrics;
+
+struct Result
+{
+    std::string name;
+    uint64_t iterations;
+    uint64_t items;
+    uint64_t bytes;
+    double seconds;
+    uint32_t threads;
+    Metrics metrics;
+};
+
+class Runner
+{
+public:
+    Runner(
+        int argc_,
+        char *argv_[]
+        ) :
+        _min_time( std::chrono::milliseconds( 200 ) ),
+        _repetitions( 3 )
+    {
+        for( int i = 1; i < argc_; ++i )
+        {
+            const char *arg = argv_[i];
+            if( !std::strncmp( arg, "--filter=", 9 ) ) _filter = arg + 9;
+            else if( !std::strncmp( arg, "--min-time-ms=", 14 ) ) _min_time = std::chrono::milliseconds( std::atoi( arg + 14 ) );
+            else if( !std::strncmp( arg, "--repetitions=", 14 ) ) _repetitions = std::max( 1, std::atoi( arg + 14 ) );
+            else if( !std::strncmp( arg, "--json=", 7 ) ) _json_path = arg + 7;
+        }
+        std::fprintf( stderr, "%-48s %14s %14s %12s\n", "benchmark", "ns/item", "items/s", "MB/s" );
+    }
+
+    bool
+    enabled(
+        const std::string &name_
+        ) const
+    {
+        return _filter.empty() || name_.find( _filter ) != std::string::npos;
+    }
+
+    std::chrono::milliseconds
+    minTime(
+        void
+        ) const
+    {
+        return _min_time;
+    }
+
+    ///<summary>
+    ///Times body_( iterations ), growing the iteration count until one call takes the minimum time.
+    ///Each iteration processes items_ items and bytes_ bytes, either may be zero.
+    ///</summary>
+    template <typename Body>
+    void
+    run(
+        const std::string &name_,
+        uint64_t items_,
+        uint64_t bytes_,
+        Body &&body_
+        )
+    {
+        if( !enabled( name_ ) ) return;
+
+        //calibrate, so the clock is read rarely enough not to matter
+        uint64_t iterations = 1;
+        double seconds = 0.0;
+        for( ;; )
+        {
+            seconds = time( body_, iterations );
+            if( seconds >= std::chrono::duration<double>( _min_time ).count() ) break;
+            const double target = std::chrono::duration<double>( _min_time ).count() * 1.2;
+            const double scale = ( seconds > 0.0 ) ? std::min( 10.0, target / seconds ) : 10.0;
+            iterations = std::max<uint64_t>( iterations + 1, static_cast<uint64_t>( iterations * scale ) );
+        }
+
+        for( int repetition = 1; repetition < _repetitions; ++repetition )
+        {
+            seconds = std::min( seconds, time( body_, iterations ) );
+        }
+        report( name_, iterations, iterations * items_, iterations * bytes_, seconds, 1 );
+    }
+
+    ///<summary>
+    ///Records a result measured by the caller, for benchmarks which cannot be expressed as a loop, such as contended ones.
+    ///With several threads, ns/item is the average time one thread took per item.
+    ///</summary>
+    void
+    report(
+        const std::string &name_,
+        uint64_t iterations_,
+        uint64_t items_,
+        uint64_t bytes_,
+        double seconds_,
+        uint32_t threads_,
+        const Metrics &metrics_ = Metrics()
+        )
+    {
+        Result result = { name_, iterations_, items_, bytes_, seconds_, threads_, metrics_ };
+        _results.push_back( result );
+
+        const double ns_per_item = items_ ? seconds_ * 1e9 * threads_ / items_ : 0.0;
+        const double items_per_second = seconds_ > 0.0 ? items_ / seconds_ : 0.0;
+        const double mb_per_second = seconds_ > 0.0 ? bytes_ / seconds_ / 1e6 : 0.0;
+        std::fprintf( stderr, "%-48s %14.2f %14.0f %12.1f", name_.c_str(), ns_per_item, items_per_second, mb_per_second );
+        for( const auto &metric : metrics_ )
+        {
+            std::fprintf( stderr, "  %s=%.0f", metric.first.c_str(), metric.second );
+        }
+        std::fprintf( stderr, "\n" );
+    }
+
+    ///<summary>
+    ///Writes the JSON report, returns the process exit code
+    ///</summary>
+    int
+    finish(
+        const char *suite_
+        )
+    {
+        std::FILE *out = _json_path.empty() ? stdout : std::fopen( _json_path.c_str(), "w" );
+        if( !out )
+        {
+            std::fprintf( stderr, "cannot write %s\n", _json_path.c_str() );
+            return 1;
+        }
+
+        char date[32];
+        const std::time_t now = std::time( nullptr );
+        std::strftime( date, sizeof( date ), "%Y-%m-%dT%H:%M:%SZ", std::gmtime( &now ) );
+
+        std::fprintf( out, "{\n  \"context\": {\n" );
+        std::fprintf( out, "    \"suite\": \"%s\",\n", suite_ );
+        std::fprintf( out, "    \"date\": \"%s\",\n", date );
+        std::fprintf( out, "    \"hardware_concurrency\": %u,\n", std::thread::hardware_concurrency() );
+        std::fprintf( out, "    \"min_time_ms\": %lld,\n", static_cast<long long>( _min_time.count() ) );
+        std::fprintf( out, "    \"repetitions\": %d\n  },\n  \"benchmarks\": [", _repetitions );
+        for( size_t i = 0; i < _results.size(); ++i )
+        {
+            const Result &result = _results[i];
+            std::fprintf( out, "%s\n    {\n", i ? "," : "" );
+            std::fprintf( out, "      \"name\": \"%s\",\n", result.name.c_str() );
+            std::fprintf( out, "      \"iterations\": %llu,\n", static_cast<unsigned long long>( result.iterations ) );
+            std::fprintf( out, "      \"threads\": %u,\n", result.threads );
+            std::fprintf( out, "      \"seconds\": %.9f,\n", result.seconds );
+            std::fprintf( out, "      \"items\": %llu,\n", static_cast<unsigned long long>( result.items ) );
+            std::fprintf( out, "      \"ns_per_item\": %.3f,\n", result.items ? result.seconds * 1e9 * result.threads / result.items : 0.0 );
+            std::fprintf( out, "      \"items_per_second\": %.1f,\n", result.seconds > 0.0 ? result.items / result.seconds : 0.0 );
+            std::fprintf( out, "      \"bytes_per_second\": %.1f", result.seconds > 0.0 ? result.bytes / result.seconds : 0.0 );
+            for( const auto &metric : result.metrics )
+            {
+                std::fprintf( out, ",\n      \"%s\": %.1f", metric.first.c_str(), metric.second );
+            }
+            std::fprintf( out, "\n    }" );
+        }
+        std::fprintf( out, "\n  ]\n}\n" );
+
+        if( out != stdout ) std::fclose( out );
+        return 0;
+    }
+
+private:
+    std::string _filter;
+    std::string _json_path;
+    std::chrono::milliseconds _min_time;
+    int _repetitions;
+    std::vector<Result> _results;
+
+    template <typename Body>
+    static
+    double
+    time(
+        Body &body_,
+        uint64_t iterations_
+        )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        body_( iterations_ );
+        return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    }
+};
+
+} // namespace Benchmark
@@ -0,0 +1,155 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * Replays the board's side of a capture through FirmataParser, as ReplaySerial and UwpFirmata::processInput would,
+ * and reports the throughput reached. Without a capture to replay, one is first recorded from a VirtualBoard streaming
+ * every analog channel at a 10us sampling interval.
+ *
+ * Built by the capture_replay_benchmark target.
+ * Usage: capture_replay_benchmark [capture path] [speed, 0 for as fast as possible] [rounds]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Firmata/Core/CaptureReplay.h"
+#include "Firmata/Core/FirmataEncoder.h"
+#include "Firmata/Core/FirmataParser.h"
+#include "Firmata/Core/SessionCapture.h"
+#include "Firmata/Core/VirtualBoard.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+//matches UwpFirmata's receive buffer
+const size_t RX_BUFFER_SIZE = 256;
+
+bool
+recordVirtualSession(
+    const std::string &path_,
+    std::chrono::seconds duration_
+    )
+{
+    CaptureRecorder recorder;
+    if( !recorder.open( path_ ) ) return false;
+
+    VirtualBoardSettings settings;
+    settings.samplingInterval = std::chrono::microseconds( 10 );
+    VirtualBoard board( settings );
+    for( uint8_t channel = 0; channel < settings.analogPinCount; ++channel )
+    {
+        SignalGenerator signal;
+        signal.shape = SignalShape::NOISE;
+        signal.offset = 512;
+        signal.amplitude = 511;
+        signal.seed = channel;
+        board.setAnalogSignal( channel, signal );
+    }
+    board.begin();
+
+    std::vector<uint8_t> request;
+    uint8_t message[FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE];
+    for( uint8_t channel = 0; channel < settings.analogPinCount; ++channel )
+    {
+        request.insert( request.end(), message, message + FirmataEncoder::reportAnalogPin( channel, true, message ) );
+    }
+    recorder.record( CaptureDirection::HOST_TO_BOARD, request.data(), request.size() );
+    board.write( request.data(), request.size() );
+
+    uint8_t buffer[RX_BUFFER_SIZE];
+    const auto stop = std::chrono::steady_clock::now() + duration_;
+    while( std::chrono::steady_clock::now() < stop )
+    {
+        if( !board.waitForData( 10 ) ) continue;
+        const size_t count = board.readBytes( buffer, sizeof( buffer ) );
+        recorder.record( CaptureDirection::BOARD_TO_HOST, buffer, count );
+    }
+    board.end();
+    recorder.close();
+    return true;
+}
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    std::string path = ( argc > 1 ) ? argv[1] : "";
+    const double speed = ( argc > 2 ) ? std::atof( argv[2] ) : 0.0;
+    const int rounds = ( argc > 3 ) ? std::atoi( argv[3] ) : 5;
+
+    if( path.empty() )
+    {
+        path = "capture_replay_benchmark.fcap";
+        if( !recordVirtualSession( path, std::chrono::seconds( 2 ) ) )
+        {
+            std::fprintf( stderr, "cannot create %s\n", path.c_str() );
+            return 1;
+        }
+    }
+
+    uint64_t messages = 0;
+    FirmataParserHandlers handlers;
+    handlers.analogMessage = [ & ]( uint8_t, uint16_t ) -> void { ++messages; };
+    handlers.digitalMessage = [ & ]( uint8_t, uint16_t ) -> void { ++messages; };
+    handlers.protocolVersion = [ & ]( uint8_t, uint8_t ) -> void { ++messages; };
+    handlers.sysexMessage = [ & ]( uint8_t, const uint8_t *, size_t ) -> void { ++messages; };
+
+    for( int round = 0; round < rounds; ++round )
+    {
+        CaptureReplay replay( speed );
+        if( !replay.begin( path ) )
+        {
+            std::fprintf( stderr, "%s is not a capture\n", path.c_str() );
+            return 1;
+        }
+
+        FirmataParser parser( handlers );
+        uint8_t buffer[RX_BUFFER_SIZE];
+        uint64_t bytes = 0;
+        messages = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        while( replay.waitForData( 100 ) || !replay.finished() )
+        {
+            const size_t count = replay.readBytes( buffer, sizeof( buffer ) );
+            parser.parse( buffer, count );
+            bytes += count;
+        }
+        const double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+        std::printf( "round %d: %llu bytes, %llu messages in %.3f s, %.1f MB/s, %.2f Mmsg/s\n", round,
+            static_cast<unsigned long long>( bytes ), static_cast<unsigned long long>( messages ), elapsed, bytes / elapsed / 1e6, messages / elapsed / 1e6 );
+    }
+    return 0;
+}
@@ -0,0 +1,379 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * End-to-end latency from a pin changing on a board to the RemoteDevice events for it returning, and how it grows with
+ * the number of boards and with slow subscribers.
+ *
+ * Each board is a loopback transport fed by an injector thread at a fixed rate, alternating analog and digital changes,
+ * with every injection timestamped. Each board has its own input thread doing what UwpFirmata::inputThread and
+ * RemoteDevice do with a report: read a transport chunk, parse it, update the pin state cache and raise the pin event
+ * to every subscriber. Latency is recorded separately for each stage:
+ *  - queue: injection until the input thread reads the chunk holding it
+ *  - parse: from the read (or the end of the previous message's dispatch) until the parser hands the message over
+ *  - cache: updating the pin state cache
+ *  - dispatch: raising the event to every subscriber
+ *  - total: injection until dispatch returns
+ *
+ * Built by the end_to_end_latency_benchmark target. Besides the harness arguments (see BenchmarkHarness.h) it takes
+ * --rate=N, injections per second per board (default 2000), and --seconds=N per configuration (default 2).
+ * Percentiles are in nanoseconds. ns/item is not meaningful for these results, items_per_second is the delivered rate.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+#include "Firmata/Core/FirmataEncoder.h"
+#include "Firmata/Core/FirmataParser.h"
+#include "Firmata/Core/Metrics.h"
+#include "RemoteWiring/Core/PinStateCache.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+using Microsoft::Maker::RemoteWiring::Core::PinStateCache;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+//matches UwpFirmata's receive buffer
+const size_t RX_BUFFER_SIZE = 256;
+
+//injection times are kept in a ring indexed by message number, the injector never gets more than half a ring ahead
+const size_t INJECTION_RING_SIZE = 1 << 16;
+
+enum Stage
+{
+    QUEUE,
+    PARSE,
+    CACHE,
+    DISPATCH,
+    TOTAL,
+    STAGE_COUNT
+};
+
+const char * const STAGE_NAMES[STAGE_COUNT] = { "queue", "parse", "cache", "dispatch", "total" };
+
+inline
+uint64_t
+nanoseconds(
+    clock_type::duration duration_
+    )
+{
+    return static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( duration_ ).count() );
+}
+
+void
+spinFor(
+    std::chrono::nanoseconds duration_
+    )
+{
+    const auto until = clock_type::now() + duration_;
+    while( clock_type::now() < until ) {}
+}
+
+/*
+ * One simulated board: the loopback transport it writes to, and the host side which reads, parses and dispatches.
+ * Every board records into the same STAGE_COUNT histograms, which take values from any number of input threads.
+ */
+class Board
+{
+public:
+    Board(
+        std::chrono::nanoseconds subscriber_delay_,
+        Histogram *histograms_
+        ) :
+        _position( 0 ),
+        _closed( false ),
+        _injection_times( INJECTION_RING_SIZE ),
+        _injected( 0 ),
+        _handled( 0 ),
+        _port_value( 0 ),
+        _events( 0 ),
+        _histograms( histograms_ )
+    {
+        FirmataParserHandlers handlers;
+        handlers.analogMessage = [ this ]( uint8_t pin_, uint16_t value_ ) -> void { onAnalogReport( pin_, value_ ); };
+        handlers.digitalMessage = [ this ]( uint8_t port_, uint16_t value_ ) -> void { onDigitalReport( port_, value_ ); };
+        _parser.reset( new FirmataParser( handlers ) );
+
+        uint8_t message[PinStateCache::MAX_PIN_MODE_MESSAGE_SIZE];
+        _pin_state.setPinMode( 2, PinMode::INPUT, message );
+
+        //a subscriber which just counts, and one which does some work of its own before returning
+        _subscribers.push_back( [ this ]( uint8_t, uint16_t ) -> void { ++_events; } );
+        if( subscriber_delay_.count() )
+        {
+            _subscribers.push_back( [ subscriber_delay_ ]( uint8_t, uint16_t ) -> void { spinFor( subscriber_delay_ ); } );
+        }
+    }
+
+    ///<summary>
+    ///Sends a change from the board, returns false if the host has fallen too far behind to track another message
+    ///</summary>
+    bool
+    inject(
+        uint64_t sequence_
+        )
+    {
+        if( _injected - _handled.load( std::memory_order_acquire ) >= INJECTION_RING_SIZE / 2 ) return false;
+
+        uint8_t message[FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE];
+        size_t length;
+        if( sequence_ & 1 )
+        {
+            //toggles pin 2, so exactly one DigitalPinUpdated is raised
+            _port_value ^= 0x04;
+            length = FirmataEncoder::digitalMessage( 0, _port_value, message );
+        }
+        else
+        {
+            length = FirmataEncoder::analogMessage( static_cast<uint8_t>( ( sequence_ >> 1 ) % 6 ), static_cast<uint16_t>( sequence_ & 0x3FF ), message );
+        }
+
+        {   //critical section
+            std::lock_guard<std::mutex> lock( _mutex );
+            _injection_times[_injected++ % INJECTION_RING_SIZE] = clock_type::now();
+            _bytes.insert( _bytes.end(), message, message + length );
+        }
+        _condition.notify_one();
+        return true;
+    }
+
+    void
+    inputThread(
+        void
+        )
+    {
+        uint8_t buffer[RX_BUFFER_SIZE];
+        for( ;; )
+        {
+            size_t count;
+            {   //critical section
+                std::unique_lock<std::mutex> lock( _mutex );
+                _condition.wait( lock, [ this ]() -> bool { return _closed || _position < _bytes.size(); } );
+                if( _position == _bytes.size() ) return;
+
+                count = std::min( RX_BUFFER_SIZE, _bytes.size() - _position );
+                std::memcpy( buffer, _bytes.data() + _position, count );
+                _position += count;
+                if( _position == _bytes.size() )
+                {
+                    _bytes.clear();
+                    _position = 0;
+                }
+            }
+
+            _read_time = clock_type::now();
+            _stage_start = _read_time;
+            _parser->parse( buffer, count );
+        }
+    }
+
+    void
+    close(
+        void
+        )
+    {
+        {   //critical section
+            std::lock_guard<std::mutex> lock( _mutex );
+            _closed = true;
+        }
+        _condition.notify_one();
+    }
+
+private:
+    //loopback transport, written by the injector and read by the input thread
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::vector<uint8_t> _bytes;
+    size_t _position;
+    bool _closed;
+    std::vector<clock_type::time_point> _injection_times;
+    uint64_t _injected;
+    std::atomic<uint64_t> _handled;
+    uint8_t _port_value;
+
+    //host side, only touched by the input thread
+    std::unique_ptr<FirmataParser> _parser;
+    PinStateCache _pin_state;
+    std::vector<std::function<void( uint8_t, uint16_t )>> _subscribers;
+    uint64_t _events;
+    clock_type::time_point _read_time;
+    clock_type::time_point _stage_start;
+    Histogram *_histograms;
+
+    void
+    onAnalogReport(
+        uint8_t pin_,
+        uint16_t value_
+        )
+    {
+        const auto parsed = clock_type::now();
+        _pin_state.setAnalogValue( pin_, value_ );
+        const auto cached = clock_type::now();
+        for( const auto &subscriber : _subscribers ) { subscriber( pin_, value_ ); }
+        recordStages( parsed, cached, clock_type::now() );
+    }
+
+    void
+    onDigitalReport(
+        uint8_t port_,
+        uint16_t value_
+        )
+    {
+        const auto parsed = clock_type::now();
+        uint8_t port_val;
+        uint8_t port_xor = _pin_state.mergeDigitalReport( port_, static_cast<uint8_t>( value_ ), &port_val );
+        const auto cached = clock_type::now();
+        for( uint8_t bit = 0; port_xor; ++bit, port_xor >>= 1 )
+        {
+            if( !( port_xor & 0x01 ) ) continue;
+            for( const auto &subscriber : _subscribers ) { subscriber( port_ * 8 + bit, ( port_val >> bit ) & 0x01 ); }
+        }
+        recordStages( parsed, cached, clock_type::now() );
+    }
+
+    void
+    recordStages(
+        clock_type::time_point parsed_,
+        clock_type::time_point cached_,
+        clock_type::time_point dispatched_
+        )
+    {
+        //the injector stored this time before publishing the bytes, and the input thread has since taken the same lock
+        const uint64_t handled = _handled.load( std::memory_order_relaxed );
+        const clock_type::time_point injected = _injection_times[handled % INJECTION_RING_SIZE];
+        _handled.store( handled + 1, std::memory_order_release );
+
+        _histograms[QUEUE].record( nanoseconds( _read_time - injected ) );
+        _histograms[PARSE].record( nanoseconds( parsed_ - _stage_start ) );
+        _histograms[CACHE].record( nanoseconds( cached_ - parsed_ ) );
+        _histograms[DISPATCH].record( nanoseconds( dispatched_ - cached_ ) );
+        _histograms[TOTAL].record( nanoseconds( dispatched_ - injected ) );
+        _stage_start = dispatched_;
+    }
+};
+
+void
+runConfiguration(
+    Benchmark::Runner &runner_,
+    unsigned board_count_,
+    std::chrono::microseconds subscriber_delay_,
+    double rate_,
+    std::chrono::seconds duration_
+    )
+{
+    const std::string prefix = "latency/boards:" + std::to_string( board_count_ ) + "/subscriber_us:" + std::to_string( subscriber_delay_.count() ) + "/";
+    bool any_enabled = false;
+    for( const char *stage : STAGE_NAMES ) { any_enabled |= runner_.enabled( prefix + stage ); }
+    if( !any_enabled ) return;
+
+    Histogram histograms[STAGE_COUNT];
+    std::vector<std::unique_ptr<Board>> boards;
+    std::vector<std::thread> input_threads;
+    for( unsigned i = 0; i < board_count_; ++i )
+    {
+        boards.emplace_back( new Board( subscriber_delay_, histograms ) );
+        Board *board = boards.back().get();
+        input_threads.emplace_back( [ board ]() -> void { board->inputThread(); } );
+    }
+
+    //one injector paces every board, spreading the injections evenly in time
+    const auto interval = std::chrono::duration_cast<clock_type::duration>( std::chrono::duration<double>( 1.0 / ( rate_ * board_count_ ) ) );
+    const auto start = clock_type::now();
+    const auto stop = start + duration_;
+    auto next = start;
+    uint64_t sequence = 0;
+    uint64_t skipped = 0;
+    while( next < stop )
+    {
+        std::this_thread::sleep_until( next );
+        if( !boards[sequence % board_count_]->inject( sequence / board_count_ ) ) ++skipped;
+        ++sequence;
+        next += interval;
+    }
+
+    for( auto &board : boards ) { board->close(); }
+    for( std::thread &thread : input_threads ) { thread.join(); }
+    const double seconds = std::chrono::duration<double>( clock_type::now() - start ).count();
+
+    for( int stage = 0; stage < STAGE_COUNT; ++stage )
+    {
+        const HistogramSnapshot snapshot = histograms[stage].snapshot();
+
+        Benchmark::Metrics metrics = {
+            { "p50_ns", static_cast<double>( snapshot.p50 ) },
+            { "p99_ns", static_cast<double>( snapshot.p99 ) },
+            { "p999_ns", static_cast<double>( snapshot.p999 ) },
+            { "max_ns", static_cast<double>( snapshot.max ) },
+            { "mean_ns", snapshot.count ? static_cast<double>( snapshot.sum ) / snapshot.count : 0.0 },
+        };
+        if( stage == TOTAL ) metrics.push_back( { "skipped_injections", static_cast<double>( skipped ) } );
+        if( runner_.enabled( prefix + STAGE_NAMES[stage] ) )
+        {
+            runner_.report( prefix + STAGE_NAMES[stage], 1, snapshot.count, 0, seconds, board_count_, metrics );
+        }
+    }
+}
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    Benchmark::Runner runner( argc, argv );
+
+    double rate = 2000.0;
+    std::chrono::seconds duration( 2 );
+    for( int i = 1; i < argc; ++i )
+    {
+        if( !std::strncmp( argv[i], "--rate=", 7 ) ) rate = std::max( 1.0, std::atof( argv[i] + 7 ) );
+        else if( !std::strncmp( argv[i], "--seconds=", 10 ) ) duration = std::chrono::seconds( std::max( 1, std::atoi( argv[i] + 10 ) ) );
+    }
+
+    for( unsigned boards : { 1, 4, 16 } )
+    {
+        for( int subscriber_us : { 0, 20 } )
+        {
+            runConfiguration( runner, boards, std::chrono::microseconds( subscriber_us ), rate, duration );
+        }
+    }
+
+    return runner.finish( "end_to_end_latency_benchmark" );
+}
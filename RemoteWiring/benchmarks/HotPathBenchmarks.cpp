@@ -0,0 +1,606 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * Microbenchmarks for the paths every report from a board goes through, run against the portable core which
+ * UwpFirmata, RemoteDevice and HardwareProfile delegate to:
+ *  - parser/...: UwpFirmata::processInput, parsing analog, digital, sysex and mixed corpora in RX_BUFFER_SIZE chunks
+ *  - codec/...: reassembleByteString and sendValueAsTwo7bitBytes, now SevenBitCodec::decode and encode
+ *  - capability/...: HardwareProfile::initializeWithFirmata on Uno and Mega capability responses, and the per-pin checks
+ *    RemoteDevice::isModeSupported makes through HardwareProfile on every pinMode
+ *  - device/digital_report_fanout/...: RemoteDevice::onDigitalReport, merging a port report and raising one event per changed pin
+ *  - device/..._read_contention/...: analogRead and digitalRead on several threads while the input thread applies reports,
+ *    neither taking the device lock, as in RemoteDevice
+ *  - device/snapshot_contention/...: getPinStateSnapshot on several threads while the input thread applies reports, each
+ *    item being one full row of ports and channels
+ *  - metrics/...: the cost of the counters and histograms UwpFirmata, RemoteDevice and the streams update on these paths,
+ *    and of taking a snapshot of them
+ *  - history/...: recording a report into RemoteDevice's sample history, and streaming samples from the input thread to an
+ *    app thread which drains them in bulk
+ *
+ * Built by the hot_path_benchmarks target. See BenchmarkHarness.h for the arguments and the JSON report.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+#include "Firmata/Core/FirmataEncoder.h"
+#include "Firmata/Core/FirmataParser.h"
+#include "Firmata/Core/FirmataProtocol.h"
+#include "Firmata/Core/Metrics.h"
+#include "Firmata/Core/SevenBitCodec.h"
+#include "RemoteWiring/Core/CapabilityParser.h"
+#include "RemoteWiring/Core/PinStateCache.h"
+#include "RemoteWiring/Core/SampleHistory.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+using Microsoft::Maker::RemoteWiring::Core::BoardCapabilities;
+using Microsoft::Maker::RemoteWiring::Core::Capability;
+using Microsoft::Maker::RemoteWiring::Core::PinStateCache;
+using Microsoft::Maker::RemoteWiring::Core::Sample;
+using Microsoft::Maker::RemoteWiring::Core::SampleHistory;
+namespace CapabilityParser = Microsoft::Maker::RemoteWiring::Core::CapabilityParser;
+
+namespace {
+
+//matches UwpFirmata's receive buffer, processInput parses one chunk of this size per read
+const size_t RX_BUFFER_SIZE = 256;
+const size_t CORPUS_SIZE = 64 * 1024;
+
+struct Corpus
+{
+    std::vector<uint8_t> bytes;
+    uint64_t messages;
+};
+
+enum class CorpusKind
+{
+    ANALOG,
+    DIGITAL,
+    SYSEX,
+    MIXED,
+};
+
+void
+appendMessage(
+    Corpus &corpus_,
+    CorpusKind kind_,
+    std::mt19937 &rng_
+    )
+{
+    uint8_t message[FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE];
+    switch( kind_ )
+    {
+    case CorpusKind::ANALOG:
+        corpus_.bytes.insert( corpus_.bytes.end(), message, message + FirmataEncoder::analogMessage( rng_() % 6, rng_() % 1024, message ) );
+        break;
+
+    case CorpusKind::DIGITAL:
+        corpus_.bytes.insert( corpus_.bytes.end(), message, message + FirmataEncoder::digitalMessage( rng_() % 3, static_cast<uint8_t>( rng_() ), message ) );
+        break;
+
+    case CorpusKind::SYSEX:
+    {
+        //an I2C reply carrying a six byte sensor reading, as an accelerometer streams them
+        uint8_t reply[8] = { 0x68, 0x3B };
+        for( size_t i = 2; i < sizeof( reply ); ++i ) { reply[i] = static_cast<uint8_t>( rng_() ); }
+        const std::vector<uint8_t> sysex = FirmataEncoder::sysex( static_cast<uint8_t>( SysexCommand::I2C_REPLY ), nullptr, 0, reply, sizeof( reply ) );
+        corpus_.bytes.insert( corpus_.bytes.end(), sysex.begin(), sysex.end() );
+    }
+        break;
+
+    case CorpusKind::MIXED:
+    {
+        //roughly the traffic of a board reporting six analog channels, three ports and an occasional I2C read
+        const unsigned roll = rng_() % 16;
+        appendMessage( corpus_, roll < 11 ? CorpusKind::ANALOG : ( roll < 15 ? CorpusKind::DIGITAL : CorpusKind::SYSEX ), rng_ );
+        return;
+    }
+    }
+    ++corpus_.messages;
+}
+
+Corpus
+makeCorpus(
+    CorpusKind kind_
+    )
+{
+    std::mt19937 rng( 42 );
+    Corpus corpus = { {}, 0 };
+    while( corpus.bytes.size() < CORPUS_SIZE )
+    {
+        appendMessage( corpus, kind_, rng );
+    }
+    return corpus;
+}
+
+void
+benchmarkParser(
+    Benchmark::Runner &runner_,
+    const char *name_,
+    CorpusKind kind_
+    )
+{
+    const Corpus corpus = makeCorpus( kind_ );
+
+    //the handlers do what UwpFirmata's do before raising events: store the value, or decode the payload into scratch space
+    uint16_t analog[16] = {};
+    uint16_t ports[16] = {};
+    std::vector<uint8_t> decode_buffer;
+    FirmataParserHandlers handlers;
+    handlers.analogMessage = [ & ]( uint8_t pin_, uint16_t value_ ) -> void { analog[pin_ & 0x0F] = value_; };
+    handlers.digitalMessage = [ & ]( uint8_t port_, uint16_t value_ ) -> void { ports[port_ & 0x0F] = value_; };
+    handlers.sysexMessage = [ & ]( uint8_t, const uint8_t *data_, size_t length_ ) -> void {
+        decode_buffer.resize( length_ / 2 + 1 );
+        decode_buffer[SevenBitCodec::decode( data_, length_, decode_buffer.data() )] = 0;
+    };
+    FirmataParser parser( handlers );
+
+    runner_.run( name_, corpus.messages, corpus.bytes.size(), [ & ]( uint64_t iterations_ ) {
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            for( size_t offset = 0; offset < corpus.bytes.size(); offset += RX_BUFFER_SIZE )
+            {
+                parser.parse( corpus.bytes.data() + offset, std::min( RX_BUFFER_SIZE, corpus.bytes.size() - offset ) );
+            }
+        }
+        Benchmark::doNotOptimize( analog[0] );
+        Benchmark::doNotOptimize( ports[0] );
+    } );
+}
+
+void
+benchmarkCodec(
+    Benchmark::Runner &runner_,
+    size_t size_
+    )
+{
+    std::mt19937 rng( 42 );
+    std::vector<uint8_t> data( size_ );
+    for( uint8_t &b : data ) { b = static_cast<uint8_t>( rng() ); }
+    std::vector<uint8_t> encoded( SevenBitCodec::encodedLength( size_ ) );
+    SevenBitCodec::encode( data.data(), size_, encoded.data() );
+    std::vector<uint8_t> out( encoded.size() + 1 );
+
+    runner_.run( "codec/encode/" + std::to_string( size_ ), 1, size_, [ & ]( uint64_t iterations_ ) {
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            SevenBitCodec::encode( data.data(), size_, out.data() );
+            Benchmark::doNotOptimize( out[0] );
+        }
+    } );
+
+    runner_.run( "codec/decode/" + std::to_string( size_ ), 1, encoded.size(), [ & ]( uint64_t iterations_ ) {
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            out[SevenBitCodec::decode( encoded.data(), encoded.size(), out.data() )] = 0;
+            Benchmark::doNotOptimize( out[0] );
+        }
+    } );
+}
+
+//the body of a CAPABILITY_RESPONSE as StandardFirmata builds it
+std::vector<uint8_t>
+capabilityResponse(
+    uint8_t total_pins_,
+    uint8_t analog_offset_,
+    const std::vector<uint8_t> &pwm_pins_,
+    const std::vector<uint8_t> &i2c_pins_
+    )
+{
+    std::vector<uint8_t> response;
+    for( uint8_t pin = 0; pin < total_pins_; ++pin )
+    {
+        const uint8_t digital[] = { static_cast<uint8_t>( PinMode::INPUT ), 1, static_cast<uint8_t>( PinMode::PULLUP ), 1, static_cast<uint8_t>( PinMode::OUTPUT ), 1 };
+        response.insert( response.end(), digital, digital + sizeof( digital ) );
+        if( pin >= analog_offset_ )
+        {
+            response.push_back( static_cast<uint8_t>( PinMode::ANALOG ) );
+            response.push_back( 10 );
+        }
+        if( std::find( pwm_pins_.begin(), pwm_pins_.end(), pin ) != pwm_pins_.end() )
+        {
+            response.push_back( static_cast<uint8_t>( PinMode::PWM ) );
+            response.push_back( 8 );
+        }
+        response.push_back( static_cast<uint8_t>( PinMode::SERVO ) );
+        response.push_back( 14 );
+        if( std::find( i2c_pins_.begin(), i2c_pins_.end(), pin ) != i2c_pins_.end() )
+        {
+            response.push_back( static_cast<uint8_t>( PinMode::I2C ) );
+            response.push_back( 1 );
+        }
+        response.push_back( 0x7F );
+    }
+    return response;
+}
+
+void
+benchmarkCapabilities(
+    Benchmark::Runner &runner_
+    )
+{
+    const std::vector<uint8_t> uno = capabilityResponse( 20, 14, { 3, 5, 6, 9, 10, 11 }, { 18, 19 } );
+
+    std::vector<uint8_t> mega_pwm = { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 44, 45, 46 };
+    const std::vector<uint8_t> mega = capabilityResponse( 70, 54, mega_pwm, { 20, 21 } );
+
+    const struct { const char *name; const std::vector<uint8_t> *response; } boards[] = {
+        { "capability/uno", &uno },
+        { "capability/mega", &mega },
+    };
+    for( const auto &board : boards )
+    {
+        runner_.run( board.name, 1, board.response->size(), [ & ]( uint64_t iterations_ ) {
+            for( uint64_t i = 0; i < iterations_; ++i )
+            {
+                BoardCapabilities capabilities;
+                CapabilityParser::parse( board.response->data(), board.response->size(), capabilities );
+                Benchmark::doNotOptimize( capabilities.totalPinCount );
+            }
+        } );
+    }
+
+    BoardCapabilities capabilities;
+    CapabilityParser::parse( mega.data(), mega.size(), capabilities );
+    runner_.run( "capability/mega/is_pwm_supported", capabilities.totalPinCount, 0, [ & ]( uint64_t iterations_ ) {
+        uint32_t supported = 0;
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            for( size_t pin = 0; pin < capabilities.totalPinCount; ++pin )
+            {
+                supported += ( capabilities.capabilities( pin ) & static_cast<uint8_t>( Capability::PWM ) ) > 0;
+            }
+            Benchmark::doNotOptimize( supported );
+        }
+    } );
+}
+
+void
+benchmarkDigitalFanout(
+    Benchmark::Runner &runner_
+    )
+{
+    PinStateCache pin_state;
+    uint8_t message[PinStateCache::MAX_PIN_MODE_MESSAGE_SIZE];
+    for( uint8_t pin = 0; pin < 8; ++pin )
+    {
+        pin_state.setPinMode( pin, PinMode::INPUT, message );
+    }
+
+    //stands in for the DigitalPinUpdated event, with a single subscriber
+    uint64_t events = 0;
+    std::function<void( uint8_t, bool )> digital_pin_updated = [ & ]( uint8_t, bool ) -> void { ++events; };
+
+    const struct { const char *name; uint8_t first; uint8_t second; } patterns[] = {
+        { "device/digital_report_fanout/one_pin", 0x00, 0x01 },
+        { "device/digital_report_fanout/all_pins", 0x00, 0xFF },
+        { "device/digital_report_fanout/unchanged", 0x5A, 0x5A },
+    };
+    for( const auto &pattern : patterns )
+    {
+        runner_.run( pattern.name, 2, 0, [ & ]( uint64_t iterations_ ) {
+            for( uint64_t i = 0; i < iterations_ * 2; ++i )
+            {
+                //mirrors RemoteDevice::onDigitalReport
+                uint8_t port_val;
+                uint8_t port_xor = pin_state.mergeDigitalReport( 0, ( i & 1 ) ? pattern.second : pattern.first, &port_val );
+                for( uint8_t bit = 0; port_xor; ++bit, port_xor >>= 1 )
+                {
+                    if( port_xor & 0x01 ) digital_pin_updated( bit, ( ( port_val >> bit ) & 0x01 ) > 0 );
+                }
+            }
+            Benchmark::doNotOptimize( events );
+        } );
+    }
+}
+
+void
+benchmarkReadContention(
+    Benchmark::Runner &runner_,
+    bool analog_,
+    unsigned readers_
+    )
+{
+    const std::string name = std::string( analog_ ? "device/analog_read_contention/readers:" : "device/digital_read_contention/readers:" ) + std::to_string( readers_ );
+    if( !runner_.enabled( name ) ) return;
+
+    PinStateCache pin_state;
+    uint8_t message[PinStateCache::MAX_PIN_MODE_MESSAGE_SIZE];
+    for( uint8_t pin = 0; pin < 8; ++pin ) { pin_state.setPinMode( pin, PinMode::INPUT, message ); }
+    for( uint8_t pin = 14; pin < 20; ++pin ) { pin_state.setPinMode( pin, PinMode::ANALOG, message ); }
+
+    std::atomic_bool stop( false );
+    std::atomic<uint64_t> total_reads( 0 );
+
+    //the input thread applies reports as fast as it can, as it would while draining a backlog
+    std::thread writer( [ & ]() -> void {
+        uint16_t value = 0;
+        while( !stop.load( std::memory_order_relaxed ) )
+        {
+            if( analog_ )
+            {
+                pin_state.setAnalogValue( value % 6, value & 0x3FF );
+            }
+            else
+            {
+                uint8_t port_val;
+                pin_state.mergeDigitalReport( 0, static_cast<uint8_t>( value ), &port_val );
+            }
+            ++value;
+        }
+    } );
+
+    std::vector<std::thread> readers;
+    for( unsigned reader = 0; reader < readers_; ++reader )
+    {
+        readers.emplace_back( [ &, reader ]() -> void {
+            uint64_t reads = 0;
+            uint32_t sum = 0;
+            while( !stop.load( std::memory_order_relaxed ) )
+            {
+                for( int i = 0; i < 64; ++i, ++reads )
+                {
+                    //mirrors the checks analogRead and digitalRead make when no courtesy mode change is needed
+                    if( analog_ )
+                    {
+                        const uint8_t channel = static_cast<uint8_t>( ( reader + i ) % 6 );
+                        if( pin_state.pinMode( channel + 14 ) == PinMode::ANALOG ) sum += pin_state.analogValue( channel );
+                    }
+                    else
+                    {
+                        const uint8_t pin = static_cast<uint8_t>( ( reader + i ) % 8 );
+                        if( pin_state.pinMode( pin ) == PinMode::INPUT ) sum += pin_state.digitalValue( pin );
+                    }
+                }
+            }
+            Benchmark::doNotOptimize( sum );
+            total_reads += reads;
+        } );
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for( runner_.minTime() );
+    stop = true;
+    for( std::thread &reader : readers ) { reader.join(); }
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    writer.join();
+
+    runner_.report( name, 1, total_reads, 0, seconds, readers_ );
+}
+
+void
+benchmarkSnapshotContention(
+    Benchmark::Runner &runner_,
+    unsigned readers_
+    )
+{
+    const std::string name = "device/snapshot_contention/readers:" + std::to_string( readers_ );
+    if( !runner_.enabled( name ) ) return;
+
+    PinStateCache pin_state;
+
+    std::atomic_bool stop( false );
+    std::atomic<uint64_t> total_rows( 0 );
+
+    //the input thread alternates analog and digital reports
+    std::thread writer( [ & ]() -> void {
+        uint16_t value = 0;
+        while( !stop.load( std::memory_order_relaxed ) )
+        {
+            if( value & 1 )
+            {
+                pin_state.setAnalogValue( value % 6, value & 0x3FF );
+            }
+            else
+            {
+                uint8_t port_val;
+                pin_state.mergeDigitalReport( 0, static_cast<uint8_t>( value ), &port_val );
+            }
+            ++value;
+        }
+    } );
+
+    std::vector<std::thread> readers;
+    for( unsigned reader = 0; reader < readers_; ++reader )
+    {
+        readers.emplace_back( [ & ]() -> void {
+            Microsoft::Maker::RemoteWiring::Core::PinStateSnapshot snapshot;
+            uint64_t rows = 0;
+            uint32_t sum = 0;
+            while( !stop.load( std::memory_order_relaxed ) )
+            {
+                for( int i = 0; i < 64; ++i, ++rows )
+                {
+                    pin_state.snapshot( &snapshot );
+                    sum += snapshot.analog_channels[0] + snapshot.digital_ports[0];
+                }
+            }
+            Benchmark::doNotOptimize( sum );
+            total_rows += rows;
+        } );
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for( runner_.minTime() );
+    stop = true;
+    for( std::thread &reader : readers ) { reader.join(); }
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    writer.join();
+
+    runner_.report( name, 1, total_rows, 0, seconds, readers_ );
+}
+
+void
+benchmarkMetrics(
+    Benchmark::Runner &runner_
+    )
+{
+    MetricsRegistry registry;
+    Counter &counter = registry.counter( "counter" );
+    Histogram &histogram = registry.histogram( "histogram" );
+
+    //registered in roughly the numbers UwpFirmata uses, so the snapshot has a realistic amount of work to do
+    for( int i = 0; i < 32; ++i ) { registry.counter( "filler." + std::to_string( i ) ); }
+    registry.histogram( "filler" );
+
+    runner_.run( "metrics/counter_increment", 1, 0, [ & ]( uint64_t iterations_ ) {
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            counter.increment();
+        }
+        Benchmark::doNotOptimize( counter );
+    } );
+
+    runner_.run( "metrics/histogram_record", 1, 0, [ & ]( uint64_t iterations_ ) {
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            histogram.record( ( i & 0xFFFF ) * 37 );
+        }
+        Benchmark::doNotOptimize( histogram );
+    } );
+
+    runner_.run( "metrics/snapshot", 1, 0, [ & ]( uint64_t iterations_ ) {
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            MetricsSnapshot snapshot = registry.snapshot();
+            Benchmark::doNotOptimize( snapshot.counters[0].second );
+        }
+    } );
+}
+
+void
+benchmarkSampleHistory(
+    Benchmark::Runner &runner_
+    )
+{
+    SampleHistory history( PinStateCache::MAX_ANALOG_PINS );
+    history.enable( 0, 1024 );
+    Sample samples[256];
+
+    //drained every 256 records so the ring never fills and every record takes the push path
+    runner_.run( "history/record", 1, 0, [ & ]( uint64_t iterations_ ) {
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            history.record( 0, static_cast<uint16_t>( i & 0x3FF ) );
+            if( ( i & 0xFF ) == 0xFF ) { history.drain( 0, samples, 256 ); }
+        }
+        Benchmark::doNotOptimize( samples[0] );
+    } );
+
+    runner_.run( "history/record_disabled", 1, 0, [ & ]( uint64_t iterations_ ) {
+        for( uint64_t i = 0; i < iterations_; ++i )
+        {
+            history.record( 1, static_cast<uint16_t>( i & 0x3FF ) );
+        }
+        Benchmark::doNotOptimize( history );
+    } );
+
+    const std::string name = "history/stream";
+    if( !runner_.enabled( name ) ) return;
+
+    history.enable( 0, 1024 );
+    std::atomic_bool stop( false );
+    uint64_t drained = 0;
+
+    //the app thread drains in bulk, as a logger would
+    std::thread consumer( [ & ]() -> void {
+        Sample buffer[256];
+        uint32_t sum = 0;
+        while( !stop.load( std::memory_order_relaxed ) )
+        {
+            const size_t count = history.drain( 0, buffer, 256 );
+            for( size_t i = 0; i < count; ++i ) { sum += buffer[i].value; }
+            drained += count;
+        }
+        drained += history.drain( 0, buffer, 256 );
+        Benchmark::doNotOptimize( sum );
+    } );
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + runner_.minTime();
+    uint64_t recorded = 0;
+    while( std::chrono::steady_clock::now() < deadline )
+    {
+        for( int i = 0; i < 256; ++i, ++recorded )
+        {
+            history.record( 0, static_cast<uint16_t>( recorded & 0x3FF ) );
+        }
+
+        //a board delivers reports in bursts of one read; give the consumer a chance to keep up between them
+        std::this_thread::yield();
+    }
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    stop = true;
+    consumer.join();
+
+    //an item is a sample delivered to the consumer, samples dropped because the ring was full are reported separately
+    Benchmark::Metrics metrics = {
+        { "recorded", static_cast<double>( recorded ) },
+        { "overruns", static_cast<double>( history.overruns() ) },
+    };
+    runner_.report( name, 1, drained, 0, seconds, 2, metrics );
+}
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    Benchmark::Runner runner( argc, argv );
+
+    benchmarkParser( runner, "parser/analog", CorpusKind::ANALOG );
+    benchmarkParser( runner, "parser/digital", CorpusKind::DIGITAL );
+    benchmarkParser( runner, "parser/sysex_i2c_reply", CorpusKind::SYSEX );
+    benchmarkParser( runner, "parser/mixed", CorpusKind::MIXED );
+
+    for( size_t size : { 8, 32, 256, 4096 } )
+    {
+        benchmarkCodec( runner, size );
+    }
+
+    benchmarkCapabilities( runner );
+    benchmarkDigitalFanout( runner );
+
+    for( unsigned readers : { 1, 2, 4 } )
+    {
+        benchmarkReadContention( runner, true, readers );
+        benchmarkReadContention( runner, false, readers );
+        benchmarkSnapshotContention( runner, readers );
+    }
+
+    benchmarkMetrics( runner );
+    benchmarkSampleHistory( runner );
+
+    return runner.finish( "hot_path_benchmarks" );
+}
@@ -0,0 +1,187 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * Throughput of the bulk 7-bit codec in Firmata/Core/SevenBitCodec.h against the per-byte loops it replaced:
+ * sendValueAsTwo7bitBytes (two virtual IStream::write calls per data byte), the scalar reassembleByteString
+ * loop and the byte-at-a-time masking in sendSysex.
+ *
+ * Built by the seven_bit_codec_benchmark target, run an optimized build for meaningful numbers.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "Firmata/Core/SevenBitCodec.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+//stands in for IStream, the legacy encoder paid for one virtual call per byte written
+struct ByteSink
+{
+    virtual ~ByteSink() {}
+    virtual uint16_t write( uint8_t c_ ) = 0;
+};
+
+struct VectorSink : ByteSink
+{
+    std::vector<uint8_t> bytes;
+    uint16_t write( uint8_t c_ ) override { bytes.push_back( c_ ); return 1; }
+};
+
+void
+legacyEncode(
+    ByteSink &sink_,
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    for( size_t i = 0; i < length_; ++i )
+    {
+        uint16_t value = data_[i];
+        sink_.write( value & 0x7F );
+        sink_.write( ( value >> 7 ) & 0x7F );
+    }
+}
+
+void
+legacyReassemble(
+    uint8_t *byte_string_,
+    size_t length_
+    )
+{
+    size_t i, j;
+    for( i = 0, j = 0; j < length_ - 1; ++i, j += 2 )
+    {
+        byte_string_[i] = byte_string_[j] | ( byte_string_[j + 1] << 7 );
+    }
+    byte_string_[i] = 0;
+}
+
+void
+legacyMask(
+    const uint8_t *data_,
+    size_t length_,
+    std::vector<uint8_t> &out_
+    )
+{
+    for( size_t i = 0; i < length_; ++i )
+    {
+        out_.push_back( data_[i] & 0x7F );
+    }
+}
+
+volatile uint8_t g_sink;
+
+//runs fn_ until at least a quarter of a second has passed and returns the throughput in MB/s of input
+double
+measure(
+    size_t bytes_per_call_,
+    const std::function<void( void )> &fn_
+    )
+{
+    typedef std::chrono::steady_clock clock;
+    size_t calls = 0;
+    clock::time_point start = clock::now();
+    clock::duration elapsed;
+
+    do
+    {
+        for( int i = 0; i < 64; ++i ) { fn_(); }
+        calls += 64;
+        elapsed = clock::now() - start;
+    } while( elapsed < std::chrono::milliseconds( 250 ) );
+
+    double seconds = std::chrono::duration<double>( elapsed ).count();
+    return ( static_cast<double>( calls ) * bytes_per_call_ ) / seconds / ( 1024.0 * 1024.0 );
+}
+
+void
+report(
+    const char *name_,
+    size_t size_,
+    double legacy_,
+    double bulk_
+    )
+{
+    std::printf( "%-8s %6zu bytes   legacy %9.1f MB/s   bulk %9.1f MB/s   x%.1f\n", name_, size_, legacy_, bulk_, bulk_ / legacy_ );
+}
+
+} // namespace
+
+int
+main(
+    void
+    )
+{
+#if defined(FIRMATA_CORE_X86)
+    const char *kernel = SevenBitCodec::detail::hasAvx2() ? "AVX2" : "SSE2";
+#else
+    const char *kernel = "scalar";
+#endif
+    std::printf( "SevenBitCodec throughput, %s kernels\n", kernel );
+
+    std::mt19937 rng( 42 );
+    const size_t sizes[] = { 16, 64, 256, 4096 };
+
+    for( size_t size : sizes )
+    {
+        std::vector<uint8_t> data( size );
+        for( uint8_t &b : data ) { b = static_cast<uint8_t>( rng() ); }
+
+        std::vector<uint8_t> encoded( SevenBitCodec::encodedLength( size ) );
+        SevenBitCodec::encode( data.data(), size, encoded.data() );
+
+        //encode: 8-bit data into 7-bit pairs
+        VectorSink sink;
+        sink.bytes.reserve( encoded.size() );
+        double legacy = measure( size, [ & ]() { sink.bytes.clear(); legacyEncode( sink, data.data(), size ); g_sink = sink.bytes.back(); } );
+        std::vector<uint8_t> out( encoded.size() );
+        double bulk = measure( size, [ & ]() { SevenBitCodec::encode( data.data(), size, out.data() ); g_sink = out.back(); } );
+        report( "encode", size, legacy, bulk );
+
+        //decode: 7-bit pairs back into 8-bit data, both in place on a fresh copy as the parser's buffer is read-only
+        std::vector<uint8_t> scratch( encoded.size() + 1 );
+        legacy = measure( encoded.size(), [ & ]() { std::memcpy( scratch.data(), encoded.data(), encoded.size() ); legacyReassemble( scratch.data(), encoded.size() ); g_sink = scratch[size - 1]; } );
+        bulk = measure( encoded.size(), [ & ]() { std::memcpy( scratch.data(), encoded.data(), encoded.size() ); scratch[SevenBitCodec::decode( scratch.data(), encoded.size(), scratch.data() )] = 0; g_sink = scratch[size - 1]; } );
+        report( "decode", size, legacy, bulk );
+
+        //mask: raw sysex payload bytes limited to 7 bits
+        std::vector<uint8_t> masked;
+        masked.reserve( size );
+        legacy = measure( size, [ & ]() { masked.clear(); legacyMask( data.data(), size, masked ); g_sink = masked.back(); } );
+        masked.resize( size );
+        bulk = measure( size, [ & ]() { SevenBitCodec::mask( data.data(), size, masked.data() ); g_sink = masked.back(); } );
+        report( "mask", size, legacy, bulk );
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * Drives Firmata/Core/VirtualBoard the way UwpFirmata drives a real board: enables reporting on every analog channel
+ * and digital port, starts a continuous I2C read, then parses everything the board sends for a few seconds.
+ * Reports the message rate reached and how it compares with a board on a 57600 baud line.
+ *
+ * Built by the virtual_board_benchmark target. Usage: virtual_board_benchmark [sampling interval in us] [seconds]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Firmata/Core/FirmataEncoder.h"
+#include "Firmata/Core/FirmataParser.h"
+#include "Firmata/Core/FirmataProtocol.h"
+#include "Firmata/Core/VirtualBoard.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    const long interval_us = ( argc > 1 ) ? std::atol( argv[1] ) : 100;
+    const long seconds = ( argc > 2 ) ? std::atol( argv[2] ) : 3;
+
+    VirtualBoardSettings settings;
+    settings.samplingInterval = std::chrono::microseconds( interval_us > 0 ? interval_us : 1 );
+    VirtualBoard board( settings );
+
+    for( uint8_t channel = 0; channel < settings.analogPinCount; ++channel )
+    {
+        SignalGenerator signal;
+        signal.shape = static_cast<SignalShape>( 1 + channel % 4 );
+        signal.offset = 512;
+        signal.amplitude = 511;
+        signal.period = std::chrono::milliseconds( 10 + channel );
+        signal.seed = channel;
+        board.setAnalogSignal( channel, signal );
+    }
+    for( uint8_t pin = 2; pin < settings.analogOffset; ++pin )
+    {
+        SignalGenerator signal;
+        signal.shape = SignalShape::SQUARE;
+        signal.offset = 0.5;
+        signal.amplitude = 0.5;
+        signal.period = std::chrono::milliseconds( pin );
+        board.setDigitalSignal( pin, signal );
+    }
+    const uint8_t registers[] = { 0x10, 0x20, 0x30, 0x40, 0x50, 0x60 };
+    board.setI2cRegisters( 0x68, 0x3B, registers, sizeof( registers ) );
+
+    uint64_t analog_messages = 0, digital_messages = 0, sysex_messages = 0;
+    FirmataParserHandlers handlers;
+    handlers.analogMessage = [ & ]( uint8_t, uint16_t ) -> void { ++analog_messages; };
+    handlers.digitalMessage = [ & ]( uint8_t, uint16_t ) -> void { ++digital_messages; };
+    handlers.sysexMessage = [ & ]( uint8_t, const uint8_t *, size_t ) -> void { ++sysex_messages; };
+    FirmataParser parser( handlers );
+
+    board.begin();
+
+    std::vector<uint8_t> request;
+    uint8_t message[FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE];
+    for( uint8_t pin = 2; pin < settings.analogOffset; ++pin )
+    {
+        request.insert( request.end(), message, message + FirmataEncoder::setPinMode( pin, static_cast<uint8_t>( PinMode::INPUT ), message ) );
+    }
+    for( uint8_t port = 0; port * 8 < settings.totalPins; ++port )
+    {
+        request.insert( request.end(), message, message + FirmataEncoder::reportDigitalPort( port, true, message ) );
+    }
+    for( uint8_t channel = 0; channel < settings.analogPinCount; ++channel )
+    {
+        request.insert( request.end(), message, message + FirmataEncoder::reportAnalogPin( channel, true, message ) );
+    }
+    const uint8_t i2c_read[] = { 0x68, 0x10, 0x3B, 0x00, 0x06, 0x00 };
+    const std::vector<uint8_t> i2c_request = FirmataEncoder::sysex( static_cast<uint8_t>( SysexCommand::I2C_REQUEST ), i2c_read, sizeof( i2c_read ), nullptr, 0 );
+    request.insert( request.end(), i2c_request.begin(), i2c_request.end() );
+    board.write( request.data(), request.size() );
+
+    std::vector<uint8_t> buffer( 64 * 1024 );
+    uint64_t bytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const auto stop = start + std::chrono::seconds( seconds );
+    while( std::chrono::steady_clock::now() < stop )
+    {
+        if( !board.waitForData( 10 ) ) continue;
+        const size_t count = board.readBytes( buffer.data(), buffer.size() );
+        parser.parse( buffer.data(), count );
+        bytes += count;
+    }
+    const double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    board.end();
+
+    //a 57600 baud line carries 5760 bytes per second, three bytes per channel message
+    const double messages = static_cast<double>( analog_messages + digital_messages + sysex_messages );
+    std::printf( "sampling interval %ld us over %.2f s\n", interval_us, elapsed );
+    std::printf( "  analog  %10.0f msg/s\n", analog_messages / elapsed );
+    std::printf( "  digital %10.0f msg/s\n", digital_messages / elapsed );
+    std::printf( "  sysex   %10.0f msg/s\n", sysex_messages / elapsed );
+    std::printf( "  total   %10.0f msg/s, %.2f MB/s, %.1fx a 57600 baud line\n", messages / elapsed, bytes / elapsed / 1e6, bytes / elapsed / 5760.0 );
+    std::printf( "  dropped %llu bytes\n", static_cast<unsigned long long>( board.droppedBytes() ) );
+    return 0;
+}
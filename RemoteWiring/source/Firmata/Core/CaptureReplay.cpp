@@ -0,0 +1,205 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "CaptureReplay.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+CaptureReplay::CaptureReplay(
+    double speed_
+    ) :
+    _speed( speed_ > 0.0 ? speed_ : 0.0 ),
+    _current(),
+    _current_offset( 0 ),
+    _finished( false ),
+    _running( false ),
+    _origin( 0 )
+{
+}
+
+CaptureReplay::~CaptureReplay(
+    void
+    )
+{
+    end();
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+size_t
+CaptureReplay::available(
+    void
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( !currentRecord() ) return 0;
+    if( _speed > 0.0 && dueTime( _current ) > std::chrono::steady_clock::now() ) return 0;
+    return _current.length - _current_offset;
+}
+
+bool
+CaptureReplay::begin(
+    const std::string &path_
+    )
+{
+    end();
+
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( !_file.open( path_ ) ) return false;
+
+    _reader.reset( new CaptureReader( _file.data(), _file.size() ) );
+    if( !_reader->valid() )
+    {
+        _reader.reset();
+        _file.close();
+        return false;
+    }
+
+    _current = CaptureRecord();
+    _current_offset = 0;
+    _finished = false;
+    _running = true;
+
+    //the clock starts from the first byte the board sent, rather than from whenever the capture was opened
+    _origin = currentRecord() ? _current.timestamp : std::chrono::microseconds( 0 );
+    _start_time = std::chrono::steady_clock::now();
+    return true;
+}
+
+void
+CaptureReplay::end(
+    void
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mutex );
+        _running = false;
+        _reader.reset();
+        _file.close();
+        _current = CaptureRecord();
+        _current_offset = 0;
+    }
+    _condition.notify_all();
+}
+
+bool
+CaptureReplay::finished(
+    void
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    return _finished;
+}
+
+size_t
+CaptureReplay::readBytes(
+    uint8_t *buffer_,
+    size_t length_
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    const auto now = std::chrono::steady_clock::now();
+    size_t count = 0;
+    while( count < length_ && currentRecord() )
+    {
+        if( _speed > 0.0 && dueTime( _current ) > now ) break;
+
+        const size_t chunk = std::min( length_ - count, _current.length - _current_offset );
+        std::memcpy( buffer_ + count, _current.data + _current_offset, chunk );
+        _current_offset += chunk;
+        count += chunk;
+    }
+    return count;
+}
+
+bool
+CaptureReplay::waitForData(
+    uint32_t timeout_ms_
+    )
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( timeout_ms_ );
+
+    std::unique_lock<std::mutex> lock( _mutex );
+    for( ;; )
+    {
+        if( !_running || !currentRecord() ) return false;
+        if( _speed == 0.0 ) return true;
+
+        const auto due = dueTime( _current );
+        const auto now = std::chrono::steady_clock::now();
+        if( due <= now ) return true;
+        if( now >= deadline ) return false;
+
+        _condition.wait_until( lock, std::min( due, deadline ) );
+    }
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+bool
+CaptureReplay::currentRecord(
+    void
+    )
+{
+    //move past the record once it has been read, along with anything the host sent
+    while( _current_offset >= _current.length )
+    {
+        if( !_reader || !_reader->next( _current ) )
+        {
+            _finished = _running;
+            _current = CaptureRecord();
+            _current_offset = 0;
+            return false;
+        }
+        _current_offset = 0;
+        if( _current.direction != CaptureDirection::BOARD_TO_HOST )
+        {
+            _current.length = 0;
+        }
+    }
+    return true;
+}
+
+std::chrono::steady_clock::time_point
+CaptureReplay::dueTime(
+    const CaptureRecord &record_
+    ) const
+{
+    const double offset_us = static_cast<double>( ( record_.timestamp - _origin ).count() ) / _speed;
+    return _start_time + std::chrono::microseconds( static_cast<int64_t>( offset_us ) );
+}
@@ -0,0 +1,141 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "MappedFile.h"
+#include "SessionCapture.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * Plays back the board's side of a capture. Each received chunk is released when its original timestamp, divided by
+ * the replay speed, has elapsed since begin(), so the host sees the same reads at the same pace as the recorded session.
+ * A speed of zero releases everything as fast as it is read. Bytes the host sent during the session are skipped.
+ */
+class CaptureReplay
+{
+public:
+    explicit
+    CaptureReplay(
+        double speed_ = 1.0
+    );
+
+    ~CaptureReplay(
+        void
+    );
+
+    ///<summary>
+    ///Returns the number of bytes which may be read without waiting, at least one whole chunk when any is due
+    ///</summary>
+    size_t
+    available(
+        void
+    );
+
+    ///<summary>
+    ///Maps the capture at path_ and starts the replay clock. Returns false if the file cannot be mapped or is not a capture.
+    ///</summary>
+    bool
+    begin(
+        const std::string &path_
+    );
+
+    ///<summary>
+    ///Stops the replay and unmaps the capture
+    ///</summary>
+    void
+    end(
+        void
+    );
+
+    ///<summary>
+    ///True once every byte the board sent has been read
+    ///</summary>
+    bool
+    finished(
+        void
+    );
+
+    ///<summary>
+    ///Copies up to length_ bytes which are due into buffer_ without waiting, reads may span several recorded chunks
+    ///</summary>
+    size_t
+    readBytes(
+        uint8_t *buffer_,
+        size_t length_
+    );
+
+    ///<summary>
+    ///Blocks until a chunk is due, the capture ends or the timeout elapses
+    ///</summary>
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+    );
+
+private:
+    const double _speed;
+    MappedFile _file;
+
+    //everything below is guarded by _mutex
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::unique_ptr<CaptureReader> _reader;
+    CaptureRecord _current;
+    size_t _current_offset;
+    bool _finished;
+    bool _running;
+    std::chrono::steady_clock::time_point _start_time;
+    std::chrono::microseconds _origin;
+
+    bool
+    currentRecord(
+        void
+    );
+
+    std::chrono::steady_clock::time_point
+    dueTime(
+        const CaptureRecord &record_
+    ) const;
+
+    CaptureReplay( const CaptureReplay & ) = delete;
+    CaptureReplay & operator=( const CaptureReplay & ) = delete;
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,152 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "FirmataEncoder.h"
+#include "FirmataProtocol.h"
+#include "SevenBitCodec.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+size_t
+FirmataEncoder::analogMessage(
+    uint8_t pin_,
+    uint16_t value_,
+    uint8_t *out_
+    )
+{
+    out_[0] = static_cast<uint8_t>( Command::ANALOG_MESSAGE ) | ( pin_ & 0x0F );
+    out_[1] = value_ & 0x7F;
+    out_[2] = ( value_ >> 7 ) & 0x7F;
+    return 3;
+}
+
+size_t
+FirmataEncoder::digitalMessage(
+    uint8_t port_,
+    uint8_t value_,
+    uint8_t *out_
+    )
+{
+    out_[0] = static_cast<uint8_t>( Command::DIGITAL_MESSAGE ) | ( port_ & 0x0F );
+    out_[1] = value_ & 0x7F;
+    out_[2] = value_ >> 7;
+    return 3;
+}
+
+size_t
+FirmataEncoder::protocolVersion(
+    uint8_t major_,
+    uint8_t minor_,
+    uint8_t *out_
+    )
+{
+    out_[0] = static_cast<uint8_t>( Command::PROTOCOL_VERSION );
+    out_[1] = major_ & 0x7F;
+    out_[2] = minor_ & 0x7F;
+    return 3;
+}
+
+size_t
+FirmataEncoder::reportAnalogPin(
+    uint8_t channel_,
+    bool enable_,
+    uint8_t *out_
+    )
+{
+    out_[0] = static_cast<uint8_t>( Command::REPORT_ANALOG_PIN ) | ( channel_ & 0x0F );
+    out_[1] = enable_ ? 1 : 0;
+    return 2;
+}
+
+size_t
+FirmataEncoder::reportDigitalPort(
+    uint8_t port_,
+    bool enable_,
+    uint8_t *out_
+    )
+{
+    out_[0] = static_cast<uint8_t>( Command::REPORT_DIGITAL_PIN ) | ( port_ & 0x0F );
+    out_[1] = enable_ ? 1 : 0;
+    return 2;
+}
+
+size_t
+FirmataEncoder::setPinMode(
+    uint8_t pin_,
+    uint8_t mode_,
+    uint8_t *out_
+    )
+{
+    out_[0] = static_cast<uint8_t>( Command::SET_PIN_MODE );
+    out_[1] = pin_ & 0x7F;
+    out_[2] = mode_ & 0x7F;
+    return 3;
+}
+
+size_t
+FirmataEncoder::sysex(
+    uint8_t command_,
+    const uint8_t *prefix_,
+    size_t prefix_length_,
+    const uint8_t *data_,
+    size_t data_length_,
+    uint8_t *out_
+    )
+{
+    size_t length = 0;
+    out_[length++] = static_cast<uint8_t>( Command::START_SYSEX );
+    out_[length++] = command_ & 0x7F;
+
+    if( prefix_length_ )
+    {
+        SevenBitCodec::mask( prefix_, prefix_length_, out_ + length );
+        length += prefix_length_;
+    }
+
+    if( data_length_ )
+    {
+        length += SevenBitCodec::encode( data_, data_length_, out_ + length );
+    }
+
+    out_[length++] = static_cast<uint8_t>( Command::END_SYSEX );
+    return length;
+}
+
+std::vector<uint8_t>
+FirmataEncoder::sysex(
+    uint8_t command_,
+    const uint8_t *prefix_,
+    size_t prefix_length_,
+    const uint8_t *data_,
+    size_t data_length_
+    )
+{
+    std::vector<uint8_t> message( sysexLength( prefix_length_, data_length_ ) );
+    sysex( command_, prefix_, prefix_length_, data_, data_length_, message.data() );
+    return message;
+}
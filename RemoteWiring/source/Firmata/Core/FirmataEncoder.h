@@ -0,0 +1,149 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * Builds complete Firmata messages. Fixed-length messages are written to a caller-supplied buffer, which is expected
+ * to live on the stack; sysex messages can also be built into a vector of exactly the right size.
+ * Every function returns the number of bytes written.
+ */
+namespace FirmataEncoder {
+
+//the length of the longest fixed-length message
+static const size_t MAX_CHANNEL_MESSAGE_SIZE = 3;
+
+///<summary>
+///ANALOG_MESSAGE carrying a 14-bit value for one of the first 16 pins
+///</summary>
+size_t
+analogMessage(
+    uint8_t pin_,
+    uint16_t value_,
+    uint8_t *out_
+);
+
+///<summary>
+///DIGITAL_MESSAGE carrying the values of all eight pins in a port
+///</summary>
+size_t
+digitalMessage(
+    uint8_t port_,
+    uint8_t value_,
+    uint8_t *out_
+);
+
+///<summary>
+///PROTOCOL_VERSION with the given major and minor version
+///</summary>
+size_t
+protocolVersion(
+    uint8_t major_,
+    uint8_t minor_,
+    uint8_t *out_
+);
+
+///<summary>
+///REPORT_ANALOG_PIN, enabling or disabling reporting for an analog channel
+///</summary>
+size_t
+reportAnalogPin(
+    uint8_t channel_,
+    bool enable_,
+    uint8_t *out_
+);
+
+///<summary>
+///REPORT_DIGITAL_PIN, enabling or disabling reporting for a port
+///</summary>
+size_t
+reportDigitalPort(
+    uint8_t port_,
+    bool enable_,
+    uint8_t *out_
+);
+
+///<summary>
+///SET_PIN_MODE for a single pin
+///</summary>
+size_t
+setPinMode(
+    uint8_t pin_,
+    uint8_t mode_,
+    uint8_t *out_
+);
+
+///<summary>
+///Returns the length of a sysex message with the given number of raw prefix bytes and 8-bit data bytes
+///</summary>
+inline
+size_t
+sysexLength(
+    size_t prefix_length_,
+    size_t data_length_
+    )
+{
+    return 3 + prefix_length_ + data_length_ * 2;
+}
+
+///<summary>
+///A sysex message made of raw prefix bytes, masked to 7 bits, followed by 8-bit data split into pairs of 7-bit bytes.
+///out_ must hold sysexLength( prefix_length_, data_length_ ) bytes. Either part may be empty.
+///</summary>
+size_t
+sysex(
+    uint8_t command_,
+    const uint8_t *prefix_,
+    size_t prefix_length_,
+    const uint8_t *data_,
+    size_t data_length_,
+    uint8_t *out_
+);
+
+///<summary>
+///Builds the same message as sysex() into a vector of exactly the right size
+///</summary>
+std::vector<uint8_t>
+sysex(
+    uint8_t command_,
+    const uint8_t *prefix_,
+    size_t prefix_length_,
+    const uint8_t *data_,
+    size_t data_length_
+);
+
+} // namespace FirmataEncoder
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,269 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "FirmataParser.h"
+#include "FirmataProtocol.h"
+
+#include <algorithm>
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+FirmataParser::FirmataParser(
+    const FirmataParserHandlers &handlers_,
+    size_t max_sysex_size_
+    ) :
+    _handlers( handlers_ ),
+    _state( State::IDLE ),
+    _command( 0 ),
+    _channel( 0 ),
+    _bytes_expected( 0 ),
+    _bytes_received( 0 ),
+    _sysex_buffer( max_sysex_size_ ),
+    _sysex_length( 0 )
+{
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+void
+FirmataParser::parse(
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    const uint8_t *end = data_ + length_;
+
+    for( const uint8_t *current = data_; current < end; ++current )
+    {
+        const uint8_t byte = *current;
+
+        switch( _state )
+        {
+        case State::IDLE:
+            //data bytes outside of a message are meaningless and are dropped until the next command byte
+            if( byte & 0x80 )
+            {
+                beginMessage( byte );
+            }
+            else if( _handlers.parseError )
+            {
+                _handlers.parseError( ParseError::STRAY_DATA );
+            }
+            break;
+
+        case State::CHANNEL_MESSAGE:
+            //a command byte before the message is complete means the rest of the message was lost, start over with the new command
+            if( byte & 0x80 )
+            {
+                if( _handlers.parseError ) { _handlers.parseError( ParseError::TRUNCATED_MESSAGE ); }
+                beginMessage( byte );
+                break;
+            }
+
+            _data[_bytes_received++] = byte;
+            if( _bytes_received == _bytes_expected )
+            {
+                _state = State::IDLE;
+                dispatchChannelMessage();
+            }
+            break;
+
+        case State::SYSEX:
+        {
+            if( byte == static_cast<uint8_t>( Command::END_SYSEX ) )
+            {
+                _state = State::IDLE;
+                dispatchSysexMessage();
+                break;
+            }
+
+            //sysex payloads are 7-bit, so any other command byte means the END_SYSEX was lost
+            if( byte & 0x80 )
+            {
+                if( _handlers.parseError ) { _handlers.parseError( ParseError::TRUNCATED_MESSAGE ); }
+                beginMessage( byte );
+                break;
+            }
+
+            //consume as many payload bytes as possible in one pass, since sysex messages make up the bulk of large reads
+            const uint8_t *payload_end = current;
+            while( payload_end < end && !( *payload_end & 0x80 ) ) { ++payload_end; }
+
+            size_t payload_length = payload_end - current;
+            if( _sysex_length + payload_length > _sysex_buffer.size() )
+            {
+                _state = State::SYSEX_OVERFLOW;
+                if( _handlers.parseError ) { _handlers.parseError( ParseError::SYSEX_OVERFLOW ); }
+            }
+            else
+            {
+                std::copy( current, payload_end, _sysex_buffer.begin() + _sysex_length );
+                _sysex_length += payload_length;
+            }
+
+            //the loop increment will move past the last payload byte
+            current = payload_end - 1;
+        }
+            break;
+
+        case State::SYSEX_OVERFLOW:
+            //discard the remainder of a message which does not fit in the buffer
+            if( byte == static_cast<uint8_t>( Command::END_SYSEX ) )
+            {
+                _state = State::IDLE;
+            }
+            else if( byte & 0x80 )
+            {
+                beginMessage( byte );
+            }
+            break;
+        }
+    }
+}
+
+void
+FirmataParser::reset(
+    void
+    )
+{
+    _state = State::IDLE;
+    _bytes_expected = 0;
+    _bytes_received = 0;
+    _sysex_length = 0;
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+FirmataParser::beginMessage(
+    uint8_t byte_
+    )
+{
+    /*
+     * the relevant bits in the command depends on the value of the data byte. If it is less than 0xF0 (start sysex), only the upper nibble identifies the command
+     * while the lower nibble contains additional data
+     */
+    _command = ( byte_ < static_cast<uint8_t>( Command::START_SYSEX ) ) ? ( byte_ & 0xF0 ) : byte_;
+    _channel = byte_ & 0x0F;
+    _bytes_received = 0;
+
+    switch( static_cast<Command>( _command ) )
+    {
+    default: //command not understood
+    case Command::END_SYSEX: //should never happen
+        reset();
+        if( _handlers.parseError ) { _handlers.parseError( ParseError::UNKNOWN_COMMAND ); }
+        break;
+
+        //commands that require 2 additional bytes
+    case Command::DIGITAL_MESSAGE:
+    case Command::ANALOG_MESSAGE:
+    case Command::SET_PIN_MODE:
+    case Command::PROTOCOL_VERSION:
+        _bytes_expected = 2;
+        _state = State::CHANNEL_MESSAGE;
+        break;
+
+        //commands that require 1 additional byte
+    case Command::REPORT_ANALOG_PIN:
+    case Command::REPORT_DIGITAL_PIN:
+        _bytes_expected = 1;
+        _state = State::CHANNEL_MESSAGE;
+        break;
+
+        //commands that do not require additional bytes
+    case Command::SYSTEM_RESET:
+        reset();
+        if( _handlers.systemReset ) { _handlers.systemReset(); }
+        break;
+
+    case Command::START_SYSEX:
+        //this is a special case with no set number of bytes remaining
+        _sysex_length = 0;
+        _state = State::SYSEX;
+        break;
+    }
+}
+
+void
+FirmataParser::dispatchChannelMessage(
+    void
+    )
+{
+    switch( static_cast<Command>( _command ) )
+    {
+    default:
+        break;
+
+    case Command::REPORT_ANALOG_PIN:
+        if( _handlers.reportAnalogPin ) { _handlers.reportAnalogPin( _channel, _data[0] != 0 ); }
+        break;
+
+    case Command::REPORT_DIGITAL_PIN:
+        if( _handlers.reportDigitalPort ) { _handlers.reportDigitalPort( _channel, _data[0] != 0 ); }
+        break;
+
+    case Command::SET_PIN_MODE:
+        if( _handlers.setPinMode ) { _handlers.setPinMode( _data[0], _data[1] ); }
+        break;
+
+    case Command::PROTOCOL_VERSION:
+        if( _handlers.protocolVersion ) { _handlers.protocolVersion( _data[0], _data[1] ); }
+        break;
+
+    case Command::ANALOG_MESSAGE:
+        //report analog commands store the pin number in the lower nibble of the command byte, the value is split over two 7-bit bytes
+        if( _handlers.analogMessage ) { _handlers.analogMessage( _channel, _data[0] | ( _data[1] << 7 ) ); }
+        break;
+
+    case Command::DIGITAL_MESSAGE:
+        //digital messages store the port number in the lower nibble of the command byte, the port value is split over two 7-bit bytes
+        if( _handlers.digitalMessage ) { _handlers.digitalMessage( _channel, _data[0] | ( _data[1] << 7 ) ); }
+        break;
+    }
+}
+
+void
+FirmataParser::dispatchSysexMessage(
+    void
+    )
+{
+    //a sysex message must include at least one extended-command byte
+    if( _sysex_length < 1 ) return;
+
+    if( _handlers.sysexMessage )
+    {
+        _handlers.sysexMessage( _sysex_buffer[0], _sysex_buffer.data() + 1, _sysex_length - 1 );
+    }
+}
@@ -0,0 +1,155 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+//the reasons the parser discards bytes, reported through FirmataParserHandlers::parseError
+enum class ParseError
+{
+    STRAY_DATA,         //a data byte arrived outside of any message
+    TRUNCATED_MESSAGE,  //a command byte arrived before the previous message was complete
+    UNKNOWN_COMMAND,    //a command byte which does not start any known message
+    SYSEX_OVERFLOW,     //a sysex message grew larger than the parser's buffer
+};
+
+/*
+ * The set of callbacks raised by FirmataParser as complete messages are recognized. Any handler may be left empty.
+ * Pointers handed to sysexMessage refer to the parser's own receive buffer and are only valid for the duration of the call.
+ */
+struct FirmataParserHandlers
+{
+    std::function<void( uint8_t pin_, uint16_t value_ )> analogMessage;
+    std::function<void( uint8_t port_, uint16_t value_ )> digitalMessage;
+    std::function<void( uint8_t major_, uint8_t minor_ )> protocolVersion;
+    std::function<void( uint8_t command_, const uint8_t *data_, size_t length_ )> sysexMessage;
+    std::function<void( void )> systemReset;
+
+    //raised each time bytes are discarded, once per stray byte or abandoned message
+    std::function<void( ParseError error_ )> parseError;
+
+    //messages only sent from the host to the board, used when the parser is playing the board's side
+    std::function<void( uint8_t channel_, bool enable_ )> reportAnalogPin;
+    std::function<void( uint8_t port_, bool enable_ )> reportDigitalPort;
+    std::function<void( uint8_t pin_, uint8_t mode_ )> setPinMode;
+};
+
+/*
+ * A resumable Firmata message parser. Bytes may be supplied in chunks of any size; a message which is split across
+ * several calls to parse() is completed when its remaining bytes arrive. The parser never blocks and never reads
+ * from a transport itself.
+ */
+class FirmataParser
+{
+public:
+    //the largest sysex message (excluding START_SYSEX and END_SYSEX) which will be buffered, larger messages are discarded
+    static const size_t DEFAULT_MAX_SYSEX_SIZE = 4096;
+
+    FirmataParser(
+        const FirmataParserHandlers &handlers_,
+        size_t max_sysex_size_ = DEFAULT_MAX_SYSEX_SIZE
+    );
+
+    ///<summary>
+    ///Consumes the given bytes, raising a handler for each message completed along the way.
+    ///<para>Partial messages are retained and completed by subsequent calls.</para>
+    ///</summary>
+    void
+    parse(
+        const uint8_t *data_,
+        size_t length_
+    );
+
+    ///<summary>
+    ///Returns true if the parser has consumed part of a message and is waiting for the rest of it
+    ///</summary>
+    inline
+    bool
+    isMidMessage(
+        void
+    ) const
+    {
+        return _state != State::IDLE;
+    }
+
+    ///<summary>
+    ///Discards any partially received message and returns the parser to its initial state
+    ///</summary>
+    void
+    reset(
+        void
+    );
+
+private:
+    enum class State
+    {
+        IDLE,
+        CHANNEL_MESSAGE,
+        SYSEX,
+        SYSEX_OVERFLOW,
+    };
+
+    FirmataParserHandlers _handlers;
+    State _state;
+
+    //fixed-length message state
+    uint8_t _command;
+    uint8_t _channel;
+    uint8_t _data[2];
+    size_t _bytes_expected;
+    size_t _bytes_received;
+
+    //sysex message state, the buffer is allocated once and reused for every message
+    std::vector<uint8_t> _sysex_buffer;
+    size_t _sysex_length;
+
+    void
+    beginMessage(
+        uint8_t byte_
+    );
+
+    void
+    dispatchChannelMessage(
+        void
+    );
+
+    void
+    dispatchSysexMessage(
+        void
+    );
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
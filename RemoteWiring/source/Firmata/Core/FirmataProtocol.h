@@ -0,0 +1,100 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * Native mirrors of the public Command, SysexCommand and PinMode enums. The Core classes are plain C++ and cannot depend on the
+ * Windows Runtime projections declared in UwpFirmata.h, so the wire values are duplicated here.
+ */
+enum class Command : uint8_t
+{
+    ANALOG_MESSAGE = 0xE0,
+    DIGITAL_MESSAGE = 0x90,
+    REPORT_ANALOG_PIN = 0xC0,
+    REPORT_DIGITAL_PIN = 0xD0,
+    SET_PIN_MODE = 0xF4,
+    START_SYSEX = 0xF0,
+    END_SYSEX = 0xF7,
+    PROTOCOL_VERSION = 0xF9,
+    SYSTEM_RESET = 0xFF,
+};
+
+enum class SysexCommand : uint8_t
+{
+    PULSE_IN = 0x42,    //MakeCodeFirmata only
+    DISTANCE = 0x43,    //MakeCodeFirmata only
+    PING = 0x44,        //MakeCodeFirmata only, echoed back unchanged
+    ENCODER_DATA = 0x61,
+    SERVO_CONFIG = 0x70,
+    STRING_DATA = 0x71,
+    STEPPER_DATA = 0x72,
+    ONEWIRE_DATA = 0x73,
+    SHIFT_DATA = 0x75,
+    I2C_REQUEST = 0x76,
+    I2C_REPLY = 0x77,
+    I2C_CONFIG = 0x78,
+    EXTENDED_ANALOG = 0x6F,
+    PIN_STATE_QUERY = 0x6D,
+    PIN_STATE_RESPONSE = 0x6E,
+    CAPABILITY_QUERY = 0x6B,
+    CAPABILITY_RESPONSE = 0x6C,
+    ANALOG_MAPPING_QUERY = 0x69,
+    ANALOG_MAPPING_RESPONSE = 0x6A,
+    REPORT_FIRMWARE = 0x79,
+    SAMPLING_INTERVAL = 0x7A,
+    SCHEDULER_DATA = 0x7B,
+    SYSEX_NON_REALTIME = 0x7E,
+    SYSEX_REALTIME = 0x7F,
+};
+
+//native mirror of the public RemoteWiring PinMode enum, these are the mode values carried by SET_PIN_MODE and CAPABILITY_RESPONSE
+enum class PinMode : uint8_t
+{
+    INPUT = 0x00,
+    OUTPUT = 0x01,
+    ANALOG = 0x02,
+    PWM = 0x03,
+    SERVO = 0x04,
+    SHIFT = 0x05,
+    I2C = 0x06,
+    ONEWIRE = 0x07,
+    STEPPER = 0x08,
+    ENCODER = 0x09,
+    SERIAL = 0x0A,
+    PULLUP = 0x0B,
+    IGNORED = 0x7F,
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,278 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "FirmataWriter.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+FirmataWriter::FirmataWriter(
+    const TransmitFunction &transmit_,
+    MetricsRegistry *metrics_
+    ) :
+    _transmit( transmit_ ),
+    _writer_waiting( false ),
+    _batching_enabled( false ),
+    _flush_threshold( DEFAULT_FLUSH_THRESHOLD_BYTES ),
+    _flush_deadline( 0 ),
+    _flush_requested( false ),
+    _should_exit( false ),
+    _messages_queued( nullptr ),
+    _messages_written( nullptr ),
+    _frames_transmitted( nullptr ),
+    _bytes_transmitted( nullptr ),
+    _flushes_requested( nullptr ),
+    _transmit_latency( nullptr )
+{
+    if( !metrics_ ) return;
+
+    _messages_queued = &metrics_->counter( "writer.messages_queued" );
+    _messages_written = &metrics_->counter( "writer.messages_written" );
+    _frames_transmitted = &metrics_->counter( "writer.frames" );
+    _bytes_transmitted = &metrics_->counter( "writer.bytes" );
+    _flushes_requested = &metrics_->counter( "writer.flush_requests" );
+    _transmit_latency = &metrics_->histogram( "writer.transmit_ns" );
+
+    //the depth is derived from the two counters when it is read, so queueing a message costs a single uncontended add
+    Counter *queued = _messages_queued;
+    Counter *written = _messages_written;
+    metrics_->gauge( "writer.queue_depth", [ queued, written ]() -> int64_t
+    {
+        //read the consumer side first, so a message written between the two reads cannot make the depth negative
+        uint64_t written_count = written->value();
+        return static_cast<int64_t>( queued->value() - written_count );
+    } );
+}
+
+FirmataWriter::~FirmataWriter(
+    void
+    )
+{
+    stop();
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+void
+FirmataWriter::disableBatching(
+    void
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mutex );
+        _batching_enabled = false;
+        _flush_requested = true;
+    }
+    _condition.notify_one();
+}
+
+void
+FirmataWriter::enableBatching(
+    std::chrono::microseconds flush_deadline_,
+    size_t flush_threshold_
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mutex );
+        _flush_deadline = flush_deadline_;
+        _flush_threshold = flush_threshold_ ? flush_threshold_ : 1;
+        _batching_enabled = true;
+    }
+    _condition.notify_one();
+}
+
+void
+FirmataWriter::flush(
+    void
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mutex );
+        _flush_requested = true;
+    }
+    _condition.notify_one();
+
+    if( _flushes_requested ) { _flushes_requested->increment(); }
+}
+
+void
+FirmataWriter::send(
+    const uint8_t *message_,
+    size_t length_
+    )
+{
+    if( !length_ ) return;
+    if( _messages_queued ) { _messages_queued->increment(); }
+    _queue.push( message_, length_ );
+    notifyWriter();
+}
+
+void
+FirmataWriter::send(
+    std::vector<uint8_t> &&message_
+    )
+{
+    if( message_.empty() ) return;
+    if( _messages_queued ) { _messages_queued->increment(); }
+    _queue.push( std::move( message_ ) );
+    notifyWriter();
+}
+
+void
+FirmataWriter::start(
+    void
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( _thread.joinable() ) return;
+
+    _should_exit = false;
+    _thread = std::thread( [ this ]() -> void { writerThread(); } );
+}
+
+void
+FirmataWriter::stop(
+    void
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mutex );
+        if( !_thread.joinable() ) return;
+        _should_exit = true;
+    }
+    _condition.notify_one();
+
+    _thread.join();
+    _thread = std::thread();
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+FirmataWriter::notifyWriter(
+    void
+    )
+{
+    //pairs with the fence in writerThread, either the writer sees the new message before it sleeps or we see it sleeping
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if( _writer_waiting.load( std::memory_order_relaxed ) )
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _condition.notify_one();
+    }
+}
+
+void
+FirmataWriter::transmitFrame(
+    void
+    )
+{
+    if( _frame.empty() ) return;
+
+    std::chrono::steady_clock::time_point start;
+    if( _transmit_latency ) { start = std::chrono::steady_clock::now(); }
+
+    try
+    {
+        _transmit( _frame.data(), _frame.size() );
+    }
+    catch( ... )
+    {
+        //the frame is dropped rather than retried, a failing transport reports its lost connection on its own
+    }
+
+    if( _transmit_latency )
+    {
+        _transmit_latency->record( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count() );
+        _frames_transmitted->increment();
+        _bytes_transmitted->add( _frame.size() );
+    }
+
+    _frame.clear();
+}
+
+void
+FirmataWriter::writerThread(
+    void
+    )
+{
+    bool deadline_armed = false;
+    std::chrono::steady_clock::time_point deadline;
+
+    std::unique_lock<std::mutex> lock( _mutex );
+    for( ;; )
+    {
+        bool flush_requested = _flush_requested;
+        bool should_exit = _should_exit;
+        _flush_requested = false;
+
+        //combine everything queued so far into one frame, a flush request covers every message queued before it was made
+        lock.unlock();
+        uint64_t messages = 0;
+        while( _queue.pop( _frame ) ) { ++messages; }
+        if( messages && _messages_written ) { _messages_written->add( messages ); }
+        lock.lock();
+
+        if( flush_requested || should_exit || !_batching_enabled || _frame.size() >= _flush_threshold || ( deadline_armed && std::chrono::steady_clock::now() >= deadline ) )
+        {
+            deadline_armed = false;
+            lock.unlock();
+            transmitFrame();
+            lock.lock();
+
+            if( should_exit ) break;
+        }
+        else if( !_frame.empty() && !deadline_armed )
+        {
+            //the deadline is measured from the oldest message waiting in the frame
+            deadline = std::chrono::steady_clock::now() + _flush_deadline;
+            deadline_armed = true;
+        }
+
+        //sleep until a message is queued, a flush is requested or the deadline passes
+        _writer_waiting.store( true, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        auto should_wake = [ this ]() -> bool { return _should_exit || _flush_requested || !_queue.empty(); };
+        if( deadline_armed )
+        {
+            _condition.wait_until( lock, deadline, should_wake );
+        }
+        else
+        {
+            _condition.wait( lock, should_wake );
+        }
+
+        _writer_waiting.store( false, std::memory_order_relaxed );
+    }
+}
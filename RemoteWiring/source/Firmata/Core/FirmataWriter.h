@@ -0,0 +1,178 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MessageQueue.h"
+#include "Metrics.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * Owns all outbound access to a transport. Complete messages are queued without locking by any number of threads and
+ * handed to the transmit function by a single writer thread, which combines everything queued since its last write
+ * into one frame.
+ * By default every frame is transmitted as soon as the writer picks it up. With batching enabled a frame is held until
+ * its oldest message has waited for the flush deadline or the frame reaches the flush threshold, unless flush() is called.
+ */
+class FirmataWriter
+{
+public:
+    //receives each frame on the writer thread, the pointer is only valid for the duration of the call
+    typedef std::function<void( const uint8_t *frame_, size_t length_ )> TransmitFunction;
+
+    static const size_t DEFAULT_FLUSH_THRESHOLD_BYTES = 64;
+
+    ///<summary>
+    ///When metrics_ is given, the writer registers its counters, queue depth and transmit latency under the "writer." prefix
+    ///</summary>
+    FirmataWriter(
+        const TransmitFunction &transmit_,
+        MetricsRegistry *metrics_ = nullptr
+    );
+
+    ~FirmataWriter(
+        void
+    );
+
+    ///<summary>
+    ///Stops combining messages. Whatever is waiting is sent immediately and every later frame is sent as soon as it is picked up.
+    ///</summary>
+    void
+    disableBatching(
+        void
+    );
+
+    ///<summary>
+    ///Holds frames until the oldest message has waited for flush_deadline_ or the frame reaches flush_threshold_ bytes
+    ///</summary>
+    void
+    enableBatching(
+        std::chrono::microseconds flush_deadline_,
+        size_t flush_threshold_
+    );
+
+    ///<summary>
+    ///Asks the writer to send everything queued so far without waiting for the batching deadline
+    ///</summary>
+    void
+    flush(
+        void
+    );
+
+    ///<summary>
+    ///Queues a copy of a complete message. Never blocks and may be called from any thread.
+    ///</summary>
+    void
+    send(
+        const uint8_t *message_,
+        size_t length_
+    );
+
+    ///<summary>
+    ///Queues a complete message, taking ownership of its storage. Never blocks and may be called from any thread.
+    ///</summary>
+    void
+    send(
+        std::vector<uint8_t> &&message_
+    );
+
+    ///<summary>
+    ///Starts the writer thread if it is not already running. Messages sent before this are held until it starts.
+    ///</summary>
+    void
+    start(
+        void
+    );
+
+    ///<summary>
+    ///Transmits everything already queued, then stops the writer thread
+    ///</summary>
+    void
+    stop(
+        void
+    );
+
+private:
+    TransmitFunction _transmit;
+
+    //messages waiting for the writer, and the frame they are combined into, which only the writer thread touches
+    MessageQueue _queue;
+    std::vector<uint8_t> _frame;
+
+    //everything except _writer_waiting is guarded by _mutex
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::atomic_bool _writer_waiting;
+    bool _batching_enabled;
+    size_t _flush_threshold;
+    std::chrono::microseconds _flush_deadline;
+    bool _flush_requested;
+    bool _should_exit;
+    std::thread _thread;
+
+    //optional metrics, left null when no registry was given
+    Counter *_messages_queued;
+    Counter *_messages_written;
+    Counter *_frames_transmitted;
+    Counter *_bytes_transmitted;
+    Counter *_flushes_requested;
+    Histogram *_transmit_latency;
+
+    void
+    notifyWriter(
+        void
+    );
+
+    void
+    transmitFrame(
+        void
+    );
+
+    void
+    writerThread(
+        void
+    );
+
+    FirmataWriter( const FirmataWriter & ) = delete;
+    FirmataWriter & operator=( const FirmataWriter & ) = delete;
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
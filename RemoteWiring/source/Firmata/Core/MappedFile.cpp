@@ -0,0 +1,137 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+MappedFile::MappedFile(
+    void
+    ) :
+    _data( nullptr ),
+    _size( 0 )
+#ifdef _WIN32
+    , _mapping( nullptr )
+#endif
+{
+}
+
+MappedFile::~MappedFile(
+    void
+    )
+{
+    close();
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+void
+MappedFile::close(
+    void
+    )
+{
+#ifdef _WIN32
+    if( _data ) UnmapViewOfFile( _data );
+    if( _mapping ) CloseHandle( _mapping );
+    _mapping = nullptr;
+#else
+    if( _data ) munmap( const_cast<uint8_t *>( _data ), _size );
+#endif
+    _data = nullptr;
+    _size = 0;
+}
+
+bool
+MappedFile::open(
+    const std::string &path_
+    )
+{
+    close();
+
+#ifdef _WIN32
+    //the FromApp variants are the ones available to UWP applications
+    std::wstring wide_path( MultiByteToWideChar( CP_UTF8, 0, path_.c_str(), -1, nullptr, 0 ), L'\0' );
+    MultiByteToWideChar( CP_UTF8, 0, path_.c_str(), -1, &wide_path[0], static_cast<int>( wide_path.size() ) );
+
+    HANDLE file = CreateFile2( wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr );
+    if( file == INVALID_HANDLE_VALUE ) return false;
+
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( file, &size ) || !size.QuadPart )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    //the mapping keeps its own reference to the file
+    _mapping = CreateFileMappingFromApp( file, nullptr, PAGE_READONLY, 0, nullptr );
+    CloseHandle( file );
+    if( !_mapping ) return false;
+
+    _data = static_cast<const uint8_t *>( MapViewOfFileFromApp( _mapping, FILE_MAP_READ, 0, 0 ) );
+    if( !_data )
+    {
+        close();
+        return false;
+    }
+    _size = static_cast<size_t>( size.QuadPart );
+#else
+    int fd = ::open( path_.c_str(), O_RDONLY | O_CLOEXEC );
+    if( fd < 0 ) return false;
+
+    struct stat status;
+    if( fstat( fd, &status ) || !status.st_size )
+    {
+        ::close( fd );
+        return false;
+    }
+
+    //the mapping keeps its own reference to the file
+    void *data = mmap( nullptr, static_cast<size_t>( status.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );
+    if( data == MAP_FAILED ) return false;
+
+    madvise( data, static_cast<size_t>( status.st_size ), MADV_SEQUENTIAL );
+    _data = static_cast<const uint8_t *>( data );
+    _size = static_cast<size_t>( status.st_size );
+#endif
+
+    return true;
+}
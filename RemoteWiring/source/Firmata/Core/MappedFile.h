@@ -0,0 +1,96 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * A whole file mapped read-only into memory, so a capture of any length can be replayed without being read or copied up
+ * front. Pages are loaded on first touch and the mapping is advised for sequential access where the platform allows it.
+ */
+class MappedFile
+{
+public:
+    MappedFile(
+        void
+    );
+
+    ~MappedFile(
+        void
+    );
+
+    void
+    close(
+        void
+    );
+
+    const uint8_t *
+    data(
+        void
+    ) const
+    {
+        return _data;
+    }
+
+    ///<summary>
+    ///Maps the file at path_ (UTF-8), unmapping any file already open. Returns false if the file cannot be opened or mapped.
+    ///</summary>
+    bool
+    open(
+        const std::string &path_
+    );
+
+    size_t
+    size(
+        void
+    ) const
+    {
+        return _size;
+    }
+
+private:
+    const uint8_t *_data;
+    size_t _size;
+
+#ifdef _WIN32
+    //the file mapping object, which must outlive the view
+    void *_mapping;
+#endif
+
+    MappedFile( const MappedFile & ) = delete;
+    MappedFile & operator=( const MappedFile & ) = delete;
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,126 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "MessageQueue.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+MessageQueue::MessageQueue(
+    void
+    ) :
+    _head( nullptr ),
+    _tail( new Node )
+{
+    _tail->next.store( nullptr, std::memory_order_relaxed );
+    _head.store( _tail, std::memory_order_relaxed );
+}
+
+
+//******************************************************************************
+//* Destructors
+//******************************************************************************
+
+MessageQueue::~MessageQueue(
+    void
+    )
+{
+    while( _tail != nullptr )
+    {
+        Node *next = _tail->next.load( std::memory_order_relaxed );
+        delete _tail;
+        _tail = next;
+    }
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+bool
+MessageQueue::empty(
+    void
+    ) const
+{
+    return _tail->next.load( std::memory_order_acquire ) == nullptr;
+}
+
+bool
+MessageQueue::pop(
+    std::vector<uint8_t> &buffer_
+    )
+{
+    Node *next = _tail->next.load( std::memory_order_acquire );
+    if( next == nullptr ) return false;
+
+    buffer_.insert( buffer_.end(), next->message.begin(), next->message.end() );
+
+    //the popped node becomes the new placeholder, its message is released now rather than when it is eventually deleted
+    std::vector<uint8_t>().swap( next->message );
+    delete _tail;
+    _tail = next;
+    return true;
+}
+
+void
+MessageQueue::push(
+    const uint8_t *message_,
+    size_t length_
+    )
+{
+    Node *node = new Node;
+    node->message.assign( message_, message_ + length_ );
+    pushNode( node );
+}
+
+void
+MessageQueue::push(
+    std::vector<uint8_t> &&message_
+    )
+{
+    Node *node = new Node;
+    node->message = std::move( message_ );
+    pushNode( node );
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+MessageQueue::pushNode(
+    Node *node_
+    )
+{
+    node_->next.store( nullptr, std::memory_order_relaxed );
+
+    //claiming the head orders this message after every message already pushed, linking it publishes it to the consumer
+    Node *prev = _head.exchange( node_, std::memory_order_acq_rel );
+    prev->next.store( node_, std::memory_order_release );
+}
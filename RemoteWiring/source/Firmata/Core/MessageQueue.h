@@ -0,0 +1,112 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * An unbounded multi-producer, single-consumer queue of complete, encoded messages.
+ * Any number of threads may push() concurrently without taking a lock; exactly one thread may pop(). Each message is
+ * kept whole, so a consumer which writes every popped message to a transport never interleaves bytes of two messages.
+ */
+class MessageQueue
+{
+public:
+    MessageQueue(
+        void
+    );
+
+    ~MessageQueue(
+        void
+    );
+
+    ///<summary>
+    ///Queues a copy of the given message. Safe to call from any thread.
+    ///</summary>
+    void
+    push(
+        const uint8_t *message_,
+        size_t length_
+    );
+
+    ///<summary>
+    ///Queues the given message, taking ownership of its storage. Safe to call from any thread.
+    ///</summary>
+    void
+    push(
+        std::vector<uint8_t> &&message_
+    );
+
+    ///<summary>
+    ///Appends the oldest queued message to the end of the given buffer and returns true, or returns false if the queue is empty.
+    ///<para>Must only be called from the consumer thread.</para>
+    ///</summary>
+    bool
+    pop(
+        std::vector<uint8_t> &buffer_
+    );
+
+    ///<summary>
+    ///Returns true if no message is ready to be popped. Must only be called from the consumer thread.
+    ///<para>A message whose push() is still in progress on another thread may not be visible yet.</para>
+    ///</summary>
+    bool
+    empty(
+        void
+    ) const;
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next;
+        std::vector<uint8_t> message;
+    };
+
+    //producers swap themselves in at the head, the consumer follows the links from the tail.
+    //the tail is always a node whose message has already been consumed (initially an empty placeholder).
+    std::atomic<Node *> _head;
+    Node *_tail;
+
+    void
+    pushNode(
+        Node *node_
+    );
+
+    MessageQueue( const MessageQueue & ) = delete;
+    MessageQueue & operator=( const MessageQueue & ) = delete;
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
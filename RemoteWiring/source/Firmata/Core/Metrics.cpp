@@ -0,0 +1,306 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "Metrics.h"
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+template <typename T>
+T *
+find(
+    std::vector<std::pair<std::string, std::unique_ptr<T>>> &metrics_,
+    const std::string &name_
+    )
+{
+    for( auto &metric : metrics_ )
+    {
+        if( metric.first == name_ ) return metric.second.get();
+    }
+
+    metrics_.emplace_back( name_, std::unique_ptr<T>( new T() ) );
+    return metrics_.back().second.get();
+}
+
+} // namespace
+
+
+//******************************************************************************
+//* Counter
+//******************************************************************************
+
+Counter::Counter(
+    void
+    )
+{
+    for( Shard &shard : _shards )
+    {
+        shard.value.store( 0, std::memory_order_relaxed );
+    }
+}
+
+uint64_t
+Counter::value(
+    void
+    ) const
+{
+    uint64_t total = 0;
+    for( const Shard &shard : _shards )
+    {
+        total += shard.value.load( std::memory_order_relaxed );
+    }
+    return total;
+}
+
+size_t
+Counter::nextShard(
+    void
+    )
+{
+    static std::atomic<size_t> next_shard( 0 );
+    return next_shard.fetch_add( 1, std::memory_order_relaxed ) % SHARD_COUNT;
+}
+
+
+//******************************************************************************
+//* Histogram
+//******************************************************************************
+
+Histogram::Histogram(
+    void
+    ) :
+    _sum( 0 ),
+    _max( 0 )
+{
+    for( std::atomic<uint64_t> &bucket : _buckets )
+    {
+        bucket.store( 0, std::memory_order_relaxed );
+    }
+}
+
+void
+Histogram::record(
+    uint64_t value_
+    )
+{
+    _buckets[bucketIndex( value_ )].fetch_add( 1, std::memory_order_relaxed );
+    _sum.fetch_add( value_, std::memory_order_relaxed );
+
+    //the maximum only changes while a histogram is warming up, so the exchange is rarely attempted
+    uint64_t max = _max.load( std::memory_order_relaxed );
+    while( value_ > max && !_max.compare_exchange_weak( max, value_, std::memory_order_relaxed ) );
+}
+
+HistogramSnapshot
+Histogram::snapshot(
+    void
+    ) const
+{
+    HistogramSnapshot snapshot = {};
+    std::vector<uint64_t> buckets( BUCKET_COUNT );
+
+    for( size_t i = 0; i < BUCKET_COUNT; ++i )
+    {
+        buckets[i] = _buckets[i].load( std::memory_order_relaxed );
+        snapshot.count += buckets[i];
+    }
+    snapshot.sum = _sum.load( std::memory_order_relaxed );
+    snapshot.max = _max.load( std::memory_order_relaxed );
+    if( !snapshot.count ) return snapshot;
+
+    //walk the buckets once, filling in each percentile as the running count passes its rank
+    struct { double fraction; uint64_t *value; } percentiles[] = {
+        { 0.5, &snapshot.p50 },
+        { 0.9, &snapshot.p90 },
+        { 0.99, &snapshot.p99 },
+        { 0.999, &snapshot.p999 },
+    };
+
+    size_t next = 0;
+    uint64_t seen = 0;
+    const size_t percentile_count = sizeof( percentiles ) / sizeof( percentiles[0] );
+    for( size_t i = 0; i < BUCKET_COUNT && next < percentile_count; ++i )
+    {
+        seen += buckets[i];
+        while( next < percentile_count && seen && seen >= static_cast<uint64_t>( percentiles[next].fraction * snapshot.count + 0.5 ) )
+        {
+            //a bucket's midpoint can overshoot the largest value actually recorded
+            uint64_t midpoint = bucketMidpoint( i );
+            *percentiles[next].value = ( midpoint < snapshot.max ) ? midpoint : snapshot.max;
+            ++next;
+        }
+    }
+
+    return snapshot;
+}
+
+size_t
+Histogram::bucketIndex(
+    uint64_t value_
+    )
+{
+    if( value_ < SUB_BUCKET_COUNT ) return static_cast<size_t>( value_ );
+
+    //the highest set bit picks the power of two, the next SUB_BUCKET_BITS bits pick the bucket within it
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_ARM64 ) )
+    unsigned long highest_bit;
+    _BitScanReverse64( &highest_bit, value_ );
+#elif defined( __GNUC__ )
+    unsigned highest_bit = 63 - __builtin_clzll( value_ );
+#else
+    unsigned highest_bit = 63;
+    while( !( value_ >> highest_bit ) ) { --highest_bit; }
+#endif
+
+    unsigned shift = static_cast<unsigned>( highest_bit ) - SUB_BUCKET_BITS;
+    return SUB_BUCKET_COUNT + shift * SUB_BUCKET_COUNT + static_cast<size_t>( ( value_ >> shift ) - SUB_BUCKET_COUNT );
+}
+
+uint64_t
+Histogram::bucketMidpoint(
+    size_t index_
+    )
+{
+    if( index_ < SUB_BUCKET_COUNT ) return index_;
+
+    unsigned shift = static_cast<unsigned>( ( index_ - SUB_BUCKET_COUNT ) / SUB_BUCKET_COUNT );
+    uint64_t lowest = static_cast<uint64_t>( SUB_BUCKET_COUNT + ( index_ - SUB_BUCKET_COUNT ) % SUB_BUCKET_COUNT ) << shift;
+    return lowest + ( ( static_cast<uint64_t>( 1 ) << shift ) >> 1 );
+}
+
+
+//******************************************************************************
+//* MetricsSnapshot
+//******************************************************************************
+
+std::vector<std::pair<std::string, double>>
+MetricsSnapshot::flatten(
+    void
+    ) const
+{
+    std::vector<std::pair<std::string, double>> values;
+    values.reserve( counters.size() + gauges.size() + histograms.size() * 7 );
+
+    for( const auto &counter : counters )
+    {
+        values.emplace_back( counter.first, static_cast<double>( counter.second ) );
+    }
+
+    for( const auto &gauge : gauges )
+    {
+        values.emplace_back( gauge.first, static_cast<double>( gauge.second ) );
+    }
+
+    for( const auto &histogram : histograms )
+    {
+        const HistogramSnapshot &h = histogram.second;
+        values.emplace_back( histogram.first + ".count", static_cast<double>( h.count ) );
+        values.emplace_back( histogram.first + ".mean", h.count ? static_cast<double>( h.sum ) / h.count : 0.0 );
+        values.emplace_back( histogram.first + ".p50", static_cast<double>( h.p50 ) );
+        values.emplace_back( histogram.first + ".p90", static_cast<double>( h.p90 ) );
+        values.emplace_back( histogram.first + ".p99", static_cast<double>( h.p99 ) );
+        values.emplace_back( histogram.first + ".p999", static_cast<double>( h.p999 ) );
+        values.emplace_back( histogram.first + ".max", static_cast<double>( h.max ) );
+    }
+
+    return values;
+}
+
+
+//******************************************************************************
+//* MetricsRegistry
+//******************************************************************************
+
+Counter &
+MetricsRegistry::counter(
+    const std::string &name_
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    return *find( _counters, name_ );
+}
+
+Gauge &
+MetricsRegistry::gauge(
+    const std::string &name_
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    return *find( _gauges, name_ );
+}
+
+void
+MetricsRegistry::gauge(
+    const std::string &name_,
+    const GaugeFunction &read_
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    _gauge_functions.emplace_back( name_, read_ );
+}
+
+Histogram &
+MetricsRegistry::histogram(
+    const std::string &name_
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    return *find( _histograms, name_ );
+}
+
+MetricsSnapshot
+MetricsRegistry::snapshot(
+    void
+    ) const
+{
+    MetricsSnapshot snapshot;
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    for( const auto &counter : _counters )
+    {
+        snapshot.counters.emplace_back( counter.first, counter.second->value() );
+    }
+
+    for( const auto &gauge : _gauges )
+    {
+        snapshot.gauges.emplace_back( gauge.first, gauge.second->value() );
+    }
+
+    for( const auto &gauge : _gauge_functions )
+    {
+        snapshot.gauges.emplace_back( gauge.first, gauge.second() );
+    }
+
+    for( const auto &histogram : _histograms )
+    {
+        snapshot.histograms.emplace_back( histogram.first, histogram.second->snapshot() );
+    }
+
+    return snapshot;
+}
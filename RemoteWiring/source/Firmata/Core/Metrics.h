@@ -0,0 +1,297 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * A monotonically increasing count. Every thread which touches the counter is given its own cache line to add to, so
+ * incrementing never contends with other threads; the per-thread values are only summed when the counter is read.
+ */
+class Counter
+{
+public:
+    Counter(
+        void
+    );
+
+    inline
+    void
+    add(
+        uint64_t amount_
+    )
+    {
+        _shards[threadShard()].value.fetch_add( amount_, std::memory_order_relaxed );
+    }
+
+    inline
+    void
+    increment(
+        void
+    )
+    {
+        add( 1 );
+    }
+
+    ///<summary>
+    ///Sums the per-thread shards. Concurrent increments may or may not be included.
+    ///</summary>
+    uint64_t
+    value(
+        void
+    ) const;
+
+private:
+    //threads are handed shards in turn, so sharing only begins once more threads than this have touched a counter
+    static const size_t SHARD_COUNT = 16;
+
+    struct alignas( 64 ) Shard
+    {
+        std::atomic<uint64_t> value;
+    };
+
+    Shard _shards[SHARD_COUNT];
+
+    static
+    size_t
+    nextShard(
+        void
+    );
+
+    static
+    inline
+    size_t
+    threadShard(
+        void
+    )
+    {
+        static thread_local size_t shard = nextShard();
+        return shard;
+    }
+
+    Counter( const Counter & ) = delete;
+    Counter & operator=( const Counter & ) = delete;
+};
+
+/*
+ * A value which may go up and down, such as a queue depth
+ */
+class Gauge
+{
+public:
+    Gauge(
+        void
+    ) :
+        _value( 0 )
+    {
+    }
+
+    inline
+    void
+    add(
+        int64_t amount_
+    )
+    {
+        _value.fetch_add( amount_, std::memory_order_relaxed );
+    }
+
+    inline
+    void
+    set(
+        int64_t value_
+    )
+    {
+        _value.store( value_, std::memory_order_relaxed );
+    }
+
+    inline
+    int64_t
+    value(
+        void
+    ) const
+    {
+        return _value.load( std::memory_order_relaxed );
+    }
+
+private:
+    std::atomic<int64_t> _value;
+
+    Gauge( const Gauge & ) = delete;
+    Gauge & operator=( const Gauge & ) = delete;
+};
+
+struct HistogramSnapshot
+{
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+/*
+ * A lock-free log-linear histogram of non-negative values, usually nanoseconds. Every power of two is split into 16
+ * buckets, so percentiles are reported within about 6% of the true value across the whole 64-bit range. Recording is
+ * two relaxed atomic adds in the common case and may be done from any number of threads.
+ */
+class Histogram
+{
+public:
+    Histogram(
+        void
+    );
+
+    void
+    record(
+        uint64_t value_
+    );
+
+    ///<summary>
+    ///Copies the buckets and computes the summary statistics. Values recorded during the copy may be partially included.
+    ///</summary>
+    HistogramSnapshot
+    snapshot(
+        void
+    ) const;
+
+private:
+    static const unsigned SUB_BUCKET_BITS = 4;
+    static const size_t SUB_BUCKET_COUNT = static_cast<size_t>( 1 ) << SUB_BUCKET_BITS;
+    static const size_t BUCKET_COUNT = SUB_BUCKET_COUNT + ( 64 - SUB_BUCKET_BITS ) * SUB_BUCKET_COUNT;
+
+    std::atomic<uint64_t> _buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _max;
+
+    static
+    size_t
+    bucketIndex(
+        uint64_t value_
+    );
+
+    static
+    uint64_t
+    bucketMidpoint(
+        size_t index_
+    );
+
+    Histogram( const Histogram & ) = delete;
+    Histogram & operator=( const Histogram & ) = delete;
+};
+
+/*
+ * A point-in-time copy of every metric in a registry, in registration order
+ */
+struct MetricsSnapshot
+{
+    std::vector<std::pair<std::string, uint64_t>> counters;
+    std::vector<std::pair<std::string, int64_t>> gauges;
+    std::vector<std::pair<std::string, HistogramSnapshot>> histograms;
+
+    ///<summary>
+    ///Lists every value under a single name, histograms being expanded into name.count, name.mean, name.p50 and so on.
+    ///<para>This is the shape handed out by the Windows Runtime classes, which cannot expose native structures.</para>
+    ///</summary>
+    std::vector<std::pair<std::string, double>>
+    flatten(
+        void
+    ) const;
+};
+
+/*
+ * Owns a set of named metrics. Registration takes a lock and is expected to happen while the owner is constructed; the
+ * references handed out stay valid for the life of the registry and are updated without any locking. Reading the
+ * metrics never blocks the threads updating them.
+ */
+class MetricsRegistry
+{
+public:
+    typedef std::function<int64_t( void )> GaugeFunction;
+
+    ///<summary>
+    ///Returns the counter with the given name, creating it on first use
+    ///</summary>
+    Counter &
+    counter(
+        const std::string &name_
+    );
+
+    ///<summary>
+    ///Returns the gauge with the given name, creating it on first use
+    ///</summary>
+    Gauge &
+    gauge(
+        const std::string &name_
+    );
+
+    ///<summary>
+    ///Registers a gauge whose value is computed by read_ each time a snapshot is taken, for values which already exist elsewhere
+    ///</summary>
+    void
+    gauge(
+        const std::string &name_,
+        const GaugeFunction &read_
+    );
+
+    ///<summary>
+    ///Returns the histogram with the given name, creating it on first use
+    ///</summary>
+    Histogram &
+    histogram(
+        const std::string &name_
+    );
+
+    MetricsSnapshot
+    snapshot(
+        void
+    ) const;
+
+private:
+    mutable std::mutex _mutex;
+    std::vector<std::pair<std::string, std::unique_ptr<Counter>>> _counters;
+    std::vector<std::pair<std::string, std::unique_ptr<Gauge>>> _gauges;
+    std::vector<std::pair<std::string, GaugeFunction>> _gauge_functions;
+    std::vector<std::pair<std::string, std::unique_ptr<Histogram>>> _histograms;
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,202 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "RoundTripProbe.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+RoundTripProbe::RoundTripProbe(
+    std::chrono::milliseconds timeout_
+    ) :
+    _timeout( timeout_ ),
+    _next_sequence( 0 ),
+    _window_count( 0 ),
+    _window_next( 0 ),
+    _sent( 0 ),
+    _answered( 0 ),
+    _lost( 0 ),
+    _unmatched( 0 )
+{
+    for( Outstanding &ping : _outstanding )
+    {
+        ping.pending = false;
+        ping.sequence = 0;
+    }
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+bool
+RoundTripProbe::decode(
+    const uint8_t *payload_,
+    size_t length_,
+    uint32_t *sequence_
+    )
+{
+    if( length_ != PAYLOAD_SIZE ) return false;
+
+    uint32_t sequence = 0;
+    for( size_t i = 0; i < PAYLOAD_SIZE; ++i )
+    {
+        sequence |= static_cast<uint32_t>( payload_[i] & 0x7F ) << ( 7 * i );
+    }
+
+    *sequence_ = sequence;
+    return true;
+}
+
+uint32_t
+RoundTripProbe::send(
+    std::chrono::steady_clock::time_point now_,
+    uint8_t *payload_
+    )
+{
+    uint32_t sequence;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mutex );
+        expire( now_ );
+
+        sequence = _next_sequence;
+        _next_sequence = ( _next_sequence + 1 ) & SEQUENCE_MASK;
+
+        //a slot still in use belongs to a ping MAX_OUTSTANDING sends ago, which is given up on
+        Outstanding &ping = _outstanding[sequence % MAX_OUTSTANDING];
+        if( ping.pending ) { ++_lost; }
+
+        ping.pending = true;
+        ping.sequence = sequence;
+        ping.sent_at = now_;
+        ++_sent;
+    }
+
+    for( size_t i = 0; i < PAYLOAD_SIZE; ++i )
+    {
+        payload_[i] = static_cast<uint8_t>( ( sequence >> ( 7 * i ) ) & 0x7F );
+    }
+
+    return sequence;
+}
+
+bool
+RoundTripProbe::receive(
+    uint32_t sequence_,
+    std::chrono::steady_clock::time_point now_,
+    std::chrono::nanoseconds *round_trip_
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    Outstanding &ping = _outstanding[sequence_ % MAX_OUTSTANDING];
+    if( !ping.pending || ping.sequence != sequence_ )
+    {
+        ++_unmatched;
+        return false;
+    }
+
+    ping.pending = false;
+    ++_answered;
+
+    const std::chrono::nanoseconds round_trip = std::chrono::duration_cast<std::chrono::nanoseconds>( now_ - ping.sent_at );
+    _window[_window_next] = round_trip;
+    _window_next = ( _window_next + 1 ) % WINDOW_SIZE;
+    if( _window_count < WINDOW_SIZE ) { ++_window_count; }
+
+    *round_trip_ = round_trip;
+    return true;
+}
+
+RoundTripStatistics
+RoundTripProbe::statistics(
+    std::chrono::steady_clock::time_point now_
+    )
+{
+    RoundTripStatistics statistics = {};
+    std::vector<std::chrono::nanoseconds> samples;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _mutex );
+        expire( now_ );
+
+        statistics.sent = _sent;
+        statistics.answered = _answered;
+        statistics.lost = _lost;
+        statistics.unmatched = _unmatched;
+        samples.assign( _window.begin(), _window.begin() + _window_count );
+    }
+
+    statistics.samples = samples.size();
+    if( samples.empty() ) return statistics;
+
+    std::sort( samples.begin(), samples.end() );
+
+    std::chrono::nanoseconds total( 0 );
+    for( const std::chrono::nanoseconds &sample : samples ) { total += sample; }
+
+    //nearest rank, so small windows report values which were actually measured
+    auto rank = [ &samples ]( double fraction_ ) -> std::chrono::nanoseconds
+    {
+        size_t index = static_cast<size_t>( fraction_ * samples.size() );
+        return samples[index < samples.size() ? index : samples.size() - 1];
+    };
+
+    statistics.min = samples.front();
+    statistics.mean = total / static_cast<int64_t>( samples.size() );
+    statistics.p50 = rank( 0.5 );
+    statistics.p90 = rank( 0.9 );
+    statistics.p99 = rank( 0.99 );
+    statistics.max = samples.back();
+
+    return statistics;
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+RoundTripProbe::expire(
+    std::chrono::steady_clock::time_point now_
+    )
+{
+    for( Outstanding &ping : _outstanding )
+    {
+        if( ping.pending && now_ - ping.sent_at > _timeout )
+        {
+            ping.pending = false;
+            ++_lost;
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+struct RoundTripStatistics
+{
+    uint64_t sent;          //pings sent since the probe was created
+    uint64_t answered;      //replies matched to an outstanding ping
+    uint64_t lost;          //pings which went unanswered for longer than the timeout
+    uint64_t unmatched;     //replies which did not match any outstanding ping, such as late replies to lost pings
+
+    //the distribution of the most recent round trips, up to WINDOW_SIZE of them
+    size_t samples;
+    std::chrono::nanoseconds min;
+    std::chrono::nanoseconds mean;
+    std::chrono::nanoseconds p50;
+    std::chrono::nanoseconds p90;
+    std::chrono::nanoseconds p99;
+    std::chrono::nanoseconds max;
+};
+
+/*
+ * Correlates PING sysex messages with their echoes to measure the round trip time of a live link. Each ping carries a
+ * 28-bit sequence number as four 7-bit bytes, least significant first, which the board sends back unchanged.
+ * Pings may be sent from any thread and replies are expected on the input thread, so the probe is guarded by a mutex;
+ * it is touched once per ping and once per reply, which is far too rarely for the lock to matter.
+ */
+class RoundTripProbe
+{
+public:
+    //the number of bytes following the PING command byte
+    static const size_t PAYLOAD_SIZE = 4;
+
+    //pings which may be awaiting a reply at once, sending more than this forgets the oldest and counts it as lost
+    static const size_t MAX_OUTSTANDING = 64;
+
+    //the number of recent round trips the distribution is computed over
+    static const size_t WINDOW_SIZE = 256;
+
+    ///<summary>
+    ///Pings unanswered for longer than timeout_ are counted as lost
+    ///</summary>
+    RoundTripProbe(
+        std::chrono::milliseconds timeout_ = std::chrono::milliseconds( 5000 )
+    );
+
+    ///<summary>
+    ///Reads the sequence number from a PING reply's payload. Returns false if the payload is malformed.
+    ///</summary>
+    static
+    bool
+    decode(
+        const uint8_t *payload_,
+        size_t length_,
+        uint32_t *sequence_
+    );
+
+    ///<summary>
+    ///Starts timing a new ping sent at now_, and fills payload_ with PAYLOAD_SIZE bytes to send after the PING command.
+    ///Returns the ping's sequence number.
+    ///</summary>
+    uint32_t
+    send(
+        std::chrono::steady_clock::time_point now_,
+        uint8_t *payload_
+    );
+
+    ///<summary>
+    ///Completes the ping with the given sequence number, received at now_. Returns false if no such ping is outstanding,
+    ///otherwise the round trip is added to the distribution and returned through round_trip_.
+    ///</summary>
+    bool
+    receive(
+        uint32_t sequence_,
+        std::chrono::steady_clock::time_point now_,
+        std::chrono::nanoseconds *round_trip_
+    );
+
+    ///<summary>
+    ///Counts pings outstanding for longer than the timeout as lost, then summarizes the recent round trips
+    ///</summary>
+    RoundTripStatistics
+    statistics(
+        std::chrono::steady_clock::time_point now_
+    );
+
+private:
+    static const uint32_t SEQUENCE_MASK = 0x0FFFFFFF;
+
+    struct Outstanding
+    {
+        bool pending;
+        uint32_t sequence;
+        std::chrono::steady_clock::time_point sent_at;
+    };
+
+    const std::chrono::milliseconds _timeout;
+
+    //everything below is guarded by _mutex
+    std::mutex _mutex;
+    uint32_t _next_sequence;
+    std::array<Outstanding, MAX_OUTSTANDING> _outstanding;
+    std::array<std::chrono::nanoseconds, WINDOW_SIZE> _window;
+    size_t _window_count;
+    size_t _window_next;
+    uint64_t _sent;
+    uint64_t _answered;
+    uint64_t _lost;
+    uint64_t _unmatched;
+
+    void
+    expire(
+        std::chrono::steady_clock::time_point now_
+    );
+
+    RoundTripProbe( const RoundTripProbe & ) = delete;
+    RoundTripProbe & operator=( const RoundTripProbe & ) = delete;
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,257 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "SessionCapture.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+const uint8_t CAPTURE_MAGIC[4] = { 'F', 'C', 'A', 'P' };
+const uint8_t CAPTURE_VERSION = 1;
+const size_t CAPTURE_HEADER_SIZE = 16;
+
+//the longest LEB128 encoding of a 64-bit value
+const size_t MAX_VARINT_SIZE = 10;
+
+inline
+void
+appendVarint(
+    std::vector<uint8_t> &out_,
+    uint64_t value_
+    )
+{
+    while( value_ >= 0x80 )
+    {
+        out_.push_back( static_cast<uint8_t>( value_ | 0x80 ) );
+        value_ >>= 7;
+    }
+    out_.push_back( static_cast<uint8_t>( value_ ) );
+}
+
+inline
+bool
+readVarint(
+    const uint8_t *&position_,
+    const uint8_t *end_,
+    uint64_t &value_
+    )
+{
+    value_ = 0;
+    for( unsigned shift = 0; position_ < end_ && shift < 64; shift += 7 )
+    {
+        const uint8_t byte = *position_++;
+        value_ |= static_cast<uint64_t>( byte & 0x7F ) << shift;
+        if( !( byte & 0x80 ) ) return true;
+    }
+    return false;
+}
+
+std::FILE *
+openForWriting(
+    const std::string &path_
+    )
+{
+#ifdef _WIN32
+    //paths are UTF-8, the C runtime only accepts those in their UTF-16 form
+    std::wstring wide_path( MultiByteToWideChar( CP_UTF8, 0, path_.c_str(), -1, nullptr, 0 ), L'\0' );
+    MultiByteToWideChar( CP_UTF8, 0, path_.c_str(), -1, &wide_path[0], static_cast<int>( wide_path.size() ) );
+    std::FILE *file = nullptr;
+    return ( _wfopen_s( &file, wide_path.c_str(), L"wb" ) == 0 ) ? file : nullptr;
+#else
+    return std::fopen( path_.c_str(), "wb" );
+#endif
+}
+
+} // namespace
+
+//******************************************************************************
+//* CaptureRecorder
+//******************************************************************************
+
+CaptureRecorder::CaptureRecorder(
+    void
+    ) :
+    _open( false ),
+    _file( nullptr )
+{
+}
+
+CaptureRecorder::~CaptureRecorder(
+    void
+    )
+{
+    close();
+}
+
+void
+CaptureRecorder::close(
+    void
+    )
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( !_file ) return;
+
+    _open = false;
+    writeBuffer();
+    std::fclose( _file );
+    _file = nullptr;
+}
+
+bool
+CaptureRecorder::open(
+    const std::string &path_
+    )
+{
+    close();
+
+    std::FILE *file = openForWriting( path_ );
+    if( !file ) return false;
+
+    const uint64_t start_time = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() ).count();
+    uint8_t header[CAPTURE_HEADER_SIZE] = {};
+    std::memcpy( header, CAPTURE_MAGIC, sizeof( CAPTURE_MAGIC ) );
+    header[4] = CAPTURE_VERSION;
+    for( size_t i = 0; i < 8; ++i )
+    {
+        header[8 + i] = static_cast<uint8_t>( start_time >> ( 8 * i ) );
+    }
+
+    if( std::fwrite( header, 1, sizeof( header ), file ) != sizeof( header ) )
+    {
+        std::fclose( file );
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock( _mutex );
+    _file = file;
+    _buffer.clear();
+    _buffer.reserve( WRITE_BLOCK_SIZE + MAX_VARINT_SIZE * 2 );
+    _last_record_time = std::chrono::steady_clock::now();
+    _open = true;
+    return true;
+}
+
+void
+CaptureRecorder::record(
+    CaptureDirection direction_,
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    if( !_open || !length_ ) return;
+
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( !_file ) return;
+
+    //the clock is read under the lock, so timestamps never run backwards however the callers race
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t delta = std::chrono::duration_cast<std::chrono::microseconds>( now - _last_record_time ).count();
+    _last_record_time = now;
+
+    appendVarint( _buffer, ( delta << 1 ) | static_cast<uint8_t>( direction_ ) );
+    appendVarint( _buffer, length_ );
+    _buffer.insert( _buffer.end(), data_, data_ + length_ );
+
+    if( _buffer.size() >= WRITE_BLOCK_SIZE )
+    {
+        writeBuffer();
+    }
+}
+
+void
+CaptureRecorder::writeBuffer(
+    void
+    )
+{
+    if( _buffer.empty() ) return;
+
+    //a failed write loses the block, but the records already written remain a readable capture
+    std::fwrite( _buffer.data(), 1, _buffer.size(), _file );
+    _buffer.clear();
+}
+
+//******************************************************************************
+//* CaptureReader
+//******************************************************************************
+
+CaptureReader::CaptureReader(
+    const uint8_t *capture_,
+    size_t length_
+    ) :
+    _begin( capture_ ),
+    _end( capture_ + length_ ),
+    _position( capture_ ),
+    _timestamp( 0 ),
+    _start_time( 0 ),
+    _valid( false )
+{
+    if( length_ < CAPTURE_HEADER_SIZE ) return;
+    if( std::memcmp( capture_, CAPTURE_MAGIC, sizeof( CAPTURE_MAGIC ) ) || capture_[4] != CAPTURE_VERSION ) return;
+
+    for( size_t i = 0; i < 8; ++i )
+    {
+        _start_time |= static_cast<uint64_t>( capture_[8 + i] ) << ( 8 * i );
+    }
+    _valid = true;
+    rewind();
+}
+
+bool
+CaptureReader::next(
+    CaptureRecord &record_
+    )
+{
+    if( !_valid ) return false;
+
+    const uint8_t *position = _position;
+    uint64_t tag;
+    uint64_t length;
+    if( !readVarint( position, _end, tag ) || !readVarint( position, _end, length ) ) return false;
+    if( length > static_cast<uint64_t>( _end - position ) ) return false;
+
+    _timestamp += std::chrono::microseconds( tag >> 1 );
+    record_.direction = static_cast<CaptureDirection>( tag & 0x01 );
+    record_.timestamp = _timestamp;
+    record_.data = position;
+    record_.length = static_cast<size_t>( length );
+
+    _position = position + length;
+    return true;
+}
+
+void
+CaptureReader::rewind(
+    void
+    )
+{
+    _position = _valid ? _begin + CAPTURE_HEADER_SIZE : _end;
+    _timestamp = std::chrono::microseconds( 0 );
+}
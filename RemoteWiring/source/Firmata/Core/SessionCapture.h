@@ -0,0 +1,196 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * Capture files hold every byte exchanged with a board, in the order it was seen.
+ *
+ * The file starts with a 16 byte header: the magic "FCAP", a format version byte, three reserved bytes and the wall clock
+ * time the capture started, in microseconds since the Unix epoch, as a little-endian uint64.
+ * Each record that follows is two LEB128 varints and a payload: the microseconds elapsed on a monotonic clock since the
+ * previous record shifted left by one with the direction in the low bit, then the payload length. A chunk read while a
+ * board is streaming typically costs three bytes of overhead.
+ */
+enum class CaptureDirection : uint8_t
+{
+    BOARD_TO_HOST = 0,
+    HOST_TO_BOARD = 1,
+};
+
+struct CaptureRecord
+{
+    CaptureDirection direction;
+    std::chrono::microseconds timestamp;    //since the start of the capture
+    const uint8_t *data;
+    size_t length;
+};
+
+/*
+ * Appends records to a capture file. record() may be called from any thread, typically the input thread for received
+ * chunks and the writer thread for transmitted frames, and costs a single atomic load while no capture is open.
+ */
+class CaptureRecorder
+{
+public:
+    CaptureRecorder(
+        void
+    );
+
+    ~CaptureRecorder(
+        void
+    );
+
+    ///<summary>
+    ///Writes out anything still buffered and closes the capture file
+    ///</summary>
+    void
+    close(
+        void
+    );
+
+    bool
+    isOpen(
+        void
+    ) const
+    {
+        return _open;
+    }
+
+    ///<summary>
+    ///Creates (or truncates) the capture file at path_, closing any capture already open. Returns false if the file cannot be created.
+    ///</summary>
+    bool
+    open(
+        const std::string &path_
+    );
+
+    ///<summary>
+    ///Timestamps a chunk of bytes and appends it to the capture, does nothing if no capture is open
+    ///</summary>
+    void
+    record(
+        CaptureDirection direction_,
+        const uint8_t *data_,
+        size_t length_
+    );
+
+private:
+    //records are gathered in memory and written out in blocks of roughly this size
+    static const size_t WRITE_BLOCK_SIZE = 64 * 1024;
+
+    std::atomic_bool _open;
+
+    //guards everything below, the file is also written while holding it so records can never be reordered
+    std::mutex _mutex;
+    std::FILE *_file;
+    std::vector<uint8_t> _buffer;
+    std::chrono::steady_clock::time_point _last_record_time;
+
+    void
+    writeBuffer(
+        void
+    );
+
+    CaptureRecorder( const CaptureRecorder & ) = delete;
+    CaptureRecorder & operator=( const CaptureRecorder & ) = delete;
+};
+
+/*
+ * Walks the records of a capture held in memory, usually a MappedFile. Records point into that memory, no data is copied.
+ * A record cut short at the end of the capture, as left behind by a session which did not close its capture, ends the walk.
+ */
+class CaptureReader
+{
+public:
+    CaptureReader(
+        const uint8_t *capture_,
+        size_t length_
+    );
+
+    ///<summary>
+    ///Decodes the next record, returns false once the capture is exhausted
+    ///</summary>
+    bool
+    next(
+        CaptureRecord &record_
+    );
+
+    ///<summary>
+    ///Returns to the first record
+    ///</summary>
+    void
+    rewind(
+        void
+    );
+
+    ///<summary>
+    ///Wall clock time at which the capture started, in microseconds since the Unix epoch
+    ///</summary>
+    uint64_t
+    startTime(
+        void
+    ) const
+    {
+        return _start_time;
+    }
+
+    ///<summary>
+    ///False if the memory does not begin with a capture header this reader understands
+    ///</summary>
+    bool
+    valid(
+        void
+    ) const
+    {
+        return _valid;
+    }
+
+private:
+    const uint8_t * const _begin;
+    const uint8_t * const _end;
+    const uint8_t *_position;
+    std::chrono::microseconds _timestamp;
+    uint64_t _start_time;
+    bool _valid;
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
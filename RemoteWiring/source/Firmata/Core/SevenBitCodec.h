@@ -0,0 +1,339 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define FIRMATA_CORE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(FIRMATA_CORE_X86) && ( defined(__GNUC__) || defined(__clang__) )
+#define FIRMATA_CORE_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#else
+#define FIRMATA_CORE_TARGET_AVX2
+#endif
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * Bulk conversion between 8-bit data and the pairs of 7-bit bytes Firmata uses to carry it inside sysex messages.
+ * Each data byte travels as its low seven bits followed by its high bit. The routines below process whole buffers
+ * in one pass, using AVX2 or SSE2 where the processor has them and a scalar loop everywhere else.
+ */
+namespace SevenBitCodec {
+
+namespace detail {
+
+inline
+void
+encodeScalar(
+    const uint8_t *data_,
+    size_t length_,
+    uint8_t *out_
+    )
+{
+    for( size_t i = 0; i < length_; ++i )
+    {
+        out_[i * 2] = data_[i] & 0x7F;
+        out_[i * 2 + 1] = ( data_[i] >> 7 ) & 0x7F;
+    }
+}
+
+inline
+void
+decodeScalar(
+    const uint8_t *data_,
+    size_t pairs_,
+    uint8_t *out_
+    )
+{
+    for( size_t i = 0; i < pairs_; ++i )
+    {
+        out_[i] = static_cast<uint8_t>( data_[i * 2] | ( data_[i * 2 + 1] << 7 ) );
+    }
+}
+
+inline
+void
+maskScalar(
+    const uint8_t *data_,
+    size_t length_,
+    uint8_t *out_
+    )
+{
+    for( size_t i = 0; i < length_; ++i )
+    {
+        out_[i] = data_[i] & 0x7F;
+    }
+}
+
+#ifdef FIRMATA_CORE_X86
+
+inline
+bool
+hasAvx2(
+    void
+    )
+{
+    static const bool supported = []() -> bool
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid( info, 0 );
+        if( info[0] < 7 ) return false;
+
+        //the OS must also save the upper halves of the ymm registers
+        __cpuid( info, 1 );
+        const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+        if( !osxsave || ( _xgetbv( 0 ) & 0x6 ) != 0x6 ) return false;
+
+        __cpuidex( info, 7, 0 );
+        return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+        return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+    }();
+    return supported;
+}
+
+//16 data bytes become 32 encoded bytes
+inline
+size_t
+encodeSse2(
+    const uint8_t *data_,
+    size_t length_,
+    uint8_t *out_
+    )
+{
+    const __m128i low_mask = _mm_set1_epi8( 0x7F );
+    const __m128i bit_mask = _mm_set1_epi8( 0x01 );
+
+    size_t i = 0;
+    for( ; i + 16 <= length_; i += 16 )
+    {
+        __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data_ + i ) );
+        __m128i low = _mm_and_si128( data, low_mask );
+        __m128i high = _mm_and_si128( _mm_srli_epi16( data, 7 ), bit_mask );
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( out_ + i * 2 ), _mm_unpacklo_epi8( low, high ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( out_ + i * 2 + 16 ), _mm_unpackhi_epi8( low, high ) );
+    }
+    return i;
+}
+
+//32 encoded bytes become 16 data bytes, each 16-bit lane holds one pair
+inline
+size_t
+decodeSse2(
+    const uint8_t *data_,
+    size_t pairs_,
+    uint8_t *out_
+    )
+{
+    const __m128i low_mask = _mm_set1_epi16( 0x00FF );
+    const __m128i high_bit = _mm_set1_epi16( 0x0080 );
+
+    size_t i = 0;
+    for( ; i + 16 <= pairs_; i += 16 )
+    {
+        __m128i first = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data_ + i * 2 ) );
+        __m128i second = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data_ + i * 2 + 16 ) );
+        first = _mm_or_si128( _mm_and_si128( first, low_mask ), _mm_and_si128( _mm_srli_epi16( first, 1 ), high_bit ) );
+        second = _mm_or_si128( _mm_and_si128( second, low_mask ), _mm_and_si128( _mm_srli_epi16( second, 1 ), high_bit ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( out_ + i ), _mm_packus_epi16( first, second ) );
+    }
+    return i;
+}
+
+inline
+size_t
+maskSse2(
+    const uint8_t *data_,
+    size_t length_,
+    uint8_t *out_
+    )
+{
+    const __m128i low_mask = _mm_set1_epi8( 0x7F );
+
+    size_t i = 0;
+    for( ; i + 16 <= length_; i += 16 )
+    {
+        __m128i data = _mm_loadu_si128( reinterpret_cast<const __m128i *>( data_ + i ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( out_ + i ), _mm_and_si128( data, low_mask ) );
+    }
+    return i;
+}
+
+//32 data bytes become 64 encoded bytes. unpack works within 128-bit lanes, so the halves are swapped back into order
+FIRMATA_CORE_TARGET_AVX2
+inline
+size_t
+encodeAvx2(
+    const uint8_t *data_,
+    size_t length_,
+    uint8_t *out_
+    )
+{
+    const __m256i low_mask = _mm256_set1_epi8( 0x7F );
+    const __m256i bit_mask = _mm256_set1_epi8( 0x01 );
+
+    size_t i = 0;
+    for( ; i + 32 <= length_; i += 32 )
+    {
+        __m256i data = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data_ + i ) );
+        __m256i low = _mm256_and_si256( data, low_mask );
+        __m256i high = _mm256_and_si256( _mm256_srli_epi16( data, 7 ), bit_mask );
+        __m256i lo_pairs = _mm256_unpacklo_epi8( low, high );
+        __m256i hi_pairs = _mm256_unpackhi_epi8( low, high );
+        _mm256_storeu_si256( reinterpret_cast<__m256i *>( out_ + i * 2 ), _mm256_permute2x128_si256( lo_pairs, hi_pairs, 0x20 ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i *>( out_ + i * 2 + 32 ), _mm256_permute2x128_si256( lo_pairs, hi_pairs, 0x31 ) );
+    }
+    return i;
+}
+
+//64 encoded bytes become 32 data bytes. pack works within 128-bit lanes, so the 64-bit quarters are put back into order
+FIRMATA_CORE_TARGET_AVX2
+inline
+size_t
+decodeAvx2(
+    const uint8_t *data_,
+    size_t pairs_,
+    uint8_t *out_
+    )
+{
+    const __m256i low_mask = _mm256_set1_epi16( 0x00FF );
+    const __m256i high_bit = _mm256_set1_epi16( 0x0080 );
+
+    size_t i = 0;
+    for( ; i + 32 <= pairs_; i += 32 )
+    {
+        __m256i first = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data_ + i * 2 ) );
+        __m256i second = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data_ + i * 2 + 32 ) );
+        first = _mm256_or_si256( _mm256_and_si256( first, low_mask ), _mm256_and_si256( _mm256_srli_epi16( first, 1 ), high_bit ) );
+        second = _mm256_or_si256( _mm256_and_si256( second, low_mask ), _mm256_and_si256( _mm256_srli_epi16( second, 1 ), high_bit ) );
+        __m256i packed = _mm256_permute4x64_epi64( _mm256_packus_epi16( first, second ), 0xD8 );
+        _mm256_storeu_si256( reinterpret_cast<__m256i *>( out_ + i ), packed );
+    }
+    return i;
+}
+
+#endif
+
+} // namespace detail
+
+///<summary>
+///Returns the number of bytes encode() writes for the given number of data bytes
+///</summary>
+inline
+size_t
+encodedLength(
+    size_t length_
+    )
+{
+    return length_ * 2;
+}
+
+///<summary>
+///Splits each of the given data bytes into a pair of 7-bit bytes, writing encodedLength( length_ ) bytes to out_.
+///<para>out_ must not overlap data_.</para>
+///</summary>
+inline
+size_t
+encode(
+    const uint8_t *data_,
+    size_t length_,
+    uint8_t *out_
+    )
+{
+    size_t done = 0;
+#ifdef FIRMATA_CORE_X86
+    if( detail::hasAvx2() )
+    {
+        done = detail::encodeAvx2( data_, length_, out_ );
+    }
+    done += detail::encodeSse2( data_ + done, length_ - done, out_ + done * 2 );
+#endif
+    detail::encodeScalar( data_ + done, length_ - done, out_ + done * 2 );
+    return encodedLength( length_ );
+}
+
+///<summary>
+///Reassembles pairs of 7-bit bytes into data bytes, returning the number of data bytes written to out_ (length_ / 2).
+///A trailing unpaired byte is ignored.
+///<para>out_ may be the same buffer as data_, in which case the data is decoded in place.</para>
+///</summary>
+inline
+size_t
+decode(
+    const uint8_t *data_,
+    size_t length_,
+    uint8_t *out_
+    )
+{
+    const size_t pairs = length_ / 2;
+    size_t done = 0;
+#ifdef FIRMATA_CORE_X86
+    //every block is loaded before it is stored, and the output never overtakes unread input, so decoding in place is safe
+    if( detail::hasAvx2() )
+    {
+        done = detail::decodeAvx2( data_, pairs, out_ );
+    }
+    done += detail::decodeSse2( data_ + done * 2, pairs - done, out_ + done );
+#endif
+    detail::decodeScalar( data_ + done * 2, pairs - done, out_ + done );
+    return pairs;
+}
+
+///<summary>
+///Clears the high bit of each byte, so raw data cannot be mistaken for a Firmata command. out_ may be the same buffer as data_.
+///</summary>
+inline
+void
+mask(
+    const uint8_t *data_,
+    size_t length_,
+    uint8_t *out_
+    )
+{
+    size_t done = 0;
+#ifdef FIRMATA_CORE_X86
+    done = detail::maskSse2( data_, length_, out_ );
+#endif
+    detail::maskScalar( data_ + done, length_ - done, out_ + done );
+}
+
+} // namespace SevenBitCodec
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,101 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+enum class SignalShape : uint8_t
+{
+    CONSTANT,
+    SINE,
+    SQUARE,
+    STEP,
+    NOISE,
+};
+
+/*
+ * A stimulus for a simulated input, sampled as a function of the time since the board started. Every shape is stateless,
+ * so a generator can be sampled from any thread and always produces the same value for the same instant.
+ * - CONSTANT: offset
+ * - SINE:     offset + amplitude * sin( 2 pi t / period )
+ * - SQUARE:   offset + amplitude for the first half of each period, offset - amplitude for the second half
+ * - STEP:     offset until period has elapsed, offset + amplitude afterwards
+ * - NOISE:    offset + a uniformly distributed value within +/- amplitude, redrawn every microsecond
+ */
+struct SignalGenerator
+{
+    SignalShape shape = SignalShape::CONSTANT;
+    double offset = 0.0;
+    double amplitude = 0.0;
+    std::chrono::microseconds period = std::chrono::seconds( 1 );
+    uint64_t seed = 0;
+
+    double
+    sample(
+        std::chrono::microseconds elapsed_
+        ) const
+    {
+        const double PI = 3.14159265358979323846;
+        const int64_t period_us = period.count() > 0 ? period.count() : 1;
+
+        switch( shape )
+        {
+        case SignalShape::SINE:
+            return offset + amplitude * std::sin( 2.0 * PI * static_cast<double>( elapsed_.count() % period_us ) / period_us );
+
+        case SignalShape::SQUARE:
+            return offset + ( ( elapsed_.count() % period_us ) < ( period_us / 2 ) ? amplitude : -amplitude );
+
+        case SignalShape::STEP:
+            return offset + ( elapsed_.count() >= period_us ? amplitude : 0.0 );
+
+        case SignalShape::NOISE:
+        {
+            //splitmix64 of the instant, so the noise is repeatable for a given seed
+            uint64_t z = seed + static_cast<uint64_t>( elapsed_.count() ) * 0x9E3779B97F4A7C15ULL;
+            z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+            z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+            z ^= ( z >> 31 );
+            return offset + amplitude * ( ( static_cast<double>( z >> 11 ) / 9007199254740992.0 ) * 2.0 - 1.0 );
+        }
+
+        case SignalShape::CONSTANT:
+        default:
+            return offset;
+        }
+    }
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,836 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "VirtualBoard.h"
+#include "FirmataEncoder.h"
+#include "FirmataProtocol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+//the version of the Firmata protocol implemented by the firmware's Firmata library
+const uint8_t PROTOCOL_MAJOR_VERSION = 2;
+const uint8_t PROTOCOL_MINOR_VERSION = 5;
+
+const uint16_t ANALOG_MAX_VALUE = 1023;
+const uint8_t ANALOG_RESOLUTION = 10;
+const uint8_t PWM_RESOLUTION = 8;
+const uint8_t SERVO_RESOLUTION = 14;
+const uint8_t END_OF_PIN = 0x7F;
+const uint8_t NOT_ANALOG = 0x7F;
+
+//I2C_REQUEST mode bits, as defined by the firmware
+const uint8_t I2C_WRITE = 0x00;
+const uint8_t I2C_READ = 0x08;
+const uint8_t I2C_READ_CONTINUOUSLY = 0x10;
+const uint8_t I2C_STOP_READING = 0x18;
+const uint8_t I2C_READ_WRITE_MODE_MASK = 0x18;
+const uint8_t I2C_10BIT_ADDRESS_MODE_MASK = 0x20;
+const int16_t I2C_REGISTER_NOT_SPECIFIED = -1;
+
+//the Wire library cannot return more than this many bytes from one read
+const uint16_t I2C_MAX_READ_LENGTH = 32;
+
+//DISTANCE reports the echo time in microseconds divided by this, giving inches
+const uint32_t MICROSECONDS_PER_INCH = 148;
+
+inline
+uint16_t
+modeBit(
+    PinMode mode_
+    )
+{
+    return static_cast<uint16_t>( 1 << static_cast<uint8_t>( mode_ ) );
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+VirtualBoard::VirtualBoard(
+    const VirtualBoardSettings &settings_
+    ) :
+    _settings( settings_ ),
+    _sampling_interval( settings_.samplingInterval ),
+    _start_time( std::chrono::steady_clock::now() ),
+    _sampling_should_exit( false ),
+    _out_position( 0 ),
+    _baud_rate( settings_.baudRate ),
+    _line_free_at( std::chrono::steady_clock::now() ),
+    _sent_bytes( 0 ),
+    _dropped_bytes( 0 )
+{
+    FirmataParserHandlers handlers;
+    handlers.analogMessage = [ this ]( uint8_t pin_, uint16_t value_ ) -> void { onAnalogMessage( pin_, value_ ); };
+    handlers.digitalMessage = [ this ]( uint8_t port_, uint16_t value_ ) -> void { onDigitalMessage( port_, value_ ); };
+    handlers.protocolVersion = [ this ]( uint8_t, uint8_t ) -> void {
+        const size_t offset = _message.size();
+        _message.resize( offset + FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE );
+        FirmataEncoder::protocolVersion( PROTOCOL_MAJOR_VERSION, PROTOCOL_MINOR_VERSION, _message.data() + offset );
+    };
+    handlers.sysexMessage = [ this ]( uint8_t command_, const uint8_t *data_, size_t length_ ) -> void { onSysexMessage( command_, data_, length_ ); };
+    handlers.systemReset = [ this ]() -> void { resetState(); };
+    handlers.reportAnalogPin = [ this ]( uint8_t channel_, bool enable_ ) -> void { onReportAnalogPin( channel_, enable_ ); };
+    handlers.reportDigitalPort = [ this ]( uint8_t port_, bool enable_ ) -> void { onReportDigitalPort( port_, enable_ ); };
+    handlers.setPinMode = [ this ]( uint8_t pin_, uint8_t mode_ ) -> void { onSetPinMode( pin_, mode_ ); };
+    _parser.reset( new FirmataParser( handlers ) );
+
+    //every pin is digital and can drive a servo, the rest depends on the board
+    _capabilities.fill( 0 );
+    const size_t total_pins = ( _settings.totalPins < MAX_PINS ) ? _settings.totalPins : MAX_PINS;
+    for( size_t pin = 0; pin < total_pins; ++pin )
+    {
+        _capabilities[pin] = modeBit( PinMode::INPUT ) | modeBit( PinMode::PULLUP ) | modeBit( PinMode::OUTPUT ) | modeBit( PinMode::SERVO );
+        if( pin >= _settings.analogOffset && pin < static_cast<size_t>( _settings.analogOffset ) + _settings.analogPinCount )
+        {
+            _capabilities[pin] |= modeBit( PinMode::ANALOG );
+        }
+    }
+    for( uint8_t pin : _settings.pwmPins ) { if( pin < total_pins ) _capabilities[pin] |= modeBit( PinMode::PWM ); }
+    for( uint8_t pin : _settings.i2cPins ) { if( pin < total_pins ) _capabilities[pin] |= modeBit( PinMode::I2C ); }
+
+    resetState();
+    _message.clear();
+}
+
+VirtualBoard::~VirtualBoard(
+    void
+    )
+{
+    end();
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+size_t
+VirtualBoard::available(
+    void
+    )
+{
+    std::lock_guard<std::mutex> lock( _out_mutex );
+    return releasableBytes( std::chrono::steady_clock::now() );
+}
+
+void
+VirtualBoard::begin(
+    void
+    )
+{
+    std::lock_guard<std::mutex> lock( _state_mutex );
+    if( _sampling_thread.joinable() ) return;
+
+    _start_time = std::chrono::steady_clock::now();
+    resetState();
+
+    //Firmata.begin() announces the protocol and firmware versions
+    _message.resize( FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE );
+    _message.resize( FirmataEncoder::protocolVersion( PROTOCOL_MAJOR_VERSION, PROTOCOL_MINOR_VERSION, _message.data() ) );
+    const uint8_t version[] = { _settings.firmwareVersionMajor, _settings.firmwareVersionMinor };
+    appendSysex( static_cast<uint8_t>( SysexCommand::REPORT_FIRMWARE ), version, sizeof( version ), reinterpret_cast<const uint8_t *>( _settings.firmwareName.data() ), _settings.firmwareName.length() );
+    enqueue();
+
+    _sampling_should_exit = false;
+    _sampling_thread = std::thread( [ this ]() -> void { samplingThread(); } );
+}
+
+void
+VirtualBoard::end(
+    void
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _state_mutex );
+        if( !_sampling_thread.joinable() ) return;
+        _sampling_should_exit = true;
+    }
+    _sampling_condition.notify_one();
+    _sampling_thread.join();
+    _sampling_thread = std::thread();
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _out_mutex );
+        _out.clear();
+        _out_position = 0;
+    }
+    _out_condition.notify_all();
+}
+
+size_t
+VirtualBoard::readBytes(
+    uint8_t *buffer_,
+    size_t length_
+    )
+{
+    std::lock_guard<std::mutex> lock( _out_mutex );
+
+    size_t count = std::min( length_, releasableBytes( std::chrono::steady_clock::now() ) );
+    if( !count ) return 0;
+
+    std::memcpy( buffer_, _out.data() + _out_position, count );
+    _out_position += count;
+
+    if( _baud_rate )
+    {
+        _line_free_at += std::chrono::nanoseconds( static_cast<int64_t>( count * 10 * 1000000000ULL / _baud_rate ) );
+    }
+
+    //reclaim the space of everything read so far once it makes up most of the buffer
+    if( _out_position == _out.size() )
+    {
+        _out.clear();
+        _out_position = 0;
+    }
+    else if( _out_position >= 4096 && _out_position * 2 >= _out.size() )
+    {
+        _out.erase( _out.begin(), _out.begin() + _out_position );
+        _out_position = 0;
+    }
+    return count;
+}
+
+void
+VirtualBoard::setAnalogSignal(
+    uint8_t channel_,
+    const SignalGenerator &signal_
+    )
+{
+    std::lock_guard<std::mutex> lock( _state_mutex );
+    _analog_signals[channel_] = signal_;
+}
+
+void
+VirtualBoard::setBaudRate(
+    uint32_t baud_
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _out_mutex );
+        _baud_rate = baud_;
+        _line_free_at = std::chrono::steady_clock::now();
+    }
+    _out_condition.notify_all();
+}
+
+void
+VirtualBoard::setDigitalSignal(
+    uint8_t pin_,
+    const SignalGenerator &signal_
+    )
+{
+    std::lock_guard<std::mutex> lock( _state_mutex );
+    _digital_signals[pin_] = signal_;
+}
+
+void
+VirtualBoard::setI2cRegisters(
+    uint8_t address_,
+    uint8_t register_,
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    std::lock_guard<std::mutex> lock( _state_mutex );
+    auto &registers = _i2c_registers[address_];
+    for( size_t i = 0; i < length_; ++i )
+    {
+        registers[static_cast<uint8_t>( register_ + i )] = data_[i];
+    }
+}
+
+void
+VirtualBoard::setPulseSignal(
+    uint8_t pin_,
+    const SignalGenerator &signal_
+    )
+{
+    std::lock_guard<std::mutex> lock( _state_mutex );
+    _pulse_signals[pin_] = signal_;
+}
+
+void
+VirtualBoard::setSamplingInterval(
+    std::chrono::microseconds interval_
+    )
+{
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _state_mutex );
+        _sampling_interval = std::max( interval_, std::chrono::microseconds( 1 ) );
+    }
+    _sampling_condition.notify_one();
+}
+
+bool
+VirtualBoard::waitForData(
+    uint32_t timeout_ms_
+    )
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( timeout_ms_ );
+
+    std::unique_lock<std::mutex> lock( _out_mutex );
+    for( ;; )
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if( releasableBytes( now ) ) return true;
+        if( now >= deadline ) return false;
+
+        if( _out_position == _out.size() || !_baud_rate )
+        {
+            _out_condition.wait_until( lock, deadline );
+        }
+        else
+        {
+            //data is queued but still "on the wire", sleep until its first byte has arrived
+            const auto byte_time = std::chrono::nanoseconds( 10 * 1000000000ULL / _baud_rate );
+            _out_condition.wait_until( lock, std::min( deadline, _line_free_at + byte_time ) );
+        }
+    }
+}
+
+void
+VirtualBoard::write(
+    const uint8_t *buffer_,
+    size_t length_
+    )
+{
+    std::lock_guard<std::mutex> lock( _state_mutex );
+    _parser->parse( buffer_, length_ );
+    enqueue();
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+VirtualBoard::appendSysex(
+    uint8_t command_,
+    const uint8_t *prefix_,
+    size_t prefix_length_,
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    const size_t offset = _message.size();
+    _message.resize( offset + FirmataEncoder::sysexLength( prefix_length_, length_ ) );
+    FirmataEncoder::sysex( command_, prefix_, prefix_length_, data_, length_, _message.data() + offset );
+}
+
+std::chrono::microseconds
+VirtualBoard::elapsed(
+    void
+    ) const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - _start_time );
+}
+
+void
+VirtualBoard::enqueue(
+    void
+    )
+{
+    if( _message.empty() ) return;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _out_mutex );
+        _sent_bytes += _message.size();
+
+        if( _out.size() - _out_position + _message.size() > _settings.maxBufferedBytes )
+        {
+            _dropped_bytes += _message.size();
+        }
+        else
+        {
+            //an idle line does not bank time, the first byte starts transmitting now
+            if( _out_position == _out.size() )
+            {
+                _line_free_at = std::max( _line_free_at, std::chrono::steady_clock::now() );
+            }
+            _out.insert( _out.end(), _message.begin(), _message.end() );
+        }
+    }
+    _out_condition.notify_all();
+    _message.clear();
+}
+
+void
+VirtualBoard::onAnalogMessage(
+    uint8_t pin_,
+    uint16_t value_
+    )
+{
+    if( pin_ >= _settings.totalPins || pin_ >= MAX_PINS ) return;
+
+    const PinMode mode = static_cast<PinMode>( _pin_mode[pin_] );
+    if( mode == PinMode::PWM || mode == PinMode::SERVO )
+    {
+        _pin_value[pin_] = value_;
+    }
+}
+
+void
+VirtualBoard::onDigitalMessage(
+    uint8_t port_,
+    uint16_t value_
+    )
+{
+    for( uint8_t bit = 0; bit < 8; ++bit )
+    {
+        const size_t pin = port_ * 8 + bit;
+        if( pin >= _settings.totalPins || pin >= MAX_PINS ) break;
+
+        if( _pin_mode[pin] == static_cast<uint8_t>( PinMode::OUTPUT ) )
+        {
+            _pin_value[pin] = ( value_ >> bit ) & 0x01;
+        }
+    }
+}
+
+void
+VirtualBoard::onI2cRequest(
+    const uint8_t *argv_,
+    size_t argc_
+    )
+{
+    if( argc_ < 2 ) return;
+
+    if( argv_[1] & I2C_10BIT_ADDRESS_MODE_MASK )
+    {
+        const char message[] = "10-bit addressing not supported";
+        appendSysex( static_cast<uint8_t>( SysexCommand::STRING_DATA ), nullptr, 0, reinterpret_cast<const uint8_t *>( message ), sizeof( message ) - 1 );
+        return;
+    }
+
+    const uint8_t address = argv_[0];
+    const uint8_t mode = argv_[1] & I2C_READ_WRITE_MODE_MASK;
+
+    //reads either name a register and a byte count, or only a byte count
+    int16_t reg = I2C_REGISTER_NOT_SPECIFIED;
+    uint16_t bytes = 0;
+    if( argc_ == 6 )
+    {
+        reg = static_cast<int16_t>( argv_[2] | ( argv_[3] << 7 ) );
+        bytes = argv_[4] | ( argv_[5] << 7 );
+    }
+    else if( argc_ >= 4 )
+    {
+        bytes = argv_[2] | ( argv_[3] << 7 );
+    }
+
+    switch( mode )
+    {
+    case I2C_WRITE:
+    {
+        //the first byte written selects the register, the rest are stored from there onwards
+        auto &registers = _i2c_registers[address];
+        uint8_t &pointer = _i2c_register_pointers[address];
+        for( size_t i = 2; i + 1 < argc_; i += 2 )
+        {
+            const uint8_t data = static_cast<uint8_t>( argv_[i] | ( argv_[i + 1] << 7 ) );
+            if( i == 2 )
+            {
+                pointer = data;
+            }
+            else
+            {
+                registers[pointer++] = data;
+            }
+        }
+    }
+        break;
+
+    case I2C_READ:
+        reportI2cData( address, reg, static_cast<uint8_t>( std::min( bytes, I2C_MAX_READ_LENGTH ) ) );
+        break;
+
+    case I2C_READ_CONTINUOUSLY:
+        if( _i2c_queries.size() >= MAX_I2C_QUERIES )
+        {
+            const char message[] = "too many queries";
+            appendSysex( static_cast<uint8_t>( SysexCommand::STRING_DATA ), nullptr, 0, reinterpret_cast<const uint8_t *>( message ), sizeof( message ) - 1 );
+            break;
+        }
+        _i2c_queries.push_back( { address, reg, static_cast<uint8_t>( std::min( bytes, I2C_MAX_READ_LENGTH ) ) } );
+        break;
+
+    case I2C_STOP_READING:
+        //as in the firmware, the only query or the first query for the address is removed, falling back to the first query
+        if( _i2c_queries.size() <= 1 )
+        {
+            _i2c_queries.clear();
+        }
+        else
+        {
+            auto query = std::find_if( _i2c_queries.begin(), _i2c_queries.end(), [ address ]( const I2cQuery &query_ ) -> bool { return query_.address == address; } );
+            _i2c_queries.erase( query != _i2c_queries.end() ? query : _i2c_queries.begin() );
+        }
+        break;
+    }
+}
+
+void
+VirtualBoard::onReportAnalogPin(
+    uint8_t channel_,
+    bool enable_
+    )
+{
+    if( channel_ >= _settings.analogPinCount || channel_ >= MAX_ANALOG_PINS ) return;
+
+    _report_analog[channel_] = enable_;
+
+    //the firmware sends the current value straight away, so the host does not wait a sampling interval for it
+    if( enable_ )
+    {
+        const size_t offset = _message.size();
+        _message.resize( offset + FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE );
+        FirmataEncoder::analogMessage( channel_, readAnalog( channel_ ), _message.data() + offset );
+    }
+}
+
+void
+VirtualBoard::onReportDigitalPort(
+    uint8_t port_,
+    bool enable_
+    )
+{
+    if( port_ >= MAX_PORTS || port_ * 8 >= _settings.totalPins ) return;
+
+    _report_digital[port_] = enable_;
+
+    if( enable_ )
+    {
+        _previous_port_value[port_] = readPort( port_ );
+
+        const size_t offset = _message.size();
+        _message.resize( offset + FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE );
+        FirmataEncoder::digitalMessage( port_, _previous_port_value[port_], _message.data() + offset );
+    }
+}
+
+void
+VirtualBoard::onSetPinMode(
+    uint8_t pin_,
+    uint8_t mode_
+    )
+{
+    if( pin_ >= _settings.totalPins || pin_ >= MAX_PINS || mode_ > static_cast<uint8_t>( PinMode::PULLUP ) ) return;
+    if( !( _capabilities[pin_] & modeBit( static_cast<PinMode>( mode_ ) ) ) ) return;
+
+    _pin_mode[pin_] = mode_;
+    _pin_value[pin_] = 0;
+}
+
+void
+VirtualBoard::onSysexMessage(
+    uint8_t command_,
+    const uint8_t *argv_,
+    size_t argc_
+    )
+{
+    switch( static_cast<SysexCommand>( command_ ) )
+    {
+    case SysexCommand::CAPABILITY_QUERY:
+    {
+        std::vector<uint8_t> response;
+        for( size_t pin = 0; pin < _settings.totalPins && pin < MAX_PINS; ++pin )
+        {
+            const uint16_t capabilities = _capabilities[pin];
+            const struct { PinMode mode; uint8_t resolution; } MODES[] = {
+                { PinMode::INPUT, 1 }, { PinMode::PULLUP, 1 }, { PinMode::OUTPUT, 1 }, { PinMode::ANALOG, ANALOG_RESOLUTION },
+                { PinMode::PWM, PWM_RESOLUTION }, { PinMode::SERVO, SERVO_RESOLUTION }, { PinMode::I2C, 1 },
+            };
+            for( const auto &entry : MODES )
+            {
+                if( capabilities & modeBit( entry.mode ) )
+                {
+                    response.push_back( static_cast<uint8_t>( entry.mode ) );
+                    response.push_back( entry.resolution );
+                }
+            }
+            response.push_back( END_OF_PIN );
+        }
+        appendSysex( static_cast<uint8_t>( SysexCommand::CAPABILITY_RESPONSE ), response.data(), response.size(), nullptr, 0 );
+    }
+        break;
+
+    case SysexCommand::ANALOG_MAPPING_QUERY:
+    {
+        std::vector<uint8_t> response;
+        for( size_t pin = 0; pin < _settings.totalPins && pin < MAX_PINS; ++pin )
+        {
+            response.push_back( ( _capabilities[pin] & modeBit( PinMode::ANALOG ) ) ? static_cast<uint8_t>( pin - _settings.analogOffset ) : NOT_ANALOG );
+        }
+        appendSysex( static_cast<uint8_t>( SysexCommand::ANALOG_MAPPING_RESPONSE ), response.data(), response.size(), nullptr, 0 );
+    }
+        break;
+
+    case SysexCommand::PIN_STATE_QUERY:
+        if( argc_ > 0 )
+        {
+            const uint8_t pin = argv_[0];
+            uint8_t response[5];
+            size_t length = 0;
+            response[length++] = pin;
+            if( pin < _settings.totalPins && pin < MAX_PINS )
+            {
+                const uint16_t state = _pin_value[pin];
+                response[length++] = _pin_mode[pin];
+                response[length++] = state & 0x7F;
+                if( state & 0xFF80 ) response[length++] = ( state >> 7 ) & 0x7F;
+                if( state & 0xC000 ) response[length++] = ( state >> 14 ) & 0x7F;
+            }
+            appendSysex( static_cast<uint8_t>( SysexCommand::PIN_STATE_RESPONSE ), response, length, nullptr, 0 );
+        }
+        break;
+
+    case SysexCommand::REPORT_FIRMWARE:
+    {
+        const uint8_t version[] = { _settings.firmwareVersionMajor, _settings.firmwareVersionMinor };
+        appendSysex( command_, version, sizeof( version ), reinterpret_cast<const uint8_t *>( _settings.firmwareName.data() ), _settings.firmwareName.length() );
+    }
+        break;
+
+    case SysexCommand::SAMPLING_INTERVAL:
+        if( argc_ > 1 )
+        {
+            const uint16_t interval_ms = argv_[0] | ( argv_[1] << 7 );
+            _sampling_interval = std::chrono::milliseconds( std::max<uint16_t>( interval_ms, 1 ) );
+            _sampling_condition.notify_one();
+        }
+        break;
+
+    case SysexCommand::EXTENDED_ANALOG:
+        if( argc_ > 1 )
+        {
+            uint16_t value = argv_[1];
+            if( argc_ > 2 ) value |= ( argv_[2] << 7 );
+            if( argc_ > 3 ) value |= ( argv_[3] << 14 );
+            onAnalogMessage( argv_[0], value );
+        }
+        break;
+
+    case SysexCommand::I2C_REQUEST:
+        onI2cRequest( argv_, argc_ );
+        break;
+
+    case SysexCommand::PULSE_IN:
+        if( argc_ > 0 )
+        {
+            const uint8_t pin = argv_[0];
+            onSetPinMode( pin, static_cast<uint8_t>( PinMode::INPUT ) );
+
+            //pulseIn() returns an unsigned long, sent least significant byte first
+            auto signal = _pulse_signals.find( pin );
+            const double width = ( signal != _pulse_signals.end() ) ? signal->second.sample( elapsed() ) : 0.0;
+            const uint32_t duration = width > 0.0 ? static_cast<uint32_t>( width ) : 0;
+            const uint8_t reading[] = {
+                static_cast<uint8_t>( duration ),
+                static_cast<uint8_t>( duration >> 8 ),
+                static_cast<uint8_t>( duration >> 16 ),
+                static_cast<uint8_t>( duration >> 24 )
+            };
+            appendSysex( command_, nullptr, 0, reading, sizeof( reading ) );
+        }
+        break;
+
+    case SysexCommand::DISTANCE:
+        if( argc_ > 1 )
+        {
+            const uint8_t trigger = argv_[0];
+            const uint8_t echo = argv_[1];
+            onSetPinMode( trigger, static_cast<uint8_t>( PinMode::OUTPUT ) );
+            onSetPinMode( echo, static_cast<uint8_t>( PinMode::INPUT ) );
+
+            auto signal = _pulse_signals.find( echo );
+            const double width = ( signal != _pulse_signals.end() ) ? signal->second.sample( elapsed() ) : 0.0;
+            const uint16_t distance = static_cast<uint16_t>( ( width > 0.0 ? static_cast<uint32_t>( width ) : 0 ) / MICROSECONDS_PER_INCH );
+            const uint8_t result[] = { static_cast<uint8_t>( distance ), static_cast<uint8_t>( distance >> 8 ) };
+            appendSysex( command_, nullptr, 0, result, sizeof( result ) );
+        }
+        break;
+
+    case SysexCommand::PING:
+        //echoed unchanged, as MakeCodeFirmata does
+        appendSysex( command_, argv_, argc_, nullptr, 0 );
+        break;
+
+    default:
+        break;
+    }
+}
+
+uint16_t
+VirtualBoard::readAnalog(
+    uint8_t channel_
+    ) const
+{
+    auto signal = _analog_signals.find( channel_ );
+    if( signal == _analog_signals.end() ) return 0;
+
+    const double value = std::round( signal->second.sample( elapsed() ) );
+    return static_cast<uint16_t>( std::min<double>( std::max( value, 0.0 ), ANALOG_MAX_VALUE ) );
+}
+
+uint8_t
+VirtualBoard::readPort(
+    uint8_t port_
+    ) const
+{
+    //only pins configured as inputs are reported, the rest read as zero
+    uint8_t value = 0;
+    const auto now = elapsed();
+    for( uint8_t bit = 0; bit < 8; ++bit )
+    {
+        const size_t pin = port_ * 8 + bit;
+        if( pin >= _settings.totalPins || pin >= MAX_PINS ) break;
+
+        const PinMode mode = static_cast<PinMode>( _pin_mode[pin] );
+        if( mode != PinMode::INPUT && mode != PinMode::PULLUP ) continue;
+
+        auto signal = _digital_signals.find( static_cast<uint8_t>( pin ) );
+        const bool high = ( signal != _digital_signals.end() ) ? signal->second.sample( now ) > 0.5 : ( mode == PinMode::PULLUP );
+        if( high ) value |= static_cast<uint8_t>( 1 << bit );
+    }
+    return value;
+}
+
+size_t
+VirtualBoard::releasableBytes(
+    std::chrono::steady_clock::time_point now_
+    ) const
+{
+    const size_t buffered = _out.size() - _out_position;
+    if( !_baud_rate || !buffered ) return buffered;
+
+    //bytes leave the board one character time apart, ten bits per character on an 8N1 line
+    if( now_ <= _line_free_at ) return 0;
+    const uint64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>( now_ - _line_free_at ).count();
+    const uint64_t transmitted = elapsed_ns * _baud_rate / ( 10 * 1000000000ULL );
+    return static_cast<size_t>( std::min<uint64_t>( buffered, transmitted ) );
+}
+
+void
+VirtualBoard::reportI2cData(
+    uint8_t address_,
+    int16_t register_,
+    uint8_t bytes_
+    )
+{
+    auto &registers = _i2c_registers[address_];
+    uint8_t &pointer = _i2c_register_pointers[address_];
+    if( register_ != I2C_REGISTER_NOT_SPECIFIED )
+    {
+        pointer = static_cast<uint8_t>( register_ );
+    }
+
+    //the reply carries the address, the register (zero if none was given) and the data, every byte split in two
+    uint8_t reply[2 + I2C_MAX_READ_LENGTH];
+    reply[0] = address_;
+    reply[1] = ( register_ != I2C_REGISTER_NOT_SPECIFIED ) ? static_cast<uint8_t>( register_ ) : 0;
+    for( uint8_t i = 0; i < bytes_; ++i )
+    {
+        reply[2 + i] = registers[pointer++];
+    }
+    appendSysex( static_cast<uint8_t>( SysexCommand::I2C_REPLY ), nullptr, 0, reply, 2 + bytes_ );
+}
+
+void
+VirtualBoard::resetState(
+    void
+    )
+{
+    //as in systemResetCallback(), analog pins return to analog input and every other pin to output
+    for( size_t pin = 0; pin < MAX_PINS; ++pin )
+    {
+        _pin_mode[pin] = static_cast<uint8_t>( ( _capabilities[pin] & modeBit( PinMode::ANALOG ) ) ? PinMode::ANALOG : PinMode::OUTPUT );
+    }
+    _pin_value.fill( 0 );
+    _report_analog.fill( false );
+    _report_digital.fill( false );
+    _previous_port_value.fill( 0 );
+    _i2c_queries.clear();
+}
+
+void
+VirtualBoard::samplingThread(
+    void
+    )
+{
+    std::unique_lock<std::mutex> lock( _state_mutex );
+    auto next_sample = std::chrono::steady_clock::now() + _sampling_interval;
+
+    for( ;; )
+    {
+        if( _sampling_condition.wait_until( lock, next_sample, [ this ]() -> bool { return _sampling_should_exit; } ) ) break;
+
+        for( uint8_t channel = 0; channel < _settings.analogPinCount && channel < MAX_ANALOG_PINS; ++channel )
+        {
+            const size_t pin = _settings.analogOffset + channel;
+            if( !_report_analog[channel] || pin >= MAX_PINS || _pin_mode[pin] != static_cast<uint8_t>( PinMode::ANALOG ) ) continue;
+
+            const size_t offset = _message.size();
+            _message.resize( offset + FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE );
+            FirmataEncoder::analogMessage( channel, readAnalog( channel ), _message.data() + offset );
+        }
+
+        //like outputPort(), a digital port is only reported when its value changes
+        for( uint8_t port = 0; port < MAX_PORTS && port * 8 < _settings.totalPins; ++port )
+        {
+            if( !_report_digital[port] ) continue;
+
+            const uint8_t value = readPort( port );
+            if( value == _previous_port_value[port] ) continue;
+            _previous_port_value[port] = value;
+
+            const size_t offset = _message.size();
+            _message.resize( offset + FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE );
+            FirmataEncoder::digitalMessage( port, value, _message.data() + offset );
+        }
+
+        for( const I2cQuery &query : _i2c_queries )
+        {
+            reportI2cData( query.address, query.reg, query.bytes );
+        }
+
+        enqueue();
+
+        //a sampling pass which overruns catches up as the firmware does, unless it has fallen hopelessly behind
+        const auto now = std::chrono::steady_clock::now();
+        next_sample += _sampling_interval;
+        if( now - next_sample > 10 * _sampling_interval )
+        {
+            next_sample = now + _sampling_interval;
+        }
+    }
+}
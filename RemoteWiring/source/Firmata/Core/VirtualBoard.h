@@ -0,0 +1,370 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FirmataParser.h"
+#include "SignalGenerator.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+
+/*
+ * The shape of a simulated board. The defaults describe an Arduino Uno running MakeCodeFirmata.
+ */
+struct VirtualBoardSettings
+{
+    uint8_t totalPins = 20;
+    uint8_t analogOffset = 14;
+    uint8_t analogPinCount = 6;
+    std::vector<uint8_t> pwmPins = { 3, 5, 6, 9, 10, 11 };
+    std::vector<uint8_t> i2cPins = { 18, 19 };
+
+    //the firmware samples its inputs every 19ms, but nothing stops a simulated board from sampling far faster
+    std::chrono::microseconds samplingInterval = std::chrono::milliseconds( 19 );
+
+    //bytes per second are limited to baudRate / 10, as on an 8N1 line. Zero lets the board send as fast as the host reads
+    uint32_t baudRate = 0;
+
+    //output which the host has not read yet is dropped beyond this point, as it would be by a full UART buffer
+    size_t maxBufferedBytes = 1 << 20;
+
+    std::string firmwareName = "MakeCodeFirmata.ino";
+    uint8_t firmwareVersionMajor = 2;
+    uint8_t firmwareVersionMinor = 11;
+};
+
+/*
+ * An in-process simulation of a board running BlockCode/MakeCodeFirmata. It answers capability, analog mapping, pin state
+ * and firmware queries, reports analog channels and digital ports at the sampling interval, serves I2C reads from simulated
+ * register files (once or continuously) and answers the custom PULSE_IN, DISTANCE and PING commands.
+ * Inputs are driven by SignalGenerators. The host side mirrors a transport: write() delivers the host's bytes to the board,
+ * and waitForData()/readBytes() collect what the board sends back.
+ */
+class VirtualBoard
+{
+public:
+    explicit
+    VirtualBoard(
+        const VirtualBoardSettings &settings_ = VirtualBoardSettings()
+    );
+
+    ~VirtualBoard(
+        void
+    );
+
+    ///<summary>
+    ///Returns the number of bytes the host may read now
+    ///</summary>
+    size_t
+    available(
+        void
+    );
+
+    ///<summary>
+    ///Powers the board on: reports the protocol and firmware versions, as the firmware does on start up, and starts sampling
+    ///</summary>
+    void
+    begin(
+        void
+    );
+
+    ///<summary>
+    ///The number of bytes the board has discarded because the host did not read them in time
+    ///</summary>
+    uint64_t
+    droppedBytes(
+        void
+    ) const
+    {
+        return _dropped_bytes;
+    }
+
+    ///<summary>
+    ///Stops sampling and discards any output the host has not read
+    ///</summary>
+    void
+    end(
+        void
+    );
+
+    ///<summary>
+    ///Copies up to length_ bytes of the board's output into buffer_ without waiting
+    ///</summary>
+    size_t
+    readBytes(
+        uint8_t *buffer_,
+        size_t length_
+    );
+
+    ///<summary>
+    ///The number of bytes the board has produced since it was created, including any that were dropped
+    ///</summary>
+    uint64_t
+    sentBytes(
+        void
+    ) const
+    {
+        return _sent_bytes;
+    }
+
+    ///<summary>
+    ///Drives an analog channel, the signal is rounded and clamped to the 10-bit range of the ADC
+    ///</summary>
+    void
+    setAnalogSignal(
+        uint8_t channel_,
+        const SignalGenerator &signal_
+    );
+
+    ///<summary>
+    ///Limits the board's output to baud_ / 10 bytes per second, zero removes the limit
+    ///</summary>
+    void
+    setBaudRate(
+        uint32_t baud_
+    );
+
+    ///<summary>
+    ///Drives a digital input, which reads HIGH while the signal is above 0.5
+    ///</summary>
+    void
+    setDigitalSignal(
+        uint8_t pin_,
+        const SignalGenerator &signal_
+    );
+
+    ///<summary>
+    ///Preloads the register file of a simulated I2C device, which the host's reads are served from
+    ///</summary>
+    void
+    setI2cRegisters(
+        uint8_t address_,
+        uint8_t register_,
+        const uint8_t *data_,
+        size_t length_
+    );
+
+    ///<summary>
+    ///The pulse width, in microseconds, measured by PULSE_IN and DISTANCE on the given pin
+    ///</summary>
+    void
+    setPulseSignal(
+        uint8_t pin_,
+        const SignalGenerator &signal_
+    );
+
+    ///<summary>
+    ///Changes the sampling interval, without the one millisecond granularity of the SAMPLING_INTERVAL command
+    ///</summary>
+    void
+    setSamplingInterval(
+        std::chrono::microseconds interval_
+    );
+
+    ///<summary>
+    ///Blocks until the host may read data from the board or the given timeout elapses, whichever comes first
+    ///</summary>
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+    );
+
+    ///<summary>
+    ///Delivers bytes from the host to the board, which handles every complete message before this returns
+    ///</summary>
+    void
+    write(
+        const uint8_t *buffer_,
+        size_t length_
+    );
+
+private:
+    static const size_t MAX_PINS = 128;
+    static const size_t MAX_PORTS = MAX_PINS / 8;
+    static const size_t MAX_ANALOG_PINS = 16;
+    static const size_t MAX_I2C_QUERIES = 8;
+
+    struct I2cQuery
+    {
+        uint8_t address;
+        int16_t reg;
+        uint8_t bytes;
+    };
+
+    const VirtualBoardSettings _settings;
+    std::unique_ptr<FirmataParser> _parser;
+
+    //board state, changed by the host's messages and read by the sampling thread
+    std::mutex _state_mutex;
+    std::array<uint8_t, MAX_PINS> _pin_mode;
+    std::array<uint16_t, MAX_PINS> _pin_value;
+    std::array<uint16_t, MAX_PINS> _capabilities;    //one bit per PinMode
+    std::array<bool, MAX_ANALOG_PINS> _report_analog;
+    std::array<bool, MAX_PORTS> _report_digital;
+    std::array<uint8_t, MAX_PORTS> _previous_port_value;
+    std::map<uint8_t, SignalGenerator> _analog_signals;
+    std::map<uint8_t, SignalGenerator> _digital_signals;
+    std::map<uint8_t, SignalGenerator> _pulse_signals;
+    std::map<uint8_t, std::array<uint8_t, 256>> _i2c_registers;
+    std::map<uint8_t, uint8_t> _i2c_register_pointers;
+    std::vector<I2cQuery> _i2c_queries;
+    std::chrono::microseconds _sampling_interval;
+    std::chrono::steady_clock::time_point _start_time;
+
+    //sampling thread
+    std::thread _sampling_thread;
+    std::condition_variable _sampling_condition;
+    bool _sampling_should_exit;
+
+    //output waiting for the host, released at the configured baud rate
+    std::mutex _out_mutex;
+    std::condition_variable _out_condition;
+    std::vector<uint8_t> _out;
+    size_t _out_position;
+    uint32_t _baud_rate;
+    std::chrono::steady_clock::time_point _line_free_at;
+    std::atomic<uint64_t> _sent_bytes;
+    std::atomic<uint64_t> _dropped_bytes;
+
+    //message under construction, only used while holding _state_mutex
+    std::vector<uint8_t> _message;
+
+    void
+    appendSysex(
+        uint8_t command_,
+        const uint8_t *prefix_,
+        size_t prefix_length_,
+        const uint8_t *data_,
+        size_t length_
+    );
+
+    std::chrono::microseconds
+    elapsed(
+        void
+    ) const;
+
+    void
+    enqueue(
+        void
+    );
+
+    void
+    onAnalogMessage(
+        uint8_t pin_,
+        uint16_t value_
+    );
+
+    void
+    onDigitalMessage(
+        uint8_t port_,
+        uint16_t value_
+    );
+
+    void
+    onI2cRequest(
+        const uint8_t *argv_,
+        size_t argc_
+    );
+
+    void
+    onReportAnalogPin(
+        uint8_t channel_,
+        bool enable_
+    );
+
+    void
+    onReportDigitalPort(
+        uint8_t port_,
+        bool enable_
+    );
+
+    void
+    onSetPinMode(
+        uint8_t pin_,
+        uint8_t mode_
+    );
+
+    void
+    onSysexMessage(
+        uint8_t command_,
+        const uint8_t *argv_,
+        size_t argc_
+    );
+
+    uint16_t
+    readAnalog(
+        uint8_t channel_
+    ) const;
+
+    uint8_t
+    readPort(
+        uint8_t port_
+    ) const;
+
+    size_t
+    releasableBytes(
+        std::chrono::steady_clock::time_point now_
+    ) const;
+
+    void
+    reportI2cData(
+        uint8_t address_,
+        int16_t register_,
+        uint8_t bytes_
+    );
+
+    void
+    resetState(
+        void
+    );
+
+    void
+    samplingThread(
+        void
+    );
+
+    VirtualBoard( const VirtualBoard & ) = delete;
+    VirtualBoard & operator=( const VirtualBoard & ) = delete;
+};
+
+} // namespace Core
+} // namespace Firmata
+} // namespace Maker
+} // namespace Microsoft
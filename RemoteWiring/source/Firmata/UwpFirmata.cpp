@@ -44,13 +44,29 @@ UwpFirmata::UwpFirmata(
     void
 ) :
     _data_buffer(new uint16_t[DATA_BUFFER_SIZE]),
+    _rx_buffer(RX_BUFFER_SIZE),
     _firmata_lock(_firmutex, std::defer_lock),
     _firmata_stream(nullptr),
     _connection_ready(ATOMIC_VAR_INIT(false)),
     _input_thread_should_exit(ATOMIC_VAR_INIT(false)),
+    _sysex_message_subscribers(ATOMIC_VAR_INIT(0)),
+    _i2c_reply_subscribers(ATOMIC_VAR_INIT(0)),
+    _digital_port_value_subscribers(ATOMIC_VAR_INIT(0)),
+    _analog_value_subscribers(ATOMIC_VAR_INIT(0)),
+    _ping_interval_millis(ATOMIC_VAR_INIT(0)),
     firmwareVersionMajor(0),
     firmwareVersionMinor(0)
 {
+    registerMetrics();
+
+    Core::FirmataParserHandlers handlers;
+    handlers.analogMessage = [ this ]( uint8_t pin_, uint16_t value_ ) -> void { onAnalogMessage( pin_, value_ ); };
+    handlers.digitalMessage = [ this ]( uint8_t port_, uint16_t value_ ) -> void { onDigitalMessage( port_, value_ ); };
+    handlers.protocolVersion = [ this ]( uint8_t major_, uint8_t minor_ ) -> void { onProtocolVersion( major_, minor_ ); };
+    handlers.sysexMessage = [ this ]( uint8_t command_, const uint8_t *data_, size_t length_ ) -> void { onSysexMessage( command_, data_, length_ ); };
+    handlers.parseError = [ this ]( Core::ParseError error_ ) -> void { _parse_errors[static_cast<size_t>( error_ )]->increment(); };
+    _parser.reset( new Core::FirmataParser( handlers ) );
+    _writer.reset( new Core::FirmataWriter( [ this ]( const uint8_t *frame_, size_t length_ ) -> void { transmitFrame( frame_, length_ ); }, &_metrics ) );
 }
 
 
@@ -67,6 +83,119 @@ UwpFirmata::~UwpFirmata(
 }
 
 
+//******************************************************************************
+//* Events
+//******************************************************************************
+
+Windows::Foundation::EventRegistrationToken
+UwpFirmata::DigitalPortValueUpdated::add(
+    CallbackFunction ^handler_
+    )
+{
+    ++_digital_port_value_subscribers;
+    return _digital_port_value_updated += handler_;
+}
+
+void
+UwpFirmata::DigitalPortValueUpdated::remove(
+    Windows::Foundation::EventRegistrationToken token_
+    )
+{
+    _digital_port_value_updated -= token_;
+    --_digital_port_value_subscribers;
+}
+
+void
+UwpFirmata::DigitalPortValueUpdated::raise(
+    UwpFirmata ^caller_,
+    CallbackEventArgs ^argv_
+    )
+{
+    _digital_port_value_updated( caller_, argv_ );
+}
+
+Windows::Foundation::EventRegistrationToken
+UwpFirmata::AnalogValueUpdated::add(
+    CallbackFunction ^handler_
+    )
+{
+    ++_analog_value_subscribers;
+    return _analog_value_updated += handler_;
+}
+
+void
+UwpFirmata::AnalogValueUpdated::remove(
+    Windows::Foundation::EventRegistrationToken token_
+    )
+{
+    _analog_value_updated -= token_;
+    --_analog_value_subscribers;
+}
+
+void
+UwpFirmata::AnalogValueUpdated::raise(
+    UwpFirmata ^caller_,
+    CallbackEventArgs ^argv_
+    )
+{
+    _analog_value_updated( caller_, argv_ );
+}
+
+Windows::Foundation::EventRegistrationToken
+UwpFirmata::SysexMessageReceived::add(
+    SysexCallbackFunction ^handler_
+    )
+{
+    ++_sysex_message_subscribers;
+    return _sysex_message_received += handler_;
+}
+
+void
+UwpFirmata::SysexMessageReceived::remove(
+    Windows::Foundation::EventRegistrationToken token_
+    )
+{
+    _sysex_message_received -= token_;
+    --_sysex_message_subscribers;
+}
+
+void
+UwpFirmata::SysexMessageReceived::raise(
+    UwpFirmata ^caller_,
+    SysexCallbackEventArgs ^argv_
+    )
+{
+    _sysex_message_received( caller_, argv_ );
+}
+
+Windows::Foundation::EventRegistrationToken
+UwpFirmata::I2cReplyReceived::add(
+    I2cReplyCallbackFunction ^handler_
+    )
+{
+    ++_i2c_reply_subscribers;
+    return _i2c_reply_received += handler_;
+}
+
+void
+UwpFirmata::I2cReplyReceived::remove(
+    Windows::Foundation::EventRegistrationToken token_
+    )
+{
+    _i2c_reply_received -= token_;
+    --_i2c_reply_subscribers;
+}
+
+void
+UwpFirmata::I2cReplyReceived::raise(
+    UwpFirmata ^caller_,
+    I2cCallbackEventArgs ^argv_
+    )
+{
+    _i2c_reply_received( caller_, argv_ );
+}
+
+
 //******************************************************************************
 //* Public Methods
 //******************************************************************************
@@ -88,6 +217,9 @@ UwpFirmata::begin(
 
     _firmata_stream = s_;
 
+    //the writer thread owns all outbound access to the transport from here on
+    _writer->start();
+
     //lock the IStream object to guarantee its state won't change while we check if it is already connected.
     _firmata_stream->lock();
 
@@ -123,6 +255,47 @@ UwpFirmata::connectionReady(
     return _connection_ready;
 }
 
+void
+UwpFirmata::disableBatching(
+    void
+    )
+{
+    _writer->disableBatching();
+}
+
+void
+UwpFirmata::disablePing(
+    void
+    )
+{
+    _ping_interval_millis = 0;
+}
+
+void
+UwpFirmata::enableBatching(
+    uint32_t flush_deadline_micros_
+    )
+{
+    enableBatching( flush_deadline_micros_, static_cast<uint32_t>( Core::FirmataWriter::DEFAULT_FLUSH_THRESHOLD_BYTES ) );
+}
+
+void
+UwpFirmata::enableBatching(
+    uint32_t flush_deadline_micros_,
+    uint32_t flush_threshold_bytes_
+    )
+{
+    _writer->enableBatching( std::chrono::microseconds( flush_deadline_micros_ ), flush_threshold_bytes_ );
+}
+
+void
+UwpFirmata::enablePing(
+    uint32_t interval_millis_
+    )
+{
+    _ping_interval_millis = interval_millis_ ? interval_millis_ : 1;
+}
+
 void
 UwpFirmata::finish(
     void
@@ -132,6 +305,9 @@ UwpFirmata::finish(
         std::lock_guard<std::mutex> lock( _firmutex );
         stopThreads();
 
+        //both threads have stopped, so the capture holds the whole session
+        _recorder.close();
+
         _connection_ready = false;
         _firmata_stream = nullptr;
         _data_buffer = nullptr;
@@ -150,7 +326,45 @@ UwpFirmata::flush(
     void
     )
 {
-    return _firmata_stream->flush();
+    //bytes staged by write() are queued as a single message, the caller holds lock() while composing them
+    if( !_tx_staging.empty() )
+    {
+        _writer->send( std::move( _tx_staging ) );
+        _tx_staging.clear();
+    }
+
+    _writer->flush();
+}
+
+Windows::Foundation::Collections::IMapView<String ^, double> ^
+UwpFirmata::getMetrics(
+    void
+    )
+{
+    Platform::Collections::Map<String ^, double> ^metrics = ref new Platform::Collections::Map<String ^, double>();
+
+    for( const std::pair<std::string, double> &metric : _metrics.snapshot().flatten() )
+    {
+        //metric names are plain ASCII
+        std::wstring name( metric.first.begin(), metric.first.end() );
+        metrics->Insert( ref new String( name.c_str() ), metric.second );
+    }
+
+    //the rolling distribution is computed over the most recent round trips, unlike link.rtt_ns which covers the whole session
+    Core::RoundTripStatistics round_trips = _probe.statistics( std::chrono::steady_clock::now() );
+    metrics->Insert( L"link.pings_sent", static_cast<double>( round_trips.sent ) );
+    metrics->Insert( L"link.pings_answered", static_cast<double>( round_trips.answered ) );
+    metrics->Insert( L"link.pings_lost", static_cast<double>( round_trips.lost ) );
+    metrics->Insert( L"link.pings_unmatched", static_cast<double>( round_trips.unmatched ) );
+    metrics->Insert( L"link.rtt_window_ns.count", static_cast<double>( round_trips.samples ) );
+    metrics->Insert( L"link.rtt_window_ns.min", static_cast<double>( round_trips.min.count() ) );
+    metrics->Insert( L"link.rtt_window_ns.mean", static_cast<double>( round_trips.mean.count() ) );
+    metrics->Insert( L"link.rtt_window_ns.p50", static_cast<double>( round_trips.p50.count() ) );
+    metrics->Insert( L"link.rtt_window_ns.p90", static_cast<double>( round_trips.p90.count() ) );
+    metrics->Insert( L"link.rtt_window_ns.p99", static_cast<double>( round_trips.p99.count() ) );
+    metrics->Insert( L"link.rtt_window_ns.max", static_cast<double>( round_trips.max.count() ) );
+
+    return metrics->GetView();
 }
 
 void
@@ -166,233 +380,96 @@ UwpFirmata::printVersion(
     void
     )
 {
-    std::lock_guard<std::mutex> lock(_firmutex);
-    _firmata_stream->write( static_cast<uint8_t>( Command::PROTOCOL_VERSION ) );
-    _firmata_stream->write( FIRMATA_PROTOCOL_MAJOR_VERSION );
-    _firmata_stream->write( FIRMATA_PROTOCOL_MINOR_VERSION );
-    _firmata_stream->flush();
+    uint8_t message[Core::FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE];
+    _writer->send( message, Core::FirmataEncoder::protocolVersion( FIRMATA_PROTOCOL_MAJOR_VERSION, FIRMATA_PROTOCOL_MINOR_VERSION, message ) );
 }
 
-void
-UwpFirmata::printFirmwareVersion(
+uint32_t
+UwpFirmata::ping(
     void
     )
 {
-    std::lock_guard<std::mutex> lock(_firmutex);
-    if( firmwareName.length() )
-    {
-        _firmata_stream->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-        _firmata_stream->write( static_cast<uint8_t>( SysexCommand::REPORT_FIRMWARE ) );
-        _firmata_stream->write( firmwareVersionMajor );
-        _firmata_stream->write( firmwareVersionMinor );
+    uint8_t message[3 + Core::RoundTripProbe::PAYLOAD_SIZE];
+    message[0] = static_cast<uint8_t>( Command::START_SYSEX );
+    message[1] = static_cast<uint8_t>( SysexCommand::PING );
+    uint32_t sequence = _probe.send( std::chrono::steady_clock::now(), message + 2 );
+    message[sizeof( message ) - 1] = static_cast<uint8_t>( Command::END_SYSEX );
 
-        for( size_t i = 0; i < firmwareName.length(); ++i )
-        {
-            sendValueAsTwo7bitBytes( firmwareName.at( i ) );
-        }
+    //a ping held back by batching would measure the flush deadline rather than the link
+    _writer->send( message, sizeof( message ) );
+    _writer->flush();
 
-        _firmata_stream->write( static_cast<uint8_t>( Command::END_SYSEX ) );
-        _firmata_stream->flush();
-    }
+    return sequence;
 }
 
 void
-UwpFirmata::processInput(
+UwpFirmata::printFirmwareVersion(
     void
     )
 {
-    uint16_t data = _firmata_stream->read();
-    if( data == static_cast<uint16_t>( -1 ) ) return;
-    
-    uint8_t byte = data & 0x00FF;
-    uint8_t upper_nibble = data & 0xF0;
-    uint8_t lower_nibble = data & 0x0F;
-
-    /*
-     * the relevant bits in the command depends on the value of the data byte. If it is less than 0xF0 (start sysex), only the upper nibble identifies the command
-     * while the lower nibble contains additional data
-     */
-    Command command = static_cast<Command>( ( data < static_cast<uint16_t>( Command::START_SYSEX ) ? upper_nibble : byte ) );
-
-    //determine the number of bytes remaining in the message
-    size_t bytes_remaining = 0;
-    bool isMessageSysex = false;
-    switch( command )
-    {
-    default: //command not understood
-    case Command::END_SYSEX: //should never happen
-        return;
+    std::string nameA;
+    uint8_t major, minor;
 
-        //commands that require 2 additional bytes
-    case Command::DIGITAL_MESSAGE:
-    case Command::ANALOG_MESSAGE:
-    case Command::SET_PIN_MODE:
-    case Command::PROTOCOL_VERSION:
-        bytes_remaining = 2;
-        break;
-
-        //commands that require 1 additional byte
-    case Command::REPORT_ANALOG_PIN:
-    case Command::REPORT_DIGITAL_PIN:
-        bytes_remaining = 1;
-        break;
-
-        //commands that do not require additional bytes
-    case Command::SYSTEM_RESET:
-        //do nothing, as there is nothing to reset
-        return;
+    {   //critical section
+        std::lock_guard<std::mutex> lock(_firmutex);
+        if( !firmwareName.length() ) return;
 
-    case Command::START_SYSEX:
-        //this is a special case with no set number of bytes remaining
-        isMessageSysex = true;
-        break;
+        //the name is sent as 8-bit characters, matching how REPORT_FIRMWARE is parsed on receipt
+        nameA.assign( firmwareName.begin(), firmwareName.end() );
+        major = firmwareVersionMajor;
+        minor = firmwareVersionMinor;
     }
 
-    //read the remaining message while keeping track of elapsed time to timeout in case of incomplete message
-    std::vector<uint8_t> message;
-    size_t bytes_read = 0;
-    auto timeout_start = std::chrono::high_resolution_clock::now();
-    while( bytes_remaining || isMessageSysex )
-    {
-        data = _firmata_stream->read();
-
-        //if no data was available, check for timeout
-        if( data == static_cast<uint16_t>( -1 ) )
-        {
-            //get elapsed seconds, given as a double with resolution in nanoseconds
-            std::chrono::duration<double> elapsed_sec = std::chrono::high_resolution_clock::now() - timeout_start;
-
-            const double MILLIS_PER_SECOND = 1000.0;
-            if( ( elapsed_sec.count() * MILLIS_PER_SECOND ) > MESSAGE_TIMEOUT_MILLIS ) return;
-            else continue;
-        }
-
-        timeout_start = std::chrono::high_resolution_clock::now();
+    const uint8_t version[] = { major, minor };
+    _writer->send( Core::FirmataEncoder::sysex( static_cast<uint8_t>( SysexCommand::REPORT_FIRMWARE ), version, sizeof( version ), reinterpret_cast<const uint8_t *>( nameA.data() ), nameA.length() ) );
+}
 
-        //if we're parsing sysex and we've just read the END_SYSEX command, we're done.
-        if( isMessageSysex && ( data == static_cast<uint16_t>( Command::END_SYSEX ) ) ) break;
+void
+UwpFirmata::processInput(
+    void
+    )
+{
+    processInputAt( std::chrono::steady_clock::now() );
+}
 
-        message.push_back( static_cast<uint8_t>( data & 0xFF ) );
-        ++bytes_read;
-        --bytes_remaining;
-    }
+void
+UwpFirmata::processInputAt(
+    std::chrono::steady_clock::time_point now_
+    )
+{
+    //read an entire transport chunk at once, the parser will pick up wherever the previous chunk left off
+    uint16_t bytes_read = _firmata_stream->readBytes( Platform::ArrayReference<uint8_t>( _rx_buffer.data(), static_cast<unsigned int>( _rx_buffer.size() ) ) );
 
-    //process the message
-    switch( command )
+    if( !bytes_read )
     {
-        //ignore these message types
-    default:
-    case Command::REPORT_ANALOG_PIN:
-    case Command::REPORT_DIGITAL_PIN:
-    case Command::SET_PIN_MODE:
-    case Command::END_SYSEX:
-    case Command::SYSTEM_RESET:
-        return;
-
-    case Command::PROTOCOL_VERSION:
-        firmwareVersionMajor = message.at(0);
-        firmwareVersionMinor = message.at(1);
-        return;
-
-    case Command::ANALOG_MESSAGE:
-        //report analog commands store the pin number in the lower nibble of the command byte, the value is split over two 7-bit bytes
-        AnalogValueUpdated( this, ref new CallbackEventArgs( lower_nibble, message.at( 0 ) | ( message.at( 1 ) << 7 ) ) );
-        break;
-
-    case Command::DIGITAL_MESSAGE:
-        //digital messages store the port number in the lower nibble of the command byte, the port value is split over two 7-bit bytes
-        DigitalPortValueUpdated( this, ref new CallbackEventArgs( lower_nibble, message.at( 0 ) | ( message.at( 1 ) << 7 ) ) );
-        break;
-
-    case Command::START_SYSEX:
-        //a sysex message must include at least one extended-command byte
-        if( bytes_read < 1 ) return;
-
-        //retrieve the raw data array & extract the extended-command byte
-        uint8_t *raw_data = message.data();
-        SysexCommand sysCommand = static_cast<SysexCommand>( raw_data[0] );
-        ++raw_data;
-        --bytes_read;
-
-        DataWriter ^writer = ref new DataWriter();
-        switch( sysCommand )
-        {
-        case SysexCommand::STRING_DATA:
-
-            //condense back into 1-byte data
-            reassembleByteString( raw_data, bytes_read );
-
-            StringMessageReceived( this, ref new StringCallbackEventArgs( createStringFromMbs( raw_data, bytes_read / 2 ) ) );
-
-        break;
-
-        case SysexCommand::CAPABILITY_RESPONSE:
-
-            //Firmata does not handle capability responses in the typical way (separating bytes), so we write them directly to the DataWriter
-            for( size_t i = 0; i < bytes_read; ++i )
-            {
-                writer->WriteByte( raw_data[i] );
-            }
-            PinCapabilityResponseReceived( this, ref new SysexCallbackEventArgs( static_cast<uint8_t>( sysCommand ), writer->DetachBuffer() ) );
-
-            break;
-
-        case SysexCommand::I2C_REPLY:
-
-            //condense back into 1-byte data
-            reassembleByteString( raw_data, bytes_read );
-
-            //if we're receiving an I2C reply, the first two bytes in our reply are the address and register
-            for( size_t i = 2; i < bytes_read / 2; ++i )
-            {
-                writer->WriteByte( raw_data[i] );
-            }
-
-            I2cReplyReceived( this, ref new I2cCallbackEventArgs( raw_data[0], raw_data[1], writer->DetachBuffer() ) );
-            break;
-
-        case SysexCommand::REPORT_FIRMWARE:
+        //an incomplete message which has stalled for too long is discarded, so it cannot swallow the start of the next message
+        if( _parser->isMidMessage() )
         {
-            // Buffer will contain:
-            // 0: SysexCommand::REPORT_FIRMWARE 0x79
-            // 1: Version Major
-            // 2: Version Minor
-            // 3: Filename char 1
-            // 4: Padding byte
-            // 5: Filename char 2
-            // 6: Padding byte
-            // repeat until end of buffer for filename
-
-            //assert(message[0] == SysexCommand::REPORT_FIRMWARE);
-            firmwareVersionMajor = message[1];
-            firmwareVersionMinor = message[2];
-            std::wstring nameTemp;
-
-            for (size_t i = 3; i < bytes_read; ++i)
+            std::chrono::duration<double, std::milli> elapsed_millis = now_ - _last_rx_time;
+            if( elapsed_millis.count() > MESSAGE_TIMEOUT_MILLIS )
             {
-                nameTemp += ((char)message[i++]);
+                _parser->reset();
+                _parse_timeouts->increment();
             }
-
-            firmwareName = nameTemp;
         }
-            break;
-
-        default:
+        return;
+    }
 
-            //we pass the data forward as-is for any other type of sysex command
-            for( size_t i = 0; i < bytes_read; ++i )
-            {
-                writer->WriteByte( raw_data[i] );
-            }
+    //the caller has already read the clock, so timing each chunk costs nothing more
+    _rx_bytes->add( bytes_read );
+    if( _last_chunk_time != std::chrono::steady_clock::time_point() )
+    {
+        _rx_interarrival->record( std::chrono::duration_cast<std::chrono::nanoseconds>( now_ - _last_chunk_time ).count() );
+    }
+    _last_chunk_time = now_;
 
-            SysexMessageReceived( this, ref new SysexCallbackEventArgs( static_cast<uint8_t>( sysCommand ), writer->DetachBuffer() ) );
+    _recorder.record( Core::CaptureDirection::BOARD_TO_HOST, _rx_buffer.data(), bytes_read );
+    _parser->parse( _rx_buffer.data(), bytes_read );
 
-        }
-
-        break;
+    if( _parser->isMidMessage() )
+    {
+        _last_rx_time = now_;
     }
-
-    //this library does not support digital write, but we need to consume the rest of the message
 }
 
 void
@@ -401,11 +478,8 @@ UwpFirmata::sendAnalog(
     uint16_t value_
     )
 {
-    std::lock_guard<std::mutex> lock(_firmutex);
-    _firmata_stream->write( static_cast<uint8_t>( Command::ANALOG_MESSAGE ) | ( pin_ & 0x0F ) );
-    _firmata_stream->write( static_cast<uint8_t>( value_ & 0x007F ) );
-    _firmata_stream->write( static_cast<uint8_t>( ( value_ >> 7 ) & 0x007F ) );
-    _firmata_stream->flush();
+    uint8_t message[Core::FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE];
+    _writer->send( message, Core::FirmataEncoder::analogMessage( pin_, value_, message ) );
 }
 
 
@@ -415,11 +489,19 @@ UwpFirmata::sendDigitalPort(
     uint8_t port_data_
     )
 {
-    std::lock_guard<std::mutex> lock(_firmutex);
-    _firmata_stream->write( static_cast<uint8_t>( Command::DIGITAL_MESSAGE ) | ( port_number_ & 0x0F ) );
-    _firmata_stream->write( port_data_ & 0x007F );
-    _firmata_stream->write( port_data_ >> 7 );
-    _firmata_stream->flush();
+    uint8_t message[Core::FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE];
+    _writer->send( message, Core::FirmataEncoder::digitalMessage( port_number_, port_data_, message ) );
+}
+
+
+void
+UwpFirmata::sendMessage(
+    const Platform::Array<uint8_t> ^message_
+    )
+{
+    if( message_ == nullptr || !message_->Length ) return;
+
+    _writer->send( message_->Data, message_->Length );
 }
 
 
@@ -441,20 +523,7 @@ UwpFirmata::sendString(
     std::wstring stringW = string_->ToString()->Begin();
     std::string stringA( stringW.begin(), stringW.end() );
 
-    {   //critical section
-        std::lock_guard<std::mutex> lock( _firmutex );
-
-        _firmata_stream->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-        _firmata_stream->write( command_ & 0x7F );
-
-        for( size_t i = 0; i < stringA.length(); ++i )
-        {
-            sendValueAsTwo7bitBytes( stringA.at( i ) );
-        }
-
-        _firmata_stream->write( static_cast<uint8_t>( Command::END_SYSEX ) );
-        _firmata_stream->flush();
-    }
+    _writer->send( Core::FirmataEncoder::sysex( command_, nullptr, 0, reinterpret_cast<const uint8_t *>( stringA.data() ), stringA.length() ) );
 }
 
 void
@@ -472,20 +541,21 @@ UwpFirmata::sendSysex(
     IBuffer ^buffer_
     )
 {
-    //critical section equivalent to function scope
-    std::lock_guard<std::mutex> lock( _firmutex );
-
-    _firmata_stream->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-    _firmata_stream->write( command_ );
-
     DataReader ^reader = DataReader::FromBuffer( buffer_ );
-    while( reader->UnconsumedBufferLength )
+    const unsigned int length = reader->UnconsumedBufferLength;
+
+    //the payload is read in one call and masked in place
+    std::vector<uint8_t> message( 3 + length );
+    message[0] = static_cast<uint8_t>( Command::START_SYSEX );
+    message[1] = command_;
+    if( length )
     {
-        _firmata_stream->write( reader->ReadByte() & 0x7F );
+        reader->ReadBytes( Platform::ArrayReference<uint8_t>( message.data() + 2, length ) );
+        Core::SevenBitCodec::mask( message.data() + 2, length, message.data() + 2 );
     }
+    message.back() = static_cast<uint8_t>( Command::END_SYSEX );
 
-    _firmata_stream->write( static_cast<uint8_t>( Command::END_SYSEX ) );
-    _firmata_stream->flush();
+    _writer->send( std::move( message ) );
 }
 
 void
@@ -493,8 +563,8 @@ UwpFirmata::sendValueAsTwo7bitBytes(
     uint16_t value_
     )
 {
-    _firmata_stream->write( value_ & 0x7F );
-    _firmata_stream->write( ( value_ >> 7 ) & 0x7F );
+    write( value_ & 0x7F );
+    write( ( value_ >> 7 ) & 0x7F );
 }
 
 void
@@ -514,6 +584,19 @@ UwpFirmata::setFirmwareNameAndVersion(
     }
 }
 
+bool
+UwpFirmata::startCapture(
+    String ^path_
+    )
+{
+    //the core takes UTF-8 paths
+    std::string path( WideCharToMultiByte( CP_UTF8, 0, path_->Data(), -1, nullptr, 0, nullptr, nullptr ), '\0' );
+    WideCharToMultiByte( CP_UTF8, 0, path_->Data(), -1, &path[0], static_cast<int>( path.size() ), nullptr, nullptr );
+    path.resize( path.size() - 1 );
+
+    return _recorder.open( path );
+}
+
 void
 UwpFirmata::startListening(
     void
@@ -529,6 +612,14 @@ UwpFirmata::startListening(
     _input_thread = std::thread( [ this ]() -> void { inputThread(); } );
 }
 
+void
+UwpFirmata::stopCapture(
+    void
+    )
+{
+    _recorder.close();
+}
+
 void
 UwpFirmata::unlock(
     void
@@ -542,7 +633,8 @@ UwpFirmata::write(
     uint8_t c_
     )
 {
-    _firmata_stream->write( c_ );
+    //the caller holds lock(), the staged bytes are queued by flush()
+    _tx_staging.push_back( c_ );
 }
 
 
@@ -570,17 +662,53 @@ UwpFirmata::inputThread(
     void
     )
 {
+    //each pass reads the clock once, the time since the previous reading is split between waiting and processing
+    std::chrono::steady_clock::time_point busy_until = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point wake_time = busy_until;
+
     //set state-tracking member variables and begin processing input
     while( !_input_thread_should_exit )
     {
         try
         {
-            processInput();
+            //sleep until the transport has data rather than spinning on an idle connection. processInput is still called
+            //after a timeout so that a stalled partial message can be discarded.
+            _firmata_stream->waitForData( INPUT_WAIT_TIMEOUT_MILLIS );
+            wake_time = std::chrono::steady_clock::now();
+            _input_idle_nanos->add( std::chrono::duration_cast<std::chrono::nanoseconds>( wake_time - busy_until ).count() );
+
+            processInputAt( wake_time );
+
+            //periodic pings piggyback on the input thread's wake-ups rather than keeping a thread of their own
+            uint32_t ping_interval_millis = _ping_interval_millis;
+            if( ping_interval_millis && wake_time >= _next_ping_time )
+            {
+                ping();
+                _next_ping_time = wake_time + std::chrono::milliseconds( ping_interval_millis );
+            }
         }
         catch( Platform::Exception ^e )
         {
             OutputDebugString( e->Message->Begin() ); OutputDebugString(L"\r\n");
         }
+
+        busy_until = std::chrono::steady_clock::now();
+        _input_busy_nanos->add( std::chrono::duration_cast<std::chrono::nanoseconds>( busy_until - wake_time ).count() );
+    }
+}
+
+void
+UwpFirmata::onAnalogMessage(
+    uint8_t pin_,
+    uint16_t value_
+    )
+{
+    _rx_analog_messages->increment();
+    AnalogValueReceived( this, pin_, value_ );
+
+    if( _analog_value_subscribers > 0 )
+    {
+        AnalogValueUpdated( this, ref new CallbackEventArgs( pin_, value_ ) );
     }
 }
 
@@ -614,6 +742,155 @@ UwpFirmata::onConnectionLost(
     FirmataConnectionLost( message_ );
 }
 
+void
+UwpFirmata::onDigitalMessage(
+    uint8_t port_,
+    uint16_t value_
+    )
+{
+    _rx_digital_messages->increment();
+    DigitalPortValueReceived( this, port_, value_ );
+
+    if( _digital_port_value_subscribers > 0 )
+    {
+        DigitalPortValueUpdated( this, ref new CallbackEventArgs( port_, value_ ) );
+    }
+}
+
+void
+UwpFirmata::onProtocolVersion(
+    uint8_t major_,
+    uint8_t minor_
+    )
+{
+    _rx_protocol_version_messages->increment();
+    firmwareVersionMajor = major_;
+    firmwareVersionMinor = minor_;
+}
+
+void
+UwpFirmata::onSysexMessage(
+    uint8_t command_,
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    _rx_sysex_messages[command_ & 0x7F]->increment();
+    SysexCommand sysCommand = static_cast<SysexCommand>( command_ );
+
+    switch( sysCommand )
+    {
+    case SysexCommand::STRING_DATA:
+
+        //condense back into 1-byte data, the parser's buffer is read-only so the payload is decoded in a scratch buffer
+        _decode_buffer.resize( length_ / 2 + 1 );
+        _decode_buffer[Core::SevenBitCodec::decode( data_, length_, _decode_buffer.data() )] = 0;
+
+        StringMessageReceived( this, ref new StringCallbackEventArgs( createStringFromMbs( _decode_buffer.data(), length_ / 2 ) ) );
+
+        break;
+
+    case SysexCommand::CAPABILITY_RESPONSE:
+    {
+        //Firmata does not handle capability responses in the typical way (separating bytes), so we write them directly to the DataWriter
+        DataWriter ^writer = ref new DataWriter();
+        if( length_ )
+        {
+            writer->WriteBytes( Platform::ArrayReference<uint8_t>( const_cast<uint8_t *>( data_ ), static_cast<unsigned int>( length_ ) ) );
+        }
+        PinCapabilityResponseReceived( this, ref new SysexCallbackEventArgs( command_, writer->DetachBuffer() ) );
+    }
+
+        break;
+
+    case SysexCommand::ANALOG_MAPPING_RESPONSE:
+    {
+        //one byte per pin, written as is like the capability response
+        DataWriter ^writer = ref new DataWriter();
+        if( length_ )
+        {
+            writer->WriteBytes( Platform::ArrayReference<uint8_t>( const_cast<uint8_t *>( data_ ), static_cast<unsigned int>( length_ ) ) );
+        }
+        AnalogMappingResponseReceived( this, ref new SysexCallbackEventArgs( command_, writer->DetachBuffer() ) );
+    }
+
+        break;
+
+    case SysexCommand::I2C_REPLY:
+
+        //condense back into 1-byte data
+        _decode_buffer.resize( length_ / 2 + 1 );
+        _decode_buffer[Core::SevenBitCodec::decode( data_, length_, _decode_buffer.data() )] = 0;
+
+        //if we're receiving an I2C reply, the first two bytes in our reply are the address and register
+        if( length_ / 2 < 2 ) return;
+        {
+            Platform::ArrayReference<uint8_t> reply( _decode_buffer.data() + 2, static_cast<unsigned int>( length_ / 2 - 2 ) );
+            I2cReplyDataReceived( this, _decode_buffer[0], _decode_buffer[1], reply );
+
+            if( _i2c_reply_subscribers > 0 )
+            {
+                DataWriter ^writer = ref new DataWriter();
+                writer->WriteBytes( reply );
+                I2cReplyReceived( this, ref new I2cCallbackEventArgs( _decode_buffer[0], _decode_buffer[1], writer->DetachBuffer() ) );
+            }
+        }
+        break;
+
+    case SysexCommand::PING:
+    {
+        uint32_t sequence;
+        std::chrono::nanoseconds round_trip;
+        if( !Core::RoundTripProbe::decode( data_, length_, &sequence ) ) return;
+        if( !_probe.receive( sequence, std::chrono::steady_clock::now(), &round_trip ) ) return;
+
+        _round_trip->record( round_trip.count() );
+        PingReplyReceived( this, sequence, round_trip.count() / 1000.0 );
+    }
+        break;
+
+    case SysexCommand::REPORT_FIRMWARE:
+    {
+        // Buffer will contain:
+        // 0: Version Major
+        // 1: Version Minor
+        // 2: Filename char 1
+        // 3: Padding byte
+        // 4: Filename char 2
+        // 5: Padding byte
+        // repeat until end of buffer for filename
+        if( length_ < 2 ) return;
+
+        firmwareVersionMajor = data_[0];
+        firmwareVersionMinor = data_[1];
+        std::wstring nameTemp;
+
+        for( size_t i = 2; i < length_; i += 2 )
+        {
+            nameTemp += static_cast<wchar_t>( data_[i] );
+        }
+
+        firmwareName = nameTemp;
+        FirmwareReportReceived( this, firmwareVersionMajor, firmwareVersionMinor, ref new Platform::String( firmwareName.c_str() ) );
+    }
+        break;
+
+    default:
+    {
+        //we pass the data forward as-is for any other type of sysex command, handing out a view of the parser's buffer rather than a copy
+        Platform::ArrayReference<uint8_t> data( const_cast<uint8_t *>( data_ ), static_cast<unsigned int>( length_ ) );
+        SysexDataReceived( this, command_, data );
+
+        if( _sysex_message_subscribers > 0 )
+        {
+            DataWriter ^writer = ref new DataWriter();
+            writer->WriteBytes( data );
+            SysexMessageReceived( this, ref new SysexCallbackEventArgs( command_, writer->DetachBuffer() ) );
+        }
+    }
+    }
+}
+
 void
 UwpFirmata::reassembleByteString(
     uint8_t *byte_string_,
@@ -621,12 +898,63 @@ UwpFirmata::reassembleByteString(
     )
 {
     //each char must be reassembled from the two 7-bit bytes received, therefore length should always be an even number.
-    size_t i, j;
-    for( i = 0, j = 0; j < length_ - 1; ++i, j += 2 )
+    if( length_ < 2 )
     {
-        byte_string_[i] = byte_string_[j] | ( byte_string_[j + 1] << 7 );
+        byte_string_[0] = 0;
+        return;
     }
-    byte_string_[i] = 0;
+
+    byte_string_[Core::SevenBitCodec::decode( byte_string_, length_, byte_string_ )] = 0;
+}
+
+void
+UwpFirmata::registerMetrics(
+    void
+    )
+{
+    static const struct { SysexCommand command; const char *name; } SYSEX_NAMES[] = {
+        { SysexCommand::PULSE_IN, "pulse_in" },
+        { SysexCommand::DISTANCE, "distance" },
+        { SysexCommand::PING, "ping" },
+        { SysexCommand::ENCODER_DATA, "encoder_data" },
+        { SysexCommand::STRING_DATA, "string_data" },
+        { SysexCommand::STEPPER_DATA, "stepper_data" },
+        { SysexCommand::ONEWIRE_DATA, "onewire_data" },
+        { SysexCommand::SHIFT_DATA, "shift_data" },
+        { SysexCommand::I2C_REPLY, "i2c_reply" },
+        { SysexCommand::EXTENDED_ANALOG, "extended_analog" },
+        { SysexCommand::PIN_STATE_RESPONSE, "pin_state_response" },
+        { SysexCommand::CAPABILITY_RESPONSE, "capability_response" },
+        { SysexCommand::ANALOG_MAPPING_RESPONSE, "analog_mapping_response" },
+        { SysexCommand::REPORT_FIRMWARE, "report_firmware" },
+        { SysexCommand::SCHEDULER_DATA, "scheduler_data" },
+        { SysexCommand::SYSEX_NON_REALTIME, "non_realtime" },
+        { SysexCommand::SYSEX_REALTIME, "realtime" },
+    };
+
+    _rx_bytes = &_metrics.counter( "rx.bytes" );
+    _rx_interarrival = &_metrics.histogram( "rx.chunk_interarrival_ns" );
+    _round_trip = &_metrics.histogram( "link.rtt_ns" );
+    _rx_analog_messages = &_metrics.counter( "rx.messages.analog" );
+    _rx_digital_messages = &_metrics.counter( "rx.messages.digital" );
+    _rx_protocol_version_messages = &_metrics.counter( "rx.messages.protocol_version" );
+
+    //sysex commands nobody has named share one counter, so a misbehaving board cannot grow the registry
+    Core::Counter *other_sysex = &_metrics.counter( "rx.sysex.other" );
+    for( Core::Counter *&counter : _rx_sysex_messages ) { counter = other_sysex; }
+    for( const auto &sysex : SYSEX_NAMES )
+    {
+        _rx_sysex_messages[static_cast<uint8_t>( sysex.command )] = &_metrics.counter( std::string( "rx.sysex." ) + sysex.name );
+    }
+
+    _parse_errors[static_cast<size_t>( Core::ParseError::STRAY_DATA )] = &_metrics.counter( "parser.errors.stray_data" );
+    _parse_errors[static_cast<size_t>( Core::ParseError::TRUNCATED_MESSAGE )] = &_metrics.counter( "parser.errors.truncated_message" );
+    _parse_errors[static_cast<size_t>( Core::ParseError::UNKNOWN_COMMAND )] = &_metrics.counter( "parser.errors.unknown_command" );
+    _parse_errors[static_cast<size_t>( Core::ParseError::SYSEX_OVERFLOW )] = &_metrics.counter( "parser.errors.sysex_overflow" );
+    _parse_timeouts = &_metrics.counter( "parser.timeouts" );
+
+    _input_busy_nanos = &_metrics.counter( "input.busy_ns" );
+    _input_idle_nanos = &_metrics.counter( "input.idle_ns" );
 }
 
 void
@@ -637,4 +965,29 @@ UwpFirmata::stopThreads(
     _input_thread_should_exit = true;
     if( _input_thread.joinable() ) { _input_thread.join(); }
     _input_thread_should_exit = false;
+
+    //the writer sends everything already queued before it exits
+    _writer->stop();
+}
+
+void
+UwpFirmata::transmitFrame(
+    const uint8_t *frame_,
+    size_t length_
+    )
+{
+    try
+    {
+        if( _firmata_stream != nullptr )
+        {
+            _recorder.record( Core::CaptureDirection::HOST_TO_BOARD, frame_, length_ );
+            _firmata_stream->write( Platform::ArrayReference<uint8_t>( const_cast<uint8_t *>( frame_ ), static_cast<unsigned int>( length_ ) ) );
+            _firmata_stream->flush();
+        }
+    }
+    catch( Platform::Exception ^e )
+    {
+        //the frame is dropped rather than retried, the transport reports a lost connection on its own
+        OutputDebugString( e->Message->Begin() ); OutputDebugString(L"\r\n");
+    }
 }
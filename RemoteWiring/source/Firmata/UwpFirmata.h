@@ -25,10 +25,20 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
+
+#include "Core/FirmataEncoder.h"
+#include "Core/FirmataParser.h"
+#include "Core/FirmataWriter.h"
+#include "Core/Metrics.h"
+#include "Core/RoundTripProbe.h"
+#include "Core/SessionCapture.h"
+#include "Core/SevenBitCodec.h"
 
 using namespace Platform;
 using namespace Concurrency;
@@ -141,6 +151,9 @@ public enum class Command {
 };
 
 public enum class SysexCommand {
+    PULSE_IN = 0x42,    //MakeCodeFirmata only
+    DISTANCE = 0x43,    //MakeCodeFirmata only
+    PING = 0x44,        //MakeCodeFirmata only, echoed back unchanged
     ENCODER_DATA = 0x61,
     SERVO_CONFIG = 0x70,
     STRING_DATA = 0x71,
@@ -166,27 +179,112 @@ public enum class SysexCommand {
 
 
 public delegate void CallbackFunction( UwpFirmata ^caller, CallbackEventArgs ^argv );
+public delegate void ValueCallbackFunction( UwpFirmata ^caller, uint8_t port, uint16_t value );
 public delegate void StringCallbackFunction(UwpFirmata ^caller, StringCallbackEventArgs ^argv);
 public delegate void SysexCallbackFunction(UwpFirmata ^caller, SysexCallbackEventArgs ^argv);
 public delegate void SystemResetCallbackFunction( UwpFirmata ^caller, SystemResetCallbackEventArgs ^argv );
 public delegate void I2cReplyCallbackFunction( UwpFirmata ^caller, I2cCallbackEventArgs ^argv );
+public delegate void SysexDataCallbackFunction( UwpFirmata ^caller, uint8_t command, const Platform::Array<uint8_t> ^data );
+public delegate void I2cReplyDataCallbackFunction( UwpFirmata ^caller, uint8_t address, uint8_t reg, const Platform::Array<uint8_t> ^data );
+public delegate void PingReplyCallbackFunction( UwpFirmata ^caller, uint32_t sequence, double round_trip_micros );
+public delegate void FirmwareReportCallbackFunction( UwpFirmata ^caller, uint8_t major, uint8_t minor, Platform::String ^name );
 public delegate void FirmataConnectionCallback();
 public delegate void FirmataConnectionCallbackWithMessage( Platform::String ^message );
 
 public ref class UwpFirmata sealed
 {
 public:
-    event CallbackFunction^ DigitalPortValueUpdated;
-    event CallbackFunction^ AnalogValueUpdated;
+    ///<summary>
+    ///Raised for each DIGITAL_MESSAGE, with the port and value wrapped in a CallbackEventArgs object.
+    ///<para>The object is only allocated while this event has subscribers. DigitalPortValueReceived delivers the same reports without allocating.</para>
+    ///</summary>
+    event CallbackFunction^ DigitalPortValueUpdated
+    {
+        Windows::Foundation::EventRegistrationToken add( CallbackFunction ^handler_ );
+        void remove( Windows::Foundation::EventRegistrationToken token_ );
+        void raise( UwpFirmata ^caller_, CallbackEventArgs ^argv_ );
+    }
+
+    ///<summary>
+    ///Raised for each ANALOG_MESSAGE, with the pin and value wrapped in a CallbackEventArgs object.
+    ///<para>The object is only allocated while this event has subscribers. AnalogValueReceived delivers the same reports without allocating.</para>
+    ///</summary>
+    event CallbackFunction^ AnalogValueUpdated
+    {
+        Windows::Foundation::EventRegistrationToken add( CallbackFunction ^handler_ );
+        void remove( Windows::Foundation::EventRegistrationToken token_ );
+        void raise( UwpFirmata ^caller_, CallbackEventArgs ^argv_ );
+    }
+
+    ///<summary>
+    ///Raised for each DIGITAL_MESSAGE with the port number and the port's pin values
+    ///</summary>
+    event ValueCallbackFunction^ DigitalPortValueReceived;
+
+    ///<summary>
+    ///Raised for each ANALOG_MESSAGE with the analog pin number and its value
+    ///</summary>
+    event ValueCallbackFunction^ AnalogValueReceived;
+
     event StringCallbackFunction^ StringMessageReceived;
-    event SysexCallbackFunction^ SysexMessageReceived;
     event SysexCallbackFunction^ PinCapabilityResponseReceived;
-    event I2cReplyCallbackFunction^ I2cReplyReceived;
+
+    ///<summary>
+    ///Raised for each ANALOG_MAPPING_RESPONSE, with the analog channel of each pin (127 for none) in pin order
+    ///</summary>
+    event SysexCallbackFunction^ AnalogMappingResponseReceived;
+
+    ///<summary>
+    ///Raised for each sysex message which is not handled by UwpFirmata itself, with a copy of the message data in an IBuffer.
+    ///<para>The copy is only made while this event has subscribers. SysexDataReceived delivers the same messages without copying.</para>
+    ///</summary>
+    event SysexCallbackFunction^ SysexMessageReceived
+    {
+        Windows::Foundation::EventRegistrationToken add( SysexCallbackFunction ^handler_ );
+        void remove( Windows::Foundation::EventRegistrationToken token_ );
+        void raise( UwpFirmata ^caller_, SysexCallbackEventArgs ^argv_ );
+    }
+
+    ///<summary>
+    ///Raised for each I2C reply, with a copy of the reply data in an IBuffer.
+    ///<para>The copy is only made while this event has subscribers. I2cReplyDataReceived delivers the same replies without copying.</para>
+    ///</summary>
+    event I2cReplyCallbackFunction^ I2cReplyReceived
+    {
+        Windows::Foundation::EventRegistrationToken add( I2cReplyCallbackFunction ^handler_ );
+        void remove( Windows::Foundation::EventRegistrationToken token_ );
+        void raise( UwpFirmata ^caller_, I2cCallbackEventArgs ^argv_ );
+    }
+
+    ///<summary>
+    ///Raised for each sysex message which is not handled by UwpFirmata itself.
+    ///<para>The data array is a read-only view of the receive buffer and is only valid for the duration of the callback.
+    ///Handlers which need to keep the data must copy it.</para>
+    ///</summary>
+    event SysexDataCallbackFunction^ SysexDataReceived;
+
+    ///<summary>
+    ///Raised for each I2C reply with the address, register and reassembled reply data.
+    ///<para>The data array is a read-only view of the receive buffer and is only valid for the duration of the callback.
+    ///Handlers which need to keep the data must copy it.</para>
+    ///</summary>
+    event I2cReplyDataCallbackFunction^ I2cReplyDataReceived;
     event SystemResetCallbackFunction^ SystemResetRequested;
     event FirmataConnectionCallback^ FirmataConnectionReady;
     event FirmataConnectionCallbackWithMessage^ FirmataConnectionFailed;
     event FirmataConnectionCallbackWithMessage^ FirmataConnectionLost;
 
+    ///<summary>
+    ///Raised on the input thread for each reply to ping(), with the ping's sequence number and its round trip time
+    ///</summary>
+    event PingReplyCallbackFunction^ PingReplyReceived;
+
+    ///<summary>
+    ///Raised on the input thread for each REPORT_FIRMWARE reply, after the values returned by getFirmwareVersionMajor,
+    ///getFirmwareVersionMinor and getFirmwareName have been updated
+    ///</summary>
+    event FirmwareReportCallbackFunction^ FirmwareReportReceived;
+
     UwpFirmata(
         void
     );
@@ -220,8 +318,56 @@ public:
         void
     );
 
+    ///<summary>
+    ///Stops combining outbound messages. Any messages waiting in the outbound frame are sent immediately, and every message
+    ///sent afterwards is flushed to the transport on its own.
+    ///</summary>
+    void
+    disableBatching(
+        void
+    );
+
+    ///<summary>
+    ///Stops the periodic pings started by enablePing()
+    ///</summary>
+    void
+    disablePing(
+        void
+    );
+
+    ///<summary>
+    ///Combines outbound messages into a single frame, which is handed to the transport once the first message in it has waited for
+    ///the given deadline, or once the frame grows past the default size threshold.
+    ///<para>Calling flush() always sends the pending frame immediately.</para>
+    ///</summary>
+    void
+    enableBatching(
+        uint32_t flush_deadline_micros_
+    );
+
+    ///<summary>
+    ///Combines outbound messages into a single frame, which is handed to the transport once the first message in it has waited for
+    ///the given deadline, or once the frame grows to the given number of bytes.
+    ///<para>Calling flush() always sends the pending frame immediately.</para>
+    ///</summary>
+    void
+    enableBatching(
+        uint32_t flush_deadline_micros_,
+        uint32_t flush_threshold_bytes_
+    );
+
+    ///<summary>
+    ///Sends a ping every interval_millis_ milliseconds from the input thread, so the round trip time of the link is measured
+    ///continuously. The interval is only honoured to within the input thread's 50ms polling period.
+    ///</summary>
+    void
+    enablePing(
+        uint32_t interval_millis_
+    );
+
     ///<summary>
     ///Finishes the usage of this UwpFirmata instance. Any existing connections will be closed.
+    ///<para>This joins the input thread, so it must not be called from a handler of this instance's events.</para>
     ///</summary>
     void
     finish(
@@ -229,14 +375,26 @@ public:
     );
 
     ///<summary>
-    ///Flushes any awaiting data from the outbound queue. This function must be called before any data
-    ///is sent across an active connection
+    ///Queues any bytes placed with write() as a single message, then asks the writer to send everything queued so far without
+    ///waiting for the batching deadline.
+    ///<para>When write() has been used, this must be called before unlock().</para>
     ///</summary>
     void
     flush(
         void
     );
 
+    ///<summary>
+    ///Takes a snapshot of this instance's metrics: bytes in and out, messages received by command and sysex command, parse
+    ///errors and timeouts, writer flushes and queue depth, input thread busy and idle time, and latency histograms.
+    ///<para>Histograms are expanded into name.count, name.mean, name.p50, name.p90, name.p99, name.p999 and name.max.
+    ///Counters only ever increase, so rates are found by differencing two snapshots.</para>
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<String ^, double> ^
+    getMetrics(
+        void
+    );
+
     ///<summary>
     ///Locks this instance of the UwpFirmata object, allowing for thread safety and guaranteeing that messages do not interfere with each other.
     ///<para>when explicitly invoking this method, unlock() must be called when the lock is no longer needed.</para>
@@ -246,6 +404,17 @@ public:
         void
     );
 
+    ///<summary>
+    ///Sends a PING sysex, which MakeCodeFirmata echoes back unchanged, and flushes it without waiting for the batching deadline.
+    ///Returns the ping's sequence number, which PingReplyReceived reports alongside its round trip time.
+    ///<para>The round trip is timed from when the ping is queued, so it includes the writer and the transport in both directions.
+    ///The distribution of recent round trips is reported by getMetrics() under "link.".</para>
+    ///</summary>
+    uint32_t
+    ping(
+        void
+    );
+
     ///<summary>
     ///Writes the firmware version.
     ///</summary>
@@ -263,8 +432,9 @@ public:
     );
 
     ///<summary>
-    ///Allows one byte to be read from an active connection and messages to be parsed. This function will need to be called multiple times
-    ///before a single multi-byte message can be completed and the appropriate action taken.
+    ///Reads all of the bytes currently available from an active connection and parses them, raising events for every message completed.
+    ///<para>This function never waits for data. A message split across several reads is retained and completed by a later call, and a
+    ///partial message is discarded if the rest of it does not arrive within the message timeout.</para>
     ///</summary>
     void
     processInput(
@@ -289,6 +459,16 @@ public:
         uint8_t port_data_
     );
 
+    ///<summary>
+    ///Queues a complete, already encoded Firmata message to be sent across an active connection.
+    ///<para>This function never blocks and may be called from any thread. The message is copied, and its bytes are always written to
+    ///the transport contiguously.</para>
+    ///</summary>
+    void
+    sendMessage(
+        const Platform::Array<uint8_t> ^message_
+    );
+
     ///<summary>
     ///Sends string data using the STRING_DATA command across an active connection
     ///</summary>
@@ -347,6 +527,15 @@ public:
         uint8_t minor_
     );
 
+    ///<summary>
+    ///Records every byte read from and written to the transport, with monotonic timestamps, into a capture file at the given path.
+    ///<para>Returns false if the file cannot be created. A capture already in progress is closed first. ReplaySerial plays captures back.</para>
+    ///</summary>
+    bool
+    startCapture(
+        String ^path_
+    );
+
     ///<summary>
     ///Spins up a thread which will listen for and process input.
     ///<para>This function must be called before any inputs can be processed and corresponding events can be raised.</para>
@@ -356,6 +545,14 @@ public:
         void
     );
 
+    ///<summary>
+    ///Closes the capture file started by startCapture(), if any
+    ///</summary>
+    void
+    stopCapture(
+        void
+    );
+
     ///<summary>
     ///Unlocks this instance of the UwpFirmata object, allowing other threads or actions to use it.
     ///<para>This function must be explicitly invoked after each invocation of the lock() method, when the lock is no longer needed.</para>
@@ -366,7 +563,8 @@ public:
     );
 
     ///<summary>
-    ///Writes a single byte using an active connection
+    ///Stages a single byte of a message being composed under lock(). Nothing is queued until flush() is called.
+    ///<para>sendMessage() is preferred, as it queues a complete message without taking the lock.</para>
     ///</summary>
     void
     write(
@@ -381,6 +579,9 @@ public:
     const uint8_t FIRMATA_PROTOCOL_MINOR_VERSION = 3;
     const double MESSAGE_TIMEOUT_MILLIS = 500.0;
 
+    //the longest the input thread will sleep waiting for data before rechecking whether it has been asked to exit
+    const uint32_t INPUT_WAIT_TIMEOUT_MILLIS = 50;
+
     //version number and name array used with set/printFirmwareVersion
     uint8_t firmwareVersionMajor;
     uint8_t firmwareVersionMinor;
@@ -390,6 +591,45 @@ public:
     const size_t DATA_BUFFER_SIZE = 31;
     std::unique_ptr<uint16_t> _data_buffer;
 
+    //receive buffer handed to the transport for bulk reads, one transport chunk is parsed per read
+    const size_t RX_BUFFER_SIZE = 256;
+    std::vector<uint8_t> _rx_buffer;
+
+    //metrics are registered before the parser and writer which update them, and outlive both
+    Core::MetricsRegistry _metrics;
+    Core::Counter *_rx_bytes;
+    Core::Counter *_rx_analog_messages;
+    Core::Counter *_rx_digital_messages;
+    Core::Counter *_rx_protocol_version_messages;
+    Core::Counter *_rx_sysex_messages[128];
+    Core::Counter *_parse_errors[4];
+    Core::Counter *_parse_timeouts;
+    Core::Counter *_input_busy_nanos;
+    Core::Counter *_input_idle_nanos;
+    Core::Histogram *_rx_interarrival;
+
+    //incremental parser which retains partial messages between calls to processInput
+    std::unique_ptr<Core::FirmataParser> _parser;
+    std::chrono::steady_clock::time_point _last_rx_time;
+
+    //when the last chunk arrived
+    std::chrono::steady_clock::time_point _last_chunk_time;
+
+    //scratch space used to decode two 7-bit byte payloads, reused for every message
+    std::vector<uint8_t> _decode_buffer;
+
+    //backing events for the IBuffer-based events, which track their subscribers so the copies can be skipped when nobody is listening
+    event SysexCallbackFunction^ _sysex_message_received;
+    event I2cReplyCallbackFunction^ _i2c_reply_received;
+    std::atomic_int _sysex_message_subscribers;
+    std::atomic_int _i2c_reply_subscribers;
+
+    //backing events for the CallbackEventArgs-based report events, which track their subscribers for the same reason
+    event CallbackFunction^ _digital_port_value_updated;
+    event CallbackFunction^ _analog_value_updated;
+    std::atomic_int _digital_port_value_subscribers;
+    std::atomic_int _analog_value_subscribers;
+
     //member variables to hold the current input thread & communications
     Serial::IStream ^_firmata_stream;
 
@@ -404,6 +644,22 @@ public:
     std::thread _input_thread;
     std::atomic_bool _input_thread_should_exit;
 
+    //outbound messages are queued without locking by any thread and written to the transport by the writer's thread alone
+    std::unique_ptr<Core::FirmataWriter> _writer;
+
+    //bytes placed with write() are staged here until flush() queues them as one message, guarded by lock()
+    std::vector<uint8_t> _tx_staging;
+
+    //tees the transport's traffic into a capture file while startCapture() is in effect
+    Core::CaptureRecorder _recorder;
+
+    //matches PING replies to the pings sent. The interval is zero while periodic pings are disabled, the due time is only
+    //touched by the input thread.
+    Core::RoundTripProbe _probe;
+    Core::Histogram *_round_trip;
+    std::atomic<uint32_t> _ping_interval_millis;
+    std::chrono::steady_clock::time_point _next_ping_time;
+
     String ^
     createStringFromMbs(
         uint8_t *mbs_,
@@ -415,6 +671,12 @@ public:
         void
     );
 
+    void
+    onAnalogMessage(
+        uint8_t pin_,
+        uint16_t value_
+    );
+
     void
     onConnectionEstablished(
         void
@@ -430,16 +692,51 @@ public:
         Platform::String ^message_
     );
 
+    void
+    onDigitalMessage(
+        uint8_t port_,
+        uint16_t value_
+    );
+
+    void
+    onProtocolVersion(
+        uint8_t major_,
+        uint8_t minor_
+    );
+
+    void
+    onSysexMessage(
+        uint8_t command_,
+        const uint8_t *data_,
+        size_t length_
+    );
+
+    void
+    processInputAt(
+        std::chrono::steady_clock::time_point now_
+    );
+
     void
     stopThreads(
         void
     );
 
+    void
+    transmitFrame(
+        const uint8_t *frame_,
+        size_t length_
+    );
+
     void
     reassembleByteString(
         uint8_t *byte_string_,
         size_t length_
     );
+
+    void
+    registerMetrics(
+        void
+    );
 };
 
 } // namespace Firmata
@@ -0,0 +1,92 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "BoardProfiles.h"
+
+using namespace Microsoft::Maker::RemoteWiring::Core;
+
+typedef Microsoft::Maker::Firmata::Core::PinMode PinMode;
+
+namespace {
+
+const uint8_t MODE_ENABLED = 1;
+const uint8_t FIRMATA_END_OF_PIN_VALUE = 0x7F;
+
+inline
+void
+appendMode(
+    std::vector<uint8_t> &out_,
+    PinMode mode_,
+    uint8_t value_
+    )
+{
+    out_.push_back( static_cast<uint8_t>( mode_ ) );
+    out_.push_back( value_ );
+}
+
+} // namespace
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+std::vector<uint8_t>
+BoardProfiles::capabilityResponse(
+    const BoardDescriptor &board_
+    )
+{
+    std::vector<uint8_t> response;
+    response.reserve( board_.totalPins * 12 );
+
+    //modes are listed in the order StandardFirmata lists them
+    for( size_t pin = 0; pin < board_.totalPins; ++pin )
+    {
+        if( board_.isDigital( pin ) )
+        {
+            appendMode( response, PinMode::INPUT, MODE_ENABLED );
+            appendMode( response, PinMode::PULLUP, MODE_ENABLED );
+            appendMode( response, PinMode::OUTPUT, MODE_ENABLED );
+        }
+        if( board_.isAnalog( pin ) ) appendMode( response, PinMode::ANALOG, board_.analogResolution );
+        if( board_.isPwm( pin ) ) appendMode( response, PinMode::PWM, board_.pwmResolution );
+        if( board_.isDigital( pin ) ) appendMode( response, PinMode::SERVO, board_.servoResolution );
+        if( board_.isI2c( pin ) ) appendMode( response, PinMode::I2C, MODE_ENABLED );
+        response.push_back( FIRMATA_END_OF_PIN_VALUE );
+    }
+
+    return response;
+}
+
+std::vector<uint8_t>
+BoardProfiles::analogMappingResponse(
+    const BoardDescriptor &board_
+    )
+{
+    std::vector<uint8_t> response( board_.totalPins );
+    for( size_t pin = 0; pin < board_.totalPins; ++pin )
+    {
+        response[pin] = board_.analogChannel( pin );
+    }
+    return response;
+}
@@ -0,0 +1,296 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CapabilityParser.h"
+#include "../../Firmata/Core/FirmataProtocol.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+namespace Core {
+
+/*
+ * The pins of a board as StandardFirmata 2.5 describes them, as rules from which every query is answered by a constexpr
+ * function, so a profile can be known before connecting and a pin checked while compiling.
+ * - Digital pins take INPUT, INPUT_PULLUP, OUTPUT and SERVO.
+ * - Analog pins are numbered consecutively, pin firstAnalogPin reads channel 0.
+ * - PWM pins are listed in a bitmask, I2C uses one pair of pins.
+ * - Pins are reported in ports of 8, so the board has ( totalPins + 7 ) / 8 ports.
+ */
+struct BoardDescriptor
+{
+    const char *name;
+    uint8_t totalPins;
+    uint8_t firstDigitalPin;
+    uint8_t digitalPinCount;
+    uint8_t firstAnalogPin;
+    uint8_t analogPinCount;
+    uint64_t pwmPinsLow;    //bit n is set if pin n supports PWM
+    uint64_t pwmPinsHigh;   //bit n is set if pin 64 + n supports PWM
+    uint8_t sdaPin;
+    uint8_t sclPin;
+    uint8_t analogResolution;
+    uint8_t pwmResolution;
+    uint8_t servoResolution;
+
+    constexpr
+    bool
+    isDigital(
+        size_t pin_
+    ) const
+    {
+        return pin_ >= firstDigitalPin && pin_ < static_cast<size_t>( firstDigitalPin ) + digitalPinCount;
+    }
+
+    constexpr
+    bool
+    isAnalog(
+        size_t pin_
+    ) const
+    {
+        return pin_ >= firstAnalogPin && pin_ < static_cast<size_t>( firstAnalogPin ) + analogPinCount;
+    }
+
+    constexpr
+    bool
+    isPwm(
+        size_t pin_
+    ) const
+    {
+        return ( pin_ < 64 ) ? ( ( pwmPinsLow >> pin_ ) & 1 ) != 0 : ( pin_ < 128 && ( ( pwmPinsHigh >> ( pin_ - 64 ) ) & 1 ) != 0 );
+    }
+
+    constexpr
+    bool
+    isI2c(
+        size_t pin_
+    ) const
+    {
+        return pin_ == sdaPin || pin_ == sclPin;
+    }
+
+    ///<summary>
+    ///Returns the Capability bitmask of the given pin, 0 if the pin is out of range
+    ///</summary>
+    constexpr
+    uint8_t
+    capabilities(
+        size_t pin_
+    ) const
+    {
+        return ( pin_ >= totalPins ) ? 0 : static_cast<uint8_t>(
+            ( isDigital( pin_ ) ? static_cast<uint8_t>( Capability::INPUT ) | static_cast<uint8_t>( Capability::INPUT_PULLUP ) | static_cast<uint8_t>( Capability::OUTPUT ) | static_cast<uint8_t>( Capability::SERVO ) : 0 )
+          | ( isAnalog( pin_ ) ? static_cast<uint8_t>( Capability::ANALOG ) : 0 )
+          | ( isPwm( pin_ ) ? static_cast<uint8_t>( Capability::PWM ) : 0 )
+          | ( isI2c( pin_ ) ? static_cast<uint8_t>( Capability::I2C ) : 0 ) );
+    }
+
+    ///<summary>
+    ///Returns the analog channel read by the given pin, BoardCapabilities::NO_CHANNEL if it reads none
+    ///</summary>
+    constexpr
+    uint8_t
+    analogChannel(
+        size_t pin_
+    ) const
+    {
+        return ( pin_ < totalPins && isAnalog( pin_ ) && pin_ - firstAnalogPin < BoardCapabilities::MAX_ANALOG_CHANNELS ) ? static_cast<uint8_t>( pin_ - firstAnalogPin ) : static_cast<uint8_t>( BoardCapabilities::NO_CHANNEL );
+    }
+
+    ///<summary>
+    ///Returns the pin which reads the given analog channel, BoardCapabilities::NO_PIN if none does
+    ///</summary>
+    constexpr
+    uint8_t
+    channelPin(
+        size_t channel_
+    ) const
+    {
+        return ( channel_ < analogPinCount && channel_ < BoardCapabilities::MAX_ANALOG_CHANNELS ) ? static_cast<uint8_t>( firstAnalogPin + channel_ ) : static_cast<uint8_t>( BoardCapabilities::NO_PIN );
+    }
+
+    constexpr
+    uint8_t
+    portCount(
+        void
+    ) const
+    {
+        return static_cast<uint8_t>( ( totalPins + 7 ) / 8 );
+    }
+
+    ///<summary>
+    ///Returns true if the given pin can be set to the given mode, as RemoteDevice checks before every mode change
+    ///</summary>
+    constexpr
+    bool
+    isModeSupported(
+        size_t pin_,
+        Microsoft::Maker::Firmata::Core::PinMode mode_
+    ) const
+    {
+        return ( mode_ == Microsoft::Maker::Firmata::Core::PinMode::ANALOG ) ? ( analogChannel( pin_ ) != BoardCapabilities::NO_CHANNEL )
+             : ( mode_ == Microsoft::Maker::Firmata::Core::PinMode::INPUT ) ? ( ( capabilities( pin_ ) & static_cast<uint8_t>( Capability::INPUT ) ) != 0 )
+             : ( mode_ == Microsoft::Maker::Firmata::Core::PinMode::PULLUP ) ? ( ( capabilities( pin_ ) & static_cast<uint8_t>( Capability::INPUT_PULLUP ) ) != 0 )
+             : ( mode_ == Microsoft::Maker::Firmata::Core::PinMode::OUTPUT ) ? ( ( capabilities( pin_ ) & static_cast<uint8_t>( Capability::OUTPUT ) ) != 0 )
+             : ( mode_ == Microsoft::Maker::Firmata::Core::PinMode::PWM ) ? ( ( capabilities( pin_ ) & static_cast<uint8_t>( Capability::PWM ) ) != 0 )
+             : ( mode_ == Microsoft::Maker::Firmata::Core::PinMode::SERVO ) ? ( ( capabilities( pin_ ) & static_cast<uint8_t>( Capability::SERVO ) ) != 0 )
+             : ( mode_ == Microsoft::Maker::Firmata::Core::PinMode::I2C ) ? ( ( capabilities( pin_ ) & static_cast<uint8_t>( Capability::I2C ) ) != 0 )
+             : false;
+    }
+};
+
+//ATmega328P with 6 analog inputs
+constexpr BoardDescriptor ARDUINO_UNO = {
+    "Arduino Uno",
+    20,                                                 //total pins
+    2, 18,                                              //digital pins 2-19
+    14, 6,                                              //analog pins 14-19 (A0-A5)
+    ( 1ull << 3 ) | ( 1ull << 5 ) | ( 1ull << 6 ) | ( 1ull << 9 ) | ( 1ull << 10 ) | ( 1ull << 11 ), 0,
+    18, 19,                                             //SDA, SCL
+    10, 8, 14                                           //analog, PWM and servo resolutions
+};
+
+//ATmega328P with 8 analog inputs, A6 and A7 are analog only
+constexpr BoardDescriptor ARDUINO_NANO = {
+    "Arduino Nano",
+    22,
+    2, 18,
+    14, 8,
+    ( 1ull << 3 ) | ( 1ull << 5 ) | ( 1ull << 6 ) | ( 1ull << 9 ) | ( 1ull << 10 ) | ( 1ull << 11 ), 0,
+    18, 19,
+    10, 8, 14
+};
+
+//ATmega2560
+constexpr BoardDescriptor ARDUINO_MEGA_2560 = {
+    "Arduino Mega 2560",
+    70,
+    2, 68,
+    54, 16,
+    ( 0xFFFull << 2 ) | ( 1ull << 44 ) | ( 1ull << 45 ) | ( 1ull << 46 ), 0,
+    20, 21,
+    10, 8, 14
+};
+
+//ATmega32U4, pins 24-29 are A6-A11, the analog inputs shared with digital pins 4, 6, 8, 9, 10 and 12. firmata treats
+//every pin as digital on this board, so they take the digital modes as well.
+constexpr BoardDescriptor ARDUINO_LEONARDO = {
+    "Arduino Leonardo",
+    30,
+    0, 30,
+    18, 12,
+    ( 1ull << 3 ) | ( 1ull << 5 ) | ( 1ull << 6 ) | ( 1ull << 9 ) | ( 1ull << 10 ) | ( 1ull << 11 ) | ( 1ull << 13 ), 0,
+    2, 3,
+    10, 8, 14
+};
+
+enum class Board : uint8_t
+{
+    ARDUINO_UNO = 0,
+    ARDUINO_NANO = 1,
+    ARDUINO_MEGA_2560 = 2,
+    ARDUINO_LEONARDO = 3,
+};
+
+/*
+ * Selects the descriptor of a board while compiling, so code written for one board can check its pins with static_assert
+ */
+template <Board BOARD>
+struct KnownBoard;
+
+template <>
+struct KnownBoard<Board::ARDUINO_UNO>
+{
+    static constexpr BoardDescriptor descriptor( void ) { return ARDUINO_UNO; }
+};
+
+template <>
+struct KnownBoard<Board::ARDUINO_NANO>
+{
+    static constexpr BoardDescriptor descriptor( void ) { return ARDUINO_NANO; }
+};
+
+template <>
+struct KnownBoard<Board::ARDUINO_MEGA_2560>
+{
+    static constexpr BoardDescriptor descriptor( void ) { return ARDUINO_MEGA_2560; }
+};
+
+template <>
+struct KnownBoard<Board::ARDUINO_LEONARDO>
+{
+    static constexpr BoardDescriptor descriptor( void ) { return ARDUINO_LEONARDO; }
+};
+
+///<summary>
+///Returns the descriptor of the given board, for code which only learns the board while running
+///</summary>
+constexpr
+BoardDescriptor
+describeBoard(
+    Board board_
+)
+{
+    return ( board_ == Board::ARDUINO_NANO ) ? ARDUINO_NANO
+         : ( board_ == Board::ARDUINO_MEGA_2560 ) ? ARDUINO_MEGA_2560
+         : ( board_ == Board::ARDUINO_LEONARDO ) ? ARDUINO_LEONARDO
+         : ARDUINO_UNO;
+}
+
+namespace BoardProfiles {
+
+///<summary>
+///Builds the CAPABILITY_RESPONSE body the board would send, so its profile is parsed exactly as a live one would be
+///</summary>
+std::vector<uint8_t>
+capabilityResponse(
+    const BoardDescriptor &board_
+);
+
+///<summary>
+///Builds the ANALOG_MAPPING_RESPONSE body the board would send
+///</summary>
+std::vector<uint8_t>
+analogMappingResponse(
+    const BoardDescriptor &board_
+);
+
+} // namespace BoardProfiles
+
+//the descriptors agree with the channel numbering firmware uses on these boards
+static_assert( ARDUINO_UNO.channelPin( 0 ) == 14 && ARDUINO_UNO.analogChannel( 19 ) == 5 && ARDUINO_UNO.portCount() == 3, "Uno analog pins are A0-A5 on pins 14-19" );
+static_assert( ARDUINO_NANO.analogChannel( 21 ) == 7 && ARDUINO_NANO.capabilities( 21 ) == static_cast<uint8_t>( Capability::ANALOG ), "Nano A7 is analog only" );
+static_assert( ARDUINO_MEGA_2560.channelPin( 15 ) == 69 && ARDUINO_MEGA_2560.isPwm( 13 ) && ARDUINO_MEGA_2560.isPwm( 46 ) && !ARDUINO_MEGA_2560.isPwm( 47 ), "Mega analog and PWM pins" );
+static_assert( ARDUINO_LEONARDO.channelPin( 11 ) == 29 && ARDUINO_LEONARDO.isDigital( 29 ) && ARDUINO_LEONARDO.capabilities( 29 ) == ARDUINO_LEONARDO.capabilities( 18 ), "Leonardo A6-A11 are reported as pins 24-29, digital like A0-A5" );
+
+} // namespace Core
+} // namespace RemoteWiring
+} // namespace Maker
+} // namespace Microsoft
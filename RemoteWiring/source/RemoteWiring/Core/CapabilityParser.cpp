@@ -0,0 +1,224 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "CapabilityParser.h"
+#include "../../Firmata/Core/FirmataProtocol.h"
+
+using namespace Microsoft::Maker::RemoteWiring::Core;
+
+typedef Microsoft::Maker::Firmata::Core::PinMode PinMode;
+
+namespace {
+
+const uint8_t MODE_ENABLED = 1;
+const uint8_t FIRMATA_END_OF_PIN_VALUE = 0x7F;
+
+void
+append(
+    BoardCapabilities::PinList &list_,
+    uint8_t pin_
+    )
+{
+    list_.pins[list_.count++] = pin_;
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+BoardCapabilities::BoardCapabilities(
+    void
+    ) :
+    pinCapabilities(),
+    resolutions(),
+    analogPins(),
+    digitalPins(),
+    disabledPins(),
+    i2cPins(),
+    pwmPins(),
+    servoPins(),
+    totalPinCount( 0 ),
+    analogOffset( 0 ),
+    analogPinCount( 0 )
+{
+    analogChannels.fill( static_cast<uint8_t>( NO_CHANNEL ) );
+    channelPins.fill( static_cast<uint8_t>( NO_PIN ) );
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+bool
+CapabilityParser::parse(
+    const uint8_t *data_,
+    size_t length_,
+    BoardCapabilities &capabilities_
+    )
+{
+    BoardCapabilities parsed;
+    size_t total_pins = 0;
+    uint8_t analog_offset = 0xFF;
+    size_t num_analog_pins = 0;
+
+    for( size_t i = 0; i < length_; ++i )
+    {
+        uint8_t pin_capabilities = 0;
+
+        //a pin number must fit in the 7 bits Firmata addresses pins with
+        if( total_pins >= BoardCapabilities::MAX_PINS )
+        {
+            return false;
+        }
+
+        //each mode is followed by a single byte, which is either a resolution or a flag telling whether the mode is enabled
+        while( i < length_ && data_[i] != FIRMATA_END_OF_PIN_VALUE )
+        {
+            if( i + 1 >= length_ )
+            {
+                return false;   //we've failed to get all of the data
+            }
+
+            const uint8_t pin = static_cast<uint8_t>( total_pins );
+            const uint8_t value = data_[i + 1];
+            switch( static_cast<PinMode>( data_[i] ) )
+            {
+            case PinMode::INPUT:
+                if( value == MODE_ENABLED ) pin_capabilities |= static_cast<uint8_t>( Capability::INPUT );
+                break;
+
+            case PinMode::OUTPUT:
+                if( value == MODE_ENABLED ) pin_capabilities |= static_cast<uint8_t>( Capability::OUTPUT );
+                break;
+
+            case PinMode::PULLUP:
+                if( value == MODE_ENABLED ) pin_capabilities |= static_cast<uint8_t>( Capability::INPUT_PULLUP );
+                break;
+
+            case PinMode::I2C:
+                if( value == MODE_ENABLED ) pin_capabilities |= static_cast<uint8_t>( Capability::I2C );
+                break;
+
+            case PinMode::ANALOG:
+                //a pin reporting ANALOG twice would otherwise be counted twice
+                if( pin_capabilities & static_cast<uint8_t>( Capability::ANALOG ) ) return false;
+                pin_capabilities |= static_cast<uint8_t>( Capability::ANALOG );
+                parsed.resolutions[pin].analog = value;
+
+                //analog offset keeps track of the first pin found that supports analog read, tells us how many digital pins we have,
+                //and allows us to convert analog pins like "A0" to the correct pin number
+                if( analog_offset == 0xFF )
+                {
+                    analog_offset = pin;
+                }
+                ++num_analog_pins;
+                break;
+
+            case PinMode::PWM:
+                pin_capabilities |= static_cast<uint8_t>( Capability::PWM );
+                parsed.resolutions[pin].pwm = value;
+                break;
+
+            case PinMode::SERVO:
+                pin_capabilities |= static_cast<uint8_t>( Capability::SERVO );
+                parsed.resolutions[pin].servo = value;
+                break;
+
+            default:
+                //this mode isn't recognized, but it still carries its byte. skipping both keeps us aligned with the modes that follow
+                break;
+            }
+            i += 2;
+        }
+        parsed.pinCapabilities[total_pins] = pin_capabilities;
+        ++total_pins;
+    }
+
+    //list the pins sharing each capability once, rather than on every query
+    for( size_t pin = 0; pin < total_pins; ++pin )
+    {
+        const uint8_t pin_capabilities = parsed.pinCapabilities[pin];
+        const uint8_t pin_number = static_cast<uint8_t>( pin );
+
+        if( !pin_capabilities ) append( parsed.disabledPins, pin_number );
+        if( pin_capabilities & static_cast<uint8_t>( Capability::ANALOG ) ) append( parsed.analogPins, pin_number );
+        if( pin_capabilities & static_cast<uint8_t>( Capability::OUTPUT ) ) append( parsed.digitalPins, pin_number );
+        if( pin_capabilities & static_cast<uint8_t>( Capability::I2C ) ) append( parsed.i2cPins, pin_number );
+        if( pin_capabilities & static_cast<uint8_t>( Capability::PWM ) ) append( parsed.pwmPins, pin_number );
+        if( pin_capabilities & static_cast<uint8_t>( Capability::SERVO ) ) append( parsed.servoPins, pin_number );
+    }
+
+    //until the board's analog mapping is known, its analog pins read consecutive channels in pin order
+    for( size_t channel = 0; channel < parsed.analogPins.count && channel < BoardCapabilities::MAX_ANALOG_CHANNELS; ++channel )
+    {
+        parsed.analogChannels[parsed.analogPins.pins[channel]] = static_cast<uint8_t>( channel );
+        parsed.channelPins[channel] = parsed.analogPins.pins[channel];
+    }
+
+    parsed.totalPinCount = static_cast<uint8_t>( total_pins );
+    parsed.analogOffset = analog_offset;
+    parsed.analogPinCount = static_cast<uint8_t>( num_analog_pins );
+    capabilities_ = parsed;
+    return true;
+}
+
+bool
+CapabilityParser::parseAnalogMapping(
+    const uint8_t *data_,
+    size_t length_,
+    BoardCapabilities &capabilities_
+    )
+{
+    std::array<uint8_t, BoardCapabilities::MAX_PINS> analog_channels;
+    std::array<uint8_t, BoardCapabilities::MAX_ANALOG_CHANNELS> channel_pins;
+    analog_channels.fill( static_cast<uint8_t>( BoardCapabilities::NO_CHANNEL ) );
+    channel_pins.fill( static_cast<uint8_t>( BoardCapabilities::NO_PIN ) );
+
+    //the response describes the same pins as the capability response
+    if( length_ != capabilities_.totalPinCount ) return false;
+
+    for( size_t pin = 0; pin < length_; ++pin )
+    {
+        const uint8_t channel = data_[pin];
+        if( channel == BoardCapabilities::NO_CHANNEL ) continue;
+
+        //a channel must be one that can be reported, read by a single pin which can read it
+        if( channel >= BoardCapabilities::MAX_ANALOG_CHANNELS
+         || channel_pins[channel] != BoardCapabilities::NO_PIN
+         || !( capabilities_.pinCapabilities[pin] & static_cast<uint8_t>( Capability::ANALOG ) ) )
+        {
+            return false;
+        }
+
+        analog_channels[pin] = channel;
+        channel_pins[channel] = static_cast<uint8_t>( pin );
+    }
+
+    capabilities_.analogChannels = analog_channels;
+    capabilities_.channelPins = channel_pins;
+    return true;
+}
@@ -0,0 +1,179 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+namespace Core {
+
+//native mirror of the public PinCapability enum, each capability is one bit of a pin's capability bitmask
+enum class Capability : uint8_t
+{
+    INPUT = 0x01,
+    INPUT_PULLUP = 0x02,
+    OUTPUT = 0x04,
+    ANALOG = 0x08,
+    PWM = 0x10,
+    SERVO = 0x20,
+    I2C = 0x40,
+};
+
+/*
+ * The pins of a board and what each of them can do, as described by a CAPABILITY_RESPONSE.
+ * Everything is held in fixed-size arrays indexed by pin number, and the pins sharing each capability are listed when the
+ * response is parsed, so no query needs to allocate or scan the pins.
+ */
+struct BoardCapabilities
+{
+    //Firmata addresses pins with 7 bits
+    static const size_t MAX_PINS = 128;
+
+    //analog values are reported with one of 16 channel commands
+    static const size_t MAX_ANALOG_CHANNELS = 16;
+
+    //marks a pin which reads no analog channel, as ANALOG_MAPPING_RESPONSE does
+    static const uint8_t NO_CHANNEL = 0x7F;
+
+    //marks a channel which no pin reads
+    static const uint8_t NO_PIN = 0xFF;
+
+    //the numbers of the pins sharing a capability, in ascending order
+    struct PinList
+    {
+        std::array<uint8_t, MAX_PINS> pins;
+        uint8_t count;
+
+        const uint8_t *begin( void ) const { return pins.data(); }
+        const uint8_t *end( void ) const { return pins.data() + count; }
+    };
+
+    //the resolution in bits of each capability which has one, 0 where the pin does not have the capability
+    struct PinResolutions
+    {
+        uint8_t analog;
+        uint8_t pwm;
+        uint8_t servo;
+    };
+
+    //the Capability bitmask of each pin, 0 for pins beyond totalPinCount
+    std::array<uint8_t, MAX_PINS> pinCapabilities;
+    std::array<PinResolutions, MAX_PINS> resolutions;
+
+    PinList analogPins;
+    PinList digitalPins;
+    PinList disabledPins;
+    PinList i2cPins;
+    PinList pwmPins;
+    PinList servoPins;
+
+    //the analog channel read by each pin and the pin read by each channel. parse() numbers the analog pins' channels in
+    //pin order, which holds for most boards, and parseAnalogMapping() replaces that with the board's own mapping.
+    std::array<uint8_t, MAX_PINS> analogChannels;
+    std::array<uint8_t, MAX_ANALOG_CHANNELS> channelPins;
+
+    uint8_t totalPinCount;
+    uint8_t analogOffset;
+    uint8_t analogPinCount;
+
+    BoardCapabilities(
+        void
+    );
+
+    ///<summary>
+    ///Returns the capability bitmask of the given pin, 0 if the pin is out of range
+    ///</summary>
+    uint8_t
+    capabilities(
+        size_t pin_
+    ) const
+    {
+        return ( pin_ < totalPinCount ) ? pinCapabilities[pin_] : 0;
+    }
+
+    ///<summary>
+    ///Returns the analog channel read by the given pin, NO_CHANNEL if it reads none
+    ///</summary>
+    uint8_t
+    analogChannel(
+        size_t pin_
+    ) const
+    {
+        return ( pin_ < totalPinCount ) ? analogChannels[pin_] : NO_CHANNEL;
+    }
+
+    ///<summary>
+    ///Returns the pin which reads the given analog channel, NO_PIN if none does
+    ///</summary>
+    uint8_t
+    channelPin(
+        size_t channel_
+    ) const
+    {
+        return ( channel_ < MAX_ANALOG_CHANNELS ) ? channelPins[channel_] : NO_PIN;
+    }
+};
+
+namespace CapabilityParser {
+
+///<summary>
+///Parses the body of a CAPABILITY_RESPONSE (everything between the command byte and END_SYSEX)
+///<param name="data_">The response body</param>
+///<param name="length_">The number of bytes in the response body</param>
+///<param name="capabilities_">Receives the parsed capabilities, it is left untouched if the response is malformed</param>
+///<returns>true if the response was complete and consistent, false otherwise</returns>
+///</summary>
+bool
+parse(
+    const uint8_t *data_,
+    size_t length_,
+    BoardCapabilities &capabilities_
+);
+
+///<summary>
+///Parses the body of an ANALOG_MAPPING_RESPONSE, one byte per pin holding its channel or 127, into the channel lookups of
+///capabilities already parsed from the same board's CAPABILITY_RESPONSE
+///<param name="data_">The response body</param>
+///<param name="length_">The number of bytes in the response body</param>
+///<param name="capabilities_">Has its analogChannels and channelPins replaced, they are left untouched if the response is
+///malformed or disagrees with the capabilities</param>
+///<returns>true if every pin was mapped, each channel to a single analog-capable pin</returns>
+///</summary>
+bool
+parseAnalogMapping(
+    const uint8_t *data_,
+    size_t length_,
+    BoardCapabilities &capabilities_
+);
+
+} // namespace CapabilityParser
+} // namespace Core
+} // namespace RemoteWiring
+} // namespace Maker
+} // namespace Microsoft
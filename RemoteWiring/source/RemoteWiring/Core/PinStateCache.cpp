@@ -0,0 +1,313 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "PinStateCache.h"
+#include "../../Firmata/Core/FirmataEncoder.h"
+
+#include <thread>
+
+using namespace Microsoft::Maker::RemoteWiring::Core;
+
+namespace FirmataCore = Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+//how many times to retry a change in progress before giving up the time slice, in case its writer has been preempted
+const unsigned SPINS_BEFORE_YIELD = 64;
+
+void
+backOff(
+    unsigned *spins_
+    )
+{
+    if( ++*spins_ >= SPINS_BEFORE_YIELD )
+    {
+        *spins_ = 0;
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+PinStateCache::PinStateCache(
+    void
+    ) :
+    _sequence( 0 )
+{
+    reset();
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+void
+PinStateCache::getPinMap(
+    uint8_t pin_,
+    uint8_t *port_,
+    uint8_t *port_mask_
+    )
+{
+    if( port_ != nullptr )
+    {
+        *port_ = ( pin_ / 8 );
+    }
+    if( port_mask_ != nullptr )
+    {
+        *port_mask_ = ( 1 << ( pin_ % 8 ) );
+    }
+}
+
+uint16_t
+PinStateCache::analogValue(
+    uint8_t channel_
+    ) const
+{
+    if( channel_ >= MAX_ANALOG_PINS ) return 0;
+    return _analog_pins[channel_];
+}
+
+bool
+PinStateCache::digitalValue(
+    uint8_t pin_
+    ) const
+{
+    uint8_t port;
+    uint8_t port_mask;
+    getPinMap( pin_, &port, &port_mask );
+
+    if( port >= MAX_PORTS ) return false;
+    return ( _digital_port[port] & port_mask ) > 0;
+}
+
+uint8_t
+PinStateCache::digitalPortValue(
+    uint8_t port_
+    ) const
+{
+    if( port_ >= MAX_PORTS ) return 0;
+    return _digital_port[port_];
+}
+
+uint8_t
+PinStateCache::mergeDigitalReport(
+    uint8_t port_,
+    uint8_t value_,
+    uint8_t *merged_value_
+    )
+{
+    if( port_ >= MAX_PORTS ) return 0;
+
+    beginUpdate();
+
+    //output_state will only set bits which correspond to output pins that are HIGH
+    uint8_t output_state = ~_subscribed_ports[port_] & _digital_port[port_];
+    uint8_t port_val = value_ | output_state;
+
+    //determine which pins have changed, then update the cache
+    uint8_t port_xor = port_val ^ _digital_port[port_];
+    _digital_port[port_] = port_val;
+
+    endUpdate();
+
+    if( merged_value_ != nullptr )
+    {
+        *merged_value_ = port_val;
+    }
+    return port_xor;
+}
+
+FirmataCore::PinMode
+PinStateCache::pinMode(
+    uint8_t pin_
+    ) const
+{
+    if( pin_ >= MAX_PINS ) return FirmataCore::PinMode::IGNORED;
+    return static_cast<FirmataCore::PinMode>( _pin_mode[pin_].load() );
+}
+
+void
+PinStateCache::reset(
+    void
+    )
+{
+    beginUpdate();
+    for( auto &port : _digital_port ) { port = 0; }
+    for( auto &port : _subscribed_ports ) { port = 0; }
+    for( auto &channel : _analog_pins ) { channel = 0; }
+    for( auto &mode : _pin_mode ) { mode = static_cast<uint8_t>( FirmataCore::PinMode::OUTPUT ); }
+    endUpdate();
+}
+
+void
+PinStateCache::snapshot(
+    PinStateSnapshot *out_
+    ) const
+{
+    if( out_ == nullptr ) return;
+
+    unsigned spins = 0;
+    for( ;; )
+    {
+        const uint32_t sequence = _sequence.load( std::memory_order_acquire );
+        if( sequence & 1 )
+        {
+            //a change is being made, and takes only a few instructions
+            backOff( &spins );
+            continue;
+        }
+
+        for( size_t i = 0; i < MAX_PORTS; ++i ) { out_->digital_ports[i] = _digital_port[i].load( std::memory_order_relaxed ); }
+        for( size_t i = 0; i < MAX_ANALOG_PINS; ++i ) { out_->analog_channels[i] = _analog_pins[i].load( std::memory_order_relaxed ); }
+
+        //the copies must complete before the sequence is checked again
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if( _sequence.load( std::memory_order_relaxed ) == sequence )
+        {
+            out_->sequence = sequence;
+            return;
+        }
+        backOff( &spins );
+    }
+}
+
+void
+PinStateCache::setAnalogValue(
+    uint8_t channel_,
+    uint16_t value_
+    )
+{
+    if( channel_ >= MAX_ANALOG_PINS ) return;
+    beginUpdate();
+    _analog_pins[channel_] = value_;
+    endUpdate();
+}
+
+uint8_t
+PinStateCache::setDigitalValue(
+    uint8_t pin_,
+    bool value_
+    )
+{
+    uint8_t port;
+    uint8_t port_mask;
+    getPinMap( pin_, &port, &port_mask );
+
+    if( port >= MAX_PORTS ) return 0;
+
+    beginUpdate();
+    if( value_ )
+    {
+        _digital_port[port] |= port_mask;
+    }
+    else
+    {
+        _digital_port[port] &= ~port_mask;
+    }
+    uint8_t port_val = _digital_port[port];
+    endUpdate();
+
+    return port_val;
+}
+
+size_t
+PinStateCache::setPinMode(
+    uint8_t pin_,
+    FirmataCore::PinMode mode_,
+    uint8_t *out_
+    )
+{
+    uint8_t port;
+    uint8_t port_mask;
+    getPinMap( pin_, &port, &port_mask );
+
+    if( pin_ >= MAX_PINS ) return 0;
+
+    size_t length = FirmataCore::FirmataEncoder::setPinMode( pin_, static_cast<uint8_t>( mode_ ), out_ );
+
+    beginUpdate();
+
+    //lets subscribe to this port if we're setting it to input
+    if( mode_ == FirmataCore::PinMode::INPUT )
+    {
+        _subscribed_ports[port] |= port_mask;
+        length += FirmataCore::FirmataEncoder::reportDigitalPort( port, _subscribed_ports[port] != 0, out_ + length );
+    }
+    //if the selected mode is NOT input and we WERE subscribed to it, unsubscribe
+    else if( _pin_mode[pin_] == static_cast<uint8_t>( FirmataCore::PinMode::INPUT ) )
+    {
+        _subscribed_ports[port] &= ~port_mask;
+        length += FirmataCore::FirmataEncoder::reportDigitalPort( port, _subscribed_ports[port] != 0, out_ + length );
+    }
+
+    //if the pin mode is being set to output, and it isn't already in output mode, the pin value is set to 0
+    if( mode_ == FirmataCore::PinMode::OUTPUT && _pin_mode[pin_] != static_cast<uint8_t>( FirmataCore::PinMode::OUTPUT ) )
+    {
+        _digital_port[port] &= ~port_mask;
+    }
+
+    _pin_mode[pin_] = static_cast<uint8_t>( mode_ );
+    endUpdate();
+
+    return length;
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+PinStateCache::beginUpdate(
+    void
+    )
+{
+    //making the sequence odd claims the right to change values, another writer holds it for a few instructions at most
+    uint32_t sequence = _sequence.load( std::memory_order_relaxed );
+    unsigned spins = 0;
+    for( ;; )
+    {
+        if( !( sequence & 1 ) && _sequence.compare_exchange_weak( sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed ) )
+        {
+            break;
+        }
+        backOff( &spins );
+        sequence = _sequence.load( std::memory_order_relaxed );
+    }
+    std::atomic_thread_fence( std::memory_order_release );
+}
+
+void
+PinStateCache::endUpdate(
+    void
+    )
+{
+    //only the writer which made the sequence odd can be here
+    _sequence.store( _sequence.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+}
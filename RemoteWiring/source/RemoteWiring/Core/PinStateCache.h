@@ -0,0 +1,195 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "../../Firmata/Core/FirmataProtocol.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+namespace Core {
+
+struct PinStateSnapshot;
+
+/*
+ * The last known state of every pin on the board: its mode, the value of each digital port and of each analog channel,
+ * and which ports are reporting.
+ * Every change is made under a sequence lock, so changes can be made from any thread (reports from the input thread,
+ * writes and mode changes from the app) without tearing each other. Readers never take it: a single value is one atomic
+ * load, and snapshot() copies all of them at once, retrying if a change lands in the middle, so a reader never makes a
+ * writer wait. Owners which send the messages built by setPinMode must still serialize those calls themselves, so the
+ * board sees mode changes in the same order as the cache.
+ */
+class PinStateCache
+{
+public:
+    static const size_t MAX_PORTS = 16;
+    static const size_t MAX_PINS = 128;
+    static const size_t MAX_ANALOG_PINS = 16;
+
+    //the longest message produced by setPinMode
+    static const size_t MAX_PIN_MODE_MESSAGE_SIZE = 5;
+
+    PinStateCache(
+        void
+    );
+
+    ///<summary>
+    ///Maps the given pin number to its port and the bit it occupies within that port
+    ///</summary>
+    static
+    void
+    getPinMap(
+        uint8_t pin_,
+        uint8_t *port_,
+        uint8_t *port_mask_
+    );
+
+    uint16_t
+    analogValue(
+        uint8_t channel_
+    ) const;
+
+    ///<summary>
+    ///Returns true if the pin is set in the cached value of its port
+    ///</summary>
+    bool
+    digitalValue(
+        uint8_t pin_
+    ) const;
+
+    uint8_t
+    digitalPortValue(
+        uint8_t port_
+    ) const;
+
+    ///<summary>
+    ///Merges a reported port value with the cached state of the output pins in that port
+    ///<param name="port_">The reporting port</param>
+    ///<param name="value_">The reported value, only the bits of subscribed pins are meaningful</param>
+    ///<param name="merged_value_">Receives the new value of the port</param>
+    ///<returns>a mask of the pins whose value changed</returns>
+    ///</summary>
+    uint8_t
+    mergeDigitalReport(
+        uint8_t port_,
+        uint8_t value_,
+        uint8_t *merged_value_
+    );
+
+    Microsoft::Maker::Firmata::Core::PinMode
+    pinMode(
+        uint8_t pin_
+    ) const;
+
+    ///<summary>
+    ///Returns every pin to OUTPUT, with all values cleared and no port reporting
+    ///</summary>
+    void
+    reset(
+        void
+    );
+
+    ///<summary>
+    ///Copies every digital port and analog channel value as they stood at a single moment. Safe to call from any thread.
+    ///<para>The copy is retried if a change is made while it is taken, so it never blocks the thread making changes.</para>
+    ///</summary>
+    void
+    snapshot(
+        PinStateSnapshot *out_
+    ) const;
+
+    void
+    setAnalogValue(
+        uint8_t channel_,
+        uint16_t value_
+    );
+
+    ///<summary>
+    ///Sets the cached value of a single pin
+    ///<returns>the new value of the pin's port</returns>
+    ///</summary>
+    uint8_t
+    setDigitalValue(
+        uint8_t pin_,
+        bool value_
+    );
+
+    ///<summary>
+    ///Records a new mode for the pin and builds the message that applies it on the board. When the pin enters or leaves INPUT
+    ///the message also updates the reporting state of its port, so both commands travel together.
+    ///<param name="out_">Receives the message, it must hold MAX_PIN_MODE_MESSAGE_SIZE bytes</param>
+    ///<returns>the length of the message</returns>
+    ///</summary>
+    size_t
+    setPinMode(
+        uint8_t pin_,
+        Microsoft::Maker::Firmata::Core::PinMode mode_,
+        uint8_t *out_
+    );
+
+private:
+    std::array<std::atomic_uint8_t, MAX_PORTS> _subscribed_ports;
+    std::array<std::atomic_uint8_t, MAX_PORTS> _digital_port;
+    std::array<std::atomic_uint16_t, MAX_ANALOG_PINS> _analog_pins;
+    std::array<std::atomic_uint8_t, MAX_PINS> _pin_mode;
+
+    //odd while a change is being made, which also excludes other writers, see beginUpdate and endUpdate
+    std::atomic<uint32_t> _sequence;
+
+    void
+    beginUpdate(
+        void
+    );
+
+    void
+    endUpdate(
+        void
+    );
+
+    PinStateCache( const PinStateCache & ) = delete;
+    PinStateCache & operator=( const PinStateCache & ) = delete;
+};
+
+/*
+ * A consistent copy of every digital port and analog channel value, as taken by PinStateCache::snapshot
+ */
+struct PinStateSnapshot
+{
+    //changes whenever any value changes, so equal sequences mean nothing has been reported in between
+    uint32_t sequence;
+    std::array<uint8_t, PinStateCache::MAX_PORTS> digital_ports;
+    std::array<uint16_t, PinStateCache::MAX_ANALOG_PINS> analog_channels;
+};
+
+} // namespace Core
+} // namespace RemoteWiring
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,294 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "ProfileCache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Microsoft::Maker::RemoteWiring::Core;
+
+namespace {
+
+const uint8_t PROFILE_MAGIC[4] = { 'F', 'P', 'R', 'C' };
+const uint8_t PROFILE_VERSION = 2;
+
+uint32_t
+fnv1a(
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    uint32_t hash = 2166136261u;
+    for( size_t i = 0; i < length_; ++i )
+    {
+        hash ^= data_[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+inline
+void
+appendUint32(
+    std::vector<uint8_t> &out_,
+    uint32_t value_
+    )
+{
+    for( size_t i = 0; i < 4; ++i )
+    {
+        out_.push_back( static_cast<uint8_t>( value_ >> ( 8 * i ) ) );
+    }
+}
+
+inline
+uint32_t
+readUint32(
+    const uint8_t *data_
+    )
+{
+    return static_cast<uint32_t>( data_[0] ) | ( static_cast<uint32_t>( data_[1] ) << 8 ) | ( static_cast<uint32_t>( data_[2] ) << 16 ) | ( static_cast<uint32_t>( data_[3] ) << 24 );
+}
+
+#ifdef _WIN32
+std::wstring
+widen(
+    const std::string &path_
+    )
+{
+    //paths are UTF-8, the C runtime only accepts those in their UTF-16 form
+    std::wstring wide_path( MultiByteToWideChar( CP_UTF8, 0, path_.c_str(), -1, nullptr, 0 ), L'\0' );
+    MultiByteToWideChar( CP_UTF8, 0, path_.c_str(), -1, &wide_path[0], static_cast<int>( wide_path.size() ) );
+    return wide_path;
+}
+#endif
+
+std::FILE *
+openFile(
+    const std::string &path_,
+    bool write_
+    )
+{
+#ifdef _WIN32
+    std::FILE *file = nullptr;
+    return ( _wfopen_s( &file, widen( path_ ).c_str(), write_ ? L"wb" : L"rb" ) == 0 ) ? file : nullptr;
+#else
+    return std::fopen( path_.c_str(), write_ ? "wb" : "rb" );
+#endif
+}
+
+bool
+removeFile(
+    const std::string &path_
+    )
+{
+#ifdef _WIN32
+    return ( _wremove( widen( path_ ).c_str() ) == 0 );
+#else
+    return ( std::remove( path_.c_str() ) == 0 );
+#endif
+}
+
+//unique per process and per store, so no other writer of the same firmware shares it
+std::string
+temporaryPath(
+    const std::string &path_
+    )
+{
+    static std::atomic<uint32_t> store_count( 0 );
+#ifdef _WIN32
+    const unsigned long process_id = ::GetCurrentProcessId();
+#else
+    const unsigned long process_id = static_cast<unsigned long>( ::getpid() );
+#endif
+    return path_ + "." + std::to_string( process_id ) + "." + std::to_string( store_count.fetch_add( 1, std::memory_order_relaxed ) ) + ".tmp";
+}
+
+bool
+replaceFile(
+    const std::string &from_,
+    const std::string &to_
+    )
+{
+#ifdef _WIN32
+    return !!MoveFileExW( widen( from_ ).c_str(), widen( to_ ).c_str(), MOVEFILE_REPLACE_EXISTING );
+#else
+    return ( std::rename( from_.c_str(), to_.c_str() ) == 0 );
+#endif
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+ProfileCache::ProfileCache(
+    const std::string &folder_
+    ) :
+    _folder( folder_ )
+{
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+std::string
+ProfileCache::path(
+    const FirmwareIdentity &firmware_
+    ) const
+{
+    std::string file_name;
+    file_name.reserve( firmware_.name.size() + 16 );
+    for( char c : firmware_.name.substr( 0, MAX_NAME_LENGTH ) )
+    {
+        const bool safe = ( c >= 'A' && c <= 'Z' ) || ( c >= 'a' && c <= 'z' ) || ( c >= '0' && c <= '9' ) || c == '-' || c == '_';
+        file_name.push_back( safe ? c : '_' );
+    }
+    file_name += "-" + std::to_string( firmware_.major ) + "." + std::to_string( firmware_.minor ) + ".profile";
+
+    if( _folder.empty() ) return file_name;
+    const char last = _folder.back();
+    return ( last == '/' || last == '\\' ) ? _folder + file_name : _folder + "/" + file_name;
+}
+
+bool
+ProfileCache::load(
+    const FirmwareIdentity &firmware_,
+    CachedProfile &profile_
+    ) const
+{
+    if( firmware_.name.size() > MAX_NAME_LENGTH ) return false;
+
+    std::FILE *file = openFile( path( firmware_ ), false );
+    if( !file ) return false;
+
+    //the header is fixed by the identity we expect, so it can be compared whole
+    const std::vector<uint8_t> expected = header( firmware_ );
+    std::vector<uint8_t> contents( expected.size() );
+    bool valid = ( std::fread( contents.data(), 1, contents.size(), file ) == contents.size() ) && ( contents == expected );
+
+    //the sections and hash follow, a file holding more than the largest of them is not ours
+    const size_t max_body_length = 2 * ( 4 + MAX_RESPONSE_LENGTH ) + 4;
+    std::vector<uint8_t> body( valid ? max_body_length + 1 : 0 );
+    body.resize( valid ? std::fread( body.data(), 1, body.size(), file ) : 0 );
+    std::fclose( file );
+
+    valid = valid && body.size() >= 12 && body.size() <= max_body_length;
+    const size_t hashed_length = valid ? body.size() - 4 : 0;
+    valid = valid && readUint32( body.data() + hashed_length ) == fnv1a( body.data(), hashed_length );
+    if( !valid ) return false;
+
+    //each section is a length and that many bytes
+    CachedProfile loaded;
+    size_t position = 0;
+    for( std::vector<uint8_t> *section : { &loaded.capabilityResponse, &loaded.analogMappingResponse } )
+    {
+        if( hashed_length - position < 4 ) return false;
+        const uint32_t length = readUint32( body.data() + position );
+        position += 4;
+        if( length > hashed_length - position ) return false;
+        section->assign( body.begin() + position, body.begin() + position + length );
+        position += length;
+    }
+    if( position != hashed_length || loaded.capabilityResponse.empty() ) return false;
+
+    profile_ = std::move( loaded );
+    return true;
+}
+
+void
+ProfileCache::remove(
+    const FirmwareIdentity &firmware_
+    ) const
+{
+    removeFile( path( firmware_ ) );
+}
+
+bool
+ProfileCache::store(
+    const FirmwareIdentity &firmware_,
+    const CachedProfile &profile_
+    ) const
+{
+    if( firmware_.name.size() > MAX_NAME_LENGTH
+     || profile_.capabilityResponse.empty()
+     || profile_.capabilityResponse.size() > MAX_RESPONSE_LENGTH
+     || profile_.analogMappingResponse.size() > MAX_RESPONSE_LENGTH )
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> contents = header( firmware_ );
+    const size_t body_start = contents.size();
+    for( const std::vector<uint8_t> *section : { &profile_.capabilityResponse, &profile_.analogMappingResponse } )
+    {
+        appendUint32( contents, static_cast<uint32_t>( section->size() ) );
+        contents.insert( contents.end(), section->begin(), section->end() );
+    }
+    appendUint32( contents, fnv1a( contents.data() + body_start, contents.size() - body_start ) );
+
+    //two devices, possibly in different processes, may store the same firmware at once, so each writes under its own temporary name
+    const std::string final_path = path( firmware_ );
+    const std::string temporary_path = temporaryPath( final_path );
+
+    std::FILE *file = openFile( temporary_path, true );
+    if( !file ) return false;
+
+    const bool written = ( std::fwrite( contents.data(), 1, contents.size(), file ) == contents.size() );
+    if( std::fclose( file ) != 0 || !written || !replaceFile( temporary_path, final_path ) )
+    {
+        removeFile( temporary_path );
+        return false;
+    }
+    return true;
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+std::vector<uint8_t>
+ProfileCache::header(
+    const FirmwareIdentity &firmware_
+    )
+{
+    std::vector<uint8_t> header( PROFILE_MAGIC, PROFILE_MAGIC + sizeof( PROFILE_MAGIC ) );
+    header.push_back( PROFILE_VERSION );
+    header.push_back( static_cast<uint8_t>( firmware_.name.size() ) );
+    header.insert( header.end(), firmware_.name.begin(), firmware_.name.end() );
+    header.push_back( firmware_.major );
+    header.push_back( firmware_.minor );
+    return header;
+}
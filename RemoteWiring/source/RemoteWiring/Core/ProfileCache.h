@@ -0,0 +1,134 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+namespace Core {
+
+/*
+ * The identity a board reports in REPORT_FIRMWARE, which keys its cached responses
+ */
+struct FirmwareIdentity
+{
+    std::string name;
+    uint8_t major;
+    uint8_t minor;
+};
+
+/*
+ * The responses a board's hardware profile is built from, each body without its command byte and END_SYSEX
+ */
+struct CachedProfile
+{
+    std::vector<uint8_t> capabilityResponse;
+    std::vector<uint8_t> analogMappingResponse;    //empty if the board did not answer ANALOG_MAPPING_QUERY
+};
+
+/*
+ * Keeps the CAPABILITY_RESPONSE and ANALOG_MAPPING_RESPONSE of each firmware seen before in a folder on disk, so that a
+ * board running the same firmware can be given its profile as soon as it identifies itself, rather than after a
+ * capability query round trip.
+ *
+ * Each firmware has its own file, named after its sanitized name and version. The file holds the magic "FPRC", a format
+ * version byte, the length of the firmware name and the name itself (so names which sanitize alike cannot be confused),
+ * the version, then each response as a little-endian uint32 length followed by its bytes, and the FNV-1a hash of both.
+ * Files are written to a temporary name and then moved into place, so a reader never sees one half written.
+ * Every method may be called from any thread, no state is kept between calls.
+ */
+class ProfileCache
+{
+public:
+    ///<summary>
+    ///Uses the given folder, which must already exist. Paths are UTF-8.
+    ///</summary>
+    explicit
+    ProfileCache(
+        const std::string &folder_
+    );
+
+    ///<summary>
+    ///Returns the path of the file holding the given firmware's responses
+    ///</summary>
+    std::string
+    path(
+        const FirmwareIdentity &firmware_
+    ) const;
+
+    ///<summary>
+    ///Reads the responses cached for the given firmware into profile_
+    ///<returns>false if nothing is cached for it, or the file is damaged or belongs to another firmware</returns>
+    ///</summary>
+    bool
+    load(
+        const FirmwareIdentity &firmware_,
+        CachedProfile &profile_
+    ) const;
+
+    ///<summary>
+    ///Deletes the responses cached for the given firmware, if any
+    ///</summary>
+    void
+    remove(
+        const FirmwareIdentity &firmware_
+    ) const;
+
+    ///<summary>
+    ///Caches the given responses for the given firmware, replacing any cached for it before
+    ///<returns>false if the file could not be written or there is no capability response</returns>
+    ///</summary>
+    bool
+    store(
+        const FirmwareIdentity &firmware_,
+        const CachedProfile &profile_
+    ) const;
+
+private:
+    //firmware names are sent as 7-bit characters and are rarely longer than a sketch file name
+    static const size_t MAX_NAME_LENGTH = 255;
+
+    //a CAPABILITY_RESPONSE describes at most 128 pins of a few modes each
+    static const size_t MAX_RESPONSE_LENGTH = 64 * 1024;
+
+    const std::string _folder;
+
+    //the magic, format version and firmware identity which start every file
+    static
+    std::vector<uint8_t>
+    header(
+        const FirmwareIdentity &firmware_
+    );
+};
+
+} // namespace Core
+} // namespace RemoteWiring
+} // namespace Maker
+} // namespace Microsoft
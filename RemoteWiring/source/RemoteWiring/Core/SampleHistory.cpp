@@ -0,0 +1,254 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "SampleHistory.h"
+
+#include <chrono>
+
+using namespace Microsoft::Maker::RemoteWiring::Core;
+
+namespace {
+
+size_t
+roundUpToPowerOfTwo(
+    size_t depth_
+    )
+{
+    size_t capacity = 1;
+    while( capacity < depth_ ) { capacity <<= 1; }
+    return capacity;
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+SampleRing::SampleRing(
+    size_t depth_
+    ) :
+    _samples( roundUpToPowerOfTwo( depth_ > MAX_CAPACITY ? static_cast<size_t>( MAX_CAPACITY ) : depth_ ) ),
+    _mask( _samples.size() - 1 ),
+    _head( 0 ),
+    _tail( 0 ),
+    _overruns( 0 )
+{
+}
+
+SampleHistory::SampleHistory(
+    size_t channels_
+    ) :
+    _channels( new Channel[channels_] ),
+    _channel_count( channels_ )
+{
+    for( size_t i = 0; i < _channel_count; ++i )
+    {
+        _channels[i].active.store( nullptr, std::memory_order_relaxed );
+    }
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+size_t
+SampleRing::capacity(
+    void
+    ) const
+{
+    return _samples.size();
+}
+
+void
+SampleRing::clear(
+    void
+    )
+{
+    _tail.store( _head.load( std::memory_order_acquire ), std::memory_order_release );
+}
+
+size_t
+SampleRing::drain(
+    Sample *out_,
+    size_t max_
+    )
+{
+    const size_t tail = _tail.load( std::memory_order_relaxed );
+    const size_t available = _head.load( std::memory_order_acquire ) - tail;
+    const size_t count = ( available < max_ ) ? available : max_;
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        out_[i] = _samples[( tail + i ) & _mask];
+    }
+
+    //hand the slots back to the producer only once they have been copied out
+    _tail.store( tail + count, std::memory_order_release );
+    return count;
+}
+
+uint64_t
+SampleRing::overruns(
+    void
+    ) const
+{
+    return _overruns.load( std::memory_order_relaxed );
+}
+
+bool
+SampleRing::push(
+    int64_t timestamp_,
+    uint16_t value_
+    )
+{
+    const size_t head = _head.load( std::memory_order_relaxed );
+    if( head - _tail.load( std::memory_order_acquire ) > _mask )
+    {
+        _overruns.fetch_add( 1, std::memory_order_relaxed );
+        return false;
+    }
+
+    Sample &sample = _samples[head & _mask];
+    sample.timestamp = timestamp_;
+    sample.value = value_;
+    _head.store( head + 1, std::memory_order_release );
+    return true;
+}
+
+int64_t
+SampleHistory::now(
+    void
+    )
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void
+SampleHistory::disable(
+    size_t channel_
+    )
+{
+    if( channel_ >= _channel_count ) return;
+
+    //critical section equivalent to function scope
+    std::lock_guard<std::mutex> lock( _consumer_mutex );
+    SampleRing *ring = _channels[channel_].active.exchange( nullptr, std::memory_order_acq_rel );
+    if( ring != nullptr )
+    {
+        ring->clear();
+    }
+}
+
+size_t
+SampleHistory::drain(
+    size_t channel_,
+    Sample *out_,
+    size_t max_
+    )
+{
+    if( channel_ >= _channel_count ) return 0;
+
+    //critical section equivalent to function scope
+    std::lock_guard<std::mutex> lock( _consumer_mutex );
+    SampleRing *ring = _channels[channel_].active.load( std::memory_order_acquire );
+    if( ring == nullptr ) return 0;
+    return ring->drain( out_, max_ );
+}
+
+bool
+SampleHistory::enable(
+    size_t channel_,
+    size_t depth_
+    )
+{
+    if( channel_ >= _channel_count || depth_ == 0 || depth_ > SampleRing::MAX_CAPACITY ) return false;
+
+    //critical section equivalent to function scope
+    std::lock_guard<std::mutex> lock( _consumer_mutex );
+    Channel &channel = _channels[channel_];
+    const size_t capacity = roundUpToPowerOfTwo( depth_ );
+
+    SampleRing *ring = nullptr;
+    for( const std::unique_ptr<SampleRing> &candidate : channel.rings )
+    {
+        if( candidate->capacity() == capacity )
+        {
+            ring = candidate.get();
+            break;
+        }
+    }
+
+    if( ring == nullptr )
+    {
+        channel.rings.emplace_back( new SampleRing( capacity ) );
+        ring = channel.rings.back().get();
+    }
+
+    ring->clear();
+    channel.active.store( ring, std::memory_order_release );
+    return true;
+}
+
+bool
+SampleHistory::enabled(
+    size_t channel_
+    ) const
+{
+    if( channel_ >= _channel_count ) return false;
+    return ( _channels[channel_].active.load( std::memory_order_acquire ) != nullptr );
+}
+
+uint64_t
+SampleHistory::overruns(
+    void
+    ) const
+{
+    uint64_t total = 0;
+
+    //critical section equivalent to function scope
+    std::lock_guard<std::mutex> lock( _consumer_mutex );
+    for( size_t i = 0; i < _channel_count; ++i )
+    {
+        for( const std::unique_ptr<SampleRing> &ring : _channels[i].rings )
+        {
+            total += ring->overruns();
+        }
+    }
+    return total;
+}
+
+void
+SampleHistory::record(
+    size_t channel_,
+    uint16_t value_
+    )
+{
+    if( channel_ >= _channel_count ) return;
+
+    SampleRing *ring = _channels[channel_].active.load( std::memory_order_acquire );
+    if( ring == nullptr ) return;
+    ring->push( now(), value_ );
+}
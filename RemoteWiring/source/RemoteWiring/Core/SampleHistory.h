@@ -0,0 +1,215 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+namespace Core {
+
+struct Sample
+{
+    //microseconds on a monotonic clock shared by every SampleHistory, see SampleHistory::now()
+    int64_t timestamp;
+    uint16_t value;
+};
+
+/*
+ * A fixed-size, lock-free single-producer, single-consumer ring of samples.
+ * Exactly one thread may push() and exactly one other thread may drain(). When the ring is full a new sample is dropped
+ * and counted as an overrun rather than overwriting the oldest one, which the consumer may be reading at that moment.
+ */
+class SampleRing
+{
+public:
+    static const size_t MAX_CAPACITY = 1 << 20;
+
+    ///<summary>
+    ///Creates a ring holding at least depth_ samples. The capacity is rounded up to a power of two, at most MAX_CAPACITY.
+    ///</summary>
+    explicit
+    SampleRing(
+        size_t depth_
+    );
+
+    size_t
+    capacity(
+        void
+    ) const;
+
+    ///<summary>
+    ///Discards every sample waiting in the ring. Must only be called from the consumer thread.
+    ///</summary>
+    void
+    clear(
+        void
+    );
+
+    ///<summary>
+    ///Moves up to max_ of the oldest samples into out_, oldest first, and returns how many were moved.
+    ///<para>Must only be called from the consumer thread.</para>
+    ///</summary>
+    size_t
+    drain(
+        Sample *out_,
+        size_t max_
+    );
+
+    ///<summary>
+    ///The number of samples dropped because the ring was full
+    ///</summary>
+    uint64_t
+    overruns(
+        void
+    ) const;
+
+    ///<summary>
+    ///Appends a sample and returns true, or counts an overrun and returns false if the ring is full.
+    ///<para>Must only be called from the producer thread.</para>
+    ///</summary>
+    bool
+    push(
+        int64_t timestamp_,
+        uint16_t value_
+    );
+
+private:
+    std::vector<Sample> _samples;
+    const size_t _mask;
+
+    //free-running positions, kept on separate cache lines so the producer and consumer do not contend for them.
+    //only the producer writes _head and only the consumer writes _tail.
+    alignas( 64 ) std::atomic<size_t> _head;
+    alignas( 64 ) std::atomic<size_t> _tail;
+    std::atomic<uint64_t> _overruns;
+
+    SampleRing( const SampleRing & ) = delete;
+    SampleRing & operator=( const SampleRing & ) = delete;
+};
+
+/*
+ * Optional sample rings for a fixed set of channels, such as the analog channels or the digital ports of a board.
+ * A single producer thread (the input thread) records into whichever channels are enabled without taking a lock. The
+ * consumer side (enable, disable and drain) may be called from any thread; those calls are serialized with each other.
+ */
+class SampleHistory
+{
+public:
+    explicit
+    SampleHistory(
+        size_t channels_
+    );
+
+    ///<summary>
+    ///Microseconds on the monotonic clock used to timestamp samples. The epoch is arbitrary, only differences are meaningful.
+    ///</summary>
+    static
+    int64_t
+    now(
+        void
+    );
+
+    ///<summary>
+    ///Stops recording the given channel. Samples already waiting in its ring are discarded.
+    ///</summary>
+    void
+    disable(
+        size_t channel_
+    );
+
+    ///<summary>
+    ///Moves up to max_ of the oldest samples recorded for the given channel into out_ and returns how many were moved.
+    ///Returns 0 if the channel is not enabled.
+    ///</summary>
+    size_t
+    drain(
+        size_t channel_,
+        Sample *out_,
+        size_t max_
+    );
+
+    ///<summary>
+    ///Starts recording the given channel into a ring of at least depth_ samples, discarding anything recorded before.
+    ///<para>Rings are only released with the history, since the producer may still be using one it has just been
+    ///replaced by. A ring of the same capacity is reused when a channel is enabled again.</para>
+    ///<returns>false if the channel or depth is out of range</returns>
+    ///</summary>
+    bool
+    enable(
+        size_t channel_,
+        size_t depth_
+    );
+
+    bool
+    enabled(
+        size_t channel_
+    ) const;
+
+    ///<summary>
+    ///The number of samples dropped across every channel because the consumer did not drain them in time
+    ///</summary>
+    uint64_t
+    overruns(
+        void
+    ) const;
+
+    ///<summary>
+    ///Records a value against the given channel, timestamped now, if that channel is enabled.
+    ///<para>Must only be called from the producer thread.</para>
+    ///</summary>
+    void
+    record(
+        size_t channel_,
+        uint16_t value_
+    );
+
+private:
+    struct Channel
+    {
+        std::atomic<SampleRing *> active;
+
+        //every ring this channel has used, owned until the history is destroyed
+        std::vector<std::unique_ptr<SampleRing>> rings;
+    };
+
+    std::unique_ptr<Channel[]> _channels;
+    const size_t _channel_count;
+    mutable std::mutex _consumer_mutex;
+
+    SampleHistory( const SampleHistory & ) = delete;
+    SampleHistory & operator=( const SampleHistory & ) = delete;
+};
+
+} // namespace Core
+} // namespace RemoteWiring
+} // namespace Maker
+} // namespace Microsoft
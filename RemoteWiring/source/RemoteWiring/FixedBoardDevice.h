@@ -0,0 +1,177 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include "RemoteDevice.h"
+#include "Core/BoardProfiles.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace RemoteWiring {
+
+/*
+ * Drives a RemoteDevice from code written for one known board. The device is given the board's built-in profile, and
+ * every pin and channel is a template argument checked against the board's descriptor while compiling, so a pin the
+ * board cannot use is a build error and mode changes skip the check pinMode makes at run time.
+ * This is a native template, usable by C++ compiled into this component rather than through WinRT.
+ */
+template <Core::Board BOARD>
+class FixedBoardDevice
+{
+public:
+    static
+    constexpr
+    Core::BoardDescriptor
+    descriptor(
+        void
+    )
+    {
+        return Core::KnownBoard<BOARD>::descriptor();
+    }
+
+    ///<summary>
+    ///Wraps the given device, giving it this board's profile unless it already has one. A device which already has a
+    ///profile must offer every pin at least the capabilities of this board, or Platform::Exception is thrown.
+    ///</summary>
+    explicit
+    FixedBoardDevice(
+        RemoteDevice ^device_
+    ) :
+        _device( device_ )
+    {
+        //the compile-time checks are only sound if the profile in use agrees with the descriptor
+        if( !_device->setHardwareProfile( HardwareProfile::ForKnownBoard( static_cast<KnownBoard>( BOARD ) ) ) && !matches( _device->DeviceHardwareProfile ) )
+        {
+            throw ref new Platform::Exception( E_INVALIDARG, "The device's hardware profile does not match the board given to FixedBoardDevice." );
+        }
+    }
+
+    RemoteDevice ^
+    device(
+        void
+    ) const
+    {
+        return _device;
+    }
+
+    template <uint8_t PIN, PinMode MODE>
+    void
+    pinMode(
+        void
+    )
+    {
+        static_assert( descriptor().isModeSupported( PIN, static_cast<Firmata::Core::PinMode>( MODE ) ), "the pin does not support this mode on this board" );
+        _device->setPinModeUnchecked( PIN, MODE );
+    }
+
+    ///<summary>
+    ///Sets the pin reading the given analog channel to PinMode.ANALOG
+    ///</summary>
+    template <uint8_t CHANNEL>
+    void
+    analogPinMode(
+        void
+    )
+    {
+        static_assert( descriptor().channelPin( CHANNEL ) != Core::BoardCapabilities::NO_PIN, "the board has no such analog channel" );
+        _device->setPinModeUnchecked( descriptor().channelPin( CHANNEL ), PinMode::ANALOG );
+    }
+
+    template <uint8_t CHANNEL>
+    uint16_t
+    analogRead(
+        void
+    )
+    {
+        static_assert( descriptor().channelPin( CHANNEL ) != Core::BoardCapabilities::NO_PIN, "the board has no such analog channel" );
+        return _device->analogRead( CHANNEL );
+    }
+
+    ///<summary>
+    ///Writes a PWM value to the given pin. Servos are driven through RemoteDevice.analogWrite, since every digital pin takes one.
+    ///</summary>
+    template <uint8_t PIN>
+    void
+    analogWrite(
+        uint16_t value_
+    )
+    {
+        static_assert( descriptor().isPwm( PIN ), "the pin does not support PWM on this board" );
+        _device->analogWrite( PIN, value_ );
+    }
+
+    template <uint8_t PIN>
+    PinState
+    digitalRead(
+        void
+    )
+    {
+        static_assert( descriptor().isModeSupported( PIN, Firmata::Core::PinMode::INPUT ), "the pin is not a digital input on this board" );
+        return _device->digitalRead( PIN );
+    }
+
+    template <uint8_t PIN>
+    void
+    digitalWrite(
+        PinState state_
+    )
+    {
+        static_assert( descriptor().isModeSupported( PIN, Firmata::Core::PinMode::OUTPUT ), "the pin is not a digital output on this board" );
+        _device->digitalWrite( PIN, state_ );
+    }
+
+private:
+    RemoteDevice ^_device;
+
+    ///<summary>
+    ///Returns true if the profile has this board's pins, each with at least the capabilities the descriptor gives it, and
+    ///reads each analog channel on the same pin
+    ///</summary>
+    static
+    bool
+    matches(
+        HardwareProfile ^profile_
+    )
+    {
+        if( profile_ == nullptr || profile_->TotalPinCount != descriptor().totalPins ) return false;
+
+        for( uint8_t pin = 0; pin < descriptor().totalPins; ++pin )
+        {
+            const uint8_t expected = descriptor().capabilities( pin );
+            if( ( profile_->getPinCapabilitiesBitmask( pin ) & expected ) != expected ) return false;
+        }
+
+        for( uint8_t channel = 0; channel < descriptor().analogPinCount; ++channel )
+        {
+            if( profile_->getAnalogPin( channel ) != descriptor().channelPin( channel ) ) return false;
+        }
+        return true;
+    }
+};
+
+} // namespace RemoteWiring
+} // namespace Maker
+} // namespace Microsoft
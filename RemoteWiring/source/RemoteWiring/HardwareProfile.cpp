@@ -25,6 +25,7 @@
 #include "pch.h"
 #include "HardwareProfile.h"
 #include "RemoteDevice.h"
+#include "Core/CapabilityParser.h"
 
 using namespace Microsoft::Maker::Firmata;
 using namespace Microsoft::Maker::RemoteWiring;
@@ -40,11 +41,7 @@ HardwareProfile::HardwareProfile(
     _is_valid( ATOMIC_VAR_INIT( false ) ),
     _total_pin_count( ATOMIC_VAR_INIT( 0 ) ),
     _analog_offset( ATOMIC_VAR_INIT( 0 ) ),
-    _analog_pin_count( ATOMIC_VAR_INIT( 0 ) ),
-    _pinCapabilities( nullptr ),
-    _analogResolutions( nullptr ),
-    _pwmResolutions( nullptr ),
-    _servoResolutions( nullptr )
+    _analog_pin_count( ATOMIC_VAR_INIT( 0 ) )
 {
     switch( protocol_ )
     {
@@ -64,11 +61,7 @@ HardwareProfile::HardwareProfile(
     _is_valid( ATOMIC_VAR_INIT( false ) ),
     _total_pin_count( ATOMIC_VAR_INIT( total_number_of_pins_ ) ),
     _analog_offset( ATOMIC_VAR_INIT( total_number_of_pins_ - number_of_analog_pins_ ) ),
-    _analog_pin_count( ATOMIC_VAR_INIT( number_of_analog_pins_ ) ),
-    _pinCapabilities( nullptr ),
-    _analogResolutions( nullptr ),
-    _pwmResolutions( nullptr ),
-    _servoResolutions( nullptr )
+    _analog_pin_count( ATOMIC_VAR_INIT( number_of_analog_pins_ ) )
 {
 }
 
@@ -76,43 +69,74 @@ HardwareProfile::HardwareProfile(
 HardwareProfile::~HardwareProfile()
 {
     _is_valid = false;
+}
 
-    if( _pinCapabilities != nullptr )
-    {
-        delete( _pinCapabilities );
-    }
 
-    if( _analogResolutions != nullptr )
-    {
-        delete( _analogResolutions );
-    }
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+HardwareProfile ^
+HardwareProfile::ForKnownBoard(
+    KnownBoard board_
+    )
+{
+    static_assert( static_cast<int>( KnownBoard::ARDUINO_LEONARDO ) == static_cast<int>( Core::Board::ARDUINO_LEONARDO ), "KnownBoard mirrors Core::Board" );
+    const Core::BoardDescriptor descriptor = Core::describeBoard( static_cast<Core::Board>( board_ ) );
+    std::vector<uint8_t> response = Core::BoardProfiles::capabilityResponse( descriptor );
+
+    Windows::Storage::Streams::DataWriter ^writer = ref new Windows::Storage::Streams::DataWriter();
+    writer->WriteBytes( Platform::ArrayReference<uint8_t>( response.data(), static_cast<unsigned int>( response.size() ) ) );
+    HardwareProfile ^profile = ref new HardwareProfile( writer->DetachBuffer() );
 
-    if( _pwmResolutions != nullptr )
+    const std::vector<uint8_t> mapping = Core::BoardProfiles::analogMappingResponse( descriptor );
+    profile->applyAnalogMapping( mapping.data(), mapping.size() );
+    return profile;
+}
+
+bool
+HardwareProfile::applyAnalogMapping(
+    const uint8_t *data_,
+    size_t length_
+    )
+{
+    return _is_valid && Core::CapabilityParser::parseAnalogMapping( data_, length_, _capabilities );
+}
+
+uint8_t
+HardwareProfile::getAnalogChannel(
+    size_t pin_
+    )
+{
+    if( !_is_valid )
     {
-        delete( _pwmResolutions );
+        return Core::BoardCapabilities::NO_CHANNEL;
     }
+    return _capabilities.analogChannel( pin_ );
+}
 
-    if( _servoResolutions != nullptr )
+uint8_t
+HardwareProfile::getAnalogPin(
+    size_t channel_
+    )
+{
+    if( !_is_valid )
     {
-        delete( _servoResolutions );
+        return Core::BoardCapabilities::NO_PIN;
     }
+    return _capabilities.channelPin( channel_ );
 }
 
-
-//******************************************************************************
-//* Public Methods
-//******************************************************************************
-
 uint8_t
 HardwareProfile::getPinCapabilitiesBitmask(
     size_t pin_
     )
 {
-    if( !_is_valid || _pinCapabilities == nullptr || pin_ >= (unsigned)_total_pin_count )
+    if( !_is_valid )
     {
         return 0;
     }
-    return _pinCapabilities->at( pin_ );
+    return _capabilities.capabilities( pin_ );
 }
 
 bool
@@ -175,6 +199,19 @@ HardwareProfile::isServoSupported(
 //* Private Methods
 //******************************************************************************
 
+Windows::Foundation::Collections::IVector<uint8_t> ^
+HardwareProfile::pinVector(
+    const Core::BoardCapabilities::PinList &pins_
+    )
+{
+    //the vector is the caller's to modify, so each call returns its own copy of the list
+    if( !_is_valid )
+    {
+        return ref new Platform::Collections::Vector<uint8_t>();
+    }
+    return ref new Platform::Collections::Vector<uint8_t>( pins_.begin(), pins_.end() );
+}
+
 void
 HardwareProfile::initializeWithFirmata(
     Windows::Storage::Streams::IBuffer ^buffer_
@@ -182,202 +219,21 @@ HardwareProfile::initializeWithFirmata(
 {
     if( buffer_ == nullptr ) return;
 
-    const uint8_t MODE_ENABLED = 1;
-    const int FIRMATA_END_OF_PIN_VALUE = 0x7F;
-
     auto reader = Windows::Storage::Streams::DataReader::FromBuffer( buffer_ );
-    auto size = buffer_->Length;
-
-    bool found_errors = false;
-    uint8_t *data = (uint8_t *)malloc( sizeof( uint8_t ) * size );
-    for( unsigned int i = 0; i < size; ++i )
-    {
-        data[i] = reader->ReadByte();
-    }
-
-    byte total_pins = 0;
-    byte analog_offset = 0xFF;
-    byte num_analog_pins = 0;
-    std::vector<uint8_t> *pinCapabilities = new std::vector<uint8_t>;
-    std::map<uint8_t, uint8_t> *analogResolutions = new std::map<uint8_t, uint8_t>; //K = pin number, V = resolution value in bits
-    std::map<uint8_t, uint8_t> *pwmResolutions = new std::map<uint8_t, uint8_t>; //K = pin number, V = resolution value in bits
-    std::map<uint8_t, uint8_t> *servoResolutions = new std::map<uint8_t, uint8_t>; //K = pin number, V = resolution value in bits
-
-    for( unsigned int i = 0; !found_errors && i < size; ++i )
-    {
-        uint8_t currentPinCapabilities = 0;
-
-        while( !found_errors && i < size && data[i] != FIRMATA_END_OF_PIN_VALUE )
-        {
-            PinMode mode = static_cast<PinMode>( data[i] );
-            switch( mode )
-            {
-            case PinMode::INPUT:
-
-                //the next bit determines if the mode is enabled, this should always be true
-                ++i;
-                if( i < size )
-                {
-                    if( data[i] == MODE_ENABLED )
-                    {
-                        currentPinCapabilities |= static_cast<uint8_t>( PinCapability::INPUT );
-                    }
-                }
-                else
-                {
-                    found_errors = true;    //we've failed to get all of the data
-                }
-                ++i;
-
-                break;
-
-            case PinMode::OUTPUT:
-
-                //the next bit determines if the mode is enabled, this should always be true
-                ++i;
-                if( i < size )
-                {
-                    if( data[i] == MODE_ENABLED )
-                    {
-                        currentPinCapabilities |= static_cast<uint8_t>( PinCapability::OUTPUT );
-                    }
-                }
-                else
-                {
-                    found_errors = true;    //we've failed to get all of the data
-                }
-                ++i;
-
-                break;
-
-            case PinMode::PULLUP:
-
-                //the next bit determines if the mode is enabled, this should always be true
-                ++i;
-                if( i < size )
-                {
-                    if( data[i] == MODE_ENABLED )
-                    {
-                        currentPinCapabilities |= static_cast<uint8_t>( PinCapability::INPUT_PULLUP );
-                    }
-                }
-                else
-                {
-                    found_errors = true;    //we've failed to get all of the data
-                }
-                ++i;
-
-                break;
-
-            case PinMode::ANALOG:
-
-                //set the mode enabled & store the analog resolution of this pin
-                ++i;
-                if( i < size )
-                {
-                    currentPinCapabilities |= static_cast<uint8_t>( PinCapability::ANALOG );
-                    analogResolutions->insert( std::make_pair( total_pins, data[i] ) );
-                }
-                else
-                {
-                    found_errors = true;    //we've failed to get all of the data
-                }
-                ++i;
-
-                //analog offset keeps track of the first pin found that supports analog read, tells us how many digital pins we have,
-                //and allows us to convert analog pins like "A0" to the correct pin number
-                if( analog_offset == 0xFF )
-                {
-                    analog_offset = total_pins;
-                }
-                ++num_analog_pins;
-
-                break;
-
-            case PinMode::PWM:
-
-                //set the mode enabled & store the pwm resolution of this pin
-                ++i;
-                if( i < size )
-                {
-                    currentPinCapabilities |= static_cast<uint8_t>( PinCapability::PWM );
-                    pwmResolutions->insert( std::make_pair( total_pins, data[i] ) );
-                }
-                else
-                {
-                    found_errors = true;    //we've failed to get all of the data
-                }
-                ++i;
-
-                break;
-
-            case PinMode::SERVO:
-
-                //set the mode enabled & store the servo resolution of this pin
-                ++i;
-                if( i < size )
-                {
-                    currentPinCapabilities |= static_cast<uint8_t>( PinCapability::SERVO );
-                    servoResolutions->insert( std::make_pair( total_pins, data[i] ) );
-                }
-                else
-                {
-                    found_errors = true;    //we've failed to get all of the data
-                }
-                ++i;
-
-                break;
-
-            case PinMode::I2C:
-
-                //the next bit determines if the mode is enabled, this should always be true
-                ++i;
-                if( i < size )
-                {
-                    if( data[i] == MODE_ENABLED )
-                    {
-                        currentPinCapabilities |= static_cast<uint8_t>( PinCapability::I2C );
-                    }
-                }
-                else
-                {
-                    found_errors = true;    //we've failed to get all of the data
-                }
-                ++i;
-
-                break;
-
-            default:
-                //this value isn't recognized. it is likely fatal, but also possible that new data was added to the query response. We will attempt to continue
-                ++i;
-
-                break;
-            }
-        }
-        pinCapabilities->push_back( currentPinCapabilities );
-        total_pins++;
-    }
-
-    //last minute error-checking
-    if( total_pins != pinCapabilities->size() ||
-        num_analog_pins != analogResolutions->size() )
+    std::vector<uint8_t> data( buffer_->Length );
+    if( !data.empty() )
     {
-        found_errors = true;
+        reader->ReadBytes( Platform::ArrayReference<uint8_t>( data.data(), static_cast<unsigned int>( data.size() ) ) );
     }
 
-    free( data );
-    if( found_errors )
+    if( !Core::CapabilityParser::parse( data.data(), data.size(), _capabilities ) )
     {
         return;
     }
 
     //we've successfully parsed a valid capability response. Set all members of this class and mark it as valid.
-    _total_pin_count = total_pins;
-    _analog_offset = analog_offset;
-    _analog_pin_count = num_analog_pins;
-    _pinCapabilities = pinCapabilities;
-    _analogResolutions = analogResolutions;
-    _pwmResolutions = pwmResolutions;
-    _servoResolutions = servoResolutions;
+    _total_pin_count = _capabilities.totalPinCount;
+    _analog_offset = _capabilities.analogOffset;
+    _analog_pin_count = _capabilities.analogPinCount;
     _is_valid = true;
 }
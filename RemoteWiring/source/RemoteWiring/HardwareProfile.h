@@ -24,6 +24,9 @@
 
 #pragma once
 
+#include "Core/BoardProfiles.h"
+#include "Core/CapabilityParser.h"
+
 namespace Microsoft {
 namespace Maker {
 namespace RemoteWiring {
@@ -37,6 +40,18 @@ public enum class Protocol
     FIRMATA
 };
 
+/*
+ * Boards whose profile is built in, see HardwareProfile::ForKnownBoard. Each running StandardFirmata 2.5 reports exactly
+ * this profile, so it can be used without waiting for the board to describe itself.
+ */
+public enum class KnownBoard
+{
+    ARDUINO_UNO = 0,
+    ARDUINO_NANO = 1,
+    ARDUINO_MEGA_2560 = 2,
+    ARDUINO_LEONARDO = 3,
+};
+
 /*
  * Pin capabilities are stored as bitmasks, the PinCapability enum represents the bit value of each capability.
  */
@@ -100,18 +115,7 @@ public:
     {
         Windows::Foundation::Collections::IVector<uint8_t> ^ get()
         {
-            auto vector = ref new Platform::Collections::Vector<uint8_t>();
-            if( _is_valid )
-            {
-                for( size_t pin = _analog_offset; pin < (unsigned)_total_pin_count; ++pin )
-                {
-                    if( isAnalogSupported( pin ) )
-                    {
-                        vector->Append( (uint8_t)pin );
-                    }
-                }
-            }
-            return vector;
+            return pinVector( _capabilities.analogPins );
         }
     }
 
@@ -119,18 +123,7 @@ public:
     {
         Windows::Foundation::Collections::IVector<uint8_t> ^ get()
         {
-            auto vector = ref new Platform::Collections::Vector<uint8_t>();
-            if( _is_valid )
-            {
-                for( size_t pin = 0; pin < (unsigned)_total_pin_count; ++pin )
-                {
-                    if( isDigitalOutputSupported( pin ) )
-                    {
-                        vector->Append((uint8_t)pin );
-                    }
-                }
-            }
-            return vector;
+            return pinVector( _capabilities.digitalPins );
         }
     }
 
@@ -138,18 +131,7 @@ public:
     {
         Windows::Foundation::Collections::IVector<uint8_t> ^ get()
         {
-            auto vector = ref new Platform::Collections::Vector<uint8_t>();
-            if( _is_valid )
-            {
-                for( size_t pin = 0; pin < (unsigned)_total_pin_count; ++pin )
-                {
-                    if( getPinCapabilitiesBitmask( pin ) == 0 )
-                    {
-                        vector->Append((uint8_t)pin );
-                    }
-                }
-            }
-            return vector;
+            return pinVector( _capabilities.disabledPins );
         }
     }
 
@@ -157,18 +139,7 @@ public:
     {
         Windows::Foundation::Collections::IVector<uint8_t> ^ get()
         {
-            auto vector = ref new Platform::Collections::Vector<uint8_t>();
-            if( _is_valid )
-            {
-                for( size_t pin = 0; pin < (unsigned)_total_pin_count; ++pin )
-                {
-                    if( isI2cSupported( pin ) )
-                    {
-                        vector->Append((uint8_t)pin );
-                    }
-                }
-            }
-            return vector;
+            return pinVector( _capabilities.i2cPins );
         }
     }
 
@@ -176,18 +147,7 @@ public:
     {
         Windows::Foundation::Collections::IVector<uint8_t> ^ get()
         {
-            auto vector = ref new Platform::Collections::Vector<uint8_t>();
-            if( _is_valid )
-            {
-                for( size_t pin = 0; pin < (unsigned)_total_pin_count; ++pin )
-                {
-                    if( isPwmSupported( pin ) )
-                    {
-                        vector->Append((uint8_t)pin );
-                    }
-                }
-            }
-            return vector;
+            return pinVector( _capabilities.pwmPins );
         }
     }
 
@@ -195,21 +155,10 @@ public:
     {
         Windows::Foundation::Collections::IVector<uint8_t> ^ get()
         {
-            auto vector = ref new Platform::Collections::Vector<uint8_t>();
-            if( _is_valid )
-            {
-                for( size_t pin = 0; pin < (unsigned)_total_pin_count; ++pin )
-                {
-                    if( isServoSupported( pin ) )
-                    {
-                        vector->Append((uint8_t)pin );
-                    }
-                }
-            }
-            return vector;
+            return pinVector( _capabilities.servoPins );
         }
     }
-    
+
     ///<summary>
     ///This default constructor accepts an IBuffer containing pin information which is assumed to be in the default Firmata protocol.
     ///<param name="buffer_">The input IBuffer object reference</param>
@@ -246,6 +195,38 @@ public:
 
     virtual ~HardwareProfile();
 
+    ///<summary>
+    ///returns the profile of the given board, built from its compiled-in descriptor and parsed as though the board had
+    ///sent it, so it can be given to RemoteDevice.setHardwareProfile without a capability query round trip
+    ///<param name="board_">The board</param>
+    ///</summary>
+    static
+    HardwareProfile ^
+    ForKnownBoard(
+        KnownBoard board_
+        );
+
+    ///<summary>
+    ///returns the analog channel read by the given pin, as given by the board's analog mapping when it reported one, or
+    ///otherwise by numbering the analog pins in order
+    ///<param name="pin_">The requested pin</param>
+    ///<returns>the channel, where 0 refers to "A0", or 127 if the pin reads no channel or this hardware profile is not valid</returns>
+    ///</summary>
+    uint8_t
+    getAnalogChannel(
+        size_t pin_
+        );
+
+    ///<summary>
+    ///returns the pin which reads the given analog channel, the inverse of getAnalogChannel
+    ///<param name="channel_">The requested channel, where 0 refers to "A0"</param>
+    ///<returns>the raw pin number, or 255 if no pin reads the channel or this hardware profile is not valid</returns>
+    ///</summary>
+    uint8_t
+    getAnalogPin(
+        size_t channel_
+        );
+
     ///<summary>
     ///returns the raw capabilities bitmask for the given pin, which represents all of the functionality of the pin
     ///an AND operation (&) can be performed with this bitmask and a PinCapability to determine if the given pin has the chosen capability.
@@ -327,6 +308,18 @@ public:
         size_t pin_
         );
 
+internal:
+    ///<summary>
+    ///replaces the inferred channel numbering with the body of the board's ANALOG_MAPPING_RESPONSE. The profile is read
+    ///without a lock, so this may only be called before it is shared.
+    ///<returns>false if the mapping does not describe this profile's pins, which are then left as they were</returns>
+    ///</summary>
+    bool
+    applyAnalogMapping(
+        const uint8_t *data_,
+        size_t length_
+        );
+
 private:
     std::atomic_bool _is_valid;
 
@@ -334,11 +327,15 @@ private:
     std::atomic_int _analog_offset;
     std::atomic_int _analog_pin_count;
     std::atomic_int _total_pin_count;
-    std::vector<uint8_t> *_pinCapabilities;
-    //for each of the following maps: K = pin number, V = resolution value in bits
-    std::map<uint8_t, uint8_t> *_analogResolutions;
-    std::map<uint8_t, uint8_t> *_pwmResolutions;
-    std::map<uint8_t, uint8_t> *_servoResolutions;
+
+    //capabilities, resolutions and per-capability pin lists, all fixed-size and filled once before _is_valid is set
+    Core::BoardCapabilities _capabilities;
+
+    //copies a precomputed pin list into a new vector, or returns an empty vector if this profile is not valid
+    Windows::Foundation::Collections::IVector<uint8_t> ^
+    pinVector(
+        const Core::BoardCapabilities::PinList &pins_
+        );
 
     void
     initializeWithFirmata(
@@ -24,6 +24,7 @@
 
 #include "pch.h"
 #include "RemoteDevice.h"
+#include <chrono>
 
 using namespace Concurrency;
 
@@ -31,6 +32,67 @@ using namespace Microsoft::Maker;
 using namespace Microsoft::Maker::Firmata;
 using namespace Microsoft::Maker::RemoteWiring;
 
+namespace {
+
+//samples are copied out of a history in chunks of this size, so draining needs no allocation
+const size_t HISTORY_DRAIN_CHUNK = 64;
+
+template <typename T>
+uint32_t
+drainHistory(
+    Microsoft::Maker::RemoteWiring::Core::SampleHistory &history_,
+    size_t channel_,
+    Platform::WriteOnlyArray<int64_t> ^timestamps_,
+    Platform::WriteOnlyArray<T> ^values_
+    )
+{
+    Microsoft::Maker::RemoteWiring::Core::Sample samples[HISTORY_DRAIN_CHUNK];
+    const uint32_t length = ( timestamps_->Length < values_->Length ) ? timestamps_->Length : values_->Length;
+    uint32_t drained = 0;
+
+    while( drained < length )
+    {
+        const size_t wanted = ( length - drained < HISTORY_DRAIN_CHUNK ) ? ( length - drained ) : HISTORY_DRAIN_CHUNK;
+        const size_t count = history_.drain( channel_, samples, wanted );
+        for( size_t i = 0; i < count; ++i, ++drained )
+        {
+            timestamps_[drained] = samples[i].timestamp;
+            values_[drained] = static_cast<T>( samples[i].value );
+        }
+        if( count < wanted ) break;
+    }
+
+    return drained;
+}
+
+std::vector<uint8_t>
+readBuffer(
+    Windows::Storage::Streams::IBuffer ^buffer_
+    )
+{
+    std::vector<uint8_t> data( buffer_->Length );
+    if( !data.empty() )
+    {
+        Windows::Storage::Streams::DataReader::FromBuffer( buffer_ )->ReadBytes( Platform::ArrayReference<uint8_t>( data.data(), static_cast<unsigned int>( data.size() ) ) );
+    }
+    return data;
+}
+
+Windows::Storage::Streams::IBuffer ^
+writeBuffer(
+    std::vector<uint8_t> &data_
+    )
+{
+    Windows::Storage::Streams::DataWriter ^writer = ref new Windows::Storage::Streams::DataWriter();
+    if( !data_.empty() )
+    {
+        writer->WriteBytes( Platform::ArrayReference<uint8_t>( data_.data(), static_cast<unsigned int>( data_.size() ) ) );
+    }
+    return writer->DetachBuffer();
+}
+
+} // namespace
+
 //******************************************************************************
 //* Constructors / Destructors
 //******************************************************************************
@@ -39,9 +101,26 @@ RemoteDevice::RemoteDevice(
     Serial::IStream ^serial_connection_
     ) :
     _initialized( ATOMIC_VAR_INIT(false) ),
+    _profile_mismatch( ATOMIC_VAR_INIT(false) ),
     _firmata( ref new Firmata::UwpFirmata ),
     _twoWire( nullptr ),
-    _hardwareProfile( nullptr )
+    _hardwareProfile( nullptr ),
+    _sysex_message_subscribers( ATOMIC_VAR_INIT(0) ),
+    _analog_reports( _metrics.counter( "device.reports.analog" ) ),
+    _digital_reports( _metrics.counter( "device.reports.digital" ) ),
+    _pin_events( _metrics.counter( "device.pin_events" ) ),
+    _reads( _metrics.counter( "device.reads" ) ),
+    _writes( _metrics.counter( "device.writes" ) ),
+    _pin_mode_changes( _metrics.counter( "device.pin_mode_changes" ) ),
+    _dispatch_latency( _metrics.histogram( "device.dispatch_ns" ) ),
+    _profile_cache_hits( _metrics.counter( "device.profile_cache.hits" ) ),
+    _profile_cache_misses( _metrics.counter( "device.profile_cache.misses" ) ),
+    _profile_cache_mismatches( _metrics.counter( "device.profile_cache.mismatches" ) ),
+    _profile_cache_validations( _metrics.counter( "device.profile_cache.validations" ) ),
+    _handshake_time( _metrics.gauge( "device.handshake_us" ) ),
+    _firmware_reported( false ),
+    _analog_history( Core::PinStateCache::MAX_ANALOG_PINS ),
+    _digital_history( Core::PinStateCache::MAX_PORTS )
 {
     //subscribe to all relevant connection changes from our new Firmata object and then attach the given IStream object
     _firmata->FirmataConnectionReady += ref new Firmata::FirmataConnectionCallback( this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onConnectionReady );
@@ -54,9 +133,26 @@ RemoteDevice::RemoteDevice(
     Firmata::UwpFirmata ^firmata_
     ) :
     _initialized( ATOMIC_VAR_INIT(false) ),
+    _profile_mismatch( ATOMIC_VAR_INIT(false) ),
     _firmata( firmata_ ),
     _twoWire( nullptr ),
-    _hardwareProfile( nullptr )
+    _hardwareProfile( nullptr ),
+    _sysex_message_subscribers( ATOMIC_VAR_INIT(0) ),
+    _analog_reports( _metrics.counter( "device.reports.analog" ) ),
+    _digital_reports( _metrics.counter( "device.reports.digital" ) ),
+    _pin_events( _metrics.counter( "device.pin_events" ) ),
+    _reads( _metrics.counter( "device.reads" ) ),
+    _writes( _metrics.counter( "device.writes" ) ),
+    _pin_mode_changes( _metrics.counter( "device.pin_mode_changes" ) ),
+    _dispatch_latency( _metrics.histogram( "device.dispatch_ns" ) ),
+    _profile_cache_hits( _metrics.counter( "device.profile_cache.hits" ) ),
+    _profile_cache_misses( _metrics.counter( "device.profile_cache.misses" ) ),
+    _profile_cache_mismatches( _metrics.counter( "device.profile_cache.mismatches" ) ),
+    _profile_cache_validations( _metrics.counter( "device.profile_cache.validations" ) ),
+    _handshake_time( _metrics.gauge( "device.handshake_us" ) ),
+    _firmware_reported( false ),
+    _analog_history( Core::PinStateCache::MAX_ANALOG_PINS ),
+    _digital_history( Core::PinStateCache::MAX_PORTS )
 {
     //since the UwpFirmata object is provided, we need to lock its state & verify it is not already in a connected state
     _firmata->lock();
@@ -85,46 +181,103 @@ RemoteDevice::~RemoteDevice(
 }
 
 
+//******************************************************************************
+//* Events
+//******************************************************************************
+
+Windows::Foundation::EventRegistrationToken
+RemoteDevice::SysexMessageReceived::add(
+    SysexMessageReceivedCallback ^handler_
+    )
+{
+    ++_sysex_message_subscribers;
+    return _sysex_message_received += handler_;
+}
+
+void
+RemoteDevice::SysexMessageReceived::remove(
+    Windows::Foundation::EventRegistrationToken token_
+    )
+{
+    _sysex_message_received -= token_;
+    --_sysex_message_subscribers;
+}
+
+void
+RemoteDevice::SysexMessageReceived::raise(
+    uint8_t command_,
+    Windows::Storage::Streams::DataReader ^message_
+    )
+{
+    _sysex_message_received( command_, message_ );
+}
+
+
 //******************************************************************************
 //* Public Methods
 //******************************************************************************
 
+void
+RemoteDevice::analogPinMode(
+    uint8_t channel_,
+    PinMode mode_
+    )
+{
+    if( !_initialized ) return;
+
+    const uint8_t pin = _hardwareProfile->getAnalogPin( channel_ );
+    if( pin == Core::BoardCapabilities::NO_PIN ) return;
+    pinMode( pin, mode_ );
+}
+
 uint16_t
 RemoteDevice::analogRead(
-	Platform::String^ analog_pin_
-	)
+    Platform::String ^analog_pin_
+    )
 {
-    uint16_t val = -1;
-	uint8_t parsed_pin = parsePinFromAnalogString( analog_pin_ );
+    //parsePinFromAnalogString returns -1 as uint if the string is invalid, which the channel overload rejects
+    return analogRead( parsePinFromAnalogString( analog_pin_ ) );
+}
 
-    {   //critical section 
-        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+uint16_t
+RemoteDevice::analogRead(
+    uint8_t channel_
+    )
+{
+    uint16_t val = -1;
+    _reads.increment();
 
-        //verify that we were given a valid analog pin number, parsePinFromAnalogString returns -1 as uint if the string is invalid, so this will catch both cases
-        if( !_initialized || parsed_pin >= _hardwareProfile->AnalogPinCount )
-        {
-            return val;
-        }
+    //the hardware profile never changes once initialized, and the cached mode and value are atomic, so no lock is taken
+    //unless the courtesy mode change below has to write to the board
 
-        //get the raw hardware pin number from the analog pin number by adding the digital pin count
-        uint8_t analog_pin_num = parsed_pin + _hardwareProfile->AnalogOffset;
+    //verify that we were given an analog channel the board has, and find the pin which reads it
+    if( !_initialized )
+    {
+        return val;
+    }
 
-        //input and analog modes can be ambiguous, so we perform a courtesy check for the incorrect mode
-        if( _pin_mode[analog_pin_num] == static_cast<uint8_t>( PinMode::INPUT ) )
-        {
-            //attempt to change to the correct mode
-            pinMode( analog_pin_num, PinMode::ANALOG );
-        }
+    const uint8_t analog_pin_num = _hardwareProfile->getAnalogPin( channel_ );
+    if( analog_pin_num == Core::BoardCapabilities::NO_PIN )
+    {
+        return val;
+    }
 
-        if( _pin_mode[analog_pin_num] != static_cast<uint8_t>( PinMode::ANALOG ) )
-        {
-            //incorrect pin mode, can't perform analog read
-            return val;
-        }
+    //input and analog modes can be ambiguous, so we perform a courtesy check for the incorrect mode
+    PinMode mode = getPinMode( analog_pin_num );
+    if( mode == PinMode::INPUT )
+    {
+        //attempt to change to the correct mode
+        pinMode( analog_pin_num, PinMode::ANALOG );
+        mode = getPinMode( analog_pin_num );
+    }
 
-        val = _analog_pins[parsed_pin];
+    if( mode != PinMode::ANALOG )
+    {
+        //incorrect pin mode, can't perform analog read
+        return val;
     }
 
+    val = _pin_state.analogValue( channel_ );
     return val;
 }
 
@@ -134,8 +287,7 @@ RemoteDevice::analogWrite(
     uint16_t value_
     )
 {
-    //critical section equivalent to function scope
-    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+    _writes.increment();
 
     if( !_initialized )
     {
@@ -143,15 +295,21 @@ RemoteDevice::analogWrite(
     }
 
     //both PWM and SERVO are valid modes for this function, but OUTPUT is ambiguous with PWM. We perform a courtesy check for the correct mode
-    if( _pin_mode[pin_] == static_cast<uint8_t>( PinMode::OUTPUT ) )
+    if( getPinMode( pin_ ) == PinMode::OUTPUT )
     {
         //attempt to change the pin mode
         pinMode( pin_, PinMode::PWM );
     }
 
-    if( _pin_mode[pin_] == static_cast<uint8_t>( PinMode::PWM ) || _pin_mode[pin_] == static_cast<uint8_t>( PinMode::SERVO ) )
-    {
-        _firmata->sendAnalog( pin_, value_ );
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _wire_mutex );
+
+        //the mode is checked again under the lock, so a mode change cannot be queued between the check and the write
+        PinMode mode = getPinMode( pin_ );
+        if( mode == PinMode::PWM || mode == PinMode::SERVO )
+        {
+            _firmata->sendAnalog( pin_, value_ );
+        }
     }
 }
 
@@ -161,34 +319,31 @@ RemoteDevice::digitalRead(
     uint8_t pin_
     )
 {
-    int port;
-    uint8_t port_mask;
-    getPinMap( pin_, &port, &port_mask );
-
-    {   //critical section
-        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+    _reads.increment();
 
-        if( !_initialized )
-        {
-            return PinState::LOW;
-        }
-
-        //input and analog modes can be ambiguous, so we perform a courtesy check for the incorrect mode
-        if( _pin_mode[pin_] == static_cast<uint8_t>( PinMode::ANALOG ) )
-        {
-            //attempt to change to the correct mode
-            pinMode( pin_, PinMode::INPUT );
-        }
+    //as with analogRead, the lock is only taken if the courtesy mode change has to write to the board
+    if( !_initialized )
+    {
+        return PinState::LOW;
+    }
 
-        //we want to verify that the pin is in INPUT mode, but OUTPUT will technically work as well (mimic Arduino behavior here)
-        if( _pin_mode[pin_] != static_cast<uint8_t>( PinMode::INPUT ) && _pin_mode[pin_] != static_cast<uint8_t>( PinMode::OUTPUT ) )
-        {
-            //incorrect pin mode
-            return PinState::LOW;
-        }
+    //input and analog modes can be ambiguous, so we perform a courtesy check for the incorrect mode
+    PinMode mode = getPinMode( pin_ );
+    if( mode == PinMode::ANALOG )
+    {
+        //attempt to change to the correct mode
+        pinMode( pin_, PinMode::INPUT );
+        mode = getPinMode( pin_ );
+    }
 
-        return static_cast<PinState>( ( _digital_port[port] & port_mask ) > 0 );
+    //we want to verify that the pin is in INPUT mode, but OUTPUT will technically work as well (mimic Arduino behavior here)
+    if( mode != PinMode::INPUT && mode != PinMode::OUTPUT )
+    {
+        //incorrect pin mode
+        return PinState::LOW;
     }
+
+    return _pin_state.digitalValue( pin_ ) ? PinState::HIGH : PinState::LOW;
 }
 
 
@@ -198,52 +353,148 @@ RemoteDevice::digitalWrite(
     PinState state_
     )
 {
-    int port;
-    uint8_t port_mask;
-    getPinMap( pin_, &port, &port_mask );
+    uint8_t port;
+    Core::PinStateCache::getPinMap( pin_, &port, nullptr );
+    _writes.increment();
 
-    {   //critical section
-        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+    if( !_initialized )
+    {
+        return;
+    }
 
-        if( !_initialized )
-        {
-            return;
-        }
+    //output can be ambiguous with PWM, so we perform a courtesy check for the incorrect mode
+    if( getPinMode( pin_ ) == PinMode::PWM )
+    {
+        //attempt to change the pin mode
+        pinMode( pin_, PinMode::OUTPUT );
+    }
 
-        //output can be ambiguous with PWM, so we perform a courtesy check for the incorrect mode
-        if( _pin_mode[pin_] == static_cast<uint8_t>( PinMode::PWM ) )
-        {
-            //attempt to change the pin mode
-            pinMode( pin_, PinMode::OUTPUT );
-        }
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _wire_mutex );
 
-        if( _pin_mode[pin_] != static_cast<uint8_t>( PinMode::OUTPUT ) )
+        if( getPinMode( pin_ ) != PinMode::OUTPUT )
         {
             //incorrect pin mode
             return;
         }
 
-        if( static_cast<uint8_t>( state_ ) )
-        {
-            _digital_port[port] |= port_mask;
-        }
-        else
-        {
-            _digital_port[port] &= ~port_mask;
-        }
+        //the new port value is queued under the same lock that committed it, so the board receives port values in the order the cache took them
+        _firmata->sendDigitalPort( port, _pin_state.setDigitalValue( pin_, state_ == PinState::HIGH ) );
+    }
+}
+
+void
+RemoteDevice::disableAnalogHistory(
+    uint8_t channel_
+    )
+{
+    _analog_history.disable( channel_ );
+}
+
+void
+RemoteDevice::disableDigitalHistory(
+    uint8_t port_
+    )
+{
+    _digital_history.disable( port_ );
+}
+
+uint32_t
+RemoteDevice::drainAnalogHistory(
+    uint8_t channel_,
+    Platform::WriteOnlyArray<int64_t> ^timestamps_,
+    Platform::WriteOnlyArray<uint16_t> ^values_
+    )
+{
+    return drainHistory( _analog_history, channel_, timestamps_, values_ );
+}
+
+uint32_t
+RemoteDevice::drainDigitalHistory(
+    uint8_t port_,
+    Platform::WriteOnlyArray<int64_t> ^timestamps_,
+    Platform::WriteOnlyArray<uint8_t> ^values_
+    )
+{
+    return drainHistory( _digital_history, port_, timestamps_, values_ );
+}
+
+bool
+RemoteDevice::enableAnalogHistory(
+    uint8_t channel_,
+    uint32_t depth_
+    )
+{
+    return _analog_history.enable( channel_, depth_ );
+}
+
+bool
+RemoteDevice::enableDigitalHistory(
+    uint8_t port_,
+    uint32_t depth_
+    )
+{
+    return _digital_history.enable( port_, depth_ );
+}
+
+void
+RemoteDevice::enableProfileCache(
+    Platform::String ^folder_
+    )
+{
+    //the core takes UTF-8 paths
+    std::string folder( WideCharToMultiByte( CP_UTF8, 0, folder_->Data(), -1, nullptr, 0, nullptr, nullptr ), '\0' );
+    WideCharToMultiByte( CP_UTF8, 0, folder_->Data(), -1, &folder[0], static_cast<int>( folder.size() ), nullptr, nullptr );
+    folder.resize( folder.size() - 1 );
 
-        _firmata->sendDigitalPort( port, _digital_port[port] );
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        _profile_cache.reset( new Core::ProfileCache( folder ) );
     }
 }
 
+PinMode
+RemoteDevice::getAnalogPinMode(
+    uint8_t channel_
+    )
+{
+    if( !_initialized ) return PinMode::IGNORED;
+
+    const uint8_t pin = _hardwareProfile->getAnalogPin( channel_ );
+    if( pin == Core::BoardCapabilities::NO_PIN ) return PinMode::IGNORED;
+    return getPinMode( pin );
+}
+
+Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+RemoteDevice::getMetrics(
+    void
+    )
+{
+    //start from the firmata metrics, their names never collide with the "device." prefix
+    Platform::Collections::Map<Platform::String ^, double> ^metrics = ref new Platform::Collections::Map<Platform::String ^, double>();
+    for( Windows::Foundation::Collections::IKeyValuePair<Platform::String ^, double> ^metric : _firmata->getMetrics() )
+    {
+        metrics->Insert( metric->Key, metric->Value );
+    }
+
+    for( const std::pair<std::string, double> &metric : _metrics.snapshot().flatten() )
+    {
+        //metric names are plain ASCII
+        std::wstring name( metric.first.begin(), metric.first.end() );
+        metrics->Insert( ref new Platform::String( name.c_str() ), metric.second );
+    }
+    metrics->Insert( L"device.history.overruns", static_cast<double>( _analog_history.overruns() + _digital_history.overruns() ) );
+
+    return metrics->GetView();
+}
+
 PinMode
 RemoteDevice::getPinMode(
     uint8_t pin_
     )
 {
-    //critical section equivalent to function scope
-    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
-    return static_cast<PinMode>( _pin_mode[ pin_ ].load() );
+    //the cached mode is atomic, so it can be read without the device lock
+    return static_cast<PinMode>( _pin_state.pinMode( pin_ ) );
 }
 
 PinMode
@@ -257,7 +508,18 @@ RemoteDevice::getPinMode(
         return PinMode::IGNORED;
     }
 
-    return getPinMode( parsed_pin + _hardwareProfile->AnalogOffset );
+    return getAnalogPinMode( parsed_pin );
+}
+
+PinStateSnapshot ^
+RemoteDevice::getPinStateSnapshot(
+    void
+    )
+{
+    Core::PinStateSnapshot snapshot;
+    _reads.increment();
+    _pin_state.snapshot( &snapshot );
+    return ref new PinStateSnapshot( snapshot );
 }
 
 void
@@ -266,61 +528,13 @@ RemoteDevice::pinMode(
     PinMode mode_
     )
 {
-    int port;
-    uint8_t port_mask;
-    getPinMap( pin_, &port, &port_mask );
-
-    {   //critical section
-        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
-
-        //verify we're initialized properly and the requested pin mode is supported by this pin
-        if( !( _initialized && isModeSupported( pin_, mode_ ) ) )
-        {
-            return;
-        }
-
-        _firmata->lock();
-        try
-        {
-            _firmata->write( static_cast<uint8_t>( Firmata::Command::SET_PIN_MODE ) );
-            _firmata->write( pin_ );
-            _firmata->write( static_cast<uint8_t>( mode_ ) );
-
-            //lets subscribe to this port if we're setting it to input
-            if( mode_ == PinMode::INPUT )
-            {
-                _subscribed_ports[port] |= port_mask;
-                _firmata->write( static_cast<uint8_t>( Firmata::Command::REPORT_DIGITAL_PIN ) | ( port & 0x0F ) );
-                _firmata->write( _subscribed_ports[port] );
-            }
-            //if the selected mode is NOT input and we WERE subscribed to it, unsubscribe
-            else if( _pin_mode[pin_] == static_cast<uint8_t>( PinMode::INPUT ) )
-            {
-                //make sure we aren't subscribed to this port
-                _subscribed_ports[port] &= ~port_mask;
-                _firmata->write( static_cast<uint8_t>( Firmata::Command::REPORT_DIGITAL_PIN ) | ( port & 0x0F ) );
-                _firmata->write( _subscribed_ports[port] );
-            }
-            _firmata->flush();
-        }
-        catch( ... )
-        {
-            //something has gone wrong, any fatal errors should be evented, so we need to exit this function
-            _firmata->unlock();
-            return;
-        }
-
-        _firmata->unlock();
-
-        //if the pin mode is being set to output, and it isn't already in output mode, the pin value is set to 0
-        if( mode_ == PinMode::OUTPUT && _pin_mode[pin_] != static_cast<uint8_t>( PinMode::OUTPUT ) )
-        {
-            _digital_port[port] &= ~port_mask;
-        }
-
-        //finally, update the cached pin mode
-        _pin_mode[pin_] = static_cast<uint8_t>( mode_ );
+    //verify we're initialized properly and the requested pin mode is supported by this pin
+    if( !( _initialized && isModeSupported( pin_, mode_ ) ) )
+    {
+        return;
     }
+
+    setPinModeUnchecked( pin_, mode_ );
 }
 
 void
@@ -335,7 +549,51 @@ RemoteDevice::pinMode(
         return;
     }
 
-    pinMode( parsed_pin + _hardwareProfile->AnalogOffset, mode_ );
+    analogPinMode( parsed_pin, mode_ );
+}
+
+bool
+RemoteDevice::setHardwareProfile(
+    HardwareProfile ^profile_
+    )
+{
+    if( profile_ == nullptr || !profile_->IsValid ) return false;
+
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+        if( _initialized ) return false;
+
+        //a handshake already under way no longer decides the profile, and a profile which was not discovered is not timed
+        _pending_profile = nullptr;
+        _fresh_profile = Core::CachedProfile();
+        _handshake_start = std::chrono::steady_clock::time_point();
+        initialize( profile_ );
+    }
+
+    return true;
+}
+
+void
+RemoteDevice::setPinModeUnchecked(
+    uint8_t pin_,
+    PinMode mode_
+    )
+{
+    if( !_initialized ) return;
+
+    {   //critical section
+        std::lock_guard<std::mutex> lock( _wire_mutex );
+
+        //the cache updates the pin's mode and port subscription, and builds both commands so no other message can be written between them
+        uint8_t message[Core::PinStateCache::MAX_PIN_MODE_MESSAGE_SIZE];
+        size_t length = _pin_state.setPinMode( pin_, static_cast<Firmata::Core::PinMode>( mode_ ), message );
+        if( !length ) return;
+
+        //queuing never waits for the transport, the writer thread transmits the commands after the lock is released
+        _firmata->sendMessage( Platform::ArrayReference<uint8_t>( message, static_cast<unsigned int>( length ) ) );
+    }
+
+    _pin_mode_changes.increment();
 }
 
 
@@ -346,25 +604,26 @@ RemoteDevice::pinMode(
 
 void
 RemoteDevice::onDigitalReport(
-    Firmata::CallbackEventArgs ^args_
+    uint8_t port_,
+    uint16_t value_
     )
 {
-    uint8_t port = args_->getPort();
-    uint8_t port_val = static_cast<uint8_t>( args_->getValue() );
+    uint8_t port = port_;
+    uint8_t port_val;
     uint8_t port_xor;
 
-    {   //critical section
-        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
-        //output_state will only set bits which correspond to output pins that are HIGH
-        uint8_t output_state = ~_subscribed_ports[port] & _digital_port[port];
-        port_val |= output_state;
+    if( _profile_mismatch ) return;
+    _digital_reports.increment();
 
-        //determine which pins have changed
-        port_xor = port_val ^ _digital_port[port];
+    //the cache serializes this with writes and mode changes made by the app, without the device lock
+    port_xor = _pin_state.mergeDigitalReport( port, static_cast<uint8_t>( value_ ), &port_val );
 
-        //update the cache
-        _digital_port[port] = port_val;
-    }
+    //every report is kept, including those which change nothing, so the history shows when the board sampled the port
+    _digital_history.record( port, port_val );
+
+    //a report which changes nothing raises nothing, and is not timed
+    if( !port_xor ) return;
+    std::chrono::steady_clock::time_point dispatch_start = std::chrono::steady_clock::now();
 
     //throw a pin event for each pin that has changed
     uint8_t i = 0;
@@ -372,36 +631,54 @@ RemoteDevice::onDigitalReport(
     {
         if( port_xor & 0x01 )
         {
+            _pin_events.increment();
             DigitalPinUpdated( ( port * 8 ) + i, ( ( port_val >> i ) & 0x01 ) > 0 ? PinState::HIGH : PinState::LOW );
         }
         port_xor >>= 1;
         ++i;
     }
+
+    _dispatch_latency.record( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - dispatch_start ).count() );
 }
 
 void
 RemoteDevice::onAnalogReport(
-    Firmata::CallbackEventArgs ^args_
+    uint8_t pin_,
+    uint16_t value_
     )
 {
-    uint8_t pin = args_->getPort();
-    uint16_t val = args_->getValue();
+    if( pin_ >= MAX_ANALOG_PINS || _profile_mismatch ) return;
+    _analog_reports.increment();
 
-    {   //critical section
-        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
-        _analog_pins[pin] = val;
-    }
+    _pin_state.setAnalogValue( pin_, value_ );
+    _analog_history.record( pin_, value_ );
+
+    std::chrono::steady_clock::time_point dispatch_start = std::chrono::steady_clock::now();
 
     //throw an event for the pin value update
-    AnalogPinUpdated( L"A" + pin.ToString(), val );
+    _pin_events.increment();
+    AnalogPinUpdated( _analog_pin_names[pin_], value_ );
+    AnalogChannelUpdated( pin_, value_ );
+
+    _dispatch_latency.record( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - dispatch_start ).count() );
 }
 
 void
 RemoteDevice::onSysexMessage(
-    Firmata::SysexCallbackEventArgs ^argv_
+    uint8_t command_,
+    const Platform::Array<uint8_t> ^data_
     )
 {
-    SysexMessageReceived( argv_->getCommand(), Windows::Storage::Streams::DataReader::FromBuffer( argv_->getDataBuffer() ) );
+    if( _profile_mismatch ) return;
+    SysexDataReceived( command_, data_ );
+
+    //the DataReader outlives the callback, so it needs its own copy of the data
+    if( _sysex_message_subscribers > 0 )
+    {
+        Windows::Storage::Streams::DataWriter ^writer = ref new Windows::Storage::Streams::DataWriter();
+        writer->WriteBytes( data_ );
+        SysexMessageReceived( command_, Windows::Storage::Streams::DataReader::FromBuffer( writer->DetachBuffer() ) );
+    }
 }
 
 void
@@ -409,6 +686,7 @@ RemoteDevice::onStringMessage(
     Firmata::StringCallbackEventArgs ^argv_
     )
 {
+    if( _profile_mismatch ) return;
     StringMessageReceived( argv_->getString() );
 }
 
@@ -427,29 +705,80 @@ RemoteDevice::initialize(
 
         if( _initialized ) return;
         _hardwareProfile = hardwareProfile_;
-        _firmata->DigitalPortValueUpdated += ref new Firmata::CallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::CallbackEventArgs^ args ) -> void { onDigitalReport( args ); } );
-        _firmata->AnalogValueUpdated += ref new Firmata::CallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::CallbackEventArgs^ args ) -> void { onAnalogReport( args ); } );
-        _firmata->SysexMessageReceived += ref new Firmata::SysexCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::SysexCallbackEventArgs^ args ) -> void { onSysexMessage( args ); } );
+        _analog_pin_names = ref new Platform::Array<Platform::String ^>( MAX_ANALOG_PINS );
+        for( uint8_t i = 0; i < MAX_ANALOG_PINS; ++i )
+        {
+            _analog_pin_names[i] = L"A" + i.ToString();
+        }
+
+        _firmata->DigitalPortValueReceived += ref new Firmata::ValueCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, uint8_t port, uint16_t value ) -> void { onDigitalReport( port, value ); } );
+        _firmata->AnalogValueReceived += ref new Firmata::ValueCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, uint8_t pin, uint16_t value ) -> void { onAnalogReport( pin, value ); } );
+        _firmata->SysexDataReceived += ref new Firmata::SysexDataCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, uint8_t command, const Platform::Array<uint8_t>^ data ) -> void { onSysexMessage( command, data ); } );
         _firmata->StringMessageReceived += ref new Firmata::StringCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, Firmata::StringCallbackEventArgs^ args ) -> void { onStringMessage( args ); } );
 
-        std::fill( _digital_port.begin(), _digital_port.end(), 0 );
-        std::fill( _subscribed_ports.begin(), _subscribed_ports.end(), 0 );
-        std::fill( _analog_pins.begin(), _analog_pins.end(), 0 );
-        std::fill( _pin_mode.begin(), _pin_mode.end(), static_cast<uint8_t>( PinMode::OUTPUT ) );
+        _pin_state.reset();
 
         _initialized = true;
+
+        //only a profile discovered through the handshake is timed
+        if( _handshake_start != std::chrono::steady_clock::time_point() )
+        {
+            _handshake_time.set( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - _handshake_start ).count() );
+        }
+        _initialized_condition.notify_all();
     }
 }
 
+void
+RemoteDevice::initializeWithPendingProfile(
+    void
+    )
+{
+    {   //critical section equivalent to function scope
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        initialize( _pending_profile );
+        _pending_profile = nullptr;
+
+        //a firmware which has not identified itself yet is cached when it does. a profile whose analog mapping timed out
+        //or was rejected is never cached, as the board's mapping would contradict it on every later connection.
+        if( _fresh_profile.analogMappingResponse.empty() )
+        {
+            _fresh_profile = Core::CachedProfile();
+        }
+        else if( _profile_cache && _firmware_reported )
+        {
+            _profile_cache->store( _firmware, _fresh_profile );
+            _fresh_profile = Core::CachedProfile();
+        }
+    }
+}
+
+void
+RemoteDevice::closeForProfileMismatch(
+    Platform::String ^message_
+    )
+{
+    //the rest of the chunk being parsed describes pins the profile in use may not have
+    if( _profile_mismatch.exchange( true ) ) return;
+
+    //finish() joins the input thread, which raised the response being handled. once it returns the input thread has
+    //stopped, so an app may reconnect or dispose of the device from DeviceConnectionLost.
+    RemoteDevice ^self = this;
+    create_task( [ self, message_ ]() -> void
+    {
+        self->_firmata->finish();
+        self->onConnectionLost( message_ );
+    } );
+}
+
 bool
 RemoteDevice::isModeSupported(
     uint8_t pin_,
     PinMode mode_
     )
 {
-    //critical section equivalent to function scope
-    std::lock_guard<std::recursive_mutex> lock( _device_mutex );
-
+    //the hardware profile never changes once initialized, so it is read without a lock
     if( !_initialized )
     {
         return false;
@@ -464,7 +793,8 @@ RemoteDevice::isModeSupported(
     switch( mode_ )
     {
     case PinMode::ANALOG:
-        return _hardwareProfile->isAnalogSupported( pin_ );
+        //a pin which reads no channel the board can report would be configured to no effect
+        return _hardwareProfile->isAnalogSupported( pin_ ) && ( _hardwareProfile->getAnalogChannel( pin_ ) != Core::BoardCapabilities::NO_CHANNEL );
 
     case PinMode::I2C:
         return _hardwareProfile->isI2cSupported( pin_ );
@@ -496,23 +826,6 @@ RemoteDevice::isModeSupported(
     }
 }
 
-void
-RemoteDevice::getPinMap(
-    uint8_t pin_,
-    int *port_,
-    uint8_t *port_mask_
-    )
-{
-    if( port_ != nullptr )
-    {
-        *port_ = ( pin_ / 8 );
-    }
-    if( port_mask_ != nullptr )
-    {
-        *port_mask_ = ( 1 << ( pin_ % 8 ) );
-    }
-}
-
 void
 RemoteDevice::onConnectionFailed(
     Platform::String^ message_
@@ -535,68 +848,77 @@ RemoteDevice::onConnectionReady(
 )
 {
     _firmata->PinCapabilityResponseReceived += ref new Microsoft::Maker::Firmata::SysexCallbackFunction(this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onPinCapabilityResponseReceived);
+    _firmata->AnalogMappingResponseReceived += ref new Microsoft::Maker::Firmata::SysexCallbackFunction(this, &Microsoft::Maker::RemoteWiring::RemoteDevice::onAnalogMappingResponseReceived);
+    _firmata->FirmwareReportReceived += ref new Firmata::FirmwareReportCallbackFunction( [ this ]( Firmata::UwpFirmata ^caller, uint8_t major, uint8_t minor, Platform::String ^name ) -> void { onFirmwareReportReceived( major, minor, name ); } );
     _firmata->startListening();
+    sendHandshake();
 
     DeviceReady();
 }
 
-bool RemoteDevice::SendPinCapabilityRequest(void)
+void
+RemoteDevice::sendHandshake(
+    void
+    )
 {
-    const int MAX_ATTEMPTS = 30;
-    const int MAX_DELAY_LOOP = 5;
-    const int INIT_DELAY_MS = 10;
-    int attempts = 0;
-    int delay_loop = 0;
-    int delay_ms = INIT_DELAY_MS;
-
-    //this loop will send the pin capability report and repeatedly lock the _device_mutex while checking the state of the object's initialization.
-    //locking guarantees that the state is able to be read only entirely before or after a complete initialization.
-    for (;; )
-    {
-        {   //critical section
-            std::lock_guard<std::recursive_mutex> lock(_device_mutex);
-            if (_initialized) return true;
-        }
+    //the queries are queued as one complete message, so the writer flushes them together and the board answers them back
+    //to back, and they are sent properly even if a user is in the middle of composing a sysex message themselves.
+    //the firmware identifies itself first, so a cached profile can be used before the capability response arrives.
+    uint8_t queries[] = {
+        static_cast<uint8_t>( Command::START_SYSEX ),
+        static_cast<uint8_t>( SysexCommand::REPORT_FIRMWARE ),
+        static_cast<uint8_t>( Command::END_SYSEX ),
+        static_cast<uint8_t>( Command::START_SYSEX ),
+        static_cast<uint8_t>( SysexCommand::CAPABILITY_QUERY ),
+        static_cast<uint8_t>( Command::END_SYSEX ),
+        static_cast<uint8_t>( Command::START_SYSEX ),
+        static_cast<uint8_t>( SysexCommand::ANALOG_MAPPING_QUERY ),
+        static_cast<uint8_t>( Command::END_SYSEX )
+    };
 
-        if (attempts >= MAX_ATTEMPTS)
-            return false;
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
 
-        //manually sending a sysex message asking for the pin configuration will guarantee it is sent properly even if a user has started a sysex message themselves
-        _firmata->lock();
-        try
-        {
-            _firmata->write(static_cast<uint8_t>(Command::START_SYSEX));
-            _firmata->write(static_cast<uint8_t>(SysexCommand::CAPABILITY_QUERY));
-            _firmata->write(static_cast<uint8_t>(Command::END_SYSEX));
-            _firmata->flush();
-        }
-        catch (...)
+        //the handshake is timed from the first attempt
+        if( _handshake_start == std::chrono::steady_clock::time_point() )
         {
-            //if an error occurs here we count it as an attempt and continue.
+            _handshake_start = std::chrono::steady_clock::now();
         }
+    }
 
-        _firmata->unlock();
-        ++attempts;
+    _firmata->sendMessage( Platform::ArrayReference<uint8_t>( queries, sizeof( queries ) ) );
+}
 
-        //this loop is responsible for waiting at increasing intervals until the response is received or MAX_DELAY_LOOP number of iterations have occurred.
-        for (delay_loop = 0, delay_ms = INIT_DELAY_MS; delay_loop < MAX_DELAY_LOOP; ++delay_loop, delay_ms *= 2)
-        {
-            Sleep(delay_ms);
+bool RemoteDevice::SendPinCapabilityRequest(void)
+{
+    const int MAX_ATTEMPTS = 30;
+
+    //as long as the backoff delays between queries used to add up to, so a board which needs retries gets as many
+    const std::chrono::milliseconds RESPONSE_TIMEOUT( 310 );
 
-            {   //critical section
-                std::lock_guard<std::recursive_mutex> lock(_device_mutex);
-                if (_initialized)
-                    return true;
+    //the handshake queued by onConnectionReady is usually answered already. otherwise wait on the response events
+    //themselves, repeating the handshake only when a response is overdue.
+    std::unique_lock<std::recursive_mutex> lock( _device_mutex );
+    for( int attempts = 0; !_initialized; ++attempts )
+    {
+        if( attempts >= MAX_ATTEMPTS ) return false;
+        if( attempts )
+        {
+            //a board which answered the capability query but not the analog mapping query keeps its analog pins numbered in order
+            if( _pending_profile )
+            {
+                initializeWithPendingProfile();
+                break;
             }
+            sendHandshake();
         }
-    }
 
-    return false;
+        _initialized_condition.wait_for( lock, RESPONSE_TIMEOUT, [ this ]() -> bool { return _initialized; } );
+    }
 
+    return true;
 }
 
-
-
 bool RemoteDevice::GetPinConfiguration(
     void
 )
@@ -614,20 +936,152 @@ bool RemoteDevice::GetPinConfiguration(
 
 
 void
-RemoteDevice::onPinCapabilityResponseReceived(
+RemoteDevice::onAnalogMappingResponseReceived(
     UwpFirmata ^caller_,
     SysexCallbackEventArgs ^argv_
     )
 {
-    if( _initialized || argv_ == nullptr ) return;
+    if( argv_ == nullptr ) return;
 
-    HardwareProfile ^hardwareProfile = ref new HardwareProfile( argv_->getDataBuffer() );
-    if( hardwareProfile->IsValid )
-    {
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        std::vector<uint8_t> response = readBuffer( argv_->getDataBuffer() );
+        if( !_initialized )
+        {
+            //the mapping is only meaningful alongside the capability response it answers
+            if( !_pending_profile ) return;
+
+            //a mapping which disagrees with the capabilities is dropped, leaving the analog pins numbered in order
+            if( _pending_profile->applyAnalogMapping( response.data(), response.size() ) )
+            {
+                _fresh_profile.analogMappingResponse.swap( response );
+            }
+            initializeWithPendingProfile();
+            return;
+        }
+
+        //only a profile loaded from the cache is waiting to be checked, its capabilities already matched
+        if( _unvalidated_profile.capabilityResponse.empty() ) return;
+
+        const bool matches = ( response == _unvalidated_profile.analogMappingResponse );
+        _unvalidated_profile = Core::CachedProfile();
+
+        if( matches )
+        {
+            _profile_cache_validations.increment();
+            return;
+        }
+
+        _profile_cache_mismatches.increment();
+        _profile_cache->remove( _firmware );
+    }
+
+    closeForProfileMismatch( L"The board's analog pins differ from its cached hardware profile. Reconnect to use them." );
+}
+
+void
+RemoteDevice::onFirmwareReportReceived(
+    uint8_t major_,
+    uint8_t minor_,
+    Platform::String ^name_
+    )
+{
+    {   //critical section equivalent to function scope
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        //firmware names arrive as 7-bit characters, so narrowing them loses nothing
+        _firmware.name.assign( name_->Begin(), name_->End() );
+        _firmware.major = major_;
+        _firmware.minor = minor_;
+        _firmware_reported = true;
+
+        if( !_profile_cache ) return;
+
+        //a profile built before the firmware identified itself can be cached now
+        if( _initialized )
+        {
+            if( !_fresh_profile.analogMappingResponse.empty() )
+            {
+                _profile_cache->store( _firmware, _fresh_profile );
+                _fresh_profile = Core::CachedProfile();
+            }
+            return;
+        }
+
+        if( !_profile_cache->load( _firmware, _unvalidated_profile ) )
+        {
+            _profile_cache_misses.increment();
+            return;
+        }
+
+        //the capability response can overtake the firmware report. if it disagrees with the cached one, the live profile is
+        //used once its analog mapping arrives and is cached in place of this entry.
+        if( !_fresh_profile.capabilityResponse.empty() && _fresh_profile.capabilityResponse != _unvalidated_profile.capabilityResponse )
+        {
+            _unvalidated_profile = Core::CachedProfile();
+            _profile_cache_mismatches.increment();
+            _profile_cache->remove( _firmware );
+            return;
+        }
+
+        HardwareProfile ^hardwareProfile = ref new HardwareProfile( writeBuffer( _unvalidated_profile.capabilityResponse ) );
+        if( !hardwareProfile->IsValid
+         || !hardwareProfile->applyAnalogMapping( _unvalidated_profile.analogMappingResponse.data(), _unvalidated_profile.analogMappingResponse.size() ) )
+        {
+            //written by a build which parsed responses differently or cached profiles without a mapping, the fresh
+            //responses will replace it
+            _unvalidated_profile = Core::CachedProfile();
+            _profile_cache->remove( _firmware );
+            _profile_cache_misses.increment();
+            return;
+        }
+
+        //the device is ready, the responses to the handshake only have to confirm the cached ones
+        _profile_cache_hits.increment();
+        _pending_profile = nullptr;
+        _fresh_profile = Core::CachedProfile();
         initialize( hardwareProfile );
     }
 }
 
+void
+RemoteDevice::onPinCapabilityResponseReceived(
+    UwpFirmata ^caller_,
+    SysexCallbackEventArgs ^argv_
+    )
+{
+    if( argv_ == nullptr ) return;
+
+    {   //critical section
+        std::lock_guard<std::recursive_mutex> lock( _device_mutex );
+
+        std::vector<uint8_t> response = readBuffer( argv_->getDataBuffer() );
+        if( !_initialized )
+        {
+            HardwareProfile ^hardwareProfile = ref new HardwareProfile( argv_->getDataBuffer() );
+            if( !hardwareProfile->IsValid ) return;
+
+            //the analog mapping queried alongside completes the profile
+            _pending_profile = hardwareProfile;
+            _fresh_profile.capabilityResponse.swap( response );
+            _fresh_profile.analogMappingResponse.clear();
+            return;
+        }
+
+        //only a profile loaded from the cache is waiting to be checked, the analog mapping which follows completes the check
+        if( _unvalidated_profile.capabilityResponse.empty() || response == _unvalidated_profile.capabilityResponse ) return;
+
+        //the same firmware can run on boards with different pins, and the profile in use can no longer change under
+        //lock-free readers. the entry is dropped so the next connection caches both fresh responses.
+        _unvalidated_profile = Core::CachedProfile();
+        _profile_cache_mismatches.increment();
+        _profile_cache->remove( _firmware );
+    }
+
+    closeForProfileMismatch( L"The board's capabilities differ from its cached hardware profile. Reconnect to use them." );
+}
+
 uint8_t
 RemoteDevice::parsePinFromAnalogString(
     Platform::String^ string_
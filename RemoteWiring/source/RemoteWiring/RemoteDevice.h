@@ -24,10 +24,19 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
 #include <mutex>
+#include <vector>
 #include "TwoWire.h"
 #include "HardwareProfile.h"
+#include "Core/PinStateCache.h"
+#include "Core/ProfileCache.h"
+#include "Core/SampleHistory.h"
+#include "../Firmata/Core/Metrics.h"
 
 namespace Microsoft {
 namespace Maker {
@@ -56,9 +65,71 @@ public enum class PinState
     HIGH = 0x01,
 };
 
+///<summary>
+///The value of every digital port and analog channel at a single moment, as returned by RemoteDevice.getPinStateSnapshot
+///</summary>
+public ref class PinStateSnapshot sealed
+{
+public:
+    ///<summary>
+    ///Changes whenever any value changes. Two snapshots with the same sequence hold the same values.
+    ///</summary>
+    property uint32_t Sequence
+    {
+        uint32_t get() { return _snapshot.sequence; }
+    }
+
+    ///<summary>
+    ///Returns the value of the given analog channel, where 0 refers to "A0", 1 refers to "A1", and so on.
+    ///<para>Channels which are not in PinMode.ANALOG keep the last value they reported, 0 if they never have.</para>
+    ///</summary>
+    uint16_t
+    analogValue(
+        uint8_t channel_
+    )
+    {
+        return ( channel_ < _snapshot.analog_channels.size() ) ? _snapshot.analog_channels[channel_] : 0;
+    }
+
+    ///<summary>
+    ///Returns the state of the given digital pin, read from its port's value
+    ///</summary>
+    PinState
+    digitalValue(
+        uint8_t pin_
+    )
+    {
+        return ( ( digitalPortValue( pin_ / 8 ) >> ( pin_ % 8 ) ) & 0x01 ) ? PinState::HIGH : PinState::LOW;
+    }
+
+    ///<summary>
+    ///Returns the value of the given digital port, pin 8 * port_ in the lowest bit
+    ///</summary>
+    uint8_t
+    digitalPortValue(
+        uint8_t port_
+    )
+    {
+        return ( port_ < _snapshot.digital_ports.size() ) ? _snapshot.digital_ports[port_] : 0;
+    }
+
+internal:
+    PinStateSnapshot(
+        const Core::PinStateSnapshot &snapshot_
+    ) :
+        _snapshot( snapshot_ )
+    {
+    }
+
+private:
+    Core::PinStateSnapshot _snapshot;
+};
+
 public delegate void DigitalPinUpdatedCallback( uint8_t pin, PinState state );
 public delegate void AnalogPinUpdatedCallback( Platform::String ^pin, uint16_t value );
+public delegate void AnalogChannelUpdatedCallback( uint8_t channel, uint16_t value );
 public delegate void SysexMessageReceivedCallback( uint8_t command, Windows::Storage::Streams::DataReader ^message );
+public delegate void SysexDataReceivedCallback( uint8_t command, const Platform::Array<uint8_t> ^data );
 public delegate void StringMessageReceivedCallback( Platform::String ^message );
 public delegate void RemoteDeviceConnectionCallback();
 public delegate void RemoteDeviceConnectionCallbackWithMessage( Platform::String ^message );
@@ -71,12 +142,34 @@ public ref class RemoteDevice sealed {
 public:
     event DigitalPinUpdatedCallback ^ DigitalPinUpdated;
     event AnalogPinUpdatedCallback ^ AnalogPinUpdated;
-    event SysexMessageReceivedCallback ^ SysexMessageReceived;
+
+    ///<summary>
+    ///Raised alongside AnalogPinUpdated, identifying the analog pin by its channel number (0 for "A0") instead of by name
+    ///</summary>
+    event AnalogChannelUpdatedCallback ^ AnalogChannelUpdated;
     event StringMessageReceivedCallback ^ StringMessageReceived;
     event RemoteDeviceConnectionCallback ^ DeviceReady;
     event RemoteDeviceConnectionCallbackWithMessage ^ DeviceConnectionFailed;
     event RemoteDeviceConnectionCallbackWithMessage ^ DeviceConnectionLost;
 
+    ///<summary>
+    ///Raised for each unhandled sysex message, with a copy of the message data wrapped in a DataReader.
+    ///<para>The copy is only made while this event has subscribers. SysexDataReceived delivers the same messages without copying.</para>
+    ///</summary>
+    event SysexMessageReceivedCallback ^ SysexMessageReceived
+    {
+        Windows::Foundation::EventRegistrationToken add( SysexMessageReceivedCallback ^handler_ );
+        void remove( Windows::Foundation::EventRegistrationToken token_ );
+        void raise( uint8_t command_, Windows::Storage::Streams::DataReader ^message_ );
+    }
+
+    ///<summary>
+    ///Raised for each unhandled sysex message.
+    ///<para>The data array is a read-only view of the receive buffer and is only valid for the duration of the callback.
+    ///Handlers which need to keep the data must copy it.</para>
+    ///</summary>
+    event SysexDataReceivedCallback ^ SysexDataReceived;
+
     property I2c::TwoWire ^ I2c
     {
         Microsoft::Maker::RemoteWiring::I2c::TwoWire ^ get()
@@ -125,22 +218,70 @@ public:
 
     virtual ~RemoteDevice();
 
-
+    ///<summary>
+    ///Waits until the board's hardware profile is known, repeating the handshake queued when the connection became ready
+    ///if its responses are overdue. The time from that first handshake to the profile being known is kept in the
+    ///device.handshake_us metric, which stays unset when the profile was given with setHardwareProfile.
+    ///<returns>false if the board never answered</returns>
+    ///</summary>
     bool GetPinConfiguration(
         void
     );
 
+    ///<summary>
+    ///Gives this device the given hardware profile, typically HardwareProfile.ForKnownBoard, instead of the one the board
+    ///describes. The device is initialized at once and GetPinConfiguration returns without waiting; the board's own
+    ///responses to the handshake are then ignored, so the profile must match the board.
+    ///<returns>false if the profile is not valid or the device already has a profile</returns>
+    ///</summary>
+    bool
+    setHardwareProfile(
+        HardwareProfile ^profile_
+    );
+
 
     ///<summary>
     ///Returns the most recently-reported value for the given analog pin.
     ///<para>Analog pins must first be in PinMode.ANALOG before their values will be reported.</para>
     ///<param name="analog_pin_">The analog pin string, where "A0" refers to the first analog pin A0, "A1" refers to A1, and so on.</param>
     ///</summary>
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
     uint16_t
     analogRead(
         Platform::String ^analog_pin_
     );
 
+    ///<summary>
+    ///Returns the most recently-reported value for the given analog channel, without building or parsing a pin name.
+    ///<para>Analog pins must first be in PinMode.ANALOG before their values will be reported.</para>
+    ///<param name="channel_">The analog channel, where 0 refers to the first analog pin A0, 1 refers to A1, and so on.</param>
+    ///</summary>
+    uint16_t
+    analogRead(
+        uint8_t channel_
+    );
+
+    ///<summary>
+    ///Sets the analog pin with the given channel number to the given PinMode, as pinMode( String, PinMode ) does for its name.
+    ///<para>This is not an overload of pinMode, because pinMode( uint8_t, PinMode ) already takes a raw pin number.</para>
+    ///<param name="channel_">The analog channel, where 0 refers to the first analog pin A0, 1 refers to A1, and so on.</param>
+    ///<param name="mode_">The desired mode for the given analog pin.</param>
+    ///</summary>
+    void
+    analogPinMode(
+        uint8_t channel_,
+        PinMode mode_
+    );
+
+    ///<summary>
+    ///Retrieves the mode of the analog pin with the given channel number, as getPinMode( String ) does for its name.
+    ///<param name="channel_">The analog channel, where 0 refers to the first analog pin A0, 1 refers to A1, and so on.</param>
+    ///</summary>
+    PinMode
+    getAnalogPinMode(
+        uint8_t channel_
+    );
+
     ///<summary>
     ///Sets the value of the given pin to the given analog value.
     ///<para>This function should only be called for pins that support PWM. If the given pin is in 
@@ -164,6 +305,16 @@ public:
         uint8_t pin_
     );
 
+    ///<summary>
+    ///Returns the most recently-reported value of every digital port and analog channel, all taken at the same moment.
+    ///<para>Unlike analogRead and digitalRead this takes no lock and never changes a pin's mode, so building a row of
+    ///readings costs one copy rather than one locked call per pin.</para>
+    ///</summary>
+    PinStateSnapshot ^
+    getPinStateSnapshot(
+        void
+    );
+
     ///<summary>
     ///Sets the value of the given pin to the given state.
     ///<param name="pin_">A raw pin number which will be treated "as is" and used exactly as given.</param>
@@ -178,6 +329,104 @@ public:
     uint8_t getMinorVersion();
     Platform::String ^ getFirmwareName();
 
+    ///<summary>
+    ///Takes a snapshot of this device's metrics: reports received, pin events raised, reads and writes made by the app, and
+    ///how long event handlers take. The metrics of the underlying UwpFirmata instance are included alongside them.
+    ///<para>Histograms are expanded into name.count, name.mean, name.p50, name.p90, name.p99, name.p999 and name.max.</para>
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    getMetrics(
+        void
+    );
+
+    ///<summary>
+    ///Keeps the capability and analog mapping responses of each firmware this device connects to in the given folder,
+    ///and gives a board whose firmware name and version were seen before its cached hardware profile as soon as it
+    ///reports them, rather than after a capability query round trip.
+    ///<para>A cached profile is checked against the fresh responses as soon as they arrive. A capability response which
+    ///arrives before the firmware report and differs replaces the cached profile outright. Otherwise, since the profile
+    ///of a ready device cannot change, a difference drops the cache entry, stops raising reports, finishes the connection
+    ///and then raises DeviceConnectionLost; the next connection caches the new profile. A profile is only cached once the
+    ///board's analog mapping has been received and accepted. Hits, misses and mismatches are counted in the
+    ///device.profile_cache metrics.</para>
+    ///<para>Call this before the connection is ready. The folder must already exist and be writable.</para>
+    ///<param name="folder_">The folder holding the cache, one file per firmware.</param>
+    ///</summary>
+    void
+    enableProfileCache(
+        Platform::String ^folder_
+    );
+
+    ///<summary>
+    ///Starts keeping every value reported for the given analog channel, rather than only the most recent one, so that a
+    ///consumer which reads slower than the board reports does not lose samples. Values are timestamped as they arrive and
+    ///held until drainAnalogHistory is called; once depth_ of them are waiting, further values are dropped and counted
+    ///in the device.history.overruns metric.
+    ///<para>Enabling a channel again discards anything it holds. The channel must also be in PinMode.ANALOG to report.</para>
+    ///<param name="channel_">The analog channel, where 0 refers to "A0", 1 refers to "A1", and so on.</param>
+    ///<param name="depth_">The number of samples to hold, rounded up to a power of two.</param>
+    ///<returns>false if the channel or depth is out of range</returns>
+    ///</summary>
+    bool
+    enableAnalogHistory(
+        uint8_t channel_,
+        uint32_t depth_
+    );
+
+    ///<summary>
+    ///Stops keeping the values reported for the given analog channel and discards any that have not been drained
+    ///</summary>
+    void
+    disableAnalogHistory(
+        uint8_t channel_
+    );
+
+    ///<summary>
+    ///Moves the oldest values held for the given analog channel into the given arrays, oldest first.
+    ///<para>Timestamps are in microseconds on a monotonic clock with an arbitrary epoch, shared by every channel and port.</para>
+    ///<param name="timestamps_">Receives the arrival time of each value.</param>
+    ///<param name="values_">Receives the values, the number moved is bounded by the shorter of the two arrays.</param>
+    ///<returns>the number of samples moved, 0 if the channel's history is not enabled</returns>
+    ///</summary>
+    uint32_t
+    drainAnalogHistory(
+        uint8_t channel_,
+        Platform::WriteOnlyArray<int64_t> ^timestamps_,
+        Platform::WriteOnlyArray<uint16_t> ^values_
+    );
+
+    ///<summary>
+    ///Starts keeping every value reported for the given digital port (pins 8 * port_ to 8 * port_ + 7), as with
+    ///enableAnalogHistory. Each sample holds the value of the whole port after the report was applied.
+    ///<param name="port_">The digital port.</param>
+    ///<param name="depth_">The number of samples to hold, rounded up to a power of two.</param>
+    ///<returns>false if the port or depth is out of range</returns>
+    ///</summary>
+    bool
+    enableDigitalHistory(
+        uint8_t port_,
+        uint32_t depth_
+    );
+
+    ///<summary>
+    ///Stops keeping the values reported for the given digital port and discards any that have not been drained
+    ///</summary>
+    void
+    disableDigitalHistory(
+        uint8_t port_
+    );
+
+    ///<summary>
+    ///Moves the oldest values held for the given digital port into the given arrays, oldest first, as with drainAnalogHistory
+    ///<returns>the number of samples moved, 0 if the port's history is not enabled</returns>
+    ///</summary>
+    uint32_t
+    drainDigitalHistory(
+        uint8_t port_,
+        Platform::WriteOnlyArray<int64_t> ^timestamps_,
+        Platform::WriteOnlyArray<uint8_t> ^values_
+    );
+
     ///<summary>
     ///Sets the given pin to the given PinMode.
     ///<para>This function uses the given pin number "as is". Due to the way that Arduino and Arduino-like devices are engineered, analog pins like "A0"
@@ -233,39 +482,106 @@ public:
         );
 
 
+internal:
+    ///<summary>
+    ///Sets the given pin to the given PinMode without checking the hardware profile supports it, for callers which have
+    ///already checked, such as FixedBoardDevice while compiling
+    ///</summary>
+    void
+    setPinModeUnchecked(
+        uint8_t pin_,
+        PinMode mode_
+    );
+
 private:
     //constant members
-    static const size_t MAX_PORTS = 16;
-    static const size_t MAX_PINS = 128;
-    static const size_t MAX_ANALOG_PINS = 16;
+    static const size_t MAX_ANALOG_PINS = Core::PinStateCache::MAX_ANALOG_PINS;
 
     //initialized state member
     std::atomic_bool _initialized;
 
+    //set on the input thread when the board contradicts its cached profile, reports are no longer raised once it is
+    std::atomic_bool _profile_mismatch;
+
     //hardware profile
     HardwareProfile ^_hardwareProfile;
 
     //initialization for constructor
     void const initialize( HardwareProfile ^hardwareProfile_ );
 
+    //initializes with _pending_profile and caches the responses it was built from, under _device_mutex
+    void
+    initializeWithPendingProfile(
+        void
+    );
+
+    //stops raising reports and closes the connection from a task, as the caller is on the input thread finish() joins
+    void
+    closeForProfileMismatch(
+        Platform::String ^message_
+    );
+
     //a reference to the UAP firmata interface
     Firmata::UwpFirmata ^_firmata;
 
-    //a mutex for thread safety
+    //serializes initialization
     std::recursive_mutex _device_mutex;
 
-    //state-tracking cache variables
-    std::array<std::atomic_uint8_t, MAX_PORTS> _subscribed_ports;
-    std::array<std::atomic_uint8_t, MAX_PORTS> _digital_port;
-    std::array<std::atomic_uint16_t, MAX_ANALOG_PINS> _analog_pins;
-    std::array<std::atomic_uint8_t, MAX_PINS> _pin_mode;
+    //notified under _device_mutex once _initialized is set, so GetPinConfiguration completes on the response itself
+    std::condition_variable_any _initialized_condition;
 
-    //maps the given pin number to the correct port and mask
-    void
-    getPinMap(
-        uint8_t, int *,
-        uint8_t *
-    );
+    //when the first handshake was queued, guarded by _device_mutex
+    std::chrono::steady_clock::time_point _handshake_start;
+
+    //held only while a change is committed to the cache and its message queued, so the board sees mode changes and writes
+    //in the same order as the cache. queuing never waits for the transport, and reads and reports never take it.
+    std::mutex _wire_mutex;
+
+    //state-tracking cache, safe to read and update from any thread, see Core::PinStateCache
+    Core::PinStateCache _pin_state;
+
+    //updated without taking _device_mutex, see Firmata::Core::Counter
+    Firmata::Core::MetricsRegistry _metrics;
+    Firmata::Core::Counter &_analog_reports;
+    Firmata::Core::Counter &_digital_reports;
+    Firmata::Core::Counter &_pin_events;
+    Firmata::Core::Counter &_reads;
+    Firmata::Core::Counter &_writes;
+    Firmata::Core::Counter &_pin_mode_changes;
+    Firmata::Core::Histogram &_dispatch_latency;
+    Firmata::Core::Counter &_profile_cache_hits;
+    Firmata::Core::Counter &_profile_cache_misses;
+    Firmata::Core::Counter &_profile_cache_mismatches;
+    Firmata::Core::Counter &_profile_cache_validations;
+    Firmata::Core::Gauge &_handshake_time;
+
+    //capability responses of firmware seen before, null unless enableProfileCache was called. this and the members
+    //below are only touched under _device_mutex, which the input thread takes once per firmware report or response.
+    std::unique_ptr<Core::ProfileCache> _profile_cache;
+
+    //the firmware most recently reported by the board, valid once _firmware_reported is set
+    Core::FirmwareIdentity _firmware;
+    bool _firmware_reported;
+
+    //the cached responses the profile was loaded from, kept until fresh responses arrive to check them against
+    Core::CachedProfile _unvalidated_profile;
+
+    //the responses to this connection's handshake, kept until the profile built from them can be cached
+    Core::CachedProfile _fresh_profile;
+
+    //built from the capability response, used once the analog mapping which follows it has been applied
+    HardwareProfile ^_pending_profile;
+
+    //optional per-channel and per-port sample rings, filled by the input thread and drained by the app
+    Core::SampleHistory _analog_history;
+    Core::SampleHistory _digital_history;
+
+    //interned "A0".."A15" names so analog reports do not build a new string for every event
+    Platform::Array<Platform::String ^> ^_analog_pin_names;
+
+    //backing event for SysexMessageReceived, which tracks its subscribers so the DataReader copy can be skipped when nobody is listening
+    event SysexMessageReceivedCallback ^ _sysex_message_received;
+    std::atomic_int _sysex_message_subscribers;
 
     bool
     isModeSupported(
@@ -282,6 +598,12 @@ private:
     // Helper
     bool SendPinCapabilityRequest(void);
 
+    //queues REPORT_FIRMWARE, CAPABILITY_QUERY and ANALOG_MAPPING_QUERY as one message
+    void
+    sendHandshake(
+        void
+    );
+
     //connection callbacks
     void
     onConnectionReady(
@@ -301,17 +623,20 @@ private:
     //reporting callbacks
     void
     onDigitalReport(
-        Firmata::CallbackEventArgs ^argv_
+        uint8_t port_,
+        uint16_t value_
     );
 
     void
     onAnalogReport(
-        Firmata::CallbackEventArgs ^argv_
+        uint8_t pin_,
+        uint16_t value_
     );
 
     void
     onSysexMessage(
-        Firmata::SysexCallbackEventArgs ^argv_
+        uint8_t command_,
+        const Platform::Array<uint8_t> ^data_
     );
 
     void
@@ -319,6 +644,19 @@ private:
         Firmata::StringCallbackEventArgs ^argv_
     );
 
+    void
+    onAnalogMappingResponseReceived(
+        Microsoft::Maker::Firmata::UwpFirmata ^caller_,
+        Microsoft::Maker::Firmata::SysexCallbackEventArgs ^argv_
+    );
+
+    void
+    onFirmwareReportReceived(
+        uint8_t major_,
+        uint8_t minor_,
+        Platform::String ^name_
+    );
+
     void
     onPinCapabilityResponseReceived(
         Microsoft::Maker::Firmata::UwpFirmata ^caller_,
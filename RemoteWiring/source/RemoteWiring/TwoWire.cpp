@@ -24,6 +24,7 @@
 
 #include "pch.h"
 #include "TwoWire.h"
+#include "../Firmata/Core/FirmataEncoder.h"
 
 using namespace Microsoft::Maker::Firmata;
 using namespace Microsoft::Maker::RemoteWiring::I2c;
@@ -89,37 +90,60 @@ TwoWire::sendI2cSysex(
     uint8_t *data_
     )
 {
-    _firmata->lock();
-    try
-    {
-        _firmata->write( static_cast<uint8_t>( Command::START_SYSEX ) );
-        _firmata->write( static_cast<uint8_t>( Microsoft::Maker::Firmata::SysexCommand::I2C_REQUEST ) );
-        _firmata->write( address_ );
-        _firmata->write( rw_mask_ );
-
-        if( data_ != nullptr )
-        {
-            for( size_t i = 0; i < len_; ++i )
-            {
-                _firmata->sendValueAsTwo7bitBytes( data_[i] );
-            }
-        }
-
-        _firmata->write( static_cast<uint8_t>( Command::END_SYSEX ) );
-        _firmata->flush();
-        _firmata->unlock();
-    }
-    catch( ... )
-    {
-        _firmata->unlock();
-    }
+    //START_SYSEX, command, address, mask, two bytes per data byte and END_SYSEX
+    uint8_t message[ 5 + 2 * UINT8_MAX ];
+    const uint8_t prefix[] = { address_, rw_mask_ };
+
+    size_t length = Firmata::Core::FirmataEncoder::sysex( static_cast<uint8_t>( Microsoft::Maker::Firmata::SysexCommand::I2C_REQUEST ), prefix, sizeof( prefix ), data_, data_ != nullptr ? len_ : 0, message );
+    _firmata->sendMessage( Platform::ArrayReference<uint8_t>( message, static_cast<unsigned int>( length ) ) );
+}
+
+
+Windows::Foundation::EventRegistrationToken
+TwoWire::I2cReplyEvent::add(
+    I2cReplyCallback ^handler_
+    )
+{
+    ++_i2c_reply_subscribers;
+    return _i2c_reply_event += handler_;
+}
+
+
+void
+TwoWire::I2cReplyEvent::remove(
+    Windows::Foundation::EventRegistrationToken token_
+    )
+{
+    _i2c_reply_event -= token_;
+    --_i2c_reply_subscribers;
+}
+
+
+void
+TwoWire::I2cReplyEvent::raise(
+    uint8_t address_,
+    uint8_t reg_,
+    Windows::Storage::Streams::DataReader ^response_
+    )
+{
+    _i2c_reply_event( address_, reg_, response_ );
 }
 
 
 void
 TwoWire::onI2cReply(
-    I2cCallbackEventArgs ^args
+    uint8_t address_,
+    uint8_t reg_,
+    const Platform::Array<uint8_t> ^response_
     )
 {
-    I2cReplyEvent( args->getAddress(), args->getRegister(), Windows::Storage::Streams::DataReader::FromBuffer( args->getDataBuffer() ) );
+    I2cReplyDataEvent( address_, reg_, response_ );
+
+    //the DataReader outlives the callback, so it needs its own copy of the response
+    if( _i2c_reply_subscribers > 0 )
+    {
+        Windows::Storage::Streams::DataWriter ^writer = ref new Windows::Storage::Streams::DataWriter();
+        writer->WriteBytes( response_ );
+        I2cReplyEvent( address_, reg_, Windows::Storage::Streams::DataReader::FromBuffer( writer->DetachBuffer() ) );
+    }
 }
@@ -22,6 +22,7 @@
     THE SOFTWARE.
 */
 
+#include <atomic>
 #include <cstdint>
 
 namespace Microsoft {
@@ -33,13 +34,30 @@ ref class RemoteDevice;
 namespace I2c {
 
 public delegate void I2cReplyCallback( uint8_t address_, uint8_t reg_, Windows::Storage::Streams::DataReader ^response );
+public delegate void I2cReplyDataCallback( uint8_t address_, uint8_t reg_, const Platform::Array<uint8_t> ^response );
 
 public ref class TwoWire sealed
 {
 public:
     friend ref class RemoteDevice;
 
-    event I2cReplyCallback ^ I2cReplyEvent;
+    ///<summary>
+    ///Raised for each I2C reply, with a copy of the response wrapped in a DataReader.
+    ///<para>The copy is only made while this event has subscribers. I2cReplyDataEvent delivers the same replies without copying.</para>
+    ///</summary>
+    event I2cReplyCallback ^ I2cReplyEvent
+    {
+        Windows::Foundation::EventRegistrationToken add( I2cReplyCallback ^handler_ );
+        void remove( Windows::Foundation::EventRegistrationToken token_ );
+        void raise( uint8_t address_, uint8_t reg_, Windows::Storage::Streams::DataReader ^response_ );
+    }
+
+    ///<summary>
+    ///Raised for each I2C reply.
+    ///<para>The response array is a read-only view of the receive buffer and is only valid for the duration of the callback.
+    ///Handlers which need to keep the response must copy it.</para>
+    ///</summary>
+    event I2cReplyDataCallback ^ I2cReplyDataEvent;
 
     ///<summary>
     ///Enables I2C with no delay time for requesting a response from the secondary device
@@ -116,9 +134,10 @@ private:
         Firmata::UwpFirmata ^ firmata_
         ) :
         _data_buffer( new uint8_t[ MAX_MESSAGE_LEN ] ),
-        _firmata( firmata_ )
+        _firmata( firmata_ ),
+        _i2c_reply_subscribers( ATOMIC_VAR_INIT(0) )
     {
-        _firmata->I2cReplyReceived += ref new Firmata::I2cReplyCallbackFunction( [this]( Firmata::UwpFirmata ^caller, Firmata::I2cCallbackEventArgs^ args ) -> void { onI2cReply( args ); } );
+        _firmata->I2cReplyDataReceived += ref new Firmata::I2cReplyDataCallbackFunction( [this]( Firmata::UwpFirmata ^caller, uint8_t address, uint8_t reg, const Platform::Array<uint8_t>^ data ) -> void { onI2cReply( address, reg, data ); } );
     }
     
     //a reference to the UAP firmata interface
@@ -129,6 +148,10 @@ private:
     uint8_t _position;
     std::unique_ptr<uint8_t> _data_buffer;
 
+    //backing event for I2cReplyEvent, which tracks its subscribers so the DataReader copy can be skipped when nobody is listening
+    event I2cReplyCallback ^ _i2c_reply_event;
+    std::atomic_int _i2c_reply_subscribers;
+
     void
     sendI2cSysex(
         const uint8_t address_,
@@ -139,7 +162,9 @@ private:
 
     void
     onI2cReply(
-        Firmata::I2cCallbackEventArgs ^argv
+        uint8_t address_,
+        uint8_t reg_,
+        const Platform::Array<uint8_t> ^response_
     );
 };
 
@@ -0,0 +1,195 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * CapabilityParser: the known board profiles survive a round trip through the responses a board would send, and
+ * malformed CAPABILITY_RESPONSEs and ANALOG_MAPPING_RESPONSEs which disagree with the capabilities are rejected without
+ * touching what was parsed before.
+ *
+ * Built by the capability_parser_tests target and run by CTest.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "TestHarness.h"
+#include "RemoteWiring/Core/BoardProfiles.h"
+#include "RemoteWiring/Core/CapabilityParser.h"
+
+using namespace Microsoft::Maker::RemoteWiring::Core;
+
+namespace {
+
+const Board BOARDS[] = { Board::ARDUINO_UNO, Board::ARDUINO_NANO, Board::ARDUINO_MEGA_2560, Board::ARDUINO_LEONARDO };
+
+//an Uno parsed from its capability response, its analog pins 14-19 numbered A0-A5 in order
+BoardCapabilities
+parsedUno(
+    void
+    )
+{
+    BoardCapabilities capabilities;
+    const std::vector<uint8_t> response = BoardProfiles::capabilityResponse( ARDUINO_UNO );
+    TEST_CHECK( CapabilityParser::parse( response.data(), response.size(), capabilities ) );
+    return capabilities;
+}
+
+bool
+sameChannels(
+    const BoardCapabilities &a_,
+    const BoardCapabilities &b_
+    )
+{
+    return a_.analogChannels == b_.analogChannels && a_.channelPins == b_.channelPins;
+}
+
+void
+knownBoardsRoundTrip(
+    void
+    )
+{
+    for( Board board : BOARDS )
+    {
+        const BoardDescriptor descriptor = describeBoard( board );
+        const std::vector<uint8_t> response = BoardProfiles::capabilityResponse( descriptor );
+        const std::vector<uint8_t> mapping = BoardProfiles::analogMappingResponse( descriptor );
+
+        BoardCapabilities capabilities;
+        TEST_CHECK( CapabilityParser::parse( response.data(), response.size(), capabilities ) );
+        TEST_CHECK( CapabilityParser::parseAnalogMapping( mapping.data(), mapping.size(), capabilities ) );
+        TEST_CHECK( capabilities.totalPinCount == descriptor.totalPins );
+        TEST_CHECK( capabilities.analogPinCount == descriptor.analogPinCount );
+
+        for( size_t pin = 0; pin < BoardCapabilities::MAX_PINS; ++pin )
+        {
+            TEST_CHECK( capabilities.capabilities( pin ) == descriptor.capabilities( pin ) );
+            TEST_CHECK( capabilities.analogChannel( pin ) == descriptor.analogChannel( pin ) );
+        }
+        for( size_t channel = 0; channel < BoardCapabilities::MAX_ANALOG_CHANNELS; ++channel )
+        {
+            TEST_CHECK( capabilities.channelPin( channel ) == descriptor.channelPin( channel ) );
+        }
+    }
+}
+
+void
+malformedCapabilityResponse(
+    void
+    )
+{
+    const BoardCapabilities original = parsedUno();
+    const std::vector<uint8_t> response = BoardProfiles::capabilityResponse( ARDUINO_UNO );
+
+    std::vector<std::vector<uint8_t>> rejected;
+
+    //a mode cut off from the byte which follows it, pins 0 and 1 having no modes
+    rejected.push_back( std::vector<uint8_t>( response.begin(), response.begin() + 3 ) );
+
+    //a pin reporting ANALOG twice
+    rejected.push_back( { 0x02, 10, 0x02, 10, 0x7F } );
+
+    //more pins than Firmata can address
+    rejected.push_back( std::vector<uint8_t>( BoardCapabilities::MAX_PINS + 1, 0x7F ) );
+
+    for( const std::vector<uint8_t> &malformed : rejected )
+    {
+        BoardCapabilities capabilities = original;
+        TEST_CHECK( !CapabilityParser::parse( malformed.data(), malformed.size(), capabilities ) );
+        TEST_CHECK( capabilities.totalPinCount == original.totalPinCount && capabilities.pinCapabilities == original.pinCapabilities );
+    }
+}
+
+void
+analogMappingReordered(
+    void
+    )
+{
+    BoardCapabilities capabilities = parsedUno();
+
+    //a board may read its analog pins in any order, the mapping replaces the in-order numbering
+    std::vector<uint8_t> mapping( capabilities.totalPinCount, static_cast<uint8_t>( BoardCapabilities::NO_CHANNEL ) );
+    for( uint8_t channel = 0; channel < 6; ++channel ) { mapping[19 - channel] = channel; }
+
+    TEST_CHECK( CapabilityParser::parseAnalogMapping( mapping.data(), mapping.size(), capabilities ) );
+    TEST_CHECK( capabilities.channelPin( 0 ) == 19 && capabilities.channelPin( 5 ) == 14 );
+    TEST_CHECK( capabilities.analogChannel( 14 ) == 5 && capabilities.analogChannel( 19 ) == 0 );
+    TEST_CHECK( capabilities.channelPin( 6 ) == BoardCapabilities::NO_PIN );
+}
+
+void
+analogMappingRejected(
+    void
+    )
+{
+    const BoardCapabilities original = parsedUno();
+    const std::vector<uint8_t> valid = BoardProfiles::analogMappingResponse( ARDUINO_UNO );
+
+    std::vector<std::vector<uint8_t>> rejected;
+
+    //not one byte per pin
+    rejected.push_back( std::vector<uint8_t>() );
+    rejected.push_back( std::vector<uint8_t>( valid.begin(), valid.end() - 1 ) );
+    rejected.push_back( valid );
+    rejected.back().push_back( static_cast<uint8_t>( BoardCapabilities::NO_CHANNEL ) );
+
+    //a channel which cannot be reported
+    rejected.push_back( valid );
+    rejected.back()[14] = static_cast<uint8_t>( BoardCapabilities::MAX_ANALOG_CHANNELS );
+
+    //two pins reading the same channel
+    rejected.push_back( valid );
+    rejected.back()[15] = 0;
+
+    //a channel read by a pin which has no ADC
+    rejected.push_back( valid );
+    rejected.back()[2] = 6;
+
+    for( const std::vector<uint8_t> &mapping : rejected )
+    {
+        BoardCapabilities capabilities = original;
+        TEST_CHECK( !CapabilityParser::parseAnalogMapping( mapping.data(), mapping.size(), capabilities ) );
+        TEST_CHECK( sameChannels( capabilities, original ) );
+    }
+
+    //the unmodified mapping is accepted
+    BoardCapabilities capabilities = original;
+    TEST_CHECK( CapabilityParser::parseAnalogMapping( valid.data(), valid.size(), capabilities ) );
+    TEST_CHECK( sameChannels( capabilities, original ) );
+}
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    return Test::run( argc, argv, {
+        { "known_boards_round_trip", knownBoardsRoundTrip },
+        { "malformed_capability_response", malformedCapabilityResponse },
+        { "analog_mapping_reordered", analogMappingReordered },
+        { "analog_mapping_rejected", analogMappingRejected },
+    } );
+}
@@ -0,0 +1,270 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * FirmataParser: messages split across chunks at every possible point, and the recovery from messages which overflow
+ * the sysex buffer, lose their end or are abandoned with reset().
+ *
+ * Built by the firmata_parser_tests target and run by CTest.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TestHarness.h"
+#include "Firmata/Core/FirmataEncoder.h"
+#include "Firmata/Core/FirmataParser.h"
+#include "Firmata/Core/FirmataProtocol.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+/*
+ * Records every message and error raised by a parser as a line of text, so two runs can be compared as a whole
+ */
+class ParserLog
+{
+public:
+    explicit
+    ParserLog(
+        size_t max_sysex_size_ = FirmataParser::DEFAULT_MAX_SYSEX_SIZE
+        )
+    {
+        FirmataParserHandlers handlers;
+        handlers.analogMessage = [ this ]( uint8_t pin_, uint16_t value_ ) -> void { add( "analog " + std::to_string( pin_ ) + " " + std::to_string( value_ ) ); };
+        handlers.digitalMessage = [ this ]( uint8_t port_, uint16_t value_ ) -> void { add( "digital " + std::to_string( port_ ) + " " + std::to_string( value_ ) ); };
+        handlers.protocolVersion = [ this ]( uint8_t major_, uint8_t minor_ ) -> void { add( "version " + std::to_string( major_ ) + "." + std::to_string( minor_ ) ); };
+        handlers.sysexMessage = [ this ]( uint8_t command_, const uint8_t *data_, size_t length_ ) -> void
+        {
+            std::string entry = "sysex " + std::to_string( command_ ) + ":";
+            for( size_t i = 0; i < length_; ++i ) { entry += " " + std::to_string( data_[i] ); }
+            add( entry );
+        };
+        handlers.parseError = [ this ]( ParseError error_ ) -> void { add( "error " + std::to_string( static_cast<int>( error_ ) ) ); };
+        _parser.reset( new FirmataParser( handlers, max_sysex_size_ ) );
+    }
+
+    FirmataParser &
+    parser(
+        void
+        )
+    {
+        return *_parser;
+    }
+
+    const std::vector<std::string> &
+    entries(
+        void
+        ) const
+    {
+        return _entries;
+    }
+
+private:
+    std::unique_ptr<FirmataParser> _parser;
+    std::vector<std::string> _entries;
+
+    void
+    add(
+        const std::string &entry_
+        )
+    {
+        _entries.push_back( entry_ );
+    }
+};
+
+//one of each message a board sends, the sysex carrying 8-bit data so its payload includes every byte value's halves
+std::vector<uint8_t>
+boardSession(
+    void
+    )
+{
+    std::vector<uint8_t> session;
+    uint8_t message[FirmataEncoder::MAX_CHANNEL_MESSAGE_SIZE];
+
+    session.insert( session.end(), message, message + FirmataEncoder::protocolVersion( 2, 5, message ) );
+    session.insert( session.end(), message, message + FirmataEncoder::analogMessage( 3, 1023, message ) );
+    session.insert( session.end(), message, message + FirmataEncoder::digitalMessage( 1, 0xA5, message ) );
+
+    uint8_t data[40];
+    for( size_t i = 0; i < sizeof( data ); ++i ) { data[i] = static_cast<uint8_t>( i * 37 ); }
+    const uint8_t prefix[] = { 0x01, 0x02 };
+    const std::vector<uint8_t> sysex = FirmataEncoder::sysex( 0x71, prefix, sizeof( prefix ), data, sizeof( data ) );
+    session.insert( session.end(), sysex.begin(), sysex.end() );
+
+    session.insert( session.end(), message, message + FirmataEncoder::analogMessage( 15, 0x3FFF, message ) );
+    return session;
+}
+
+void
+splitAtEveryPoint(
+    void
+    )
+{
+    const std::vector<uint8_t> session = boardSession();
+
+    ParserLog whole;
+    whole.parser().parse( session.data(), session.size() );
+    TEST_CHECK( whole.entries().size() == 5 );
+    TEST_CHECK( !whole.parser().isMidMessage() );
+
+    //the parser resumes wherever a chunk ends, including between a command byte and its data and inside a sysex payload
+    for( size_t split = 1; split < session.size(); ++split )
+    {
+        ParserLog chunked;
+        chunked.parser().parse( session.data(), split );
+        chunked.parser().parse( session.data() + split, session.size() - split );
+        TEST_CHECK( chunked.entries() == whole.entries() );
+    }
+}
+
+void
+oneByteAtATime(
+    void
+    )
+{
+    const std::vector<uint8_t> session = boardSession();
+
+    ParserLog whole;
+    whole.parser().parse( session.data(), session.size() );
+
+    ParserLog bytewise;
+    for( size_t i = 0; i < session.size(); ++i )
+    {
+        bytewise.parser().parse( session.data() + i, 1 );
+        if( i + 1 < session.size() ) TEST_CHECK( bytewise.parser().isMidMessage() || ( session[i + 1] & 0x80 ) );
+    }
+    TEST_CHECK( bytewise.entries() == whole.entries() );
+    TEST_CHECK( !bytewise.parser().isMidMessage() );
+}
+
+void
+sysexOverflow(
+    void
+    )
+{
+    //the buffer holds the command byte and seven payload bytes
+    const size_t max_sysex_size = 8;
+    const uint8_t fits[] = { 0xF0, 0x71, 1, 2, 3, 4, 5, 6, 7, 0xF7 };
+    const uint8_t too_long[] = { 0xF0, 0x71, 1, 2, 3, 4, 5, 6, 7, 8, 0xF7 };
+    const uint8_t analog[] = { 0xE2, 0x10, 0x01 };
+
+    ParserLog log( max_sysex_size );
+    log.parser().parse( fits, sizeof( fits ) );
+    TEST_CHECK( log.entries().size() == 1 && log.entries().back() == "sysex 113: 1 2 3 4 5 6 7" );
+
+    //the oversized message is dropped with a single error, and the message after it is unaffected
+    log.parser().parse( too_long, sizeof( too_long ) );
+    log.parser().parse( analog, sizeof( analog ) );
+    TEST_CHECK( log.entries().size() == 3 );
+    TEST_CHECK( log.entries()[1] == "error " + std::to_string( static_cast<int>( ParseError::SYSEX_OVERFLOW ) ) );
+    TEST_CHECK( log.entries()[2] == "analog 2 144" );
+}
+
+void
+sysexOverflowAcrossChunks(
+    void
+    )
+{
+    const size_t max_sysex_size = 8;
+    std::vector<uint8_t> session = { 0xF0, 0x71 };
+    session.insert( session.end(), 100, 0x55 );
+    session.push_back( 0xF7 );
+    session.insert( session.end(), { 0x91, 0x7F, 0x01 } );
+
+    //the overflow is noticed in one chunk and the remainder of the message is discarded from the chunks which follow
+    for( size_t chunk = 1; chunk <= 16; ++chunk )
+    {
+        ParserLog log( max_sysex_size );
+        for( size_t offset = 0; offset < session.size(); offset += chunk )
+        {
+            log.parser().parse( session.data() + offset, std::min( chunk, session.size() - offset ) );
+        }
+        TEST_CHECK( log.entries().size() == 2 );
+        TEST_CHECK( log.entries().front() == "error " + std::to_string( static_cast<int>( ParseError::SYSEX_OVERFLOW ) ) );
+        TEST_CHECK( log.entries().back() == "digital 1 255" );
+    }
+}
+
+void
+truncatedAndStrayBytes(
+    void
+    )
+{
+    //an analog message cut short by a digital message, then a sysex whose END_SYSEX was lost, then a stray data byte
+    const uint8_t session[] = { 0xE0, 0x01, 0x90, 0x03, 0x00, 0xF0, 0x71, 0x01, 0xF9, 0x02, 0x05, 0x42 };
+
+    ParserLog log;
+    log.parser().parse( session, sizeof( session ) );
+
+    const std::vector<std::string> expected = {
+        "error " + std::to_string( static_cast<int>( ParseError::TRUNCATED_MESSAGE ) ),
+        "digital 0 3",
+        "error " + std::to_string( static_cast<int>( ParseError::TRUNCATED_MESSAGE ) ),
+        "version 2.5",
+        "error " + std::to_string( static_cast<int>( ParseError::STRAY_DATA ) ),
+    };
+    TEST_CHECK( log.entries() == expected );
+}
+
+void
+resetDiscardsPartialMessage(
+    void
+    )
+{
+    const uint8_t partial[] = { 0xF0, 0x71, 0x01, 0x02 };
+    const uint8_t analog[] = { 0xE1, 0x05, 0x00 };
+
+    ParserLog log;
+    log.parser().parse( partial, sizeof( partial ) );
+    TEST_CHECK( log.parser().isMidMessage() );
+
+    log.parser().reset();
+    TEST_CHECK( !log.parser().isMidMessage() );
+
+    log.parser().parse( analog, sizeof( analog ) );
+    TEST_CHECK( log.entries().size() == 1 && log.entries().front() == "analog 1 5" );
+}
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    return Test::run( argc, argv, {
+        { "split_at_every_point", splitAtEveryPoint },
+        { "one_byte_at_a_time", oneByteAtATime },
+        { "sysex_overflow", sysexOverflow },
+        { "sysex_overflow_across_chunks", sysexOverflowAcrossChunks },
+        { "truncated_and_stray_bytes", truncatedAndStrayBytes },
+        { "reset_discards_partial_message", resetDiscardsPartialMessage },
+    } );
+}
@@ -0,0 +1,169 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * MessageQueue: messages pushed by several producer threads at once all reach the single consumer whole, exactly once,
+ * and in the order each producer pushed them, while the consumer pops concurrently.
+ *
+ * Built by the message_queue_tests target and run by CTest.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "TestHarness.h"
+#include "Firmata/Core/MessageQueue.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+const unsigned PRODUCER_COUNT = 8;
+const uint32_t MESSAGES_PER_PRODUCER = 20000;
+
+//a message names its producer and sequence number, and is padded to a length which varies with the sequence number
+std::vector<uint8_t>
+buildMessage(
+    uint8_t producer_,
+    uint32_t sequence_
+    )
+{
+    std::vector<uint8_t> message = {
+        producer_,
+        static_cast<uint8_t>( sequence_ ),
+        static_cast<uint8_t>( sequence_ >> 8 ),
+        static_cast<uint8_t>( sequence_ >> 16 ),
+    };
+    const size_t padding = sequence_ % 61;
+    for( size_t i = 0; i < padding; ++i ) { message.push_back( static_cast<uint8_t>( producer_ ^ i ) ); }
+    return message;
+}
+
+void
+concurrentProducers(
+    void
+    )
+{
+    MessageQueue queue;
+    std::atomic<unsigned> ready( 0 );
+
+    //half the producers hand over their storage, the rest have their message copied
+    std::vector<std::thread> producers;
+    for( unsigned producer = 0; producer < PRODUCER_COUNT; ++producer )
+    {
+        producers.emplace_back( [ &queue, &ready, producer ]() -> void
+        {
+            ++ready;
+            while( ready < PRODUCER_COUNT ) { std::this_thread::yield(); }
+
+            for( uint32_t sequence = 0; sequence < MESSAGES_PER_PRODUCER; ++sequence )
+            {
+                std::vector<uint8_t> message = buildMessage( static_cast<uint8_t>( producer ), sequence );
+                if( producer & 1 ) queue.push( std::move( message ) );
+                else queue.push( message.data(), message.size() );
+            }
+        } );
+    }
+
+    //the consumer pops while the producers are still pushing
+    std::vector<uint32_t> next_sequence( PRODUCER_COUNT, 0 );
+    uint64_t popped = 0;
+    uint64_t malformed = 0;
+    uint64_t out_of_order = 0;
+    std::vector<uint8_t> buffer;
+    while( popped < uint64_t( PRODUCER_COUNT ) * MESSAGES_PER_PRODUCER )
+    {
+        buffer.clear();
+        if( !queue.pop( buffer ) )
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ++popped;
+
+        if( buffer.size() < 4 || buffer[0] >= PRODUCER_COUNT )
+        {
+            ++malformed;
+            continue;
+        }
+
+        const uint8_t producer = buffer[0];
+        const uint32_t sequence = buffer[1] | ( buffer[2] << 8 ) | ( buffer[3] << 16 );
+        if( buffer != buildMessage( producer, sequence ) ) ++malformed;
+        if( sequence != next_sequence[producer] ) ++out_of_order;
+        next_sequence[producer] = sequence + 1;
+    }
+
+    for( std::thread &thread : producers ) { thread.join(); }
+
+    TEST_CHECK( malformed == 0 );
+    TEST_CHECK( out_of_order == 0 );
+    for( unsigned producer = 0; producer < PRODUCER_COUNT; ++producer )
+    {
+        TEST_CHECK( next_sequence[producer] == MESSAGES_PER_PRODUCER );
+    }
+
+    //nothing was delivered twice
+    TEST_CHECK( queue.empty() );
+    buffer.clear();
+    TEST_CHECK( !queue.pop( buffer ) && buffer.empty() );
+}
+
+void
+popAppends(
+    void
+    )
+{
+    MessageQueue queue;
+    const uint8_t first[] = { 1, 2, 3 };
+    const uint8_t second[] = { 4 };
+    queue.push( first, sizeof( first ) );
+    queue.push( std::vector<uint8_t>( second, second + sizeof( second ) ) );
+    queue.push( nullptr, 0 );
+
+    //the consumer can gather several messages into one buffer, and an empty message is still a message
+    std::vector<uint8_t> buffer;
+    TEST_CHECK( !queue.empty() );
+    TEST_CHECK( queue.pop( buffer ) && queue.pop( buffer ) );
+    TEST_CHECK( ( buffer == std::vector<uint8_t>{ 1, 2, 3, 4 } ) );
+    TEST_CHECK( queue.pop( buffer ) && buffer.size() == 4 );
+    TEST_CHECK( queue.empty() && !queue.pop( buffer ) );
+}
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    return Test::run( argc, argv, {
+        { "concurrent_producers", concurrentProducers },
+        { "pop_appends", popAppends },
+    } );
+}
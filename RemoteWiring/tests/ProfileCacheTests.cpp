@@ -0,0 +1,265 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * ProfileCache: responses round trip through the cache, firmware identities are kept apart, and a file which is
+ * damaged, truncated or extended in any way is refused rather than loaded.
+ *
+ * Built by the profile_cache_tests target and run by CTest. Each test works in a folder of its own under the system's
+ * temporary directory, which is deleted afterwards.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "TestHarness.h"
+#include "RemoteWiring/Core/BoardProfiles.h"
+#include "RemoteWiring/Core/ProfileCache.h"
+
+using namespace Microsoft::Maker::RemoteWiring::Core;
+
+namespace {
+
+/*
+ * A uniquely named folder which is removed with everything in it when the test finishes
+ */
+class TemporaryFolder
+{
+public:
+    TemporaryFolder(
+        void
+        ) :
+        _path( std::filesystem::temp_directory_path() / ( "profile_cache_tests." + std::to_string( std::chrono::steady_clock::now().time_since_epoch().count() ) ) )
+    {
+        std::filesystem::create_directories( _path );
+    }
+
+    ~TemporaryFolder(
+        void
+        )
+    {
+        std::error_code ignored;
+        std::filesystem::remove_all( _path, ignored );
+    }
+
+    std::string
+    path(
+        void
+        ) const
+    {
+        return _path.string();
+    }
+
+    size_t
+    fileCount(
+        void
+        ) const
+    {
+        return static_cast<size_t>( std::distance( std::filesystem::directory_iterator( _path ), std::filesystem::directory_iterator() ) );
+    }
+
+private:
+    const std::filesystem::path _path;
+};
+
+const FirmwareIdentity STANDARD_FIRMATA = { "StandardFirmata.ino", 2, 5 };
+
+CachedProfile
+unoProfile(
+    void
+    )
+{
+    CachedProfile profile;
+    profile.capabilityResponse = BoardProfiles::capabilityResponse( ARDUINO_UNO );
+    profile.analogMappingResponse = BoardProfiles::analogMappingResponse( ARDUINO_UNO );
+    return profile;
+}
+
+bool
+sameProfile(
+    const CachedProfile &a_,
+    const CachedProfile &b_
+    )
+{
+    return a_.capabilityResponse == b_.capabilityResponse && a_.analogMappingResponse == b_.analogMappingResponse;
+}
+
+std::vector<uint8_t>
+readFile(
+    const std::string &path_
+    )
+{
+    std::ifstream file( path_, std::ios::binary );
+    return std::vector<uint8_t>( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+}
+
+void
+writeFile(
+    const std::string &path_,
+    const std::vector<uint8_t> &contents_
+    )
+{
+    std::ofstream file( path_, std::ios::binary | std::ios::trunc );
+    file.write( reinterpret_cast<const char *>( contents_.data() ), static_cast<std::streamsize>( contents_.size() ) );
+}
+
+void
+roundTrip(
+    void
+    )
+{
+    TemporaryFolder folder;
+    ProfileCache cache( folder.path() );
+    const CachedProfile stored = unoProfile();
+
+    CachedProfile loaded;
+    TEST_CHECK( !cache.load( STANDARD_FIRMATA, loaded ) );
+    TEST_CHECK( cache.store( STANDARD_FIRMATA, stored ) );
+    TEST_CHECK( cache.load( STANDARD_FIRMATA, loaded ) );
+    TEST_CHECK( sameProfile( loaded, stored ) );
+
+    //the temporary file the entry was written to has been moved into place
+    TEST_CHECK( folder.fileCount() == 1 );
+
+    //a later store replaces the entry
+    CachedProfile replacement;
+    replacement.capabilityResponse = BoardProfiles::capabilityResponse( ARDUINO_NANO );
+    TEST_CHECK( cache.store( STANDARD_FIRMATA, replacement ) );
+    TEST_CHECK( cache.load( STANDARD_FIRMATA, loaded ) );
+    TEST_CHECK( sameProfile( loaded, replacement ) );
+
+    cache.remove( STANDARD_FIRMATA );
+    TEST_CHECK( !cache.load( STANDARD_FIRMATA, loaded ) );
+    TEST_CHECK( folder.fileCount() == 0 );
+
+    //there is nothing to build a profile from without a capability response
+    TEST_CHECK( !cache.store( STANDARD_FIRMATA, CachedProfile() ) );
+}
+
+void
+identitiesKeptApart(
+    void
+    )
+{
+    TemporaryFolder folder;
+    ProfileCache cache( folder.path() );
+    const CachedProfile stored = unoProfile();
+    TEST_CHECK( cache.store( STANDARD_FIRMATA, stored ) );
+
+    CachedProfile loaded;
+    const FirmwareIdentity other_version = { STANDARD_FIRMATA.name, 2, 4 };
+    TEST_CHECK( !cache.load( other_version, loaded ) );
+
+    //a name which sanitizes to the same file name is told apart by the name kept in the file
+    const FirmwareIdentity similar_name = { "StandardFirmata ino", 2, 5 };
+    TEST_CHECK( cache.path( similar_name ) == cache.path( STANDARD_FIRMATA ) );
+    TEST_CHECK( !cache.load( similar_name, loaded ) );
+    TEST_CHECK( loaded.capabilityResponse.empty() );
+}
+
+void
+damagedFilesRefused(
+    void
+    )
+{
+    TemporaryFolder folder;
+    ProfileCache cache( folder.path() );
+    const CachedProfile stored = unoProfile();
+    TEST_CHECK( cache.store( STANDARD_FIRMATA, stored ) );
+
+    const std::string path = cache.path( STANDARD_FIRMATA );
+    const std::vector<uint8_t> original = readFile( path );
+    TEST_CHECK( !original.empty() );
+
+    //a failed load leaves the caller's profile untouched
+    CachedProfile sentinel;
+    sentinel.capabilityResponse.assign( 1, 0x42 );
+
+    //every single bit of the header, the sections and the hash is covered
+    size_t refused = 0;
+    for( size_t i = 0; i < original.size(); ++i )
+    {
+        for( int bit = 0; bit < 8; ++bit )
+        {
+            std::vector<uint8_t> damaged = original;
+            damaged[i] ^= static_cast<uint8_t>( 1 << bit );
+            writeFile( path, damaged );
+
+            CachedProfile loaded = sentinel;
+            if( !cache.load( STANDARD_FIRMATA, loaded ) && sameProfile( loaded, sentinel ) ) ++refused;
+        }
+    }
+    TEST_CHECK( refused == original.size() * 8 );
+
+    writeFile( path, original );
+    CachedProfile loaded;
+    TEST_CHECK( cache.load( STANDARD_FIRMATA, loaded ) && sameProfile( loaded, stored ) );
+}
+
+void
+truncatedAndExtendedFilesRefused(
+    void
+    )
+{
+    TemporaryFolder folder;
+    ProfileCache cache( folder.path() );
+    TEST_CHECK( cache.store( STANDARD_FIRMATA, unoProfile() ) );
+
+    const std::string path = cache.path( STANDARD_FIRMATA );
+    const std::vector<uint8_t> original = readFile( path );
+
+    for( size_t length = 0; length < original.size(); ++length )
+    {
+        writeFile( path, std::vector<uint8_t>( original.begin(), original.begin() + length ) );
+        CachedProfile loaded;
+        TEST_CHECK( !cache.load( STANDARD_FIRMATA, loaded ) );
+    }
+
+    std::vector<uint8_t> extended = original;
+    extended.push_back( 0 );
+    writeFile( path, extended );
+    CachedProfile loaded;
+    TEST_CHECK( !cache.load( STANDARD_FIRMATA, loaded ) );
+}
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    return Test::run( argc, argv, {
+        { "round_trip", roundTrip },
+        { "identities_kept_apart", identitiesKeptApart },
+        { "damaged_files_refused", damagedFilesRefused },
+        { "truncated_and_extended_files_refused", truncatedAndExtendedFilesRefused },
+    } );
+}
@@ -0,0 +1,211 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * SevenBitCodec: the SSE2 and AVX2 paths produce exactly what the scalar loops do, for every length around the vector
+ * widths and at unaligned offsets, and the public routines round trip, including decoding in place. The AVX2 checks
+ * are skipped on processors without it.
+ *
+ * Built by the seven_bit_codec_tests target and run by CTest.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "TestHarness.h"
+#include "Firmata/Core/SevenBitCodec.h"
+
+using namespace Microsoft::Maker::Firmata::Core;
+
+namespace {
+
+//covers the scalar tails left after every whole 16 and 32 byte block
+const size_t MAX_LENGTH = 200;
+
+//inputs are read from these offsets into a larger buffer, so no vector load is aligned by accident
+const size_t MAX_OFFSET = 3;
+
+std::vector<uint8_t>
+randomBytes(
+    size_t length_,
+    uint8_t mask_
+    )
+{
+    static std::mt19937 generator( 1234 );
+    std::vector<uint8_t> bytes( length_ );
+    for( uint8_t &byte : bytes ) { byte = static_cast<uint8_t>( generator() ) & mask_; }
+    return bytes;
+}
+
+#ifdef FIRMATA_CORE_X86
+
+//runs a vector routine over as much of the input as it takes, and the scalar routine over the rest
+template <typename Vector, typename Scalar>
+std::vector<uint8_t>
+withTail(
+    Vector vector_,
+    Scalar scalar_,
+    const uint8_t *data_,
+    size_t count_,
+    size_t input_per_item_,
+    size_t output_per_item_
+    )
+{
+    std::vector<uint8_t> out( count_ * output_per_item_ + 1, 0xEE );
+    const size_t done = vector_( data_, count_, out.data() );
+    scalar_( data_ + done * input_per_item_, count_ - done, out.data() + done * output_per_item_ );
+    return out;
+}
+
+#endif
+
+void
+encodeMatchesScalar(
+    void
+    )
+{
+    const std::vector<uint8_t> input = randomBytes( MAX_LENGTH + MAX_OFFSET, 0xFF );
+
+    for( size_t offset = 0; offset <= MAX_OFFSET; ++offset )
+    {
+        for( size_t length = 0; length <= MAX_LENGTH; ++length )
+        {
+            const uint8_t *data = input.data() + offset;
+            std::vector<uint8_t> expected( length * 2 + 1, 0xEE );
+            SevenBitCodec::detail::encodeScalar( data, length, expected.data() );
+
+            std::vector<uint8_t> encoded( length * 2 + 1, 0xEE );
+            TEST_CHECK( SevenBitCodec::encode( data, length, encoded.data() ) == length * 2 );
+            TEST_CHECK( encoded == expected );
+
+#ifdef FIRMATA_CORE_X86
+            TEST_CHECK( withTail( SevenBitCodec::detail::encodeSse2, SevenBitCodec::detail::encodeScalar, data, length, 1, 2 ) == expected );
+            if( SevenBitCodec::detail::hasAvx2() )
+            {
+                TEST_CHECK( withTail( SevenBitCodec::detail::encodeAvx2, SevenBitCodec::detail::encodeScalar, data, length, 1, 2 ) == expected );
+            }
+#endif
+        }
+    }
+}
+
+void
+decodeMatchesScalar(
+    void
+    )
+{
+    //decoding is defined for 7-bit input, the high bit of a pair's second byte is the only other one carried
+    const std::vector<uint8_t> input = randomBytes( MAX_LENGTH * 2 + MAX_OFFSET, 0x7F );
+
+    for( size_t offset = 0; offset <= MAX_OFFSET; ++offset )
+    {
+        for( size_t pairs = 0; pairs <= MAX_LENGTH; ++pairs )
+        {
+            const uint8_t *data = input.data() + offset;
+            std::vector<uint8_t> expected( pairs + 1, 0xEE );
+            SevenBitCodec::detail::decodeScalar( data, pairs, expected.data() );
+
+            //a trailing unpaired byte is ignored
+            std::vector<uint8_t> decoded( pairs + 1, 0xEE );
+            TEST_CHECK( SevenBitCodec::decode( data, pairs * 2 + 1, decoded.data() ) == pairs );
+            TEST_CHECK( decoded == expected );
+
+#ifdef FIRMATA_CORE_X86
+            TEST_CHECK( withTail( SevenBitCodec::detail::decodeSse2, SevenBitCodec::detail::decodeScalar, data, pairs, 2, 1 ) == expected );
+            if( SevenBitCodec::detail::hasAvx2() )
+            {
+                TEST_CHECK( withTail( SevenBitCodec::detail::decodeAvx2, SevenBitCodec::detail::decodeScalar, data, pairs, 2, 1 ) == expected );
+            }
+#endif
+        }
+    }
+}
+
+void
+maskMatchesScalar(
+    void
+    )
+{
+    const std::vector<uint8_t> input = randomBytes( MAX_LENGTH + MAX_OFFSET, 0xFF );
+
+    for( size_t offset = 0; offset <= MAX_OFFSET; ++offset )
+    {
+        for( size_t length = 0; length <= MAX_LENGTH; ++length )
+        {
+            const uint8_t *data = input.data() + offset;
+            std::vector<uint8_t> expected( length + 1, 0xEE );
+            SevenBitCodec::detail::maskScalar( data, length, expected.data() );
+
+            std::vector<uint8_t> masked( length + 1, 0xEE );
+            SevenBitCodec::mask( data, length, masked.data() );
+            TEST_CHECK( masked == expected );
+
+            //masking in place gives the same result
+            std::vector<uint8_t> in_place( data, data + length );
+            in_place.push_back( 0xEE );
+            SevenBitCodec::mask( in_place.data(), length, in_place.data() );
+            TEST_CHECK( in_place == expected );
+        }
+    }
+}
+
+void
+roundTripInPlace(
+    void
+    )
+{
+    for( size_t length = 0; length <= MAX_LENGTH; ++length )
+    {
+        const std::vector<uint8_t> data = randomBytes( length, 0xFF );
+
+        std::vector<uint8_t> buffer( SevenBitCodec::encodedLength( length ) );
+        SevenBitCodec::encode( data.data(), length, buffer.data() );
+
+        //every encoded byte is 7-bit, so none can be taken for a command
+        bool seven_bit = true;
+        for( uint8_t byte : buffer ) { seven_bit = seven_bit && !( byte & 0x80 ); }
+        TEST_CHECK( seven_bit );
+
+        TEST_CHECK( SevenBitCodec::decode( buffer.data(), buffer.size(), buffer.data() ) == length );
+        buffer.resize( length );
+        TEST_CHECK( buffer == data );
+    }
+}
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    return Test::run( argc, argv, {
+        { "encode_matches_scalar", encodeMatchesScalar },
+        { "decode_matches_scalar", decodeMatchesScalar },
+        { "mask_matches_scalar", maskMatchesScalar },
+        { "round_trip_in_place", roundTripInPlace },
+    } );
+}
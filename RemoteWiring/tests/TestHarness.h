@@ -0,0 +1,105 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+/*
+ * A small harness shared by the unit test executables, each of which is registered with CTest. A test is a function
+ * which makes any number of TEST_CHECKs; a failed check prints its expression and location and the test carries on, so
+ * one run reports every failure. The executable exits non-zero if any check failed.
+ *
+ * Recognized arguments: --filter=substring
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+
+#define TEST_CHECK( condition_ ) ::Test::check( ( condition_ ), #condition_, __FILE__, __LINE__ )
+
+namespace Test {
+
+typedef void ( *TestFunction )( void );
+
+inline
+unsigned &
+failures(
+    void
+    )
+{
+    static unsigned count = 0;
+    return count;
+}
+
+inline
+bool
+check(
+    bool passed_,
+    const char *expression_,
+    const char *file_,
+    int line_
+    )
+{
+    if( !passed_ )
+    {
+        ++failures();
+        std::fprintf( stderr, "%s:%d: check failed: %s\n", file_, line_, expression_ );
+    }
+    return passed_;
+}
+
+///<summary>
+///Runs each test whose name contains the --filter argument, if one was given, and returns the process exit code
+///</summary>
+inline
+int
+run(
+    int argc,
+    char *argv[],
+    std::initializer_list<std::pair<const char *, TestFunction>> tests_
+    )
+{
+    const char *filter = "";
+    for( int i = 1; i < argc; ++i )
+    {
+        if( !std::strncmp( argv[i], "--filter=", 9 ) ) filter = argv[i] + 9;
+    }
+
+    unsigned run_count = 0;
+    for( const auto &test : tests_ )
+    {
+        if( !std::strstr( test.first, filter ) ) continue;
+
+        const unsigned failed_before = failures();
+        test.second();
+        ++run_count;
+        std::fprintf( stderr, "%-6s %s\n", ( failures() == failed_before ) ? "ok" : "FAILED", test.first );
+    }
+
+    std::fprintf( stderr, "%u tests run, %u checks failed\n", run_count, failures() );
+    return failures() ? 1 : 0;
+}
+
+} // namespace Test
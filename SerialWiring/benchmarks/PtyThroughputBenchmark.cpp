@@ -0,0 +1,134 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+/*
+ * Throughput of the POSIX transports over a pseudo-terminal pair. A PtySerial plays the board, streaming 3-byte
+ * ANALOG_MESSAGEs, while a TermiosSerial on the far end reads them with waitForData()/readBytes() the way UwpFirmata's
+ * input thread does.
+ *
+ *   pty_throughput_benchmark [megabytes] [vmin] [vtime]
+ *
+ * To measure a real line or a socat stand-in instead, e.g. `socat -d -d pty,raw,echo=0 pty,raw,echo=0`, pass the path
+ * of one end as a fourth argument and stream into the other end yourself.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Posix/PtySerial.h"
+#include "Posix/TermiosSerial.h"
+
+using namespace Microsoft::Maker::Serial;
+
+namespace {
+
+const size_t CHUNK_SIZE = 3 * 64;
+const size_t READ_BUFFER_SIZE = 4096;
+const uint32_t WAIT_TIMEOUT_MS = 1000;
+
+} // namespace
+
+int
+main(
+    int argc,
+    char *argv[]
+    )
+{
+    const size_t total_bytes = static_cast<size_t>( argc > 1 ? std::atof( argv[1] ) * 1024 * 1024 : 16 * 1024 * 1024 );
+    Posix::TermiosSettings settings;
+    settings.baud = 115200;
+    settings.vmin = static_cast<uint8_t>( argc > 2 ? std::atoi( argv[2] ) : 0 );
+    settings.vtime = static_cast<uint8_t>( argc > 3 ? std::atoi( argv[3] ) : 0 );
+
+    Posix::PtySerial board;
+    std::string failure;
+    Core::StreamHandlers handlers;
+    handlers.connectionFailed = [ &failure ]( const std::string &message_ ) -> void { failure = message_; };
+
+    const bool external = ( argc > 4 );
+    if( !external )
+    {
+        board.setHandlers( handlers );
+        board.begin();
+        if( !board.connectionReady() )
+        {
+            std::fprintf( stderr, "%s\n", failure.c_str() );
+            return 1;
+        }
+    }
+
+    Posix::TermiosSerial host( external ? argv[4] : board.slavePath(), settings );
+    host.setHandlers( handlers );
+    host.begin();
+    if( !host.connectionReady() )
+    {
+        std::fprintf( stderr, "%s\n", failure.c_str() );
+        return 1;
+    }
+
+    std::thread producer;
+    if( !external )
+    {
+        producer = std::thread( [ &board, total_bytes ]() -> void {
+            std::vector<uint8_t> chunk( CHUNK_SIZE );
+            for( size_t i = 0; i < CHUNK_SIZE; i += 3 )
+            {
+                chunk[i] = static_cast<uint8_t>( 0xE0 | ( ( i / 3 ) & 0x0F ) );
+                chunk[i + 1] = static_cast<uint8_t>( i & 0x7F );
+                chunk[i + 2] = 0x07;
+            }
+            for( size_t sent = 0; sent < total_bytes; sent += CHUNK_SIZE )
+            {
+                board.write( chunk.data(), chunk.size() );
+                board.flush();
+            }
+        } );
+    }
+
+    std::vector<uint8_t> buffer( READ_BUFFER_SIZE );
+    size_t received = 0;
+    size_t reads = 0;
+    auto start = std::chrono::steady_clock::now();
+    while( received < total_bytes && host.waitForData( WAIT_TIMEOUT_MS ) )
+    {
+        size_t bytes_read = host.readBytes( buffer.data(), buffer.size() );
+        received += bytes_read;
+        reads += ( bytes_read > 0 );
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if( producer.joinable() ) producer.join();
+
+    std::printf( "%s, VMIN %u VTIME %u\n", external ? argv[4] : "pty loopback", settings.vmin, settings.vtime );
+    std::printf( "received %zu bytes in %.3f s: %.1f MB/s, %.0f messages/s, %zu reads of %.1f bytes on average\n",
+        received, elapsed.count(), received / elapsed.count() / ( 1024 * 1024 ), received / 3 / elapsed.count(),
+        reads, reads ? static_cast<double>( received ) / reads : 0.0 );
+    return ( received >= total_bytes ) ? 0 : 1;
+}
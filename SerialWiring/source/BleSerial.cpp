@@ -199,10 +199,12 @@ BleSerial::flush (
 ) {
     if ( !connectionReady() ) { return; }
 
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
     create_task(_gatt_tx_characteristic->WriteValueAsync(_tx->DetachBuffer(), GattWriteOption::WriteWithoutResponse))
-    .then([this](GattCommunicationStatus status_) {
+    .then([this, started](GattCommunicationStatus status_) {
         switch (status_) {
         case GattCommunicationStatus::Success:
+            _metrics.flushed(started);
             break;
         case GattCommunicationStatus::Unreachable:
             ConnectionLost( L"Your connection has been lost. The device is no longer available." );
@@ -213,6 +215,13 @@ BleSerial::flush (
     });
 }
 
+Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+BleSerial::getMetrics (
+    void
+) {
+    return _metrics.snapshot();
+}
+
 /// \details An Advanced Query String is constructed based upon paired bluetooth GATT devices. Then a collection is returned of all devices matching the query.
 /// \ref https://msdn.microsoft.com/en-us/library/aa965711(VS.85).aspx
 /// \warning Must be called from UI thread
@@ -353,11 +362,31 @@ BleSerial::read (
         std::lock_guard<std::mutex> lock(_q_lock);
         c = _rx.front();
         _rx.pop();
+        _metrics.bytesRead(1);
     }
 
     return c;
 }
 
+uint16_t
+BleSerial::readBytes (
+    Platform::WriteOnlyArray<uint8_t> ^buffer_
+) {
+    uint16_t count = 0;
+
+    // Check to see if connection is ready
+    if (!connectionReady()) { return 0; }
+
+    std::lock_guard<std::mutex> lock(_q_lock);
+    while (count < buffer_->Length && count < 0xFFFF && !_rx.empty()) {
+        buffer_->Data[count++] = _rx.front();
+        _rx.pop();
+    }
+
+    _metrics.bytesRead(count);
+    return count;
+}
+
 void
 BleSerial::unlock (
     void
@@ -365,6 +394,19 @@ BleSerial::unlock (
     _ble_lock.unlock();
 }
 
+bool
+BleSerial::waitForData (
+    uint32_t timeout_ms_
+) {
+    std::unique_lock<std::mutex> lock(_q_lock);
+    bool ready = _rx_condition.wait_for(lock, std::chrono::milliseconds(timeout_ms_), [this]() -> bool {
+        return !_rx.empty();
+    });
+
+    if (!ready) { _metrics.waitTimedOut(); }
+    return ready;
+}
+
 uint16_t
 BleSerial::write (
     uint8_t c_
@@ -373,6 +415,7 @@ BleSerial::write (
     if (!connectionReady()) { return 0; }
 
     _tx->WriteByte(c_);
+    _metrics.bytesWritten(1);
     return 1;
 }
 
@@ -384,6 +427,7 @@ BleSerial::write (
     if (!connectionReady()) { return 0; }
 
     _tx->WriteBytes(buffer_);
+    _metrics.bytesWritten(buffer_->Length);
     return buffer_->Length;
 }
 
@@ -463,4 +507,5 @@ BleSerial::rxCallback (
             _rx.push(data_);
         });
     }
+    _rx_condition.notify_all();
 }
@@ -24,6 +24,8 @@
 
 #pragma once
 #include "IStream.h"
+#include "StreamMetrics.h"
+#include <condition_variable>
 #include <mutex>
 #include <queue>
 
@@ -105,6 +107,14 @@ public ref class BleSerial sealed : public IStream
         void
     );
 
+    ///<summary>
+    ///Takes a snapshot of this stream's metrics: bytes in and out, reads, flushes and how long they took, and waits which timed out
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    getMetrics (
+        void
+    );
+
     virtual
     void
     lock (
@@ -170,12 +180,24 @@ public ref class BleSerial sealed : public IStream
         void
     );
 
+    virtual
+    uint16_t
+    readBytes (
+        Platform::WriteOnlyArray<uint8_t> ^buffer_
+    );
+
     virtual
     void
     unlock (
         void
     );
 
+    virtual
+    bool
+    waitForData (
+        uint32_t timeout_ms_
+    );
+
     virtual
     uint16_t
     write (
@@ -207,6 +229,9 @@ public ref class BleSerial sealed : public IStream
     Windows::Devices::Enumeration::DeviceInformation ^_device;
     Platform::String ^_device_name;
 
+    //bytes in and out, flushes and waits, reported by getMetrics()
+    StreamMetrics _metrics;
+
     //thread-safe mechanisms. std::unique_lock used to manage the lifecycle of std::mutex
     std::mutex _mutex;
     std::unique_lock<std::mutex> _ble_lock;
@@ -219,6 +244,7 @@ public ref class BleSerial sealed : public IStream
     Windows::Devices::Bluetooth::GenericAttributeProfile::GattDeviceService ^_gatt_service;
     std::mutex _q_lock;
     std::queue<byte> _rx;
+    std::condition_variable _rx_condition;
     Windows::Storage::Streams::DataWriter ^_tx;
 
     Concurrency::task<void>
@@ -114,7 +114,7 @@ BluetoothSerial::available(
 			return 0;
 		}
 
-		_current_load_operation = _rx->LoadAsync(MAX_READ_SIZE);
+		startLoadOperation();
 	}
 
 	return 0;
@@ -194,6 +194,7 @@ BluetoothSerial::end(
 {
     _connection_ready = false;
     _current_load_operation = nullptr;
+    _rx_condition.notify_all();
 
     // Reset with respect to dependencies
     delete(_rx); //_rx->Close();
@@ -216,6 +217,7 @@ BluetoothSerial::flush(
         return;
     }
 
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
     auto async_operation = _tx->StoreAsync();
     create_task( async_operation )
     .then( [ this, async_operation ]( unsigned int value_ )
@@ -230,11 +232,12 @@ BluetoothSerial::flush(
 
         return create_task( _tx->FlushAsync() );
     } )
-    .then( [ this ]( task<bool> task_ )
+    .then( [ this, started ]( task<bool> task_ )
     {
         try
         {
             task_.wait();
+            _metrics.flushed( started );
         }
         catch( Platform::Exception ^e )
         {
@@ -244,6 +247,14 @@ BluetoothSerial::flush(
     } );
 }
 
+Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+BluetoothSerial::getMetrics(
+    void
+    )
+{
+    return _metrics.snapshot();
+}
+
 /// \details An Advanced Query String is constructed based upon paired bluetooth devices. Then a collection is returned of all devices matching the query.
 /// \ref https://msdn.microsoft.com/en-us/library/aa965711(VS.85).aspx
 /// \warning Must be called from UI thread
@@ -393,11 +404,29 @@ BluetoothSerial::read(
 
     if ( available() ) {
         c = _rx->ReadByte();
+        _metrics.bytesRead( 1 );
     }
 
     return c;
 }
 
+uint16_t
+BluetoothSerial::readBytes(
+    Platform::WriteOnlyArray<uint8_t> ^buffer_
+    )
+{
+    uint16_t count = available();
+    if ( count > buffer_->Length ) { count = static_cast<uint16_t>(buffer_->Length); }
+
+    // Hand the caller's storage straight to the DataReader to avoid a per-byte ReadByte() call
+    if ( count ) {
+        _rx->ReadBytes(Platform::ArrayReference<uint8_t>(buffer_->Data, count));
+    }
+
+    _metrics.bytesRead( count );
+    return count;
+}
+
 void
 BluetoothSerial::unlock(
     void
@@ -406,6 +435,27 @@ BluetoothSerial::unlock(
     _bluetooth_lock.unlock();
 }
 
+bool
+BluetoothSerial::waitForData(
+    uint32_t timeout_ms_
+    )
+{
+    // available() restarts the load operation once the previous one has been consumed
+    if ( available() ) { return true; }
+
+    {
+        std::unique_lock<std::mutex> lock(_rx_mutex);
+        _rx_condition.wait_for(lock, std::chrono::milliseconds(timeout_ms_), [this]() -> bool {
+            return ( connectionReady() && _current_load_operation != nullptr && _current_load_operation->Status != Windows::Foundation::AsyncStatus::Started );
+        });
+    }
+
+    if ( available() ) { return true; }
+
+    _metrics.waitTimedOut();
+    return false;
+}
+
 uint16_t
 BluetoothSerial::write(
     uint8_t c_
@@ -415,6 +465,7 @@ BluetoothSerial::write(
     if ( !connectionReady() ) { return 0; }
 
     _tx->WriteByte(c_);
+    _metrics.bytesWritten( 1 );
     return 1;
 }
 
@@ -427,6 +478,7 @@ BluetoothSerial::write(
     if (!connectionReady()) { return 0; }
 
     _tx->WriteBytes(buffer_);
+    _metrics.bytesWritten( buffer_->Length );
     return buffer_->Length;
 }
 
@@ -462,7 +514,7 @@ BluetoothSerial::connectToDeviceAsync(
             // Enable RX
             _rx = ref new Windows::Storage::Streams::DataReader(_stream_socket->InputStream);
             _rx->InputStreamOptions = Windows::Storage::Streams::InputStreamOptions::Partial;  // Partial mode will allow for better async reads
-            _current_load_operation = _rx->LoadAsync( MAX_READ_SIZE );
+            startLoadOperation();
 
             // Enable TX
             _tx = ref new Windows::Storage::Streams::DataWriter(_stream_socket->OutputStream);
@@ -490,3 +542,17 @@ BluetoothSerial::identifyDeviceFromCollection(
     // If we searched and found nothing that matches the identifier, we've failed to connect and cannot recover.
     throw ref new Platform::Exception(E_INVALIDARG, L"No Bluetooth devices found matching the specified identifier.");
 }
+
+void
+BluetoothSerial::startLoadOperation(
+    void
+    )
+{
+    _current_load_operation = _rx->LoadAsync(MAX_READ_SIZE);
+
+    // Wake any thread sleeping in waitForData() as soon as the load completes
+    _current_load_operation->Completed = ref new Windows::Foundation::AsyncOperationCompletedHandler<unsigned int>([this](Windows::Foundation::IAsyncOperation<unsigned int> ^, Windows::Foundation::AsyncStatus) {
+        std::lock_guard<std::mutex> lock(_rx_mutex);
+        _rx_condition.notify_all();
+    });
+}
@@ -24,6 +24,8 @@
 
 #pragma once
 #include "IStream.h"
+#include "StreamMetrics.h"
+#include <condition_variable>
 #include <mutex>
 
 namespace Microsoft {
@@ -99,6 +101,14 @@ public:
         void
         );
 
+    ///<summary>
+    ///Takes a snapshot of this stream's metrics: bytes in and out, reads, flushes and how long they took, and waits which timed out
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    getMetrics(
+        void
+        );
+
     virtual
     void
     lock(
@@ -164,12 +174,24 @@ public:
         void
         );
 
+    virtual
+    uint16_t
+    readBytes(
+        Platform::WriteOnlyArray<uint8_t> ^buffer_
+        );
+
     virtual
     void
     unlock(
         void
         );
 
+    virtual
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+        );
+
     virtual
     uint16_t
     write(
@@ -200,12 +222,19 @@ private:
     Windows::Devices::Enumeration::DeviceInformation ^_device;
     Platform::String ^_device_name;
 
+    //bytes in and out, flushes and waits, reported by getMetrics()
+    StreamMetrics _metrics;
+
     //thread-safe mechanisms. std::unique_lock used to manage the lifecycle of std::mutex
     std::mutex _blutex;
     std::unique_lock<std::mutex> _bluetooth_lock;
 
     std::atomic_bool _connection_ready;
     Windows::Storage::Streams::DataReaderLoadOperation ^_current_load_operation;
+
+    //signaled whenever a load operation completes, allowing waitForData() to sleep until data arrives
+    std::mutex _rx_mutex;
+    std::condition_variable _rx_condition;
     Windows::Devices::Enumeration::DeviceInformationCollection ^_device_collection;
     Windows::Devices::Bluetooth::Rfcomm::RfcommDeviceService ^_rfcomm_service;
     Windows::Networking::Sockets::StreamSocket ^_stream_socket;
@@ -221,6 +250,11 @@ private:
     identifyDeviceFromCollection(
         Windows::Devices::Enumeration::DeviceInformationCollection ^devices_
         );
+
+    void
+    startLoadOperation(
+        void
+        );
 };
 
 } // namespace Serial
@@ -0,0 +1,191 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace Microsoft {
+namespace Maker {
+namespace Serial {
+namespace Core {
+
+/*
+ * The connection callbacks raised by a Stream, mirroring the IStream connection events. Any handler may be left empty.
+ * Handlers may be raised on whichever thread notices the change in the connection.
+ */
+struct StreamHandlers
+{
+    std::function<void( void )> connectionEstablished;
+    std::function<void( const std::string &message_ )> connectionFailed;
+    std::function<void( const std::string &message_ )> connectionLost;
+};
+
+/*
+ * A native transport with the same contract as IStream, for platforms without WinRT. Outbound bytes are queued by write()
+ * and sent by flush(); inbound bytes are read without blocking once waitForData() reports that they are available.
+ * The connection parameters (port, baud rate, address) are given to the implementation's constructor.
+ */
+class Stream
+{
+public:
+    virtual
+    ~Stream(
+        void
+        )
+    {
+    }
+
+    ///<summary>
+    ///Returns the number of bytes available to be read
+    ///</summary>
+    virtual
+    uint16_t
+    available(
+        void
+        ) = 0;
+
+    ///<summary>
+    ///Attempts to establish the connection, raising connectionEstablished or connectionFailed before it returns
+    ///</summary>
+    virtual
+    void
+    begin(
+        void
+        ) = 0;
+
+    ///<summary>
+    ///Returns true if the connection is currently established
+    ///</summary>
+    virtual
+    bool
+    connectionReady(
+        void
+        ) = 0;
+
+    ///<summary>
+    ///Closes the active connection and wakes any thread waiting on it
+    ///</summary>
+    virtual
+    void
+    end(
+        void
+        ) = 0;
+
+    ///<summary>
+    ///Sends everything placed in the outbound queue, blocking until the transport has accepted all of it
+    ///</summary>
+    virtual
+    void
+    flush(
+        void
+        ) = 0;
+
+    ///<summary>
+    ///Locks this instance of the object, enabling thread safety
+    ///<para>when explicitly invoking this method, unlock() must be called when the lock is no longer needed.</para>
+    ///</summary>
+    virtual
+    void
+    lock(
+        void
+        ) = 0;
+
+    ///<summary>
+    ///Attempts to read one byte, returning -1 as uint16_t if none is available
+    ///</summary>
+    virtual
+    uint16_t
+    read(
+        void
+        ) = 0;
+
+    ///<summary>
+    ///Reads as many bytes as are currently available, up to length_, without waiting for more data to arrive.
+    ///<para>Returns the number of bytes copied into the buffer, which may be zero.</para>
+    ///</summary>
+    virtual
+    size_t
+    readBytes(
+        uint8_t *buffer_,
+        size_t length_
+        ) = 0;
+
+    void
+    setHandlers(
+        const StreamHandlers &handlers_
+        )
+    {
+        _handlers = handlers_;
+    }
+
+    ///<summary>
+    ///Blocks the calling thread until data is available to be read or the given timeout elapses, whichever comes first.
+    ///<para>Returns true if data is available to be read.</para>
+    ///</summary>
+    virtual
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+        ) = 0;
+
+    ///<summary>
+    ///Places one byte into the outbound queue. Data will not be sent until `flush()` is called explicitly.
+    ///</summary>
+    virtual
+    uint16_t
+    write(
+        uint8_t c_
+        ) = 0;
+
+    ///<summary>
+    ///Places multiple bytes into the outbound queue. Data will not be sent until `flush()` is called explicitly.
+    ///</summary>
+    virtual
+    size_t
+    write(
+        const uint8_t *buffer_,
+        size_t length_
+        ) = 0;
+
+    ///<summary>
+    ///Unlocks this instance of the object, allowing other threads or actions to use it.
+    ///</summary>
+    virtual
+    void
+    unlock(
+        void
+        ) = 0;
+
+protected:
+    StreamHandlers _handlers;
+};
+
+} // namespace Core
+} // namespace Serial
+} // namespace Maker
+} // namespace Microsoft
@@ -227,6 +227,26 @@ public interface struct IStream
         void
         ) = 0;
 
+    ///<summary>
+    ///Reads as many bytes as are currently available, up to the length of the given buffer, without waiting for more data to arrive.
+    ///<para>Returns the number of bytes copied into the buffer, which may be zero.</para>
+    ///</summary>
+    virtual
+    uint16_t
+    readBytes(
+        Platform::WriteOnlyArray<uint8_t> ^buffer_
+        ) = 0;
+
+    ///<summary>
+    ///Blocks the calling thread until data is available to be read or the given timeout elapses, whichever comes first.
+    ///<para>Returns true if data is available to be read. This allows a reader to sleep while the connection is idle instead of polling read().</para>
+    ///</summary>
+    virtual
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+        ) = 0;
+
     ///<summary>
     ///Places one byte into the outbound queue. Data will not be sent until `flush()` is called explicitly.
     ///</summary>
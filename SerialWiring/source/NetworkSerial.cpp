@@ -97,7 +97,7 @@ NetworkSerial::available(
 			return 0;
 		}
 
-		_current_load_operation = _rx->LoadAsync(MAX_READ_SIZE);
+		startLoadOperation();
 	}
 
 	return 0;
@@ -151,6 +151,7 @@ NetworkSerial::end(
 {
     _connection_ready = false;
     _current_load_operation = nullptr;
+    _rx_condition.notify_all();
 
     // Reset with respect to dependencies
     delete( _rx );
@@ -171,6 +172,7 @@ NetworkSerial::flush(
         return;
     }
 
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
     auto async_operation = _tx->StoreAsync();
     create_task( async_operation )
     .then( [ this, async_operation ]( unsigned int value_ )
@@ -185,11 +187,12 @@ NetworkSerial::flush(
 
         return create_task( _tx->FlushAsync() );
     } )
-    .then( [ this ]( task<bool> task_ )
+    .then( [ this, started ]( task<bool> task_ )
     {
         try
         {
             task_.wait();
+            _metrics.flushed( started );
         }
         catch( Platform::Exception ^e )
         {
@@ -199,6 +202,14 @@ NetworkSerial::flush(
     } );
 }
 
+Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+NetworkSerial::getMetrics(
+    void
+    )
+{
+    return _metrics.snapshot();
+}
+
 void
 NetworkSerial::lock(
     void
@@ -333,11 +344,29 @@ NetworkSerial::read(
 
 	if ( available() ) {
 		c = _rx->ReadByte();
+		_metrics.bytesRead( 1 );
 	}
 
 	return c;
 }
 
+uint16_t
+NetworkSerial::readBytes(
+    Platform::WriteOnlyArray<uint8_t> ^buffer_
+    )
+{
+    uint16_t count = available();
+    if ( count > buffer_->Length ) { count = static_cast<uint16_t>(buffer_->Length); }
+
+    // Hand the caller's storage straight to the DataReader to avoid a per-byte ReadByte() call
+    if ( count ) {
+        _rx->ReadBytes(Platform::ArrayReference<uint8_t>(buffer_->Data, count));
+    }
+
+    _metrics.bytesRead( count );
+    return count;
+}
+
 void
 NetworkSerial::unlock(
     void
@@ -346,6 +375,27 @@ NetworkSerial::unlock(
     _network_lock.unlock();
 }
 
+bool
+NetworkSerial::waitForData(
+    uint32_t timeout_ms_
+    )
+{
+    // available() restarts the load operation once the previous one has been consumed
+    if ( available() ) { return true; }
+
+    {
+        std::unique_lock<std::mutex> lock(_rx_mutex);
+        _rx_condition.wait_for(lock, std::chrono::milliseconds(timeout_ms_), [this]() -> bool {
+            return ( connectionReady() && _current_load_operation != nullptr && _current_load_operation->Status != Windows::Foundation::AsyncStatus::Started );
+        });
+    }
+
+    if ( available() ) { return true; }
+
+    _metrics.waitTimedOut();
+    return false;
+}
+
 uint16_t
 NetworkSerial::write(
     uint8_t c_
@@ -355,6 +405,7 @@ NetworkSerial::write(
     if( !connectionReady() ) { return 0; }
 
     _tx->WriteByte( c_ );
+    _metrics.bytesWritten( 1 );
     return 1;
 }
 
@@ -367,6 +418,7 @@ NetworkSerial::write(
     if (!connectionReady()) { return 0; }
 
     _tx->WriteBytes(buffer_);
+    _metrics.bytesWritten( buffer_->Length );
     return buffer_->Length;
 }
 
@@ -387,7 +439,7 @@ NetworkSerial::connectToHostAsync(
     {
         _rx = ref new Windows::Storage::Streams::DataReader( _stream_socket->InputStream );
         _rx->InputStreamOptions = Windows::Storage::Streams::InputStreamOptions::Partial;  // Partial mode will allow for better async reads
-        _current_load_operation = _rx->LoadAsync( MAX_READ_SIZE );
+        startLoadOperation();
 
         // Enable TX
         _tx = ref new Windows::Storage::Streams::DataWriter( _stream_socket->OutputStream );
@@ -396,4 +448,18 @@ NetworkSerial::connectToHostAsync(
         _connection_ready = true;
         ConnectionEstablished();
     } );
-}
\ No newline at end of file
+}
+
+void
+NetworkSerial::startLoadOperation(
+    void
+    )
+{
+    _current_load_operation = _rx->LoadAsync(MAX_READ_SIZE);
+
+    // Wake any thread sleeping in waitForData() as soon as the load completes
+    _current_load_operation->Completed = ref new Windows::Foundation::AsyncOperationCompletedHandler<unsigned int>([this](Windows::Foundation::IAsyncOperation<unsigned int> ^, Windows::Foundation::AsyncStatus) {
+        std::lock_guard<std::mutex> lock(_rx_mutex);
+        _rx_condition.notify_all();
+    });
+}
@@ -24,6 +24,8 @@ THE SOFTWARE.
 
 #pragma once
 #include "IStream.h"
+#include "StreamMetrics.h"
+#include <condition_variable>
 #include <mutex>
 
 namespace Microsoft {
@@ -93,6 +95,14 @@ public:
         void
         );
 
+    ///<summary>
+    ///Takes a snapshot of this stream's metrics: bytes in and out, reads, flushes and how long they took, and waits which timed out
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    getMetrics(
+        void
+        );
+
     virtual
     void
     lock(
@@ -158,12 +168,24 @@ public:
         void
         );
 
+    virtual
+    uint16_t
+    readBytes(
+        Platform::WriteOnlyArray<uint8_t> ^buffer_
+        );
+
     virtual
     void
     unlock(
         void
         );
 
+    virtual
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+        );
+
     virtual
     uint16_t
     write(
@@ -185,12 +207,19 @@ private:
     Windows::Networking::HostName ^_host;
     uint16_t _port;
 
+    //bytes in and out, flushes and waits, reported by getMetrics()
+    StreamMetrics _metrics;
+
     //thread-safe mechanisms. std::unique_lock used to manage the lifecycle of std::mutex
     std::mutex _nutex;
     std::unique_lock<std::mutex> _network_lock;
 
     std::atomic_bool _connection_ready;
     Windows::Storage::Streams::DataReaderLoadOperation ^_current_load_operation;
+
+    //signaled whenever a load operation completes, allowing waitForData() to sleep until data arrives
+    std::mutex _rx_mutex;
+    std::condition_variable _rx_condition;
     Windows::Networking::Sockets::StreamSocket ^_stream_socket;
     Windows::Storage::Streams::DataReader ^_rx;
     Windows::Storage::Streams::DataWriter ^_tx;
@@ -200,6 +229,11 @@ private:
             Windows::Networking::HostName ^host_,
             uint16_t port_
             );
+
+    void
+    startLoadOperation(
+        void
+        );
 };
 
 } // namespace Serial
@@ -0,0 +1,400 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "FdStream.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+using namespace Microsoft::Maker::Serial::Posix;
+
+namespace {
+
+//identifies the descriptors registered with each epoll instance
+const uint64_t DESCRIPTOR_EVENT = 0;
+const uint64_t WAKE_EVENT = 1;
+
+bool
+addToEpoll(
+    int epoll_,
+    int fd_,
+    uint32_t events_,
+    uint64_t tag_
+    )
+{
+    epoll_event event = {};
+    event.events = events_;
+    event.data.u64 = tag_;
+    return ::epoll_ctl( epoll_, EPOLL_CTL_ADD, fd_, &event ) == 0;
+}
+
+std::string
+describeErrno(
+    const char *operation_
+    )
+{
+    return std::string( operation_ ) + " failed: " + std::strerror( errno );
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+FdStream::FdStream(
+    void
+    ) :
+    _fd( -1 ),
+    _rx_epoll( -1 ),
+    _tx_epoll( -1 ),
+    _wake_event( -1 ),
+    _connected( false )
+{
+}
+
+FdStream::~FdStream(
+    void
+    )
+{
+    //derived classes have already been destroyed, so only the descriptors themselves are released here
+    _connected = false;
+    closeDescriptors();
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+uint16_t
+FdStream::available(
+    void
+    )
+{
+    std::shared_lock<std::shared_mutex> lock( _fd_mutex );
+    if( _fd < 0 ) return 0;
+
+    int count = 0;
+    if( ::ioctl( _fd, FIONREAD, &count ) < 0 || count < 0 ) return 0;
+    return static_cast<uint16_t>( count > UINT16_MAX ? UINT16_MAX : count );
+}
+
+void
+FdStream::begin(
+    void
+    )
+{
+    std::string error_message;
+
+    {   //critical section
+        std::unique_lock<std::shared_mutex> lock( _fd_mutex );
+        if( _fd >= 0 ) return;
+
+        _fd = openDescriptor( error_message );
+        if( _fd >= 0 )
+        {
+            _rx_epoll = ::epoll_create1( EPOLL_CLOEXEC );
+            _tx_epoll = ::epoll_create1( EPOLL_CLOEXEC );
+            _wake_event = ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+
+            if( _rx_epoll < 0 || _tx_epoll < 0 || _wake_event < 0 ||
+                !addToEpoll( _rx_epoll, _fd, EPOLLIN | EPOLLRDHUP, DESCRIPTOR_EVENT ) ||
+                !addToEpoll( _rx_epoll, _wake_event, EPOLLIN, WAKE_EVENT ) ||
+                !addToEpoll( _tx_epoll, _fd, EPOLLOUT, DESCRIPTOR_EVENT ) ||
+                !addToEpoll( _tx_epoll, _wake_event, EPOLLIN, WAKE_EVENT ) )
+            {
+                error_message = describeErrno( "epoll setup" );
+                closeDescriptors();
+            }
+        }
+        _connected = ( _fd >= 0 );
+    }
+
+    if( _connected )
+    {
+        if( _handlers.connectionEstablished ) _handlers.connectionEstablished();
+    }
+    else
+    {
+        if( _handlers.connectionFailed ) _handlers.connectionFailed( error_message );
+    }
+}
+
+bool
+FdStream::connectionReady(
+    void
+    )
+{
+    return _connected;
+}
+
+void
+FdStream::end(
+    void
+    )
+{
+    _connected = false;
+
+    //wake every thread sleeping in epoll_wait, so it releases the descriptor and the exclusive lock can be taken
+    {   //critical section
+        std::shared_lock<std::shared_mutex> lock( _fd_mutex );
+        if( _wake_event >= 0 )
+        {
+            uint64_t one = 1;
+            ssize_t written = ::write( _wake_event, &one, sizeof( one ) );
+            (void)written;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock( _fd_mutex );
+    closeDescriptors();
+}
+
+void
+FdStream::flush(
+    void
+    )
+{
+    std::string lost_message;
+
+    {   //critical section, flushes are serialized so each frame reaches the descriptor whole and in the order it was taken
+        std::lock_guard<std::mutex> flush_lock( _flush_mutex );
+
+        {   //critical section
+            std::lock_guard<std::mutex> lock( _tx_mutex );
+            if( _tx.empty() ) return;
+            _tx_frame.swap( _tx );
+        }
+
+        std::shared_lock<std::shared_mutex> lock( _fd_mutex );
+        size_t sent = 0;
+        while( _fd >= 0 && sent < _tx_frame.size() )
+        {
+            ssize_t written = writeDescriptor( _fd, _tx_frame.data() + sent, _tx_frame.size() - sent );
+            if( written > 0 )
+            {
+                sent += static_cast<size_t>( written );
+            }
+            else if( written < 0 && errno == EINTR )
+            {
+                continue;
+            }
+            else if( written < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+            {
+                if( !waitForWritable() ) break;
+            }
+            else
+            {
+                lost_message = describeErrno( "write" );
+                break;
+            }
+        }
+
+        _tx_frame.clear();
+    }
+
+    //reported once no lock is held, since the handler may end() or flush() the stream
+    if( !lost_message.empty() )
+    {
+        connectionLost( "A fatal error has occurred in FdStream::flush() and your connection has been lost. (" + lost_message + ")" );
+    }
+}
+
+void
+FdStream::lock(
+    void
+    )
+{
+    _stream_mutex.lock();
+}
+
+uint16_t
+FdStream::read(
+    void
+    )
+{
+    uint8_t c;
+    if( !readBytes( &c, 1 ) ) return static_cast<uint16_t>( -1 );
+    return c;
+}
+
+size_t
+FdStream::readBytes(
+    uint8_t *buffer_,
+    size_t length_
+    )
+{
+    if( !length_ ) return 0;
+
+    std::shared_lock<std::shared_mutex> lock( _fd_mutex );
+    if( _fd < 0 ) return 0;
+
+    for( ;; )
+    {
+        ssize_t bytes_read = ::read( _fd, buffer_, length_ );
+        if( bytes_read > 0 ) return static_cast<size_t>( bytes_read );
+        if( bytes_read < 0 && errno == EINTR ) continue;
+        if( bytes_read < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) return 0;
+        if( bytes_read == 0 && !emptyReadIsEndOfStream() ) return 0;
+
+        std::string message = ( bytes_read == 0 ) ? std::string( "the remote end closed the connection" ) : describeErrno( "read" );
+        lock.unlock();
+        connectionLost( "A fatal error has occurred in FdStream::readBytes() and your connection has been lost. (" + message + ")" );
+        return 0;
+    }
+}
+
+bool
+FdStream::waitForData(
+    uint32_t timeout_ms_
+    )
+{
+    std::shared_lock<std::shared_mutex> lock( _fd_mutex );
+    if( _fd < 0 ) return false;
+
+    epoll_event events[2];
+    int count;
+    do
+    {
+        count = ::epoll_wait( _rx_epoll, events, 2, static_cast<int>( timeout_ms_ > INT32_MAX ? INT32_MAX : timeout_ms_ ) );
+    } while( count < 0 && errno == EINTR );
+
+    bool readable = false;
+    bool hung_up = false;
+    for( int i = 0; i < count; ++i )
+    {
+        if( events[i].data.u64 != DESCRIPTOR_EVENT ) continue;
+        readable = ( events[i].events & EPOLLIN ) != 0;
+        hung_up = ( events[i].events & ( EPOLLHUP | EPOLLERR ) ) != 0;
+    }
+
+    //a hang up with data still pending is reported once the data has been read
+    if( hung_up && !readable )
+    {
+        lock.unlock();
+        connectionLost( "The remote end hung up and your connection has been lost." );
+        return false;
+    }
+    return readable;
+}
+
+uint16_t
+FdStream::write(
+    uint8_t c_
+    )
+{
+    return static_cast<uint16_t>( write( &c_, 1 ) );
+}
+
+size_t
+FdStream::write(
+    const uint8_t *buffer_,
+    size_t length_
+    )
+{
+    if( !_connected ) return 0;
+
+    std::lock_guard<std::mutex> lock( _tx_mutex );
+    _tx.insert( _tx.end(), buffer_, buffer_ + length_ );
+    return length_;
+}
+
+void
+FdStream::unlock(
+    void
+    )
+{
+    _stream_mutex.unlock();
+}
+
+
+//******************************************************************************
+//* Protected Methods
+//******************************************************************************
+
+void
+FdStream::connectionLost(
+    const std::string &message_
+    )
+{
+    //only the first thread to notice the loss reports it
+    if( !_connected.exchange( false ) ) return;
+    if( _handlers.connectionLost ) _handlers.connectionLost( message_ );
+}
+
+ssize_t
+FdStream::writeDescriptor(
+    int fd_,
+    const uint8_t *buffer_,
+    size_t length_
+    )
+{
+    return ::write( fd_, buffer_, length_ );
+}
+
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+FdStream::closeDescriptors(
+    void
+    )
+{
+    for( int *fd : { &_fd, &_rx_epoll, &_tx_epoll, &_wake_event } )
+    {
+        if( *fd >= 0 )
+        {
+            ::close( *fd );
+            *fd = -1;
+        }
+    }
+}
+
+bool
+FdStream::waitForWritable(
+    void
+    )
+{
+    epoll_event events[2];
+    for( ;; )
+    {
+        int count = ::epoll_wait( _tx_epoll, events, 2, -1 );
+        if( count < 0 && errno == EINTR ) continue;
+        if( count <= 0 ) return false;
+
+        for( int i = 0; i < count; ++i )
+        {
+            if( events[i].data.u64 == WAKE_EVENT ) return false;
+        }
+        return true;
+    }
+}
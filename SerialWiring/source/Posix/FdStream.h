@@ -0,0 +1,203 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "../Core/Stream.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace Serial {
+namespace Posix {
+
+/*
+ * The common half of every POSIX transport: a Stream over a single file descriptor, driven by epoll.
+ * Readers sleep in epoll_wait until the descriptor is readable, flush() sleeps until it is writable again, and end()
+ * wakes both through an eventfd before the descriptor is closed. Implementations only open and configure the descriptor.
+ */
+class FdStream : public Core::Stream
+{
+public:
+    virtual
+    ~FdStream(
+        void
+        );
+
+    virtual
+    uint16_t
+    available(
+        void
+        ) override;
+
+    virtual
+    void
+    begin(
+        void
+        ) override;
+
+    virtual
+    bool
+    connectionReady(
+        void
+        ) override;
+
+    virtual
+    void
+    end(
+        void
+        ) override;
+
+    virtual
+    void
+    flush(
+        void
+        ) override;
+
+    virtual
+    void
+    lock(
+        void
+        ) override;
+
+    virtual
+    uint16_t
+    read(
+        void
+        ) override;
+
+    virtual
+    size_t
+    readBytes(
+        uint8_t *buffer_,
+        size_t length_
+        ) override;
+
+    virtual
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+        ) override;
+
+    virtual
+    uint16_t
+    write(
+        uint8_t c_
+        ) override;
+
+    virtual
+    size_t
+    write(
+        const uint8_t *buffer_,
+        size_t length_
+        ) override;
+
+    virtual
+    void
+    unlock(
+        void
+        ) override;
+
+protected:
+    FdStream(
+        void
+        );
+
+    ///<summary>
+    ///Opens and configures the descriptor. On failure returns -1 and describes the problem in error_message_.
+    ///</summary>
+    virtual
+    int
+    openDescriptor(
+        std::string &error_message_
+        ) = 0;
+
+    ///<summary>
+    ///Returns true if a read of zero bytes means the other end has closed the connection, as it does for sockets.
+    ///A terminal configured with VMIN=0 also returns zero bytes when it simply has nothing to deliver.
+    ///</summary>
+    virtual
+    bool
+    emptyReadIsEndOfStream(
+        void
+        ) const
+    {
+        return true;
+    }
+
+    virtual
+    ssize_t
+    writeDescriptor(
+        int fd_,
+        const uint8_t *buffer_,
+        size_t length_
+        );
+
+    void
+    connectionLost(
+        const std::string &message_
+        );
+
+private:
+    //the descriptor may only be used while holding _fd_mutex shared, end() takes it exclusively to close it
+    std::shared_mutex _fd_mutex;
+    int _fd;
+    int _rx_epoll;
+    int _tx_epoll;
+    int _wake_event;
+    std::atomic_bool _connected;
+
+    //bytes placed by write() until flush() sends them
+    std::mutex _tx_mutex;
+    std::vector<uint8_t> _tx;
+
+    //the bytes being sent by flush(), only touched while holding _flush_mutex
+    std::mutex _flush_mutex;
+    std::vector<uint8_t> _tx_frame;
+
+    std::mutex _stream_mutex;
+
+    void
+    closeDescriptors(
+        void
+        );
+
+    bool
+    waitForWritable(
+        void
+        );
+};
+
+} // namespace Posix
+} // namespace Serial
+} // namespace Maker
+} // namespace Microsoft
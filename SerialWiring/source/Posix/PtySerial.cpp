@@ -0,0 +1,111 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "PtySerial.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace Microsoft::Maker::Serial::Posix;
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+PtySerial::PtySerial(
+    void
+    ) :
+    _slave_fd( -1 )
+{
+}
+
+PtySerial::~PtySerial(
+    void
+    )
+{
+    end();
+    if( _slave_fd >= 0 ) { ::close( _slave_fd ); }
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+std::string
+PtySerial::slavePath(
+    void
+    ) const
+{
+    return _slave_path;
+}
+
+
+//******************************************************************************
+//* Protected Methods
+//******************************************************************************
+
+int
+PtySerial::openDescriptor(
+    std::string &error_message_
+    )
+{
+    int fd = ::posix_openpt( O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+    if( fd < 0 || ::grantpt( fd ) < 0 || ::unlockpt( fd ) < 0 )
+    {
+        error_message_ = std::string( "Unable to create a pseudo-terminal: " ) + std::strerror( errno );
+        if( fd >= 0 ) { ::close( fd ); }
+        return -1;
+    }
+
+    char path[128];
+    if( ::ptsname_r( fd, path, sizeof( path ) ) != 0 )
+    {
+        error_message_ = std::string( "Unable to name the pseudo-terminal: " ) + std::strerror( errno );
+        ::close( fd );
+        return -1;
+    }
+
+    //both ends carry raw bytes, exactly like a serial line
+    int slave_fd = ::open( path, O_RDWR | O_NOCTTY | O_CLOEXEC );
+    termios tty = {};
+    if( slave_fd < 0 || ::tcgetattr( slave_fd, &tty ) < 0 )
+    {
+        error_message_ = std::string( "Unable to open " ) + path + ": " + std::strerror( errno );
+        if( slave_fd >= 0 ) { ::close( slave_fd ); }
+        ::close( fd );
+        return -1;
+    }
+    ::cfmakeraw( &tty );
+    ::tcsetattr( slave_fd, TCSANOW, &tty );
+
+    if( _slave_fd >= 0 ) { ::close( _slave_fd ); }
+    _slave_fd = slave_fd;
+    _slave_path = path;
+    return fd;
+}
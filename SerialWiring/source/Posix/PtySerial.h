@@ -0,0 +1,76 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "FdStream.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace Serial {
+namespace Posix {
+
+/*
+ * The controlling end of a pseudo-terminal pair, for loopback testing without a board. After begin() the other end is
+ * available at slavePath(), where a TermiosSerial, a simulated board or `socat` can open it like any serial port.
+ * The pair holds its own reference to the far end, so peers may come and go without the stream seeing a hang up.
+ */
+class PtySerial : public FdStream
+{
+public:
+    PtySerial(
+        void
+        );
+
+    virtual
+    ~PtySerial(
+        void
+        );
+
+    ///<summary>
+    ///Returns the path of the far end of the pair, or an empty string before begin() has succeeded
+    ///</summary>
+    std::string
+    slavePath(
+        void
+        ) const;
+
+protected:
+    virtual
+    int
+    openDescriptor(
+        std::string &error_message_
+        ) override;
+
+private:
+    std::string _slave_path;
+    int _slave_fd;
+};
+
+} // namespace Posix
+} // namespace Serial
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,166 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "TcpSerial.h"
+
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Microsoft::Maker::Serial::Posix;
+
+namespace {
+
+//waits for a non-blocking connect to complete, returns 0 on success or the error which ended it
+int
+awaitConnection(
+    int fd_,
+    uint32_t timeout_ms_
+    )
+{
+    int epoll = ::epoll_create1( EPOLL_CLOEXEC );
+    if( epoll < 0 ) return errno;
+
+    epoll_event event = {};
+    event.events = EPOLLOUT;
+    int result = ETIMEDOUT;
+    if( ::epoll_ctl( epoll, EPOLL_CTL_ADD, fd_, &event ) == 0 )
+    {
+        int count;
+        do
+        {
+            count = ::epoll_wait( epoll, &event, 1, static_cast<int>( timeout_ms_ ) );
+        } while( count < 0 && errno == EINTR );
+
+        if( count > 0 )
+        {
+            socklen_t length = sizeof( result );
+            if( ::getsockopt( fd_, SOL_SOCKET, SO_ERROR, &result, &length ) < 0 ) result = errno;
+        }
+        else if( count < 0 )
+        {
+            result = errno;
+        }
+    }
+    ::close( epoll );
+    return result;
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+TcpSerial::TcpSerial(
+    const std::string &host_,
+    uint16_t port_,
+    uint32_t connect_timeout_ms_
+    ) :
+    _host( host_ ),
+    _port( port_ ),
+    _connect_timeout_ms( connect_timeout_ms_ )
+{
+}
+
+TcpSerial::~TcpSerial(
+    void
+    )
+{
+    end();
+}
+
+
+//******************************************************************************
+//* Protected Methods
+//******************************************************************************
+
+int
+TcpSerial::openDescriptor(
+    std::string &error_message_
+    )
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo *addresses = nullptr;
+    int status = ::getaddrinfo( _host.c_str(), std::to_string( _port ).c_str(), &hints, &addresses );
+    if( status != 0 )
+    {
+        error_message_ = "Unable to resolve " + _host + ": " + ::gai_strerror( status );
+        return -1;
+    }
+
+    //try each address in turn, the last failure is the one reported
+    int fd = -1;
+    error_message_ = "No addresses found for " + _host;
+    for( addrinfo *address = addresses; address != nullptr && fd < 0; address = address->ai_next )
+    {
+        fd = ::socket( address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol );
+        if( fd < 0 )
+        {
+            error_message_ = std::string( "Unable to create a socket: " ) + std::strerror( errno );
+            continue;
+        }
+
+        int result = 0;
+        if( ::connect( fd, address->ai_addr, address->ai_addrlen ) < 0 )
+        {
+            result = ( errno == EINPROGRESS ) ? awaitConnection( fd, _connect_timeout_ms ) : errno;
+        }
+
+        if( result != 0 )
+        {
+            error_message_ = "Unable to connect to " + _host + ":" + std::to_string( _port ) + ": " + std::strerror( result );
+            ::close( fd );
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo( addresses );
+
+    if( fd >= 0 )
+    {
+        int enable = 1;
+        ::setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof( enable ) );
+        error_message_.clear();
+    }
+    return fd;
+}
+
+ssize_t
+TcpSerial::writeDescriptor(
+    int fd_,
+    const uint8_t *buffer_,
+    size_t length_
+    )
+{
+    //a closed peer is reported through the return value rather than SIGPIPE
+    return ::send( fd_, buffer_, length_, MSG_NOSIGNAL );
+}
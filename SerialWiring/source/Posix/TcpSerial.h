@@ -0,0 +1,81 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "FdStream.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace Serial {
+namespace Posix {
+
+/*
+ * A TCP client, for boards reached through a network bridge such as ser2net or an ESP8266 running a serial-to-TCP sketch.
+ * Nagle's algorithm is disabled, since Firmata messages are small and latency sensitive; batching is left to the writer.
+ */
+class TcpSerial : public FdStream
+{
+public:
+    static const uint32_t DEFAULT_CONNECT_TIMEOUT_MS = 5000;
+
+    TcpSerial(
+        const std::string &host_,
+        uint16_t port_,
+        uint32_t connect_timeout_ms_ = DEFAULT_CONNECT_TIMEOUT_MS
+        );
+
+    virtual
+    ~TcpSerial(
+        void
+        );
+
+protected:
+    virtual
+    int
+    openDescriptor(
+        std::string &error_message_
+        ) override;
+
+    virtual
+    ssize_t
+    writeDescriptor(
+        int fd_,
+        const uint8_t *buffer_,
+        size_t length_
+        ) override;
+
+private:
+    const std::string _host;
+    const uint16_t _port;
+    const uint32_t _connect_timeout_ms;
+};
+
+} // namespace Posix
+} // namespace Serial
+} // namespace Maker
+} // namespace Microsoft
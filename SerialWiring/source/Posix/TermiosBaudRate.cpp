@@ -0,0 +1,45 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "TermiosBaudRate.h"
+
+#include <asm/termbits.h>
+#include <cerrno>
+#include <sys/ioctl.h>
+
+bool
+Microsoft::Maker::Serial::Posix::setCustomBaudRate(
+    int fd_,
+    uint32_t baud_
+    )
+{
+    struct termios2 tty;
+    if( ::ioctl( fd_, TCGETS2, &tty ) < 0 ) return false;
+
+    tty.c_cflag &= ~( CBAUD | ( CBAUD << IBSHIFT ) );
+    tty.c_cflag |= BOTHER | ( BOTHER << IBSHIFT );
+    tty.c_ispeed = baud_;
+    tty.c_ospeed = baud_;
+    return ::ioctl( fd_, TCSETS2, &tty ) == 0;
+}
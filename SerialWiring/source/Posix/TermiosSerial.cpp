@@ -0,0 +1,150 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "TermiosSerial.h"
+#include "TermiosBaudRate.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace Microsoft::Maker::Serial::Posix;
+
+namespace {
+
+bool
+standardSpeed(
+    uint32_t baud_,
+    speed_t *speed_
+    )
+{
+    static const struct { uint32_t baud; speed_t speed; } SPEEDS[] = {
+        { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 },
+        { 57600, B57600 }, { 115200, B115200 }, { 230400, B230400 }, { 460800, B460800 }, { 500000, B500000 },
+        { 921600, B921600 }, { 1000000, B1000000 }, { 2000000, B2000000 },
+    };
+
+    for( const auto &entry : SPEEDS )
+    {
+        if( entry.baud == baud_ )
+        {
+            *speed_ = entry.speed;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors / Destructors
+//******************************************************************************
+
+TermiosSerial::TermiosSerial(
+    const std::string &device_path_,
+    const TermiosSettings &settings_
+    ) :
+    _device_path( device_path_ ),
+    _settings( settings_ )
+{
+}
+
+TermiosSerial::~TermiosSerial(
+    void
+    )
+{
+    end();
+}
+
+
+//******************************************************************************
+//* Protected Methods
+//******************************************************************************
+
+int
+TermiosSerial::openDescriptor(
+    std::string &error_message_
+    )
+{
+    //open without waiting for carrier detect, then return to blocking reads so VMIN and VTIME take effect
+    int fd = ::open( _device_path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+    if( fd < 0 )
+    {
+        error_message_ = "Unable to open " + _device_path + ": " + std::strerror( errno );
+        return -1;
+    }
+
+    termios tty = {};
+    if( ::tcgetattr( fd, &tty ) < 0 )
+    {
+        error_message_ = _device_path + " is not a terminal: " + std::strerror( errno );
+        ::close( fd );
+        return -1;
+    }
+
+    ::cfmakeraw( &tty );
+    tty.c_cflag |= ( CLOCAL | CREAD );
+    tty.c_cflag &= ~( CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS );
+    switch( _settings.dataBits )
+    {
+    case 5: tty.c_cflag |= CS5; break;
+    case 6: tty.c_cflag |= CS6; break;
+    case 7: tty.c_cflag |= CS7; break;
+    default: tty.c_cflag |= CS8; break;
+    }
+    if( _settings.parity != Parity::NONE ) tty.c_cflag |= PARENB;
+    if( _settings.parity == Parity::ODD ) tty.c_cflag |= PARODD;
+    if( _settings.stopBits == 2 ) tty.c_cflag |= CSTOPB;
+    tty.c_cc[VMIN] = _settings.vmin;
+    tty.c_cc[VTIME] = _settings.vtime;
+
+    speed_t speed;
+    bool standard = standardSpeed( _settings.baud, &speed );
+    if( standard )
+    {
+        ::cfsetispeed( &tty, speed );
+        ::cfsetospeed( &tty, speed );
+    }
+
+    if( ::tcsetattr( fd, TCSANOW, &tty ) < 0 )
+    {
+        error_message_ = "Unable to configure " + _device_path + ": " + std::strerror( errno );
+        ::close( fd );
+        return -1;
+    }
+
+    if( !standard && !setCustomBaudRate( fd, _settings.baud ) )
+    {
+        error_message_ = "Unable to set a baud rate of " + std::to_string( _settings.baud ) + " on " + _device_path + ": " + std::strerror( errno );
+        ::close( fd );
+        return -1;
+    }
+
+    ::fcntl( fd, F_SETFL, ::fcntl( fd, F_GETFL ) & ~O_NONBLOCK );
+    ::tcflush( fd, TCIOFLUSH );
+    return fd;
+}
@@ -0,0 +1,100 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "FdStream.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace Serial {
+namespace Posix {
+
+enum class Parity
+{
+    NONE,
+    EVEN,
+    ODD,
+};
+
+/*
+ * Line settings for a TermiosSerial port. The defaults match the 8N1 profile used by Arduino devices.
+ * vmin and vtime are applied to the terminal as-is: with vmin above zero a read waits for that many bytes, or for vtime
+ * tenths of a second after the first byte arrives, trading latency for fewer, larger reads.
+ */
+struct TermiosSettings
+{
+    uint32_t baud = 57600;
+    uint8_t dataBits = 8;
+    Parity parity = Parity::NONE;
+    uint8_t stopBits = 1;
+    uint8_t vmin = 0;
+    uint8_t vtime = 0;
+};
+
+/*
+ * A serial port opened through termios, such as /dev/ttyACM0 or the far end of a PtySerial.
+ * Any baud rate the driver supports may be requested, including rates with no Bxxx constant.
+ */
+class TermiosSerial : public FdStream
+{
+public:
+    TermiosSerial(
+        const std::string &device_path_,
+        const TermiosSettings &settings_ = TermiosSettings()
+        );
+
+    virtual
+    ~TermiosSerial(
+        void
+        );
+
+protected:
+    virtual
+    bool
+    emptyReadIsEndOfStream(
+        void
+        ) const override
+    {
+        return false;
+    }
+
+    virtual
+    int
+    openDescriptor(
+        std::string &error_message_
+        ) override;
+
+private:
+    const std::string _device_path;
+    const TermiosSettings _settings;
+};
+
+} // namespace Posix
+} // namespace Serial
+} // namespace Maker
+} // namespace Microsoft
@@ -127,6 +127,17 @@ public ref class RedBearLabBleSerial sealed : public IStream
         _bleSerial->flush();
     }
 
+    ///<summary>
+    ///Takes a snapshot of the wrapped BleSerial's metrics
+    ///</summary>
+    inline
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    getMetrics (
+        void
+    ) {
+        return _bleSerial->getMetrics();
+    }
+
     virtual inline
     void
     lock (
@@ -212,6 +223,14 @@ public ref class RedBearLabBleSerial sealed : public IStream
         return _bleSerial->read();
     }
 
+    virtual inline
+    uint16_t
+    readBytes (
+        Platform::WriteOnlyArray<uint8_t> ^buffer_
+    ) {
+        return _bleSerial->readBytes(buffer_);
+    }
+
     virtual inline
     void
     unlock (
@@ -220,6 +239,14 @@ public ref class RedBearLabBleSerial sealed : public IStream
         _bleSerial->unlock();
     }
 
+    virtual inline
+    bool
+    waitForData (
+        uint32_t timeout_ms_
+    ) {
+        return _bleSerial->waitForData(timeout_ms_);
+    }
+
     virtual inline
     uint16_t
     write (
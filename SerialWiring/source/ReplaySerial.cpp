@@ -0,0 +1,353 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "ReplaySerial.h"
+
+#include "../../RemoteWiring/source/Firmata/Core/CaptureReplay.h"
+
+#include <bitset>
+
+using namespace Microsoft::Maker::Serial;
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+ReplaySerial::ReplaySerial(
+    Platform::String ^path_,
+    double speed_
+    ) :
+    _path( path_ ),
+    _replay( new Firmata::Core::CaptureReplay( speed_ ) ),
+    _connection_ready( ATOMIC_VAR_INIT( false ) ),
+    _replay_lock( _rutex, std::defer_lock )
+{
+}
+
+//******************************************************************************
+//* Destructors
+//******************************************************************************
+
+ReplaySerial::~ReplaySerial(
+    void
+    )
+{
+    end();
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+uint16_t
+ReplaySerial::available(
+    void
+    )
+{
+    if( !connectionReady() ) { return 0; }
+
+    size_t count = _replay->available();
+    if( !count ) { checkForEndOfCapture(); }
+    return static_cast<uint16_t>( count > 0xFFFF ? 0xFFFF : count );
+}
+
+/// \details Immediately discards the incoming parameters, the pace of the replay is set by the capture and the replay speed.
+void
+ReplaySerial::begin(
+    uint32_t baud_,
+    SerialConfig config_
+    )
+{
+    UNREFERENCED_PARAMETER( baud_ );
+    UNREFERENCED_PARAMETER( config_ );
+
+    // Ensure known good state
+    end();
+
+    //the core takes UTF-8 paths
+    std::string path( WideCharToMultiByte( CP_UTF8, 0, _path->Data(), -1, nullptr, 0, nullptr, nullptr ), '\0' );
+    WideCharToMultiByte( CP_UTF8, 0, _path->Data(), -1, &path[0], static_cast<int>( path.size() ), nullptr, nullptr );
+    path.resize( path.size() - 1 );
+
+    if( !_replay->begin( path ) )
+    {
+        ConnectionFailed( L"ReplaySerial::begin failed to open the capture file, or the file is not a capture. Path: " + _path );
+        return;
+    }
+
+    _connection_ready = true;
+    ConnectionEstablished();
+}
+
+bool
+ReplaySerial::connectionReady(
+    void
+    )
+{
+    return _connection_ready;
+}
+
+void
+ReplaySerial::end(
+    void
+    )
+{
+    _connection_ready = false;
+    _replay->end();
+}
+
+/// \details Writes are discarded, so there is nothing to flush.
+void
+ReplaySerial::flush(
+    void
+    )
+{
+    //written bytes are discarded, so a flush completes immediately
+    _metrics.flushed( std::chrono::steady_clock::now() );
+}
+
+Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+ReplaySerial::getMetrics(
+    void
+    )
+{
+    return _metrics.snapshot();
+}
+
+void
+ReplaySerial::lock(
+    void
+    )
+{
+    _replay_lock.lock();
+}
+
+uint16_t
+ReplaySerial::print(
+    uint8_t c_
+    )
+{
+    return write(c_);
+}
+
+uint16_t
+ReplaySerial::print(
+    int32_t value_
+    )
+{
+    return print(value_, Radix::DEC);
+}
+
+uint16_t
+ReplaySerial::print(
+    int32_t value_,
+    Radix base_
+    )
+{
+    constexpr int bit_size = (sizeof(int) * 8);
+    std::bitset<bit_size> bits(value_);
+    char text_value[bit_size + 1];
+
+    switch (base_) {
+    case Radix::BIN:
+        sprintf_s(text_value, "%s", bits.to_string().c_str());
+        break;
+    case Radix::DEC:
+        sprintf_s(text_value, "%i", value_);
+        break;
+    case Radix::HEX:
+        sprintf_s(text_value, "%x", value_);
+        break;
+    case Radix::OCT:
+        sprintf_s(text_value, "%o", value_);
+        break;
+    default:
+        return static_cast<uint16_t>(-1);
+    }
+
+    return write(Platform::ArrayReference<uint8_t>(reinterpret_cast<uint8_t *>(const_cast<char *>(text_value)), strnlen(text_value, bit_size + 1)));
+}
+
+uint16_t
+ReplaySerial::print(
+    uint32_t value_
+    )
+{
+    return print(value_, Radix::DEC);
+}
+
+uint16_t
+ReplaySerial::print(
+    uint32_t value_,
+    Radix base_
+    )
+{
+    constexpr int bit_size = (sizeof(unsigned int) * 8);
+    std::bitset<bit_size> bits(value_);
+    char text_value[bit_size + 1];
+
+    switch (base_) {
+    case Radix::BIN:
+        sprintf_s(text_value, "%s", bits.to_string().c_str());
+        break;
+    case Radix::DEC:
+        sprintf_s(text_value, "%u", value_);
+        break;
+    case Radix::HEX:
+        sprintf_s(text_value, "%x", value_);
+        break;
+    case Radix::OCT:
+        sprintf_s(text_value, "%o", value_);
+        break;
+    default:
+        return static_cast<uint16_t>(-1);
+    }
+
+    return write(Platform::ArrayReference<uint8_t>(reinterpret_cast<uint8_t *>(const_cast<char *>(text_value)), strnlen(text_value, bit_size + 1)));
+}
+
+uint16_t
+ReplaySerial::print(
+    double value_
+    )
+{
+    return print(value_, 2);
+}
+
+uint16_t
+ReplaySerial::print(
+    double value_,
+    int16_t decimal_places_
+    )
+{
+    constexpr int max_double_size = (sizeof(double) * 8);
+    constexpr int max_int_size = (sizeof(int16_t) * 8);
+    char format_string[max_int_size + 5];
+    char text_value[max_double_size + 1];
+
+    sprintf_s(format_string, "%%.%ilf", decimal_places_);
+    sprintf_s(text_value, format_string, value_);
+
+    return write(Platform::ArrayReference<uint8_t>(reinterpret_cast<uint8_t *>(const_cast<char *>(text_value)), strnlen(text_value, max_double_size + 1)));
+}
+
+uint16_t
+ReplaySerial::print(
+    const Platform::Array<uint8_t> ^buffer_
+    )
+{
+    return write(buffer_);
+}
+
+uint16_t
+ReplaySerial::read(
+    void
+    )
+{
+    uint8_t c;
+
+    if( !connectionReady() ) { return static_cast<uint16_t>( -1 ); }
+    if( !_replay->readBytes( &c, 1 ) )
+    {
+        checkForEndOfCapture();
+        return static_cast<uint16_t>( -1 );
+    }
+    _metrics.bytesRead( 1 );
+    return c;
+}
+
+uint16_t
+ReplaySerial::readBytes(
+    Platform::WriteOnlyArray<uint8_t> ^buffer_
+    )
+{
+    if( !connectionReady() ) { return 0; }
+
+    size_t length = buffer_->Length > 0xFFFF ? 0xFFFF : buffer_->Length;
+    size_t count = _replay->readBytes( buffer_->Data, length );
+    _metrics.bytesRead( count );
+    if( !count ) { checkForEndOfCapture(); }
+    return static_cast<uint16_t>( count );
+}
+
+void
+ReplaySerial::unlock(
+    void
+    )
+{
+    _replay_lock.unlock();
+}
+
+bool
+ReplaySerial::waitForData(
+    uint32_t timeout_ms_
+    )
+{
+    if( !connectionReady() ) { return false; }
+    if( _replay->waitForData( timeout_ms_ ) ) { return true; }
+
+    _metrics.waitTimedOut();
+    checkForEndOfCapture();
+    return false;
+}
+
+/// \details The board's side of the session is fixed by the capture, so the bytes are counted as written and dropped.
+uint16_t
+ReplaySerial::write(
+    uint8_t c_
+    )
+{
+    UNREFERENCED_PARAMETER( c_ );
+
+    if( !connectionReady() ) { return 0; }
+    _metrics.bytesWritten( 1 );
+    return 1;
+}
+
+uint16_t
+ReplaySerial::write(
+    const Platform::Array<uint8_t> ^buffer_
+    )
+{
+    if( !connectionReady() ) { return 0; }
+    _metrics.bytesWritten( buffer_->Length );
+    return static_cast<uint16_t>( buffer_->Length );
+}
+
+//******************************************************************************
+//* Private Methods
+//******************************************************************************
+
+void
+ReplaySerial::checkForEndOfCapture(
+    void
+    )
+{
+    //raised once, by whichever read first finds the capture exhausted
+    if( _replay->finished() && _connection_ready.exchange( false ) )
+    {
+        ConnectionLost( L"The end of the capture has been reached. Path: " + _path );
+    }
+}
@@ -0,0 +1,233 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+#include "IStream.h"
+#include "StreamMetrics.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+    class CaptureReplay;
+} // namespace Core
+} // namespace Firmata
+
+namespace Serial {
+
+///<summary>
+///An IStream which plays back the board's side of a capture recorded with UwpFirmata::startCapture(). Everything written
+///to it is discarded. ConnectionLost is raised once the whole capture has been read.
+///</summary>
+public ref class ReplaySerial sealed : public IStream
+{
+public:
+    virtual event IStreamConnectionCallback ^ConnectionEstablished;
+    virtual event IStreamConnectionCallbackWithMessage ^ConnectionLost;
+    virtual event IStreamConnectionCallbackWithMessage ^ConnectionFailed;
+
+    ///<summary>
+    ///A constructor which accepts the path of a capture file and the replay speed: 1.0 reproduces the recorded timing, larger
+    ///values replay proportionally faster and 0 replays as fast as the data is read.
+    ///</summary>
+    ReplaySerial(
+        Platform::String ^path_,
+        double speed_
+        );
+
+    virtual
+    ~ReplaySerial(
+        void
+        );
+
+    virtual
+    uint16_t
+    available(
+        void
+        );
+
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    inline
+    void
+    begin(
+        void
+        )
+    {
+        //the capture dictates the timing, the line settings are irrelevant
+        begin( NULL, SerialConfig::NONE );
+    }
+
+    virtual
+    void
+    begin(
+        uint32_t baud_,
+        SerialConfig config_
+        );
+
+    virtual
+    bool
+    connectionReady(
+        void
+        );
+
+    virtual
+    void
+    end(
+        void
+        );
+
+    virtual
+    void
+    flush(
+        void
+        );
+
+    ///<summary>
+    ///Takes a snapshot of this stream's metrics: bytes in and out, reads, flushes and how long they took, and waits which timed out
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    getMetrics(
+        void
+        );
+
+    virtual
+    void
+    lock(
+        void
+        );
+
+    virtual
+    uint16_t
+    print(
+          uint8_t c_
+         );
+
+    virtual
+    uint16_t
+    print(
+          int32_t value_
+         );
+
+    virtual
+    uint16_t
+    print(
+          int32_t value_,
+          Radix base_
+         );
+
+    virtual
+    uint16_t
+    print(
+          uint32_t value_
+         );
+
+    virtual
+    uint16_t
+    print(
+          uint32_t value_,
+          Radix base_
+         );
+
+    virtual
+    uint16_t
+    print(
+          double value_
+         );
+
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    virtual
+    uint16_t
+    print(
+          double value_,
+          int16_t decimal_place_
+         );
+
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    virtual
+    uint16_t
+    print(
+        const Platform::Array<uint8_t> ^buffer_
+        );
+
+    virtual
+    uint16_t
+    read(
+        void
+        );
+
+    virtual
+    uint16_t
+    readBytes(
+        Platform::WriteOnlyArray<uint8_t> ^buffer_
+        );
+
+    virtual
+    void
+    unlock(
+        void
+        );
+
+    virtual
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+        );
+
+    virtual
+    uint16_t
+    write(
+        uint8_t c_
+        );
+
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    virtual
+    uint16_t
+    write(
+        const Platform::Array<uint8_t> ^buffer_
+        );
+
+private:
+    Platform::String ^_path;
+    std::unique_ptr<Firmata::Core::CaptureReplay> _replay;
+    std::atomic_bool _connection_ready;
+
+    //bytes in and out, flushes and waits, reported by getMetrics()
+    StreamMetrics _metrics;
+
+    //thread-safe mechanisms. std::unique_lock used to manage the lifecycle of std::mutex
+    std::mutex _rutex;
+    std::unique_lock<std::mutex> _replay_lock;
+
+    void
+    checkForEndOfCapture(
+        void
+        );
+};
+
+} // namespace Serial
+} // namespace Maker
+} // namespace Microsoft
@@ -0,0 +1,66 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "StreamMetrics.h"
+
+using namespace Microsoft::Maker::Serial;
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+StreamMetrics::StreamMetrics(
+    void
+    ) :
+    _bytes_read( _registry.counter( "stream.bytes_in" ) ),
+    _bytes_written( _registry.counter( "stream.bytes_out" ) ),
+    _reads( _registry.counter( "stream.reads" ) ),
+    _flushes( _registry.counter( "stream.flushes" ) ),
+    _wait_timeouts( _registry.counter( "stream.wait_timeouts" ) ),
+    _flush_latency( _registry.histogram( "stream.flush_ns" ) )
+{
+}
+
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+StreamMetrics::snapshot(
+    void
+    ) const
+{
+    Platform::Collections::Map<Platform::String ^, double> ^metrics = ref new Platform::Collections::Map<Platform::String ^, double>();
+
+    for( const std::pair<std::string, double> &metric : _registry.snapshot().flatten() )
+    {
+        //metric names are plain ASCII
+        std::wstring name( metric.first.begin(), metric.first.end() );
+        metrics->Insert( ref new Platform::String( name.c_str() ), metric.second );
+    }
+
+    return metrics->GetView();
+}
@@ -0,0 +1,115 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+#include "../../RemoteWiring/source/Firmata/Core/Metrics.h"
+
+namespace Microsoft {
+namespace Maker {
+namespace Serial {
+
+/*
+ * The metrics kept by every IStream implementation. Each update is a single uncontended atomic add, so they are safe to
+ * call from the read, write and flush paths whichever thread those run on.
+ */
+class StreamMetrics
+{
+public:
+    StreamMetrics(
+        void
+    );
+
+    ///<summary>
+    ///Counts bytes handed to the caller by read() or readBytes(). Reads which returned nothing are not counted.
+    ///</summary>
+    inline
+    void
+    bytesRead(
+        size_t count_
+    )
+    {
+        if( !count_ ) return;
+        _reads.increment();
+        _bytes_read.add( count_ );
+    }
+
+    ///<summary>
+    ///Counts bytes accepted by write() or print() into the outbound buffer
+    ///</summary>
+    inline
+    void
+    bytesWritten(
+        size_t count_
+    )
+    {
+        _bytes_written.add( count_ );
+    }
+
+    ///<summary>
+    ///Counts a flush which has completed, and records how long it took from the call to flush()
+    ///</summary>
+    inline
+    void
+    flushed(
+        std::chrono::steady_clock::time_point started_
+    )
+    {
+        _flushes.increment();
+        _flush_latency.record( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - started_ ).count() );
+    }
+
+    ///<summary>
+    ///Builds the map handed out by the getMetrics() method of each IStream implementation
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    snapshot(
+        void
+    ) const;
+
+    inline
+    void
+    waitTimedOut(
+        void
+    )
+    {
+        _wait_timeouts.increment();
+    }
+
+private:
+    Firmata::Core::MetricsRegistry _registry;
+    Firmata::Core::Counter &_bytes_read;
+    Firmata::Core::Counter &_bytes_written;
+    Firmata::Core::Counter &_reads;
+    Firmata::Core::Counter &_flushes;
+    Firmata::Core::Counter &_wait_timeouts;
+    Firmata::Core::Histogram &_flush_latency;
+};
+
+} // namespace Serial
+} // namespace Maker
+} // namespace Microsoft
@@ -139,12 +139,29 @@ UsbSerial::available(
 			return 0;
 		}
 
-		_current_load_operation = _rx->LoadAsync(MAX_READ_SIZE);
+		startLoadOperation();
 	}
 
 	return 0;
 }
 
+uint16_t
+UsbSerial::readBytes(
+    Platform::WriteOnlyArray<uint8_t> ^buffer_
+    )
+{
+    uint16_t count = available();
+    if ( count > buffer_->Length ) { count = static_cast<uint16_t>(buffer_->Length); }
+
+    // Hand the caller's storage straight to the DataReader to avoid a per-byte ReadByte() call
+    if ( count ) {
+        _rx->ReadBytes(Platform::ArrayReference<uint8_t>(buffer_->Data, count));
+    }
+
+    _metrics.bytesRead( count );
+    return count;
+}
+
 void
 UsbSerial::begin(
     uint32_t baud_,
@@ -238,6 +255,7 @@ UsbSerial::end(
     OutputDebugString(L"UsbSerial::end()\r\n");
     _connection_ready = false;
     _current_load_operation = nullptr;
+    _rx_condition.notify_all();
 
     // Reset with respect to dependencies
     delete(_rx); //_rx->Close();
@@ -258,9 +276,10 @@ UsbSerial::flush(
         return;
     }
 
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
     auto async_operation = _tx->StoreAsync();
     create_task( async_operation )
-    .then( [ this, async_operation ]( task<unsigned int> task_ )
+    .then( [ this, async_operation, started ]( task<unsigned int> task_ )
     {
         try
         {
@@ -271,6 +290,8 @@ UsbSerial::flush(
             {
                 throw ref new Platform::Exception( E_UNEXPECTED );
             }
+
+            _metrics.flushed( started );
         }
         catch( Platform::Exception ^ )
         {
@@ -280,6 +301,14 @@ UsbSerial::flush(
     } );
 }
 
+Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+UsbSerial::getMetrics(
+    void
+    )
+{
+    return _metrics.snapshot();
+}
+
 /// \details An Advanced Query String is constructed based upon paired usb devices. Then a collection is returned of all devices matching the query.
 /// \ref https://msdn.microsoft.com/en-us/library/aa965711(VS.85).aspx
 Windows::Foundation::IAsyncOperation<Windows::Devices::Enumeration::DeviceInformationCollection ^> ^
@@ -428,6 +457,7 @@ UsbSerial::read(
 
     if ( available() ) {
         c = _rx->ReadByte();
+        _metrics.bytesRead( 1 );
     }
 
     return c;
@@ -441,6 +471,27 @@ UsbSerial::unlock(
     _usb_lock.unlock();
 }
 
+bool
+UsbSerial::waitForData(
+    uint32_t timeout_ms_
+    )
+{
+    // available() restarts the load operation once the previous one has been consumed
+    if ( available() ) { return true; }
+
+    {
+        std::unique_lock<std::mutex> lock(_rx_mutex);
+        _rx_condition.wait_for(lock, std::chrono::milliseconds(timeout_ms_), [this]() -> bool {
+            return ( connectionReady() && _current_load_operation != nullptr && _current_load_operation->Status != Windows::Foundation::AsyncStatus::Started );
+        });
+    }
+
+    if ( available() ) { return true; }
+
+    _metrics.waitTimedOut();
+    return false;
+}
+
 uint16_t
 UsbSerial::write(
     uint8_t c_
@@ -450,6 +501,7 @@ UsbSerial::write(
     if ( !connectionReady() ) { return 0; }
 
     _tx->WriteByte(c_);
+    _metrics.bytesWritten( 1 );
     return 1;
 }
 
@@ -462,6 +514,7 @@ UsbSerial::write(
     if (!connectionReady()) { return 0; }
 
     _tx->WriteBytes(buffer_);
+    _metrics.bytesWritten( buffer_->Length );
     return buffer_->Length;
 }
 
@@ -625,7 +678,7 @@ UsbSerial::connectToDeviceAsync(
             // Enable RX
             _rx = ref new Windows::Storage::Streams::DataReader(_serial_device->InputStream);
             _rx->InputStreamOptions = Windows::Storage::Streams::InputStreamOptions::Partial;  // Partial mode will allow for better async reads
-            _current_load_operation = _rx->LoadAsync(MAX_READ_SIZE);
+            startLoadOperation();
 
             OutputDebugString(L"UsbSerial::connectToDeviceAsync() EnableTX\r\n");
             // Enable TX
@@ -679,3 +732,17 @@ UsbSerial::identifyDeviceFromCollection(
     // If we searched and found nothing that matches the identifier, we've failed to connect and cannot recover.
     throw ref new Platform::Exception(E_INVALIDARG, L"No USB devices found matching the specified identifier.");
 }
+
+void
+UsbSerial::startLoadOperation(
+    void
+    )
+{
+    _current_load_operation = _rx->LoadAsync(MAX_READ_SIZE);
+
+    // Wake any thread sleeping in waitForData() as soon as the load completes
+    _current_load_operation->Completed = ref new Windows::Foundation::AsyncOperationCompletedHandler<unsigned int>([this](Windows::Foundation::IAsyncOperation<unsigned int> ^, Windows::Foundation::AsyncStatus) {
+        std::lock_guard<std::mutex> lock(_rx_mutex);
+        _rx_condition.notify_all();
+    });
+}
@@ -25,6 +25,8 @@
 #pragma once
 
 #include "IStream.h"
+#include "StreamMetrics.h"
+#include <condition_variable>
 #include <mutex>
 
 namespace Microsoft {
@@ -108,6 +110,14 @@ public:
         void
         );
 
+    ///<summary>
+    ///Takes a snapshot of this stream's metrics: bytes in and out, reads, flushes and how long they took, and waits which timed out
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    getMetrics(
+        void
+        );
+
     virtual
     void
     lock(
@@ -173,12 +183,24 @@ public:
         void
         );
 
+    virtual
+    uint16_t
+    readBytes(
+        Platform::WriteOnlyArray<uint8_t> ^buffer_
+        );
+
     virtual
     void
     unlock(
         void
         );
 
+    virtual
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+        );
+
     virtual
     uint16_t
     write(
@@ -210,6 +232,9 @@ private:
     Platform::String ^_pid;
     Platform::String ^_vid;
 
+    //bytes in and out, flushes and waits, reported by getMetrics()
+    StreamMetrics _metrics;
+
     //thread-safe mechanisms. std::unique_lock used to manage the lifecycle of std::mutex
     std::mutex _usbutex;
     std::unique_lock<std::mutex> _usb_lock;
@@ -218,6 +243,10 @@ private:
     SerialConfig _config;
     std::atomic_bool _connection_ready;
     Windows::Storage::Streams::DataReaderLoadOperation ^_current_load_operation;
+
+    //signaled whenever a load operation completes, allowing waitForData() to sleep until data arrives
+    std::mutex _rx_mutex;
+    std::condition_variable _rx_condition;
     Windows::Devices::Enumeration::DeviceInformationCollection ^_device_collection;
     Windows::Devices::SerialCommunication::SerialDevice ^_serial_device;
     Windows::Storage::Streams::DataReader ^_rx;
@@ -232,6 +261,11 @@ private:
     identifyDeviceFromCollection(
         Windows::Devices::Enumeration::DeviceInformationCollection ^devices_
         );
+
+    void
+    startLoadOperation(
+        void
+        );
 };
 
 } // namespace Serial
@@ -0,0 +1,422 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "VirtualSerial.h"
+
+#include "../../RemoteWiring/source/Firmata/Core/VirtualBoard.h"
+
+#include <bitset>
+
+using namespace Microsoft::Maker::Serial;
+
+namespace {
+
+Microsoft::Maker::Firmata::Core::SignalGenerator
+makeSignal(
+    VirtualSignalShape shape_,
+    double offset_,
+    double amplitude_,
+    Windows::Foundation::TimeSpan period_
+    )
+{
+    Microsoft::Maker::Firmata::Core::SignalGenerator signal;
+    signal.shape = static_cast<Microsoft::Maker::Firmata::Core::SignalShape>( shape_ );
+    signal.offset = offset_;
+    signal.amplitude = amplitude_;
+
+    //TimeSpan counts 100ns ticks
+    signal.period = std::chrono::microseconds( period_.Duration / 10 );
+    return signal;
+}
+
+} // namespace
+
+//******************************************************************************
+//* Constructors
+//******************************************************************************
+
+VirtualSerial::VirtualSerial(
+    void
+    ) :
+    _board( new Firmata::Core::VirtualBoard() ),
+    _connection_ready( ATOMIC_VAR_INIT( false ) ),
+    _virtual_lock( _vutex, std::defer_lock )
+{
+}
+
+//******************************************************************************
+//* Destructors
+//******************************************************************************
+
+VirtualSerial::~VirtualSerial(
+    void
+    )
+{
+    end();
+}
+
+//******************************************************************************
+//* Public Methods
+//******************************************************************************
+
+uint16_t
+VirtualSerial::available(
+    void
+    )
+{
+    if( !connectionReady() ) { return 0; }
+
+    size_t count = _board->available();
+    return static_cast<uint16_t>( count > 0xFFFF ? 0xFFFF : count );
+}
+
+/// \details The baud rate limits how fast the simulated board may send, zero removes the limit. The serial configuration is ignored.
+void
+VirtualSerial::begin(
+    uint32_t baud_,
+    SerialConfig config_
+    )
+{
+    UNREFERENCED_PARAMETER( config_ );
+
+    // Ensure known good state
+    end();
+
+    _board->setBaudRate( baud_ );
+    _board->begin();
+    _connection_ready = true;
+    ConnectionEstablished();
+}
+
+bool
+VirtualSerial::connectionReady(
+    void
+    )
+{
+    return _connection_ready;
+}
+
+uint64_t
+VirtualSerial::droppedBytes(
+    void
+    )
+{
+    return _board->droppedBytes();
+}
+
+void
+VirtualSerial::end(
+    void
+    )
+{
+    _connection_ready = false;
+    _board->end();
+
+    std::lock_guard<std::mutex> lock( _tx_mutex );
+    _tx.clear();
+}
+
+void
+VirtualSerial::flush(
+    void
+    )
+{
+    if( !connectionReady() ) { return; }
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock( _tx_mutex );
+    if( !_tx.empty() )
+    {
+        _board->write( _tx.data(), _tx.size() );
+        _tx.clear();
+    }
+    _metrics.flushed( started );
+}
+
+Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+VirtualSerial::getMetrics(
+    void
+    )
+{
+    return _metrics.snapshot();
+}
+
+void
+VirtualSerial::lock(
+    void
+    )
+{
+    _virtual_lock.lock();
+}
+
+uint16_t
+VirtualSerial::print(
+    uint8_t c_
+    )
+{
+    return write(c_);
+}
+
+uint16_t
+VirtualSerial::print(
+    int32_t value_
+    )
+{
+    return print(value_, Radix::DEC);
+}
+
+uint16_t
+VirtualSerial::print(
+    int32_t value_,
+    Radix base_
+    )
+{
+    constexpr int bit_size = (sizeof(int) * 8);
+    std::bitset<bit_size> bits(value_);
+    char text_value[bit_size + 1];
+
+    switch (base_) {
+    case Radix::BIN:
+        sprintf_s(text_value, "%s", bits.to_string().c_str());
+        break;
+    case Radix::DEC:
+        sprintf_s(text_value, "%i", value_);
+        break;
+    case Radix::HEX:
+        sprintf_s(text_value, "%x", value_);
+        break;
+    case Radix::OCT:
+        sprintf_s(text_value, "%o", value_);
+        break;
+    default:
+        return static_cast<uint16_t>(-1);
+    }
+
+    return write(Platform::ArrayReference<uint8_t>(reinterpret_cast<uint8_t *>(const_cast<char *>(text_value)), strnlen(text_value, bit_size + 1)));
+}
+
+uint16_t
+VirtualSerial::print(
+    uint32_t value_
+    )
+{
+    return print(value_, Radix::DEC);
+}
+
+uint16_t
+VirtualSerial::print(
+    uint32_t value_,
+    Radix base_
+    )
+{
+    constexpr int bit_size = (sizeof(unsigned int) * 8);
+    std::bitset<bit_size> bits(value_);
+    char text_value[bit_size + 1];
+
+    switch (base_) {
+    case Radix::BIN:
+        sprintf_s(text_value, "%s", bits.to_string().c_str());
+        break;
+    case Radix::DEC:
+        sprintf_s(text_value, "%u", value_);
+        break;
+    case Radix::HEX:
+        sprintf_s(text_value, "%x", value_);
+        break;
+    case Radix::OCT:
+        sprintf_s(text_value, "%o", value_);
+        break;
+    default:
+        return static_cast<uint16_t>(-1);
+    }
+
+    return write(Platform::ArrayReference<uint8_t>(reinterpret_cast<uint8_t *>(const_cast<char *>(text_value)), strnlen(text_value, bit_size + 1)));
+}
+
+uint16_t
+VirtualSerial::print(
+    double value_
+    )
+{
+    return print(value_, 2);
+}
+
+uint16_t
+VirtualSerial::print(
+    double value_,
+    int16_t decimal_places_
+    )
+{
+    constexpr int max_double_size = (sizeof(double) * 8);
+    constexpr int max_int_size = (sizeof(int16_t) * 8);
+    char format_string[max_int_size + 5];
+    char text_value[max_double_size + 1];
+
+    sprintf_s(format_string, "%%.%ilf", decimal_places_);
+    sprintf_s(text_value, format_string, value_);
+
+    return write(Platform::ArrayReference<uint8_t>(reinterpret_cast<uint8_t *>(const_cast<char *>(text_value)), strnlen(text_value, max_double_size + 1)));
+}
+
+uint16_t
+VirtualSerial::print(
+    const Platform::Array<uint8_t> ^buffer_
+    )
+{
+    return write(buffer_);
+}
+
+uint16_t
+VirtualSerial::read(
+    void
+    )
+{
+    uint8_t c;
+
+    if( !connectionReady() || !_board->readBytes( &c, 1 ) ) { return static_cast<uint16_t>( -1 ); }
+    _metrics.bytesRead( 1 );
+    return c;
+}
+
+uint16_t
+VirtualSerial::readBytes(
+    Platform::WriteOnlyArray<uint8_t> ^buffer_
+    )
+{
+    if( !connectionReady() ) { return 0; }
+
+    size_t length = buffer_->Length > 0xFFFF ? 0xFFFF : buffer_->Length;
+    size_t count = _board->readBytes( buffer_->Data, length );
+    _metrics.bytesRead( count );
+    return static_cast<uint16_t>( count );
+}
+
+uint64_t
+VirtualSerial::sentBytes(
+    void
+    )
+{
+    return _board->sentBytes();
+}
+
+void
+VirtualSerial::setAnalogSignal(
+    uint8_t channel_,
+    VirtualSignalShape shape_,
+    double offset_,
+    double amplitude_,
+    Windows::Foundation::TimeSpan period_
+    )
+{
+    _board->setAnalogSignal( channel_, makeSignal( shape_, offset_, amplitude_, period_ ) );
+}
+
+void
+VirtualSerial::setDigitalSignal(
+    uint8_t pin_,
+    VirtualSignalShape shape_,
+    double offset_,
+    double amplitude_,
+    Windows::Foundation::TimeSpan period_
+    )
+{
+    _board->setDigitalSignal( pin_, makeSignal( shape_, offset_, amplitude_, period_ ) );
+}
+
+void
+VirtualSerial::setI2cRegisters(
+    uint8_t address_,
+    uint8_t register_,
+    const Platform::Array<uint8_t> ^data_
+    )
+{
+    _board->setI2cRegisters( address_, register_, data_->Data, data_->Length );
+}
+
+void
+VirtualSerial::setPulseSignal(
+    uint8_t pin_,
+    VirtualSignalShape shape_,
+    double offset_,
+    double amplitude_,
+    Windows::Foundation::TimeSpan period_
+    )
+{
+    _board->setPulseSignal( pin_, makeSignal( shape_, offset_, amplitude_, period_ ) );
+}
+
+void
+VirtualSerial::setSamplingInterval(
+    Windows::Foundation::TimeSpan interval_
+    )
+{
+    _board->setSamplingInterval( std::chrono::microseconds( interval_.Duration / 10 ) );
+}
+
+void
+VirtualSerial::unlock(
+    void
+    )
+{
+    _virtual_lock.unlock();
+}
+
+bool
+VirtualSerial::waitForData(
+    uint32_t timeout_ms_
+    )
+{
+    if( !connectionReady() ) { return false; }
+    if( _board->waitForData( timeout_ms_ ) ) { return true; }
+
+    _metrics.waitTimedOut();
+    return false;
+}
+
+uint16_t
+VirtualSerial::write(
+    uint8_t c_
+    )
+{
+    if( !connectionReady() ) { return 0; }
+
+    std::lock_guard<std::mutex> lock( _tx_mutex );
+    _tx.push_back( c_ );
+    _metrics.bytesWritten( 1 );
+    return 1;
+}
+
+uint16_t
+VirtualSerial::write(
+    const Platform::Array<uint8_t> ^buffer_
+    )
+{
+    if( !connectionReady() ) { return 0; }
+
+    std::lock_guard<std::mutex> lock( _tx_mutex );
+    _tx.insert( _tx.end(), buffer_->Data, buffer_->Data + buffer_->Length );
+    _metrics.bytesWritten( buffer_->Length );
+    return static_cast<uint16_t>( buffer_->Length );
+}
@@ -0,0 +1,308 @@
+/*
+    Copyright(c) Microsoft Open Technologies, Inc. All rights reserved.
+
+    The MIT License(MIT)
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files(the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions :
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#pragma once
+#include "IStream.h"
+#include "StreamMetrics.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Microsoft {
+namespace Maker {
+namespace Firmata {
+namespace Core {
+    class VirtualBoard;
+} // namespace Core
+} // namespace Firmata
+
+namespace Serial {
+
+public enum class VirtualSignalShape {
+    CONSTANT,
+    SINE,
+    SQUARE,
+    STEP,
+    NOISE,
+};
+
+///<summary>
+///An IStream connected to an in-process simulation of a board running MakeCodeFirmata, so UwpFirmata and RemoteDevice
+///can be exercised without hardware. Passing a baud rate of zero to begin() lets the simulated board send as fast as
+///it is read, any other value limits it to what that line could carry.
+///</summary>
+public ref class VirtualSerial sealed : public IStream
+{
+public:
+    virtual event IStreamConnectionCallback ^ConnectionEstablished;
+    virtual event IStreamConnectionCallbackWithMessage ^ConnectionLost;
+    virtual event IStreamConnectionCallbackWithMessage ^ConnectionFailed;
+
+    ///<summary>
+    ///A constructor which simulates an Arduino Uno
+    ///</summary>
+    VirtualSerial(
+        void
+        );
+
+    virtual
+    ~VirtualSerial(
+        void
+        );
+
+    virtual
+    uint16_t
+    available(
+        void
+        );
+
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    inline
+    void
+    begin(
+        void
+        )
+    {
+        begin( 0, SerialConfig::NONE );
+    }
+
+    virtual
+    void
+    begin(
+        uint32_t baud_,
+        SerialConfig config_
+        );
+
+    virtual
+    bool
+    connectionReady(
+        void
+        );
+
+    ///<summary>
+    ///The number of bytes the simulated board has discarded because they were not read in time
+    ///</summary>
+    uint64_t
+    droppedBytes(
+        void
+        );
+
+    virtual
+    void
+    end(
+        void
+        );
+
+    virtual
+    void
+    flush(
+        void
+        );
+
+    ///<summary>
+    ///Takes a snapshot of this stream's metrics: bytes in and out, reads, flushes and how long they took, and waits which timed out
+    ///</summary>
+    Windows::Foundation::Collections::IMapView<Platform::String ^, double> ^
+    getMetrics(
+        void
+        );
+
+    virtual
+    void
+    lock(
+        void
+        );
+
+    virtual
+    uint16_t
+    print(
+          uint8_t c_
+         );
+
+    virtual
+    uint16_t
+    print(
+          int32_t value_
+         );
+
+    virtual
+    uint16_t
+    print(
+          int32_t value_,
+          Radix base_
+         );
+
+    virtual
+    uint16_t
+    print(
+          uint32_t value_
+         );
+
+    virtual
+    uint16_t
+    print(
+          uint32_t value_,
+          Radix base_
+         );
+
+    virtual
+    uint16_t
+    print(
+          double value_
+         );
+
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    virtual
+    uint16_t
+    print(
+          double value_,
+          int16_t decimal_place_
+         );
+
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    virtual
+    uint16_t
+    print(
+        const Platform::Array<uint8_t> ^buffer_
+        );
+
+    virtual
+    uint16_t
+    read(
+        void
+        );
+
+    virtual
+    uint16_t
+    readBytes(
+        Platform::WriteOnlyArray<uint8_t> ^buffer_
+        );
+
+    ///<summary>
+    ///The number of bytes the simulated board has produced, including any that were dropped
+    ///</summary>
+    uint64_t
+    sentBytes(
+        void
+        );
+
+    ///<summary>
+    ///Drives an analog channel with a signal ranging from offset_ - amplitude_ to offset_ + amplitude_
+    ///</summary>
+    void
+    setAnalogSignal(
+        uint8_t channel_,
+        VirtualSignalShape shape_,
+        double offset_,
+        double amplitude_,
+        Windows::Foundation::TimeSpan period_
+        );
+
+    ///<summary>
+    ///Drives a digital input, which reads HIGH while the signal is above 0.5
+    ///</summary>
+    void
+    setDigitalSignal(
+        uint8_t pin_,
+        VirtualSignalShape shape_,
+        double offset_,
+        double amplitude_,
+        Windows::Foundation::TimeSpan period_
+        );
+
+    ///<summary>
+    ///Preloads the register file of a simulated I2C device, starting at the given register
+    ///</summary>
+    void
+    setI2cRegisters(
+        uint8_t address_,
+        uint8_t register_,
+        const Platform::Array<uint8_t> ^data_
+        );
+
+    ///<summary>
+    ///The pulse width, in microseconds, measured by PULSE_IN and DISTANCE on the given pin
+    ///</summary>
+    void
+    setPulseSignal(
+        uint8_t pin_,
+        VirtualSignalShape shape_,
+        double offset_,
+        double amplitude_,
+        Windows::Foundation::TimeSpan period_
+        );
+
+    ///<summary>
+    ///Samples the simulated inputs at the given interval, which may be far shorter than SAMPLING_INTERVAL allows
+    ///</summary>
+    void
+    setSamplingInterval(
+        Windows::Foundation::TimeSpan interval_
+        );
+
+    virtual
+    void
+    unlock(
+        void
+        );
+
+    virtual
+    bool
+    waitForData(
+        uint32_t timeout_ms_
+        );
+
+    virtual
+    uint16_t
+    write(
+        uint8_t c_
+        );
+
+    [Windows::Foundation::Metadata::DefaultOverloadAttribute]
+    virtual
+    uint16_t
+    write(
+        const Platform::Array<uint8_t> ^buffer_
+        );
+
+private:
+    std::unique_ptr<Firmata::Core::VirtualBoard> _board;
+    std::atomic_bool _connection_ready;
+
+    //bytes in and out, flushes and waits, reported by getMetrics()
+    StreamMetrics _metrics;
+
+    //thread-safe mechanisms. std::unique_lock used to manage the lifecycle of std::mutex
+    std::mutex _vutex;
+    std::unique_lock<std::mutex> _virtual_lock;
+
+    //bytes written by the host are held until flush(), then handed to the board in one piece
+    std::mutex _tx_mutex;
+    std::vector<uint8_t> _tx;
+};
+
+} // namespace Serial
+} // namespace Maker
+} // namespace Microsoft